@@ -23,13 +23,23 @@ interface MuxSessionOptions {
   maxIdle?: number | string,
   maxQueue?: number,
   maxMessages?: number,
+  minIdle?: number,
+  pingInterval?: number | string,
 }
 
 interface MuxOptions extends MuxSessionOptions {
   outputCount?: number | (() => number),
 }
 
-interface MuxHTTPOptions extends MuxOptions {
+interface HTTP2Options {
+  connectionWindowSize?: number | string,
+  streamWindowSize?: number | string,
+  maxConnectionWindowSize?: number | string,
+  maxStreamWindowSize?: number | string,
+  streamQuantum?: number | string,
+}
+
+interface MuxHTTPOptions extends MuxOptions, HTTP2Options {
   bufferSize?: number | string,
   maxHeaderSize?: number | string,
   version?: number | string | (() => number | string),
@@ -337,38 +347,66 @@ interface Configuration {
   /**
    * Appends a _compress_ filter to the current pipeline layout.
    *
-   * A _compress_ filter compresses messages.
+   * A _compress_ filter compresses a Data stream.
    *
-   * - **INPUT** - _Messages_ to compress.
-   * - **OUTPUT** - Compressed _Messages_.
+   * - **INPUT** - _Data_ stream to compress.
+   * - **OUTPUT** - Compressed _Data_ stream.
    *
    * @param algorithm Compression algorithm or a function that returns the compression algorithm.
-   *       Available compression algorithms are `"deflate"`, `"gzip"`.
-   * @returns The same _Configuration_ object.
-   */
-  compress(algorithm: string | (() => string)): Configuration;
+   *       Available compression algorithms are `"deflate"`, `"gzip"` and `"br"`.
+   * @param options Options including:
+   *   - level - Compression level. For `"deflate"` and `"gzip"` it ranges from 0 to 9,
+   *       for `"br"` it ranges from 0 to 11. Default is 6.
+   *   - window - Base-2 logarithm of the sliding window size for `"br"`, ranging from 10 to 24.
+   *   - offload - If true, the stream is compressed on a shared background thread pool
+   *       instead of the worker thread, `offloadThreshold` bytes at a time. Smaller leftovers
+   *       are compressed on the worker thread. Default is false.
+   *   - offloadThreshold - Minimum amount of data to be compressed in the background at a time.
+   *       Can be a number in bytes or a string with a unit suffix `"k"`, `"m"` or `"g"`.
+   *       Default is 64KB.
+   * @returns The same _Configuration_ object.
+   */
+  compress(
+    algorithm: 'deflate' | 'gzip' | 'br' | (() => ('deflate' | 'gzip' | 'br')),
+    options?: {
+      level?: number,
+      window?: number,
+      offload?: boolean,
+      offloadThreshold?: number | string,
+    }
+  ): Configuration;
 
   /**
    * Appends a _compressHTTP_ filter to the current pipeline layout.
    *
-   * A _compressHTTP_ filter compresses HTTP messages.
+   * A _compressHTTP_ filter compresses HTTP messages and sets their _content-encoding_ header.
+   * Messages that already have a _content-encoding_ header are left unchanged.
    *
    * - **INPUT** - HTTP _Messages_ to compress.
    * - **OUTPUT** - Compressed HTTP _Messages_.
    *
+   * @param algorithm Compression algorithm or a function that receives the _MessageStart_
+   *       and returns the compression algorithm. Available compression algorithms are
+   *       `"deflate"`, `"gzip"` and `"br"`. Returning `null` or `undefined` leaves the message uncompressed.
    * @param options Options including:
-   *   - method - Compression method or a function that returns the compression method.
-   *       Available compression methods are `"deflate"`, `"gzip"` and  `""` for no compression.
-   *       Default is `""`.
-   *   - level - Compression level or a function that returns the compression level.
-   *       Available compression levels are `"default"`, `"speed"` and `"best"`.
-   *       Default is `"default"`.
+   *   - level - Compression level. For `"deflate"` and `"gzip"` it ranges from 0 to 9,
+   *       for `"br"` it ranges from 0 to 11. Default is 6.
+   *   - window - Base-2 logarithm of the sliding window size for `"br"`, ranging from 10 to 24.
+   *   - offload - If true, bodies are buffered and those larger than `offloadThreshold`
+   *       are compressed on a shared background thread pool instead of the worker thread.
+   *       Default is false.
+   *   - offloadThreshold - Minimum size of a body to be compressed in the background.
+   *       Can be a number in bytes or a string with a unit suffix `"k"`, `"m"` or `"g"`.
+   *       Default is 64KB.
    * @returns The same _Configuration_ object.
    */
   compressHTTP(
+    algorithm: 'deflate' | 'gzip' | 'br' | ((head: MessageStart) => ('deflate' | 'gzip' | 'br' | null | undefined)),
     options?: {
-      method?: '' | 'deflate' | 'gzip' | (() => (''|'deflate'|'gzip')),
-      level?: 'default' | 'speed' | 'best' | (() => ('default'|'speed'|'best')),
+      level?: number,
+      window?: number,
+      offload?: boolean,
+      offloadThreshold?: number | string,
     }
   ): Configuration;
 
@@ -393,6 +431,13 @@ interface Configuration {
    *   - _connectTimeout_ - Timeout while connecting.
    *       Can be a number in seconds or a string with one of the time unit suffixes such as `s`, `m` or `h`.
    *       Defaults to no timeout.
+   *   - _connectAttemptDelay_ - When greater than 0, all resolved addresses of the target host are raced (RFC 8305),
+   *       starting a new connection attempt after this delay or as soon as the previous attempt fails.
+   *       Can be a number in seconds or a string with one of the time unit suffixes such as `s`, `m` or `h`.
+   *       Defaults to 0, meaning only the first resolved address is tried.
+   *   - _connectFailureMemory_ - How long a failed address is tried after the others in later races.
+   *       Can be a number in seconds or a string with one of the time unit suffixes such as `s`, `m` or `h`.
+   *       Defaults to 10 seconds.
    *   - _readTimeout_ - Timeout while reading.
    *       Can be a number in seconds or a string with one of the time unit suffixes such as `s`, `m` or `h`.
    *       Defaults to no timeout.
@@ -416,6 +461,8 @@ interface Configuration {
       retryCount?: number,
       retryDelay?: number | string,
       connectTimeout?: number | string,
+      connectAttemptDelay?: number | string,
+      connectFailureMemory?: number | string,
       readTimeout?: number | string,
       writeTimeout?: number | string,
       idleTimeout?: number | string,
@@ -685,11 +732,18 @@ interface Configuration {
    *   - _bufferSize_ - (optional) Maximum body size above which a message should be transferred in chunks.
    *       Can be a number in bytes or a string with a unit suffix such as `'k'`, `'m'`, `'g'` and `'t'`.
    *       Default is _16KB_.
+   *   - _connectionWindowSize_ - (optional) Initial HTTP/2 receive window of the connection. Default is _1MB_.
+   *   - _streamWindowSize_ - (optional) Initial HTTP/2 receive window of each stream. Default is _1MB_.
+   *   - _maxConnectionWindowSize_ - (optional) Ceiling up to which the connection receive window
+   *       grows with the bandwidth-delay product measured by PING round trips. No growth by default.
+   *   - _maxStreamWindowSize_ - (optional) Same as _maxConnectionWindowSize_ for the stream receive windows.
+   *   - _streamQuantum_ - (optional) Bytes a stream of default weight can send per round when
+   *       HTTP/2 streams share the connection send window. Default is _16KB_.
    * @returns The same _Configuration_ object.
    */
-  demuxHTTP(options? : {
-    bufferSize: number | string,
-    maxHeaderSize: number | string,
+  demuxHTTP(options? : HTTP2Options & {
+    bufferSize?: number | string,
+    maxHeaderSize?: number | string,
   }): Configuration;
 
   /**
@@ -1019,6 +1073,13 @@ interface Configuration {
    *       Defaults is _60 seconds_.
    *   - _maxQueue_ - Maximum number of messages allowed to run concurrently in one sub-pipeline.
    *   - _maxMessages_ - Maximum number of messages allowed to run accumulatively in one sub-pipeline.
+   *   - _minIdle_ - Number of idle sub-pipelines to keep open ahead of demand. Sub-pipelines are started
+   *       as soon as a new stream comes, and without a protocol handshake to start (as with HTTP/1), they get
+   *       an empty _Data_ as input so that _connect_ can dial out. They are kept past _maxIdle_ until no new
+   *       stream has come for _maxIdle_. Default is `0`.
+   *   - _pingInterval_ - Interval at which idle sub-pipelines kept by _minIdle_ are pinged, for protocols
+   *       that support it such as HTTP/2. Can be a number in seconds or a string with one of the time unit
+   *       suffixes such as `s`, `m` or `h`. Default is `0` for no pinging.
    * @returns The same _Configuration_ object.
    */
   mux(
@@ -1036,6 +1097,13 @@ interface Configuration {
    *       Defaults is _60 seconds_.
    *   - _maxQueue_ - Maximum number of messages allowed to run concurrently in one sub-pipeline.
    *   - _maxMessages_ - Maximum number of messages allowed to run accumulatively in one sub-pipeline.
+   *   - _minIdle_ - Number of idle sub-pipelines to keep open ahead of demand. Sub-pipelines are started
+   *       as soon as a new stream comes, and without a protocol handshake to start (as with HTTP/1), they get
+   *       an empty _Data_ as input so that _connect_ can dial out. They are kept past _maxIdle_ until no new
+   *       stream has come for _maxIdle_. Default is `0`.
+   *   - _pingInterval_ - Interval at which idle sub-pipelines kept by _minIdle_ are pinged, for protocols
+   *       that support it such as HTTP/2. Can be a number in seconds or a string with one of the time unit
+   *       suffixes such as `s`, `m` or `h`. Default is `0` for no pinging.
    * @returns The same _Configuration_ object.
    */
   mux(
@@ -1059,10 +1127,19 @@ interface Configuration {
    *       Defaults is `60` seconds.
    *   - _maxQueue_ - Maximum number of messages allowed to run concurrently in one sub-pipeline.
    *   - _maxMessages_ - Maximum number of messages allowed to run accumulatively in one sub-pipeline.
+   *   - _minIdle_ - Number of idle sub-pipelines to keep open ahead of demand. Sub-pipelines are started
+   *       as soon as a new stream comes, and without a protocol handshake to start (as with HTTP/1), they get
+   *       an empty _Data_ as input so that _connect_ can dial out. They are kept past _maxIdle_ until no new
+   *       stream has come for _maxIdle_. Default is `0`.
+   *   - _pingInterval_ - Interval at which idle sub-pipelines kept by _minIdle_ are pinged, for protocols
+   *       that support it such as HTTP/2. Can be a number in seconds or a string with one of the time unit
+   *       suffixes such as `s`, `m` or `h`. Default is `0` for no pinging.
    *   - _bufferSize_ - Maximum body size above which a message should be transferred in chunks.
    *       Can be a number in bytes or a string with a unit suffix such as `'k'`, `'m'`, `'g'` and `'t'`.
    *       Default is _16KB_.
    *   - _version_ - Number `1` for HTTP/1 or number `2` for HTTP/2. Can also be a function that returns `1` or `2`.
+   *   - _connectionWindowSize_, _streamWindowSize_, _maxConnectionWindowSize_, _maxStreamWindowSize_
+   *       and _streamQuantum_ - HTTP/2 flow control and scheduling options, same as in _demuxHTTP_.
    * @returns The same _Configuration_ object.
    */
   muxHTTP(
@@ -1080,10 +1157,19 @@ interface Configuration {
    *       Defaults is `60` seconds.
    *   - _maxQueue_ - Maximum number of messages allowed to run concurrently in one sub-pipeline.
    *   - _maxMessages_ - Maximum number of messages allowed to run accumulatively in one sub-pipeline.
+   *   - _minIdle_ - Number of idle sub-pipelines to keep open ahead of demand. Sub-pipelines are started
+   *       as soon as a new stream comes, and without a protocol handshake to start (as with HTTP/1), they get
+   *       an empty _Data_ as input so that _connect_ can dial out. They are kept past _maxIdle_ until no new
+   *       stream has come for _maxIdle_. Default is `0`.
+   *   - _pingInterval_ - Interval at which idle sub-pipelines kept by _minIdle_ are pinged, for protocols
+   *       that support it such as HTTP/2. Can be a number in seconds or a string with one of the time unit
+   *       suffixes such as `s`, `m` or `h`. Default is `0` for no pinging.
    *   - _bufferSize_ - Maximum body size above which a message should be transferred in chunks.
    *       Can be a number in bytes or a string with a unit suffix such as `'k'`, `'m'`, `'g'` and `'t'`.
    *       Default is _16KB_.
    *   - _version_ - Number `1` for HTTP/1 or number `2` for HTTP/2. Can also be a function that returns `1` or `2`.
+   *   - _connectionWindowSize_, _streamWindowSize_, _maxConnectionWindowSize_, _maxStreamWindowSize_
+   *       and _streamQuantum_ - HTTP/2 flow control and scheduling options, same as in _demuxHTTP_.
    * @returns The same _Configuration_ object.
    */
   muxHTTP(
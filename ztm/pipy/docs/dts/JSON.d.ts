@@ -59,6 +59,64 @@ interface JSON {
     replacer?: (key: string, value: any, container: Object) => any,
     space?: number
   ): Data;
+
+  /**
+   * Creates a read-only view over a JSON text without decoding it up front.
+   *
+   * Only the nesting of objects and arrays is indexed when the view is created.
+   * Values are decoded when they are first accessed, so reading a few fields
+   * out of a large document costs much less than decoding all of it.
+   * Malformed structure is reported when the view is created, other errors
+   * when the offending part is accessed.
+   *
+   * @param text A string or a _Data_ object containing a JSON text.
+   * @returns A _JSON.View_ object.
+   */
+  view(text: string | Data): JSON.View;
+}
+
+declare namespace JSON {
+
+  /**
+   * Read-only view over a JSON text, returned by _JSON.view()_.
+   *
+   * A path is given as a list of object keys and array indices,
+   * starting from the root value. An empty path refers to the root value.
+   */
+  interface View {
+
+    /**
+     * Decodes the value at a path.
+     *
+     * @param path Object keys and array indices leading to the value.
+     * @returns The decoded value, or _undefined_ if the path doesn't exist.
+     */
+    get(...path: (string | number)[]): any;
+
+    /**
+     * Checks if a path exists.
+     *
+     * @param path Object keys and array indices leading to the value.
+     * @returns A boolean indicating whether there is a value at the path.
+     */
+    has(...path: (string | number)[]): boolean;
+
+    /**
+     * Lists the keys of the object at a path.
+     *
+     * @param path Object keys and array indices leading to the object.
+     * @returns An array of keys, or _undefined_ if the value at the path is not an object.
+     */
+    keys(...path: (string | number)[]): string[] | undefined;
+
+    /**
+     * Counts the entries in the object or array at a path.
+     *
+     * @param path Object keys and array indices leading to the object or array.
+     * @returns Number of keys or elements, or _undefined_ if the value at the path is neither an object nor an array.
+     */
+    size(...path: (string | number)[]): number | undefined;
+  }
 }
 
 declare var JSON: JSON;
@@ -58,6 +58,91 @@ interface CacheConstructor {
   ): Cache;
 }
 
+/**
+ * A key-value storage shared by all threads.
+ * Keys are compared by their type and string form, so `1` and `"1"` are different keys.
+ */
+interface SharedCache {
+
+  /**
+   * Looks up an entry.
+   *
+   * @param key The key of the entry to look up.
+   * @returns A copy of the value of the entry.
+   */
+  get(key: any): any;
+
+  /**
+   * Creates or changes an entry.
+   *
+   * @param key The key of the entry to create or change.
+   * @param value The value of the entry. Only booleans, numbers, strings and plain objects are kept.
+   */
+  set(key: any, value: any): void;
+
+  /**
+   * Checks if an entry exists.
+   *
+   * @param key The key of the entry to look up.
+   * @returns A boolean value indicating whether the entry exists.
+   */
+  has(key: any): boolean;
+
+  /**
+   * Looks up an entry without allocating it when not found.
+   *
+   * @param key The key of the entry to look up.
+   * @returns A copy of the value of the entry, or `undefined` if the entry is not found.
+   */
+  find(key: any): any;
+
+  /**
+   * Deletes an entry.
+   *
+   * @param key The key of the entry to delete.
+   * @returns A boolean value indicating whether the entry being deleted was found.
+   */
+  remove(key: any): boolean;
+
+  /**
+   * Deletes all entries.
+   */
+  clear(): void;
+
+  /**
+   * Gets statistics of the cache accumulated from all threads.
+   */
+  stats(): { size: number, hits: number, misses: number, evictions: number };
+}
+
+interface SharedCacheConstructor {
+
+  /**
+   * Creates an instance of _SharedCache_.
+   *
+   * All instances created with the same _key_ option, from any thread, share the same entries.
+   *
+   * @param onAllocate A function to be called when a queried entry does not exist.
+   *   It receives the key of the entry and is supposed to return the value of that entry.
+   * @param options Options including:
+   *   - _key_ - Name of the shared storage. Required.
+   *   - _size_ - Maximum number of entries allowed in the cache.
+   *   - _ttl_ - Time-to-live for the entries in the cache.
+   *       Can be a number in seconds or a string with one of the time unit suffixes such as `'s'`, `'m'` and `'h'`.
+   *   - _eviction_ - How to choose entries to evict when the cache is full. Can be `'lru'` or `'lfu'`. Defaults to `'lru'`.
+   * @returns A _SharedCache_ object.
+   */
+  new(
+    onAllocate: ((key: any) => any) | null,
+    options: {
+      key: string,
+      size?: number,
+      ttl?: number | string,
+      eviction?: 'lru' | 'lfu',
+    }
+  ): SharedCache;
+}
+
 /**
  * Keeps track of quota.
  */
@@ -148,6 +233,114 @@ interface URLRouterConstructor {
   new(routes: { [path: string]: any }): URLRouter;
 }
 
+/**
+ * Set of IPv4/IPv6 prefixes looked up by longest-prefix match.
+ */
+interface IPSet {
+
+  /**
+   * Number of prefixes in the set.
+   */
+  readonly size: number;
+
+  /**
+   * Adds a prefix.
+   *
+   * @param cidr A string in CIDR notation such as `"10.0.0.0/8"`, or a plain address for a single host.
+   * @param value The value that the prefix is mapped to. Defaults to `true`.
+   */
+  add(cidr: string, value?: any): void;
+
+  /**
+   * Replaces all prefixes in the set at once.
+   *
+   * @param prefixes An array of prefixes, or an object of key-value pairs where keys are prefixes and values are what they map to.
+   * @returns The same _IPSet_ object.
+   */
+  load(prefixes: string[] | { [cidr: string]: any }): IPSet;
+
+  /**
+   * Finds the longest prefix containing an address.
+   *
+   * @param address A string, an IP object or an _Inbound_ whose remote address is looked up.
+   * @returns The value mapped to the longest matching prefix, or `undefined` if none matches.
+   */
+  find(address: string | Inbound): any;
+
+  /**
+   * Checks if any prefix contains an address.
+   *
+   * @param address A string, an IP object or an _Inbound_ whose remote address is looked up.
+   * @returns A boolean indicating whether a prefix matches.
+   */
+  has(address: string | Inbound): boolean;
+}
+
+interface IPSetConstructor {
+
+  /**
+   * Creates an instance of _IPSet_.
+   *
+   * @param prefixes An array of prefixes, or an object of key-value pairs where keys are prefixes and values are what they map to.
+   * @returns An _IPSet_ object.
+   */
+  new(prefixes?: string[] | { [cidr: string]: any }): IPSet;
+}
+
+/**
+ * MQTT topic filters, each with a set of subscribers.
+ *
+ * Filters can have `+` and `#` wildcards. Topics starting with `$` are not
+ * matched by a wildcard at the first level. Filters in the form of
+ * `$share/<group>/<filter>` are shared subscriptions, where members of
+ * the same group take turns to receive matching topics.
+ */
+interface TopicTrie {
+
+  /**
+   * Number of subscriptions.
+   */
+  readonly size: number;
+
+  /**
+   * Adds a subscriber to a topic filter.
+   *
+   * @param filter A topic filter, optionally in the form of `$share/<group>/<filter>`.
+   * @param subscriber Any value standing for the subscriber.
+   * @returns A boolean indicating whether the subscription is new.
+   */
+  subscribe(filter: string, subscriber: any): boolean;
+
+  /**
+   * Removes a subscriber from a topic filter.
+   *
+   * @param filter A topic filter, optionally in the form of `$share/<group>/<filter>`.
+   * @param subscriber The value given to _subscribe()_.
+   * @returns A boolean indicating whether the subscription existed.
+   */
+  unsubscribe(filter: string, subscriber: any): boolean;
+
+  /**
+   * Finds the subscribers of a topic.
+   *
+   * @param topic A topic name to publish to.
+   * @returns An array of subscribers, with one member from each matching shared subscription group.
+   */
+  match(topic: string): any[];
+}
+
+interface TopicTrieConstructor {
+
+  /**
+   * Creates an instance of _TopicTrie_.
+   *
+   * @param options Options including:
+   *   - _cacheSize_ - Number of recently published topics whose results are remembered. Defaults to 1000. Set to 0 to disable the cache.
+   * @returns A _TopicTrie_ object.
+   */
+  new(options?: { cacheSize?: number }): TopicTrie;
+}
+
 /**
  * Load-balancer base class.
  */
@@ -323,8 +516,11 @@ interface LoadBalancerResource {
 
 interface Algo {
   Cache: CacheConstructor;
+  SharedCache: SharedCacheConstructor;
   Quota: QuotaConstructor;
   URLRouter: URLRouterConstructor;
+  IPSet: IPSetConstructor;
+  TopicTrie: TopicTrieConstructor;
   HashingLoadBalancer: HashingLoadBalancerConstructor;
   RoundRobinLoadBalancer: RoundRobinLoadBalancerConstructor;
   LeastWorkLoadBalancer: LeastWorkLoadBalancerConstructor;
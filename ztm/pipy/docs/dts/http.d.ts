@@ -94,10 +94,14 @@ interface HttpDirectory {
   /**
    * Generates a response for a static file request.
    *
+   * With _cache_, a _Promise_ is returned instead when the file has to be
+   * loaded or gzipped first, which is done without blocking the current thread.
+   *
    * @param request A _Message_ object requesting a static file.
-   * @returns A _Message_ object containing the HTTP response for the static file.
+   * @returns A _Message_ object containing the HTTP response for the static file,
+   *   or a _Promise_ of it, or _null_ if the file is not found.
    */
-  serve(request: Message): Message;
+  serve(request: Message): Message | Promise<Message> | null;
 }
 
 interface HttpDirectoryConstructor {
@@ -105,6 +109,15 @@ interface HttpDirectoryConstructor {
   /**
    * Creates an instance of _Directory_.
    *
+   * When _cache_ is true (requires _fs_), files are loaded into memory and kept
+   * in a cache shared by all threads, bounded by _cacheSize_ in bytes
+   * (default 64MB, the largest value requested by any directory wins).
+   * Files larger than that are loaded again for every request.
+   * In this mode, responses carry _ETag_ and _Last-Modified_ headers, and
+   * conditional requests and single byte ranges are honored. Files are
+   * reloaded when their size or modification time changes. Bodies gzipped
+   * on the fly by _compression_ are cached along with the files.
+   *
    * @param path Path of the directory.
    * @returns An instance of _http.File_ created from the file.
    */
@@ -113,6 +126,8 @@ interface HttpDirectoryConstructor {
     options?: {
       fs?: boolean,
       tarball?: boolean,
+      cache?: boolean,
+      cacheSize?: number | string,
       index?: string[],
       contentTypes?: (
         { [extension: string]: string } |
@@ -45,6 +45,19 @@ interface OS {
    */
   readFile(filename: string): Data;
 
+  /**
+   * Read the entire content of a file without blocking the current thread.
+   *
+   * @param filename Pathname of the file to read.
+   * @param options Options including:
+   *   - _cache_ - Get the content from the file cache shared by all threads, where it is
+   *     kept for later reads as long as it fits in the _cacheSize_ of any _http.Directory_
+   *     with the _cache_ option. The file is reloaded when its size or modification time
+   *     changes. Defaults to _false_.
+   * @returns A _Promise_ that resolves to a _Data_ object containing the entire content of the file.
+   */
+  readFileAsync(filename: string, options?: { cache?: boolean }): Promise<Data>;
+
   /**
    * Write the entire content of a file.
    *
@@ -53,6 +66,15 @@ interface OS {
    */
   writeFile(filename: string, content: Data | string): void;
 
+  /**
+   * Write the entire content of a file without blocking the current thread.
+   *
+   * @param filename Pathname of the file to write.
+   * @param content A string or a _Data_ object containing the entire content of the file.
+   * @returns A _Promise_ that resolves when the file is written.
+   */
+  writeFileAsync(filename: string, content: Data | string): Promise<void>;
+
   /**
    * Retrieves information about a file.
    *
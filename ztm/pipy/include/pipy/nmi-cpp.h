@@ -185,6 +185,7 @@ class Data : public Local {
 public:
   Data() : Data(pipy_Data_new(nullptr, 0)) {}
   Data(const char *buf, size_t len) : Data(pipy_Data_new(buf, len)) {}
+  Data(const char *buf, size_t len, fn_object_free free, void *user_ptr) : Data(pipy_Data_new_external(buf, len, free, user_ptr)) {}
 
   auto size() const -> size_t { return pipy_Data_get_size(m_id); }
   auto read(char *buf, size_t len) const -> size_t { return pipy_Data_get_data(m_id, buf, len); }
@@ -192,6 +193,17 @@ public:
   auto pop(size_t len) -> Data { return Data(pipy_Data_pop(m_id, len)); }
   auto shift(size_t len) -> Data { return Data(pipy_Data_shift(m_id, len)); }
 
+  template<class F>
+  void for_each_chunk(F f) const {
+    pipy_Data_iterate(
+      m_id,
+      [](const char *ptr, int len, void *user_ptr) -> int {
+        return (*static_cast<F*>(user_ptr))(ptr, len);
+      },
+      &f
+    );
+  }
+
 protected:
   Data(const pjs_value value) : Local(value) {}
 
@@ -214,6 +226,7 @@ public:
   void hold() { pipy_hold(m_id); }
   void free() { pipy_free(m_id); }
   void output(Local evt) { pipy_output_event(m_id, evt.id()); }
+  void output(pjs_value evts[], int count) { pipy_output_events(m_id, evts, count); }
 
 private:
   pipy_pipeline m_id;
@@ -0,0 +1,36 @@
+#include <pipy/nmi.h>
+#include <stdlib.h>
+
+/*
+ * Copies every Data event out into a buffer and back into a new Data,
+ * one event per call, as modules had to before zero-copy access.
+ */
+
+static void copy_process(pipy_pipeline ppl, void *user_ptr, pjs_value evt) {
+  if (pipy_is_Data(evt)) {
+    int n = pipy_Data_get_size(evt);
+    char *buf = malloc(n);
+    pipy_Data_get_data(evt, buf, n);
+    pipy_output_event(ppl, pipy_Data_new(buf, n));
+    free(buf);
+  } else {
+    pipy_output_event(ppl, evt);
+  }
+}
+
+/*
+ * Receives all events queued in one round and passes them through
+ * without touching their data.
+ */
+
+static void batch_process(pipy_pipeline ppl, void *user_ptr, pjs_value evts[], int count) {
+  pipy_output_events(ppl, evts, count);
+}
+
+static void pipeline_init(pipy_pipeline ppl, void **user_ptr) {}
+static void pipeline_free(pipy_pipeline ppl, void *user_ptr) {}
+
+void pipy_module_init() {
+  pipy_define_pipeline("copy", pipeline_init, pipeline_free, copy_process);
+  pipy_define_pipeline_batch("batch", pipeline_init, pipeline_free, batch_process);
+}
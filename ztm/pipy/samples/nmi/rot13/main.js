@@ -0,0 +1,3 @@
+pipy()
+  .listen(8080)
+  .use('../../../bin/rot13.so', os.env.MODE || 'batch')
@@ -0,0 +1,66 @@
+#include <pipy/nmi.h>
+#include <stdlib.h>
+
+static void rot13(const char *src, char *dst, int len) {
+  int i;
+  for (i = 0; i < len; i++) {
+    char c = src[i];
+    if ('a' <= c && c <= 'z') c = 'a' + (c - 'a' + 13) % 26;
+    else if ('A' <= c && c <= 'Z') c = 'A' + (c - 'A' + 13) % 26;
+    dst[i] = c;
+  }
+}
+
+/*
+ * Copies every Data event out, transforms it in place and copies
+ * the result into a new Data, one event per call.
+ */
+
+static void copy_process(pipy_pipeline ppl, void *user_ptr, pjs_value evt) {
+  if (pipy_is_Data(evt)) {
+    int n = pipy_Data_get_size(evt);
+    char *buf = malloc(n);
+    pipy_Data_get_data(evt, buf, n);
+    rot13(buf, buf, n);
+    pipy_output_event(ppl, pipy_Data_new(buf, n));
+    free(buf);
+  } else {
+    pipy_output_event(ppl, evt);
+  }
+}
+
+/*
+ * Reads the chunks of every Data event in place, transforms them
+ * into a buffer of our own and hands that buffer over to the output
+ * Data, which frees it when it's no longer referenced.
+ */
+
+static int transform_chunk(const char *ptr, int len, void *user_ptr) {
+  char **p = (char **)user_ptr;
+  rot13(ptr, *p, len);
+  *p += len;
+  return 1;
+}
+
+static void batch_process(pipy_pipeline ppl, void *user_ptr, pjs_value evts[], int count) {
+  int i;
+  for (i = 0; i < count; i++) {
+    pjs_value evt = evts[i];
+    if (pipy_is_Data(evt)) {
+      int n = pipy_Data_get_size(evt);
+      char *buf = malloc(n);
+      char *p = buf;
+      pipy_Data_iterate(evt, transform_chunk, &p);
+      evts[i] = pipy_Data_new_external(buf, n, free, buf);
+    }
+  }
+  pipy_output_events(ppl, evts, count);
+}
+
+static void pipeline_init(pipy_pipeline ppl, void **user_ptr) {}
+static void pipeline_free(pipy_pipeline ppl, void *user_ptr) {}
+
+void pipy_module_init() {
+  pipy_define_pipeline("copy", pipeline_init, pipeline_free, copy_process);
+  pipy_define_pipeline_batch("batch", pipeline_init, pipeline_free, batch_process);
+}
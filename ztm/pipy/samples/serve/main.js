@@ -42,7 +42,10 @@ config.http.forEach(
             }
             break
           case 'files':
-            service.files = new http.Directory(service.path)
+            service.files = new http.Directory(
+              service.path,
+              service.cacheSize ? { fs: true, cache: true, cacheSize: service.cacheSize } : null
+            )
             break
           default: throw `Unknown service type '${service.type}'`
         }
@@ -73,7 +76,7 @@ config.http.forEach(
     var serveFiles = pipeline($=>$
       .replaceData()
       .replaceMessage(
-        req => $service.files.serve(req) || page404
+        req => Promise.resolve($service.files.serve(req)).then(res => res || page404)
       )
     )
 
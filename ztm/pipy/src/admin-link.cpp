@@ -124,8 +124,8 @@ void AdminLink::close() {
 // AdminLink::Receiver
 //
 
-auto AdminLink::Receiver::clone() -> Filter* {
-  return new Receiver(m_admin_link);
+auto AdminLink::Receiver::clone(Arena *arena) -> Filter* {
+  return new (arena) Receiver(m_admin_link);
 }
 
 void AdminLink::Receiver::reset() {
@@ -83,7 +83,7 @@ private:
     Receiver(AdminLink *admin_link) : m_admin_link(admin_link) {}
 
   private:
-    virtual auto clone() -> Filter* override;
+    virtual auto clone(Arena *arena) -> Filter* override;
     virtual void reset() override;
     virtual void process(Event *evt) override;
     virtual void dump(Dump &d) override;
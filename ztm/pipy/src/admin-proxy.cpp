@@ -52,8 +52,8 @@ public:
     , m_proxy(r.m_proxy) {}
 
 private:
-  virtual auto clone() -> Filter* override {
-    return new AdminProxyHandler(*this);
+  virtual auto clone(Arena *arena) -> Filter* override {
+    return new (arena) AdminProxyHandler(*this);
   }
 
   virtual void reset() override {
@@ -199,7 +199,7 @@ auto AdminProxy::handle(http::RequestHead *head) -> Message* {
         pjs::Context ctx(nullptr);
         pjs::Ref<Message> req = Message::make(head, nullptr);
         if (auto response = m_gui_files->serve(ctx, req)) {
-          return response;
+          return response->as<Message>(); // Not cached, so never a Promise
         } else {
           return m_response_not_found.get();
         }
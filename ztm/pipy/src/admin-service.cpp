@@ -39,6 +39,7 @@
 #include "worker-thread.hpp"
 #include "module.hpp"
 #include "status.hpp"
+#include "tar.hpp"
 #include "graph.hpp"
 #include "compressor.hpp"
 #include "fs.hpp"
@@ -105,6 +106,17 @@ AdminService::AdminService(
     return Message::make(head, nullptr);
   };
 
+  // Tell the reporting instances that delta metrics are accepted
+  auto create_response_partial = []() -> Message* {
+    auto head = http::ResponseHead::make();
+    auto headers = pjs::Object::make();
+    headers->ht_set("server", s_server_name);
+    headers->ht_set("x-pipy-metrics", "delta");
+    head->headers = headers;
+    head->status = 206;
+    return Message::make(head, nullptr);
+  };
+
   m_response_head_text = create_response_head("text/plain", false);
   m_response_head_json = create_response_head("application/json", false);
   m_response_head_text_gzip = create_response_head("text/plain", true);
@@ -112,7 +124,7 @@ AdminService::AdminService(
   m_response_ok = create_response(200);
   m_response_created = create_response(201);
   m_response_deleted = create_response(204);
-  m_response_partial = create_response(206);
+  m_response_partial = create_response_partial();
   m_response_not_found = create_response(404);
   m_response_method_not_allowed = create_response(405);
 
@@ -337,6 +349,18 @@ auto AdminService::handle(Context *ctx, Message *req) -> pjs::Object* {
         return m_response_method_not_allowed;
       }
 
+    // GET|POST|DELETE /profile
+    } else if (path == "/profile") {
+      if (method == "GET") {
+        return profile_GET();
+      } else if (method == "POST") {
+        return profile_POST();
+      } else if (method == "DELETE") {
+        return profile_DELETE();
+      } else {
+        return m_response_method_not_allowed;
+      }
+
     // GET|POST /options
     } else if (path == "/options") {
       if (method == "GET") {
@@ -383,9 +407,9 @@ auto AdminService::handle(Context *ctx, Message *req) -> pjs::Object* {
           path = path.substr(prefix_repo.length() - 1);
           if (path == "/") path.clear();
           if (method == "HEAD") {
-            return repo_HEAD(path);
+            return repo_HEAD(path, headers);
           } else if (method == "GET") {
-            return repo_GET(path);
+            return repo_GET(path, headers);
           } else if (method == "POST") {
             return repo_POST(ctx, path, body);
           } else {
@@ -602,7 +626,9 @@ Message* AdminService::dump_GET(const std::string &path) {
     auto &status = WorkerManager::get().status();
     auto items = utils::split(path, '+');
     for (const auto &item : items) {
-      if (item == "pools") {
+      if (item == "modules") {
+        status.dump_modules(db);
+      } else if (item == "pools") {
         status.dump_pools(db);
       } else if (item == "objects") {
         status.dump_objects(db);
@@ -612,6 +638,8 @@ Message* AdminService::dump_GET(const std::string &path) {
         status.dump_buffers(db);
       } else if (item == "pipelines") {
         status.dump_pipelines(db);
+      } else if (item == "filters") {
+        status.dump_filters(db);
       } else if (item == "inbound") {
         status.dump_inbound(db);
       } else if (item == "outbound") {
@@ -642,6 +670,30 @@ Message* AdminService::log_GET(const std::string &path) {
   }
 }
 
+//
+// Filter profiling is started by POST and stopped by DELETE.
+// GET returns what's been collected as folded stacks for flame graphs.
+// A table of the same is available at /dump/filters.
+//
+
+Message* AdminService::profile_GET() {
+  Data buf;
+  Data::Builder db(buf, &s_dp);
+  WorkerManager::get().status().dump_filters_folded(db);
+  db.flush();
+  return response(buf);
+}
+
+Message* AdminService::profile_POST() {
+  WorkerManager::get().profile(true);
+  return m_response_created;
+}
+
+Message* AdminService::profile_DELETE() {
+  WorkerManager::get().profile(false);
+  return m_response_deleted;
+}
+
 Message* AdminService::metrics_GET(pjs::Object *headers) {
   thread_local static pjs::ConstStr s_accept_encoding("accept-encoding");
   static const std::string s_gzip("gzip");
@@ -743,10 +795,27 @@ Message* AdminService::options_POST(Data *data) {
   );
 }
 
-Message* AdminService::repo_HEAD(const std::string &path) {
+//
+// A codebase is bundled for clients accepting application/x-tar,
+// on HEAD as well as GET so that both come with the same ETag
+//
+
+static bool is_bundle_request(const std::string &path, pjs::Object *headers) {
+  thread_local static pjs::ConstStr s_accept("accept");
+  static const std::string s_application_x_tar("application/x-tar");
+  if (path.empty() || path.back() != '/') return false;
+  pjs::Value accept;
+  if (headers) headers->get(s_accept, accept);
+  return accept.is_string() && accept.s()->str().find(s_application_x_tar) != std::string::npos;
+}
+
+Message* AdminService::repo_HEAD(const std::string &path, pjs::Object *headers) {
   Data buf;
   std::string version;
   if (m_store->find_file(path, buf, version)) {
+    if (is_bundle_request(path, headers)) {
+      return repo_bundle(path, buf, version);
+    }
     return Message::make(
       response_head(200, {
         { "etag", version },
@@ -758,10 +827,24 @@ Message* AdminService::repo_HEAD(const std::string &path) {
   return m_response_not_found;
 }
 
-Message* AdminService::repo_GET(const std::string &path) {
+Message* AdminService::repo_GET(const std::string &path, pjs::Object *headers) {
+  thread_local static pjs::ConstStr s_if_none_match("if-none-match");
+
   Data buf;
   std::string version;
   if (m_store->find_file(path, buf, version)) {
+    pjs::Value if_none_match;
+    if (headers) headers->get(s_if_none_match, if_none_match);
+    if (is_bundle_request(path, headers)) {
+      return repo_bundle(path, buf, version);
+    } else if (!path.empty() && path.back() != '/' && if_none_match.is_string() && if_none_match.s()->str() == version) {
+      return Message::make(
+        response_head(304, {
+          { "etag", version },
+        }),
+        nullptr
+      );
+    }
     return Message::make(
       response_head(200, {
         { "etag", version },
@@ -783,6 +866,42 @@ Message* AdminService::repo_GET(const std::string &path) {
   );
 }
 
+//
+// Packs all files listed in a codebase manifest into one tarball
+// so that a codebase can be downloaded in one request. The first
+// file in the manifest is the entry. The ETag goes with the content
+// of the files, since files can change without a new manifest.
+//
+
+Message* AdminService::repo_bundle(const std::string &path, const Data &manifest, const std::string &version) {
+  auto base = path.substr(0, path.length() - 1);
+  auto lines = utils::split(manifest.to_string(), '\n');
+  pjs::Ref<crypto::Hash> hash = crypto::Hash::make("sha1");
+  std::string tarball, entry;
+  for (const auto &line : lines) {
+    auto name = utils::trim(line);
+    if (name.empty()) continue;
+    Data data;
+    std::string file_version;
+    if (!m_store->find_file(base + name, data, file_version)) continue;
+    if (entry.empty()) entry = name;
+    auto str = data.to_string();
+    Tarball::write(tarball, name, str.c_str(), str.length());
+    hash->update(name + '\n' + std::to_string(str.length()) + '\n');
+    hash->update(str);
+  }
+  Tarball::write_end(tarball);
+  pjs::Ref<pjs::Str> digest(hash->digest(Data::Encoding::hex));
+  return Message::make(
+    response_head(200, {
+      { "etag", version + '-' + digest->str() },
+      { "content-type", "application/x-tar" },
+      { "x-pipy-entry", entry },
+    }),
+    Data::make(tarball, &s_dp)
+  );
+}
+
 Message* AdminService::repo_POST(Context *ctx, const std::string &path, Data *data) {
   if (path.back() == '/') {
     auto name = path.substr(0, path.length() - 1);
@@ -1512,8 +1631,8 @@ void AdminService::inactive_instance_removal_step() {
 // AdminService::WebSocketHandler
 //
 
-auto AdminService::WebSocketHandler::clone() -> Filter* {
-  return new AdminService::WebSocketHandler(*this);
+auto AdminService::WebSocketHandler::clone(Arena *arena) -> Filter* {
+  return new (arena) AdminService::WebSocketHandler(*this);
 }
 
 void AdminService::WebSocketHandler::reset() {
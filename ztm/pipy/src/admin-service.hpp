@@ -94,7 +94,7 @@ private:
     void signal_reload();
 
   private:
-    virtual auto clone() -> Filter* override;
+    virtual auto clone(Arena *arena) -> Filter* override;
     virtual void reset() override;
     virtual void process(Event *evt) override;
     virtual void dump(Dump &d) override;
@@ -211,11 +211,15 @@ private:
   Message* log_GET();
   Message* log_GET(const std::string &path);
   Message* metrics_GET(pjs::Object *headers);
+  Message* profile_GET();
+  Message* profile_POST();
+  Message* profile_DELETE();
   Message* options_GET();
   Message* options_POST(Data *data);
 
-  Message* repo_HEAD(const std::string &path);
-  Message* repo_GET(const std::string &path);
+  Message* repo_HEAD(const std::string &path, pjs::Object *headers = nullptr);
+  Message* repo_GET(const std::string &path, pjs::Object *headers = nullptr);
+  Message* repo_bundle(const std::string &path, const Data &manifest, const std::string &version);
   Message* repo_POST(Context *ctx, const std::string &path, Data *data);
 
   Message* api_v1_repo_GET(const std::string &path);
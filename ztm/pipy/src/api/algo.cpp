@@ -24,11 +24,15 @@
  */
 
 #include "algo.hpp"
+#include "api/ip.hpp"
 #include "context.hpp"
+#include "inbound.hpp"
 #include "utils.hpp"
 #include "log.hpp"
 
 #include <algorithm>
+#include <limits>
+#include <vector>
 
 namespace pipy {
 namespace algo {
@@ -225,6 +229,470 @@ void Cache::set(
   }
 }
 
+//
+// Epoch
+//
+// Epoch-based reclamation of memory that lock-free readers might still see.
+// Readers announce the global epoch they started in, and retired objects
+// are only deleted after every reader that might have seen them has left.
+//
+
+class Epoch {
+  struct Reader {
+    std::atomic<uint64_t> epoch;
+    std::atomic<bool> used;
+    Reader* next = nullptr;
+    int depth = 0;
+    Reader() : epoch(0), used(true) {}
+  };
+
+public:
+
+  //
+  // Epoch::Guard
+  //
+
+  class Guard {
+  public:
+    Guard() : m_reader(reader()) {
+      if (!m_reader->depth++) {
+        m_reader->epoch.store(s_current.load());
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+      }
+    }
+
+    ~Guard() {
+      if (!--m_reader->depth) {
+        m_reader->epoch.store(0, std::memory_order_release);
+      }
+    }
+
+  private:
+    Reader* m_reader;
+  };
+
+  static void retire(const std::function<void()> &deleter) {
+    std::vector<std::function<void()>> reclaimed;
+    {
+      std::lock_guard<std::mutex> lock(s_retired_mutex);
+      s_retired.push_back({ s_current.fetch_add(1), deleter });
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (s_retired.size() < RECLAIM_THRESHOLD) return;
+      auto min = std::numeric_limits<uint64_t>::max();
+      for (auto *r = s_readers.load(std::memory_order_acquire); r; r = r->next) {
+        auto e = r->epoch.load();
+        if (e && e < min) min = e;
+      }
+      auto i = std::remove_if(
+        s_retired.begin(), s_retired.end(),
+        [&](Retired &r) {
+          if (r.epoch >= min) return false;
+          reclaimed.push_back(std::move(r.deleter));
+          return true;
+        }
+      );
+      s_retired.erase(i, s_retired.end());
+    }
+    for (const auto &f : reclaimed) f();
+  }
+
+private:
+  enum { RECLAIM_THRESHOLD = 64 };
+
+  struct Retired {
+    uint64_t epoch;
+    std::function<void()> deleter;
+  };
+
+  struct ThreadReader {
+    Reader *r = nullptr;
+    ~ThreadReader() { if (r) r->used.store(false); }
+  };
+
+  static auto reader() -> Reader* {
+    thread_local static ThreadReader s_thread_reader;
+    auto r = s_thread_reader.r;
+    if (!r) {
+      std::lock_guard<std::mutex> lock(s_readers_mutex);
+      for (r = s_readers.load(); r; r = r->next) {
+        bool used = false;
+        if (r->used.compare_exchange_strong(used, true)) break;
+      }
+      if (!r) {
+        r = new Reader;
+        r->next = s_readers.load();
+        s_readers.store(r, std::memory_order_release);
+      }
+      s_thread_reader.r = r;
+    }
+    return r;
+  }
+
+  static std::atomic<uint64_t> s_current;
+  static std::atomic<Reader*> s_readers;
+  static std::mutex s_readers_mutex;
+  static std::vector<Retired> s_retired;
+  static std::mutex s_retired_mutex;
+};
+
+std::atomic<uint64_t> Epoch::s_current(1);
+std::atomic<Epoch::Reader*> Epoch::s_readers(nullptr);
+std::mutex Epoch::s_readers_mutex;
+std::vector<Epoch::Retired> Epoch::s_retired;
+std::mutex Epoch::s_retired_mutex;
+
+//
+// SharedCache::Options
+//
+
+SharedCache::Options::Options(pjs::Object *options) {
+  Value(options, "key")
+    .get(key)
+    .check();
+  Value(options, "size")
+    .get(size)
+    .check_nullable();
+  Value(options, "ttl")
+    .get_seconds(ttl)
+    .check_nullable();
+  Value(options, "eviction")
+    .get_enum(eviction)
+    .check_nullable();
+}
+
+//
+// SharedCache
+//
+
+SharedCache::SharedCache(const Options &options, pjs::Function *allocate)
+  : m_storage(Storage::get(options.key->str(), options))
+  , m_allocate(allocate)
+{
+}
+
+SharedCache::~SharedCache() {
+}
+
+bool SharedCache::get(pjs::Context &ctx, const pjs::Value &key, pjs::Value &value) {
+  std::string k;
+  to_key(key, k);
+  if (m_storage->find(k, value)) return true;
+  if (!m_allocate) return false;
+  pjs::Value arg(key);
+  (*m_allocate)(ctx, 1, &arg, value);
+  if (!ctx.ok()) return false;
+  m_storage->set(k, value);
+  return true;
+}
+
+void SharedCache::set(const pjs::Value &key, const pjs::Value &value) {
+  std::string k;
+  to_key(key, k);
+  m_storage->set(k, value);
+}
+
+bool SharedCache::has(const pjs::Value &key) {
+  pjs::Value value;
+  return find(key, value);
+}
+
+bool SharedCache::find(const pjs::Value &key, pjs::Value &value) {
+  std::string k;
+  to_key(key, k);
+  return m_storage->find(k, value);
+}
+
+bool SharedCache::remove(const pjs::Value &key) {
+  std::string k;
+  to_key(key, k);
+  return m_storage->remove(k);
+}
+
+void SharedCache::clear() {
+  m_storage->clear();
+}
+
+void SharedCache::to_key(const pjs::Value &key, std::string &str) {
+  str = char('0' + int(key.type()));
+  if (key.is_string()) {
+    str += key.s()->str();
+  } else {
+    auto s = key.to_string();
+    str += s->str();
+    s->release();
+  }
+}
+
+//
+// SharedCache::Storage
+//
+
+std::map<std::string, SharedCache::Storage*> SharedCache::Storage::s_storages;
+std::mutex SharedCache::Storage::s_storages_mutex;
+
+auto SharedCache::Storage::get(const std::string &key, const Options &options) -> pjs::Ref<Storage> {
+  std::lock_guard<std::mutex> lock(s_storages_mutex);
+  auto i = s_storages.find(key);
+  if (i != s_storages.end()) {
+    auto p = i->second;
+    if (p->try_retain()) {
+      pjs::Ref<Storage> storage(p);
+      p->release();
+      p->init(options);
+      return storage;
+    }
+  }
+  return new Storage(key, options);
+}
+
+SharedCache::Storage::Storage(const std::string &key, const Options &options)
+  : m_key(key)
+{
+  for (auto &shard : m_shards) {
+    shard.table.store(new Table(INITIAL_BUCKETS));
+    shard.hits.store(0);
+    shard.misses.store(0);
+    shard.random = std::hash<const void*>()(&shard);
+  }
+  init(options);
+  s_storages[key] = this;
+}
+
+SharedCache::Storage::~Storage() {
+  {
+    std::lock_guard<std::mutex> lock(s_storages_mutex);
+    auto i = s_storages.find(m_key);
+    if (i != s_storages.end() && i->second == this) s_storages.erase(i);
+  }
+  for (auto &shard : m_shards) {
+    auto t = shard.table.load();
+    for (size_t i = 0; i <= t->mask; i++) {
+      auto e = t->buckets[i].load();
+      while (e) {
+        auto next = e->next.load();
+        delete e;
+        e = next;
+      }
+    }
+    delete t;
+  }
+}
+
+void SharedCache::Storage::init(const Options &options) {
+  m_size_limit.store(options.size);
+  m_ttl.store(options.ttl * 1000);
+  m_eviction.store(options.eviction);
+}
+
+bool SharedCache::Storage::find(const std::string &key, pjs::Value &value) {
+  auto h = std::hash<std::string>()(key);
+  auto &shard = shard_of(h);
+  Epoch::Guard guard;
+  auto t = shard.table.load(std::memory_order_acquire);
+  auto e = t->buckets[h & t->mask].load(std::memory_order_acquire);
+  while (e) {
+    if (e->hash == h && e->key == key) {
+      auto now = utils::now();
+      if (e->expiration > 0 && now >= e->expiration) break;
+      e->access_time.store(now, std::memory_order_relaxed);
+      e->access_count.fetch_add(1, std::memory_order_relaxed);
+      e->value.to_value(value);
+      shard.hits.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+    e = e->next.load(std::memory_order_acquire);
+  }
+  shard.misses.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+void SharedCache::Storage::set(const std::string &key, const pjs::Value &value) {
+  auto h = std::hash<std::string>()(key);
+  auto now = utils::now();
+  auto ttl = m_ttl.load();
+  auto entry = new Entry(key, h, value, ttl > 0 ? now + ttl : 0);
+  entry->access_time.store(now, std::memory_order_relaxed);
+
+  auto &shard = shard_of(h);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto t = shard.table.load(std::memory_order_relaxed);
+  auto link = &t->buckets[h & t->mask];
+  auto e = link->load(std::memory_order_relaxed);
+  while (e) {
+    if (e->hash == h && e->key == key) {
+      entry->next.store(e->next.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      link->store(entry, std::memory_order_release);
+      Epoch::retire([=]() { delete e; });
+      return;
+    }
+    link = &e->next;
+    e = link->load(std::memory_order_relaxed);
+  }
+
+  link = &t->buckets[h & t->mask];
+  entry->next.store(link->load(std::memory_order_relaxed), std::memory_order_relaxed);
+  link->store(entry, std::memory_order_release);
+  shard.size++;
+
+  auto limit = m_size_limit.load();
+  if (limit > 0 && shard.size > (limit + SHARD_COUNT - 1) / SHARD_COUNT) {
+    evict(shard, now);
+  }
+
+  if (shard.size > 2 * (t->mask + 1)) {
+    grow(shard);
+  }
+}
+
+bool SharedCache::Storage::remove(const std::string &key) {
+  auto h = std::hash<std::string>()(key);
+  auto &shard = shard_of(h);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto t = shard.table.load(std::memory_order_relaxed);
+  auto e = t->buckets[h & t->mask].load(std::memory_order_relaxed);
+  while (e) {
+    if (e->hash == h && e->key == key) {
+      unlink(shard, e);
+      return true;
+    }
+    e = e->next.load(std::memory_order_relaxed);
+  }
+  return false;
+}
+
+void SharedCache::Storage::clear() {
+  for (auto &shard : m_shards) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto t = shard.table.load(std::memory_order_relaxed);
+    shard.table.store(new Table(INITIAL_BUCKETS), std::memory_order_release);
+    shard.size = 0;
+    Epoch::retire(
+      [=]() {
+        for (size_t i = 0; i <= t->mask; i++) {
+          auto e = t->buckets[i].load(std::memory_order_relaxed);
+          while (e) {
+            auto next = e->next.load(std::memory_order_relaxed);
+            delete e;
+            e = next;
+          }
+        }
+        delete t;
+      }
+    );
+  }
+}
+
+void SharedCache::Storage::stats(Stats &stats) {
+  for (auto &shard : m_shards) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    stats.size += shard.size;
+    stats.evictions += shard.evictions;
+    stats.hits += shard.hits.load(std::memory_order_relaxed);
+    stats.misses += shard.misses.load(std::memory_order_relaxed);
+  }
+}
+
+void SharedCache::Storage::unlink(Shard &shard, Entry *entry) {
+  auto t = shard.table.load(std::memory_order_relaxed);
+  auto link = &t->buckets[entry->hash & t->mask];
+  auto e = link->load(std::memory_order_relaxed);
+  while (e) {
+    if (e == entry) {
+      link->store(e->next.load(std::memory_order_relaxed), std::memory_order_release);
+      shard.size--;
+      Epoch::retire([=]() { delete e; });
+      return;
+    }
+    link = &e->next;
+    e = link->load(std::memory_order_relaxed);
+  }
+}
+
+//
+// Approximated LRU/LFU: sample a few random entries
+// and evict the least recently/frequently used one,
+// or any sampled entry that has already expired.
+//
+
+void SharedCache::Storage::evict(Shard &shard, double now) {
+  auto t = shard.table.load(std::memory_order_relaxed);
+  auto n = t->mask + 1;
+  auto lfu = (m_eviction.load() == Eviction::LFU);
+  Entry *samples[EVICTION_SAMPLES];
+  Entry *victim = nullptr;
+  int sample_count = 0;
+
+  for (int i = 0; i < EVICTION_SAMPLES; i++) {
+    auto &r = shard.random;
+    r ^= r << 13; r ^= r >> 17; r ^= r << 5;
+    Entry *e = nullptr;
+    for (size_t j = 0; j < n && !e; j++) {
+      e = t->buckets[(r + j) & t->mask].load(std::memory_order_relaxed);
+    }
+    if (!e) break;
+    for (auto k = (r >> 16) & 3; k > 0; k--) {
+      auto next = e->next.load(std::memory_order_relaxed);
+      if (!next) break;
+      e = next;
+    }
+    if (e->expiration > 0 && now >= e->expiration) {
+      victim = e;
+      break;
+    }
+    samples[sample_count++] = e;
+    if (!victim) {
+      victim = e;
+    } else if (lfu) {
+      auto a = e->access_count.load(std::memory_order_relaxed);
+      auto b = victim->access_count.load(std::memory_order_relaxed);
+      if (a < b || (a == b && e->access_time.load() < victim->access_time.load())) victim = e;
+    } else {
+      if (e->access_time.load(std::memory_order_relaxed) < victim->access_time.load(std::memory_order_relaxed)) victim = e;
+    }
+  }
+
+  if (lfu) {
+    for (int i = 0; i < sample_count; i++) {
+      auto &c = samples[i]->access_count;
+      c.store(c.load(std::memory_order_relaxed) >> 1, std::memory_order_relaxed);
+    }
+  }
+
+  if (victim) {
+    unlink(shard, victim);
+    shard.evictions++;
+  }
+}
+
+void SharedCache::Storage::grow(Shard &shard) {
+  auto old_table = shard.table.load(std::memory_order_relaxed);
+  auto new_table = new Table(2 * (old_table->mask + 1));
+  for (size_t i = 0; i <= old_table->mask; i++) {
+    for (auto e = old_table->buckets[i].load(std::memory_order_relaxed); e; e = e->next.load(std::memory_order_relaxed)) {
+      auto copy = new Entry(e->key, e->hash, e->value, e->expiration);
+      copy->access_time.store(e->access_time.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      copy->access_count.store(e->access_count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      auto &bucket = new_table->buckets[e->hash & new_table->mask];
+      copy->next.store(bucket.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      bucket.store(copy, std::memory_order_relaxed);
+    }
+  }
+  shard.table.store(new_table, std::memory_order_release);
+  Epoch::retire(
+    [=]() {
+      for (size_t i = 0; i <= old_table->mask; i++) {
+        auto e = old_table->buckets[i].load(std::memory_order_relaxed);
+        while (e) {
+          auto next = e->next.load(std::memory_order_relaxed);
+          delete e;
+          e = next;
+        }
+      }
+      delete old_table;
+    }
+  );
+}
+
 //
 // Quota
 //
@@ -645,6 +1113,481 @@ void URLRouter::dump(Node *node, int level) {
   }
 }
 
+//
+// IPSet
+//
+
+IPSet::IPSet(pjs::Object *prefixes)
+  : m_table(new Table)
+{
+  if (prefixes) load(prefixes);
+}
+
+IPSet::~IPSet() {
+}
+
+void IPSet::add(const std::string &cidr, const pjs::Value &value) {
+  add(m_table, cidr, value);
+}
+
+void IPSet::load(pjs::Object *prefixes) {
+  pjs::Ref<Table> table = new Table;
+  if (prefixes) {
+    if (prefixes->is_array()) {
+      prefixes->as<pjs::Array>()->iterate_all(
+        [&](pjs::Value &v, int) {
+          if (v.is<IPMask>()) {
+            add(table, v.as<IPMask>()->to_string(), true);
+          } else {
+            auto s = v.to_string();
+            add(table, s->str(), true);
+            s->release();
+          }
+        }
+      );
+    } else {
+      prefixes->iterate_all(
+        [&](pjs::Str *k, pjs::Value &v) {
+          add(table, k->str(), v);
+        }
+      );
+    }
+  }
+  m_table = table;
+}
+
+bool IPSet::find(const std::string &addr, pjs::Value &value) {
+  uint8_t ipv4[4];
+  uint16_t ipv6[8];
+  const pjs::Value *v = nullptr;
+  if (utils::get_ip_v4(addr, ipv4)) {
+    v = m_table->find(false, Key(IPAddressData(ipv4).v4()));
+  } else if (utils::get_ip_v6(addr, ipv6)) {
+    v = m_table->find(true, Key(ipv6));
+  }
+  if (!v) return false;
+  value = *v;
+  return true;
+}
+
+bool IPSet::find(const IPAddressData &addr, pjs::Value &value) {
+  auto v = (addr.is_v6()
+    ? m_table->find(true, Key(addr.v6()))
+    : m_table->find(false, Key(addr.v4()))
+  );
+  if (!v) return false;
+  value = *v;
+  return true;
+}
+
+bool IPSet::find(const asio::ip::address &addr, pjs::Value &value) {
+  const pjs::Value *v = nullptr;
+  if (addr.is_v4()) {
+    v = m_table->find(false, Key(addr.to_v4().to_uint()));
+  } else {
+    auto a = addr.to_v6();
+    auto b = a.to_bytes();
+    if (a.is_v4_mapped()) {
+      v = m_table->find(false, Key(
+        ((uint32_t)b[12] << 24) |
+        ((uint32_t)b[13] << 16) |
+        ((uint32_t)b[14] <<  8) |
+        ((uint32_t)b[15] <<  0)
+      ));
+    } else {
+      uint16_t ipv6[8];
+      for (int i = 0; i < 8; i++) ipv6[i] = ((uint16_t)b[i*2] << 8) | b[i*2+1];
+      v = m_table->find(true, Key(ipv6));
+    }
+  }
+  if (!v) return false;
+  value = *v;
+  return true;
+}
+
+void IPSet::add(Table *table, const std::string &cidr, const pjs::Value &value) {
+  std::string addr(cidr);
+  int len = -1;
+  auto p = cidr.find('/');
+  if (p != std::string::npos) {
+    addr = cidr.substr(0, p);
+    auto mask = cidr.substr(p + 1);
+    if (mask.empty() || mask.size() > 3) throw std::runtime_error("invalid CIDR notation: " + cidr);
+    len = 0;
+    for (auto c : mask) {
+      if (c < '0' || c > '9') throw std::runtime_error("invalid CIDR notation: " + cidr);
+      len = len * 10 + (c - '0');
+    }
+  }
+
+  uint8_t ipv4[4];
+  uint16_t ipv6[8];
+
+  if (utils::get_ip_v4(addr, ipv4)) {
+    if (len < 0) len = 32;
+    if (len > 32) throw std::runtime_error("IPv4 CIDR mask out of range");
+    table->add(false, Key(IPAddressData(ipv4).v4()), len, value);
+  } else if (utils::get_ip_v6(addr, ipv6)) {
+    if (len < 0) len = 128;
+    if (len > 128) throw std::runtime_error("IPv6 CIDR mask out of range");
+    table->add(true, Key(ipv6), len, value);
+  } else {
+    throw std::runtime_error("invalid CIDR notation: " + cidr);
+  }
+}
+
+//
+// IPSet::Key
+//
+
+static inline auto mask_hi(int len) -> uint64_t {
+  return len <= 0 ? 0 : len >= 64 ? ~uint64_t(0) : ~uint64_t(0) << (64 - len);
+}
+
+static inline auto mask_lo(int len) -> uint64_t {
+  return len <= 64 ? 0 : len >= 128 ? ~uint64_t(0) : ~uint64_t(0) << (128 - len);
+}
+
+static inline auto clz64(uint64_t x) -> int {
+  auto h = uint32_t(x >> 32);
+  return h ? pjs::clz(h) : 32 + pjs::clz(uint32_t(x));
+}
+
+IPSet::Key::Key(const uint16_t v6[]) {
+  for (int i = 0; i < 4; i++) hi = (hi << 16) | v6[i];
+  for (int i = 4; i < 8; i++) lo = (lo << 16) | v6[i];
+}
+
+auto IPSet::Key::masked(int len) const -> Key {
+  Key k;
+  k.hi = hi & mask_hi(len);
+  k.lo = lo & mask_lo(len);
+  return k;
+}
+
+bool IPSet::Key::matches(const Key &k, int len) const {
+  return ((hi ^ k.hi) & mask_hi(len)) == 0 && ((lo ^ k.lo) & mask_lo(len)) == 0;
+}
+
+auto IPSet::Key::common(const Key &k) const -> int {
+  if (auto x = hi ^ k.hi) return clz64(x);
+  if (auto x = lo ^ k.lo) return 64 + clz64(x);
+  return 128;
+}
+
+//
+// IPSet::Table
+//
+
+void IPSet::Table::add(bool v6, const Key &k, int len, const pjs::Value &value) {
+  auto key = k.masked(len);
+
+  auto new_value = [&]() -> int {
+    m_values.push_back(value);
+    return m_values.size() - 1;
+  };
+
+  // Nodes are referred to by index as the array can be reallocated
+  int parent = -1, side = 0;
+  auto link = [&]() -> int& {
+    return parent < 0 ? m_roots[v6] : m_nodes[parent].child[side];
+  };
+
+  for (;;) {
+    auto i = link();
+    if (i < 0) {
+      auto n = node(key, len, new_value());
+      link() = n;
+      return;
+    }
+
+    auto n = m_nodes[i];
+    auto c = std::min(std::min(n.len, len), key.common(n.key));
+
+    // Descend past a shorter prefix of the key
+    if (c == n.len) {
+      if (c == len) {
+        if (n.value >= 0) {
+          m_values[n.value] = value;
+        } else {
+          m_nodes[i].value = new_value();
+        }
+        return;
+      }
+      parent = i;
+      side = key.bit(c);
+      continue;
+    }
+
+    // Insert the key above a longer prefix
+    if (c == len) {
+      auto j = node(key, len, new_value());
+      m_nodes[j].child[n.key.bit(len)] = i;
+      link() = j;
+      return;
+    }
+
+    // Branch out where the key and the prefix diverge
+    auto b = node(key.masked(c), c, -1);
+    auto j = node(key, len, new_value());
+    m_nodes[b].child[n.key.bit(c)] = i;
+    m_nodes[b].child[key.bit(c)] = j;
+    link() = b;
+    return;
+  }
+}
+
+auto IPSet::Table::find(bool v6, const Key &key) const -> const pjs::Value* {
+  const pjs::Value *found = nullptr;
+  auto i = m_roots[v6];
+  while (i >= 0) {
+    const auto &n = m_nodes[i];
+    if (!key.matches(n.key, n.len)) break;
+    if (n.value >= 0) found = &m_values[n.value];
+    if (n.len >= 128) break;
+    i = n.child[key.bit(n.len)];
+  }
+  return found;
+}
+
+auto IPSet::Table::node(const Key &key, int len, int value) -> int {
+  Node n;
+  n.key = key;
+  n.len = len;
+  n.value = value;
+  n.child[0] = -1;
+  n.child[1] = -1;
+  m_nodes.push_back(n);
+  return m_nodes.size() - 1;
+}
+
+//
+// TopicTrie
+//
+
+TopicTrie::Options::Options(pjs::Object *options) {
+  Value(options, "cacheSize")
+    .get(cache_size)
+    .check_nullable();
+}
+
+TopicTrie::TopicTrie(const Options &options)
+  : m_options(options)
+{
+}
+
+TopicTrie::~TopicTrie() {
+}
+
+bool TopicTrie::subscribe(const std::string &filter, const pjs::Value &subscriber) {
+  std::string group;
+  std::vector<std::string> levels;
+  parse(filter, group, levels);
+
+  auto node = &m_root;
+  for (const auto &l : levels) {
+    auto &next = (l == "+" ? node->plus : l == "#" ? node->hash : node->children[l]);
+    if (!next) next = new Node;
+    node = next;
+  }
+
+  if (group.empty()) {
+    if (!node->subscribers.insert(subscriber).second) return false;
+  } else {
+    auto &members = node->groups[group].members;
+    for (const auto &m : members) {
+      if (std::equal_to<pjs::Value>()(m, subscriber)) return false;
+    }
+    members.push_back(subscriber);
+  }
+
+  m_size++;
+  invalidate(levels);
+  return true;
+}
+
+bool TopicTrie::unsubscribe(const std::string &filter, const pjs::Value &subscriber) {
+  std::string group;
+  std::vector<std::string> levels;
+  parse(filter, group, levels);
+
+  std::vector<Node*> path;
+  auto node = &m_root;
+  for (const auto &l : levels) {
+    Node *next = nullptr;
+    if (l == "+") next = node->plus;
+    else if (l == "#") next = node->hash;
+    else {
+      auto i = node->children.find(l);
+      if (i != node->children.end()) next = i->second;
+    }
+    if (!next) return false;
+    path.push_back(node);
+    node = next;
+  }
+
+  if (group.empty()) {
+    if (!node->subscribers.erase(subscriber)) return false;
+  } else {
+    auto i = node->groups.find(group);
+    if (i == node->groups.end()) return false;
+    auto &members = i->second.members;
+    auto j = std::find_if(
+      members.begin(), members.end(),
+      [&](const pjs::Value &m) { return std::equal_to<pjs::Value>()(m, subscriber); }
+    );
+    if (j == members.end()) return false;
+    members.erase(j);
+    if (members.empty()) node->groups.erase(i);
+  }
+
+  m_size--;
+  invalidate(levels);
+
+  // Prune the branch left with nothing in it
+  for (int i = levels.size() - 1; i >= 0 && node->empty(); i--) {
+    auto parent = path[i];
+    const auto &l = levels[i];
+    if (l == "+") parent->plus = nullptr;
+    else if (l == "#") parent->hash = nullptr;
+    else parent->children.erase(l);
+    delete node;
+    node = parent;
+  }
+
+  return true;
+}
+
+auto TopicTrie::match(const std::string &topic) -> pjs::Array* {
+  auto i = m_cache.find(topic);
+  if (i != m_cache.end()) {
+    m_cache_lru.splice(m_cache_lru.end(), m_cache_lru, i->second.lru);
+    return result(i->second);
+  }
+
+  std::vector<Node*> nodes;
+  collect(&m_root, topic, 0, nodes);
+
+  Match m;
+  if (nodes.size() == 1) {
+    auto n = nodes.front();
+    m.subscribers.assign(n->subscribers.begin(), n->subscribers.end());
+  } else if (nodes.size() > 1) {
+    std::unordered_set<pjs::Value> seen;
+    for (auto n : nodes) {
+      for (const auto &s : n->subscribers) {
+        if (seen.insert(s).second) {
+          m.subscribers.push_back(s);
+        }
+      }
+    }
+  }
+  for (auto n : nodes) {
+    for (auto &g : n->groups) {
+      m.groups.push_back(&g.second);
+    }
+  }
+
+  if (m_options.cache_size <= 0) return result(m);
+  if (m_cache.size() >= size_t(m_options.cache_size)) {
+    m_cache.erase(m_cache_lru.front());
+    m_cache_lru.pop_front();
+  }
+  m.lru = m_cache_lru.insert(m_cache_lru.end(), topic);
+  return result(m_cache.emplace(topic, std::move(m)).first->second);
+}
+
+auto TopicTrie::result(const Match &m) -> pjs::Array* {
+  auto a = pjs::Array::make(m.subscribers.size() + m.groups.size());
+  int n = 0;
+  for (const auto &s : m.subscribers) a->set(n++, s);
+
+  // Shared subscriptions take turns among members of each group
+  for (auto g : m.groups) {
+    a->set(n++, g->members[g->next++ % g->members.size()]);
+  }
+  return a;
+}
+
+void TopicTrie::collect(Node *node, const std::string &topic, size_t pos, std::vector<Node*> &nodes) {
+  if (pos == std::string::npos) {
+    nodes.push_back(node);
+    if (auto n = node->hash) nodes.push_back(n);
+    return;
+  }
+
+  // Wildcards at the first level never match topics starting with '$'
+  auto wildcard = (pos > 0 || topic.empty() || topic[0] != '$');
+  auto end = topic.find('/', pos);
+  auto next = (end == std::string::npos ? end : end + 1);
+
+  if (wildcard && node->hash) nodes.push_back(node->hash);
+  if (!node->children.empty()) {
+    auto i = node->children.find(topic.substr(pos, end == std::string::npos ? end : end - pos));
+    if (i != node->children.end()) collect(i->second, topic, next, nodes);
+  }
+  if (wildcard && node->plus) collect(node->plus, topic, next, nodes);
+}
+
+void TopicTrie::invalidate(const std::vector<std::string> &levels) {
+  for (auto i = m_cache.begin(); i != m_cache.end(); ) {
+    if (matches(levels, i->first)) {
+      m_cache_lru.erase(i->second.lru);
+      i = m_cache.erase(i);
+    } else {
+      i++;
+    }
+  }
+}
+
+void TopicTrie::parse(const std::string &filter, std::string &group, std::vector<std::string> &levels) {
+  static const std::string s_share("$share/");
+
+  auto f = filter;
+  if (utils::starts_with(f, s_share)) {
+    auto i = f.find('/', s_share.length());
+    if (i == std::string::npos || i == s_share.length()) {
+      throw std::runtime_error("invalid shared subscription: " + filter);
+    }
+    group = f.substr(s_share.length(), i - s_share.length());
+    f = f.substr(i + 1);
+  }
+
+  if (f.empty()) throw std::runtime_error("empty topic filter");
+
+  size_t p = 0;
+  for (;;) {
+    auto i = f.find('/', p);
+    auto l = f.substr(p, i == std::string::npos ? i : i - p);
+    if (l.find_first_of("+#") != std::string::npos) {
+      if (l.length() > 1 || (l == "#" && i != std::string::npos)) {
+        throw std::runtime_error("invalid wildcard in topic filter: " + filter);
+      }
+    }
+    levels.push_back(std::move(l));
+    if (i == std::string::npos) break;
+    p = i + 1;
+  }
+}
+
+bool TopicTrie::matches(const std::vector<std::string> &levels, const std::string &topic) {
+  size_t pos = 0;
+  for (size_t i = 0; i < levels.size(); i++) {
+    const auto &l = levels[i];
+    auto wildcard = (i > 0 || topic.empty() || topic[0] != '$');
+    if (l == "#") return wildcard;
+    if (pos == std::string::npos) return false;
+    auto end = topic.find('/', pos);
+    if (l == "+") {
+      if (!wildcard) return false;
+    } else if (topic.compare(pos, end == std::string::npos ? end : end - pos, l)) {
+      return false;
+    }
+    pos = (end == std::string::npos ? end : end + 1);
+  }
+  return pos == std::string::npos;
+}
+
 //
 // LoadBalancer
 //
@@ -1501,6 +2444,79 @@ template<> void ClassDef<Constructor<Cache>>::init() {
   ctor();
 }
 
+//
+// SharedCache
+//
+
+template<> void EnumDef<SharedCache::Eviction>::init() {
+  define(SharedCache::Eviction::LRU, "lru");
+  define(SharedCache::Eviction::LFU, "lfu");
+}
+
+template<> void ClassDef<SharedCache>::init() {
+  ctor([](Context &ctx) -> Object* {
+    Function *allocate = nullptr;
+    Object *options = nullptr;
+    if (!ctx.arguments(0, &allocate, &options)) return nullptr;
+    try {
+      return SharedCache::make(options, allocate);
+    } catch (std::runtime_error &err) {
+      ctx.error(err);
+      return nullptr;
+    }
+  });
+
+  method("get", [](Context &ctx, Object *obj, Value &ret) {
+    Value key;
+    if (!ctx.arguments(1, &key)) return;
+    obj->as<SharedCache>()->get(ctx, key, ret);
+  });
+
+  method("set", [](Context &ctx, Object *obj, Value &ret) {
+    Value key, val;
+    if (!ctx.arguments(2, &key, &val)) return;
+    obj->as<SharedCache>()->set(key, val);
+  });
+
+  method("has", [](Context &ctx, Object *obj, Value &ret) {
+    Value key;
+    if (!ctx.arguments(1, &key)) return;
+    ret.set(obj->as<SharedCache>()->has(key));
+  });
+
+  method("find", [](Context &ctx, Object *obj, Value &ret) {
+    Value key;
+    if (!ctx.arguments(1, &key)) return;
+    if (!obj->as<SharedCache>()->find(key, ret)) ret = Value::undefined;
+  });
+
+  method("remove", [](Context &ctx, Object *obj, Value &ret) {
+    Value key;
+    if (!ctx.arguments(1, &key)) return;
+    ret.set(obj->as<SharedCache>()->remove(key));
+  });
+
+  method("clear", [](Context &ctx, Object *obj, Value &ret) {
+    obj->as<SharedCache>()->clear();
+  });
+
+  method("stats", [](Context &ctx, Object *obj, Value &ret) {
+    SharedCache::Storage::Stats stats;
+    obj->as<SharedCache>()->stats(stats);
+    auto o = Object::make();
+    o->set("size", double(stats.size));
+    o->set("hits", double(stats.hits));
+    o->set("misses", double(stats.misses));
+    o->set("evictions", double(stats.evictions));
+    ret.set(o);
+  });
+}
+
+template<> void ClassDef<Constructor<SharedCache>>::init() {
+  super<Function>();
+  ctor();
+}
+
 //
 // Quota
 //
@@ -1593,6 +2609,131 @@ template<> void ClassDef<Constructor<URLRouter>>::init() {
   ctor();
 }
 
+//
+// IPSet
+//
+
+static bool ip_set_find(Context &ctx, IPSet *set, Value &ret) {
+  if (ctx.argc() > 0) {
+    const auto &addr = ctx.arg(0);
+    if (addr.is_string()) {
+      return set->find(addr.s()->str(), ret);
+    } else if (addr.is<IP>()) {
+      return set->find(addr.as<IP>()->data(), ret);
+    } else if (addr.is_instance_of<Inbound>()) {
+      return set->find(addr.as<Inbound>()->remote_ip(), ret);
+    } else if (addr.is<InboundWrapper>()) {
+      auto inbound = addr.as<InboundWrapper>()->get();
+      return inbound && set->find(inbound->remote_ip(), ret);
+    }
+  }
+  ctx.error_argument_type(0, "a string, an IP or an Inbound");
+  return false;
+}
+
+template<> void ClassDef<IPSet>::init() {
+  ctor([](Context &ctx) -> Object* {
+    Object *prefixes = nullptr;
+    if (!ctx.arguments(0, &prefixes)) return nullptr;
+    try {
+      return IPSet::make(prefixes);
+    } catch (std::runtime_error &err) {
+      ctx.error(err);
+      return nullptr;
+    }
+  });
+
+  accessor("size", [](Object *obj, Value &ret) { ret.set(int(obj->as<IPSet>()->size())); });
+
+  method("add", [](Context &ctx, Object *obj, Value &ret) {
+    std::string cidr;
+    Value value(true);
+    if (!ctx.arguments(1, &cidr, &value)) return;
+    try {
+      obj->as<IPSet>()->add(cidr, value);
+    } catch (std::runtime_error &err) {
+      ctx.error(err);
+    }
+  });
+
+  method("load", [](Context &ctx, Object *obj, Value &ret) {
+    Object *prefixes;
+    if (!ctx.arguments(1, &prefixes)) return;
+    try {
+      obj->as<IPSet>()->load(prefixes);
+      ret.set(obj);
+    } catch (std::runtime_error &err) {
+      ctx.error(err);
+    }
+  });
+
+  method("find", [](Context &ctx, Object *obj, Value &ret) {
+    ip_set_find(ctx, obj->as<IPSet>(), ret);
+  });
+
+  method("has", [](Context &ctx, Object *obj, Value &ret) {
+    Value value;
+    ret.set(ip_set_find(ctx, obj->as<IPSet>(), value));
+  });
+}
+
+template<> void ClassDef<Constructor<IPSet>>::init() {
+  super<Function>();
+  ctor();
+}
+
+//
+// TopicTrie
+//
+
+template<> void ClassDef<TopicTrie>::init() {
+  ctor([](Context &ctx) -> Object* {
+    Object *options = nullptr;
+    if (!ctx.arguments(0, &options)) return nullptr;
+    try {
+      return TopicTrie::make(TopicTrie::Options(options));
+    } catch (std::runtime_error &err) {
+      ctx.error(err);
+      return nullptr;
+    }
+  });
+
+  accessor("size", [](Object *obj, Value &ret) { ret.set(int(obj->as<TopicTrie>()->size())); });
+
+  method("subscribe", [](Context &ctx, Object *obj, Value &ret) {
+    std::string filter;
+    Value subscriber;
+    if (!ctx.arguments(2, &filter, &subscriber)) return;
+    try {
+      ret.set(obj->as<TopicTrie>()->subscribe(filter, subscriber));
+    } catch (std::runtime_error &err) {
+      ctx.error(err);
+    }
+  });
+
+  method("unsubscribe", [](Context &ctx, Object *obj, Value &ret) {
+    std::string filter;
+    Value subscriber;
+    if (!ctx.arguments(2, &filter, &subscriber)) return;
+    try {
+      ret.set(obj->as<TopicTrie>()->unsubscribe(filter, subscriber));
+    } catch (std::runtime_error &err) {
+      ctx.error(err);
+    }
+  });
+
+  method("match", [](Context &ctx, Object *obj, Value &ret) {
+    Str *topic;
+    if (!ctx.arguments(1, &topic)) return;
+    ret.set(obj->as<TopicTrie>()->match(topic->str()));
+  });
+}
+
+template<> void ClassDef<Constructor<TopicTrie>>::init() {
+  super<Function>();
+  ctor();
+}
+
 //
 // LoadBalancer
 //
@@ -1869,8 +3010,11 @@ template<> void ClassDef<Constructor<Percentile>>::init() {
 template<> void ClassDef<Algo>::init() {
   ctor();
   variable("Cache", class_of<Constructor<Cache>>());
+  variable("SharedCache", class_of<Constructor<SharedCache>>());
   variable("Quota", class_of<Constructor<Quota>>());
   variable("URLRouter", class_of<Constructor<URLRouter>>());
+  variable("IPSet", class_of<Constructor<IPSet>>());
+  variable("TopicTrie", class_of<Constructor<TopicTrie>>());
   variable("LoadBalancer", class_of<Constructor<LoadBalancer>>());
   variable("HashingLoadBalancer", class_of<Constructor<HashingLoadBalancer>>());
   variable("RoundRobinLoadBalancer", class_of<Constructor<RoundRobinLoadBalancer>>());
@@ -34,12 +34,17 @@
 
 #include <atomic>
 #include <limits>
+#include <list>
 #include <map>
 #include <mutex>
 #include <set>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace pipy {
+
+class IPAddressData;
+
 namespace algo {
 
 //
@@ -93,6 +98,133 @@ private:
   friend class pjs::ObjectTemplate<Cache>;
 };
 
+//
+// SharedCache
+//
+
+class SharedCache : public pjs::ObjectTemplate<SharedCache> {
+public:
+  enum class Eviction {
+    LRU,
+    LFU,
+  };
+
+  struct Options : public pipy::Options {
+    pjs::Ref<pjs::Str> key;
+    int size = 0;
+    double ttl = 0;
+    Eviction eviction = Eviction::LRU;
+
+    Options() {}
+    Options(pjs::Object *options);
+  };
+
+  //
+  // SharedCache::Storage
+  //
+  // Process-wide storage shared by all SharedCache objects with the same key.
+  // Lookups are lock-free, reading immutable entries that are reclaimed
+  // only after all readers have left (epoch-based reclamation).
+  // Updates are serialized with a lock per shard.
+  //
+
+  class Storage : public pjs::RefCountMT<Storage> {
+  public:
+    struct Stats {
+      size_t size = 0;
+      size_t hits = 0;
+      size_t misses = 0;
+      size_t evictions = 0;
+    };
+
+    static auto get(const std::string &key, const Options &options) -> pjs::Ref<Storage>;
+
+    void init(const Options &options);
+    bool find(const std::string &key, pjs::Value &value);
+    void set(const std::string &key, const pjs::Value &value);
+    bool remove(const std::string &key);
+    void clear();
+    void stats(Stats &stats);
+
+  private:
+    Storage(const std::string &key, const Options &options);
+    ~Storage();
+
+    enum {
+      SHARD_COUNT = 16,
+      EVICTION_SAMPLES = 5,
+      INITIAL_BUCKETS = 16,
+    };
+
+    struct Entry {
+      Entry(const std::string &k, size_t h, const pjs::SharedValue &v, double e)
+        : key(k), hash(h), value(v), expiration(e), access_time(0), access_count(0), next(nullptr) {}
+
+      const std::string key;
+      const size_t hash;
+      const pjs::SharedValue value;
+      const double expiration;
+      std::atomic<double> access_time;
+      std::atomic<uint32_t> access_count;
+      std::atomic<Entry*> next;
+    };
+
+    struct Table {
+      Table(size_t n) : buckets(new std::atomic<Entry*>[n]), mask(n - 1) {
+        for (size_t i = 0; i < n; i++) buckets[i].store(nullptr, std::memory_order_relaxed);
+      }
+      ~Table() { delete [] buckets; }
+      std::atomic<Entry*>* buckets;
+      size_t mask;
+    };
+
+    struct Shard {
+      std::mutex mutex;
+      std::atomic<Table*> table;
+      std::atomic<size_t> hits;
+      std::atomic<size_t> misses;
+      size_t size = 0;
+      size_t evictions = 0;
+      uint32_t random = 0;
+    };
+
+    std::string m_key;
+    std::atomic<int> m_size_limit;
+    std::atomic<double> m_ttl;
+    std::atomic<Eviction> m_eviction;
+    Shard m_shards[SHARD_COUNT];
+
+    auto shard_of(size_t hash) -> Shard& { return m_shards[(hash >> 16) % SHARD_COUNT]; }
+    void unlink(Shard &shard, Entry *entry);
+    void evict(Shard &shard, double now);
+    void grow(Shard &shard);
+
+    static std::map<std::string, Storage*> s_storages;
+    static std::mutex s_storages_mutex;
+
+    friend class pjs::RefCountMT<Storage>;
+  };
+
+  bool get(pjs::Context &ctx, const pjs::Value &key, pjs::Value &value);
+  void set(const pjs::Value &key, const pjs::Value &value);
+  bool has(const pjs::Value &key);
+  bool find(const pjs::Value &key, pjs::Value &value);
+  bool remove(const pjs::Value &key);
+  void clear();
+  void stats(Storage::Stats &stats) { m_storage->stats(stats); }
+
+private:
+  SharedCache(const Options &options, pjs::Function *allocate = nullptr);
+  ~SharedCache();
+
+  pjs::Ref<Storage> m_storage;
+  pjs::Ref<pjs::Function> m_allocate;
+
+  static void to_key(const pjs::Value &key, std::string &str);
+
+  friend class pjs::ObjectTemplate<SharedCache>;
+};
+
 //
 // Quota
 //
@@ -286,6 +418,146 @@ private:
   friend class pjs::ObjectTemplate<URLRouter>;
 };
 
+//
+// IPSet
+//
+// A set of IPv4/IPv6 prefixes, each with a value attached, looked up
+// by longest-prefix match. Prefixes live in a path-compressed binary trie
+// kept in one flat array. A reload builds a whole new table before
+// swapping it in, so lookups never see a half-loaded set.
+//
+
+class IPSet : public pjs::ObjectTemplate<IPSet> {
+public:
+  auto size() const -> size_t { return m_table->size(); }
+  void add(const std::string &cidr, const pjs::Value &value);
+  void load(pjs::Object *prefixes);
+  bool find(const std::string &addr, pjs::Value &value);
+  bool find(const IPAddressData &addr, pjs::Value &value);
+  bool find(const asio::ip::address &addr, pjs::Value &value);
+
+private:
+  IPSet(pjs::Object *prefixes = nullptr);
+  ~IPSet();
+
+  struct Key {
+    uint64_t hi = 0;
+    uint64_t lo = 0;
+
+    Key() {}
+    Key(uint32_t v4) : hi(uint64_t(v4) << 32) {}
+    Key(const uint16_t v6[]);
+
+    auto bit(int i) const -> int {
+      return i < 64 ? int(hi >> (63 - i)) & 1 : int(lo >> (127 - i)) & 1;
+    }
+
+    auto masked(int len) const -> Key;
+    bool matches(const Key &k, int len) const;
+    auto common(const Key &k) const -> int;
+  };
+
+  class Table : public pjs::RefCount<Table> {
+  public:
+    auto size() const -> size_t { return m_values.size(); }
+    void add(bool v6, const Key &key, int len, const pjs::Value &value);
+    auto find(bool v6, const Key &key) const -> const pjs::Value*;
+
+  private:
+    struct Node {
+      Key key;
+      int len;
+      int value;
+      int child[2];
+    };
+
+    std::vector<Node> m_nodes;
+    std::vector<pjs::Value> m_values;
+    int m_roots[2] = { -1, -1 };
+
+    auto node(const Key &key, int len, int value) -> int;
+  };
+
+  pjs::Ref<Table> m_table;
+
+  static void add(Table *table, const std::string &cidr, const pjs::Value &value);
+
+  friend class pjs::ObjectTemplate<IPSet>;
+};
+
+//
+// TopicTrie
+//
+// MQTT topic filters with '+' and '#' wildcards and $share groups, each
+// filter holding a set of subscribers. Matching walks the trie level by
+// level and remembers results for the most recently published topics,
+// dropping the least recently published one when the cache is full. A
+// change to a filter only drops the remembered topics it matches.
+//
+
+class TopicTrie : public pjs::ObjectTemplate<TopicTrie> {
+public:
+  struct Options : public pipy::Options {
+    int cache_size = 1000;
+
+    Options() {}
+    Options(pjs::Object *options);
+  };
+
+  auto size() const -> size_t { return m_size; }
+  bool subscribe(const std::string &filter, const pjs::Value &subscriber);
+  bool unsubscribe(const std::string &filter, const pjs::Value &subscriber);
+  auto match(const std::string &topic) -> pjs::Array*;
+
+private:
+  TopicTrie(const Options &options);
+  ~TopicTrie();
+
+  struct Group {
+    std::vector<pjs::Value> members;
+    size_t next = 0;
+  };
+
+  struct Node {
+    std::unordered_map<std::string, Node*> children;
+    Node* plus = nullptr;
+    Node* hash = nullptr;
+    std::unordered_set<pjs::Value> subscribers;
+    std::map<std::string, Group> groups;
+
+    bool empty() const {
+      return children.empty() && !plus && !hash && subscribers.empty() && groups.empty();
+    }
+
+    ~Node() {
+      for (auto &i : children) delete i.second;
+      delete plus;
+      delete hash;
+    }
+  };
+
+  struct Match {
+    std::vector<pjs::Value> subscribers;
+    std::vector<Group*> groups;
+    std::list<std::string>::iterator lru;
+  };
+
+  Options m_options;
+  Node m_root;
+  size_t m_size = 0;
+  std::unordered_map<std::string, Match> m_cache;
+  std::list<std::string> m_cache_lru;
+
+  void collect(Node *node, const std::string &topic, size_t pos, std::vector<Node*> &nodes);
+  void invalidate(const std::vector<std::string> &levels);
+
+  static auto result(const Match &m) -> pjs::Array*;
+  static void parse(const std::string &filter, std::string &group, std::vector<std::string> &levels);
+  static bool matches(const std::vector<std::string> &levels, const std::string &topic);
+
+  friend class pjs::ObjectTemplate<TopicTrie>;
+};
+
 //
 // LoadBalancer
 //
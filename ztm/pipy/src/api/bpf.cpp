@@ -27,6 +27,7 @@
 #include "elf.hpp"
 #include "log.hpp"
 
+#include <algorithm>
 #include <cstring>
 
 #ifdef PIPY_USE_BPF
@@ -34,6 +35,7 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <elf.h>
+#include <sys/mman.h>
 #include <sys/syscall.h>
 
 #include "api/linux/bpf.h"
@@ -69,6 +71,39 @@ static void syscall_error(const char *name) {
   throw std::runtime_error(std::string(msg) + std::strerror(errno));
 }
 
+#ifndef ENOTSUPP
+#define ENOTSUPP 524
+#endif
+
+// Kernels before 5.6 and map types without batch ops
+static bool batch_unsupported(int err) {
+  return (
+    err == EINVAL ||
+    err == ENOTSUPP ||
+    err == EOPNOTSUPP ||
+    err == ENOSYS
+  );
+}
+
+static auto decode_bytes(const uint8_t *buf, int size, CStructBase *type) -> pjs::Object* {
+  Data data(buf, size, &s_dp);
+  if (type) return type->decode(data);
+  return Data::make(std::move(data));
+}
+
+static bool encode_bytes(pjs::Object *obj, CStructBase *type, uint8_t *buf, int size) {
+  std::memset(buf, 0, size);
+  if (obj->is<Data>()) {
+    obj->as<Data>()->to_bytes(buf, size);
+    return true;
+  } else if (type) {
+    pjs::Ref<Data> data = type->encode(obj);
+    data->to_bytes(buf, size);
+    return true;
+  }
+  return false;
+}
+
 #define MAKE_ENTRY(value) { #value, value }
 
 static struct {
@@ -636,91 +671,42 @@ void Map::create() {
   m_id = info.id;
 }
 
-auto Map::keys() -> pjs::Array* {
+auto Map::keys(int batch_size) -> pjs::Array* {
   if (!m_fd) return nullptr;
 
-  uint8_t k[m_key_size];
-
   auto a = pjs::Array::make();
-  uint8_t *p = nullptr;
 
-  union bpf_attr attr;
-  while (!syscall_bpf(
-    BPF_MAP_GET_NEXT_KEY, &attr, attr_size(next_key),
-    [&](union bpf_attr &attr) {
-      attr.map_fd = m_fd;
-      attr.key = (uintptr_t)p;
-      attr.next_key = (uintptr_t)k;
-    }
-  )) {
-    Data data(k, m_key_size, &s_dp);
-    if (m_key_type) {
-      a->push(m_key_type->decode(data));
-    } else {
-      a->push(Data::make(std::move(data)));
-    }
-    p = k;
-  }
-
-  if (errno != ENOENT) {
+  try {
+    for_each(
+      false, batch_size,
+      [&](const uint8_t *k, const uint8_t *v) {
+        a->push(decode_bytes(k, m_key_size, m_key_type));
+      }
+    );
+  } catch (std::runtime_error &) {
     a->retain();
     a->release();
-    syscall_error("BPF_MAP_GET_NEXT_KEY");
+    throw;
   }
 
   return a;
 }
 
-auto Map::entries() -> pjs::Array* {
+auto Map::entries(int batch_size) -> pjs::Array* {
   if (!m_fd) return nullptr;
 
-  uint8_t k[m_key_size];
-  uint8_t v[m_value_size];
-
   auto a = pjs::Array::make();
-  uint8_t *p = nullptr;
 
   try {
-    union bpf_attr attr;
-    while (!syscall_bpf(
-      BPF_MAP_GET_NEXT_KEY, &attr, attr_size(next_key),
-      [&](union bpf_attr &attr) {
-        attr.map_fd = m_fd;
-        attr.key = (uintptr_t)p;
-        attr.next_key = (uintptr_t)k;
-      }
-    )) {
-      if (syscall_bpf(
-        BPF_MAP_LOOKUP_ELEM, &attr, attr_size(flags),
-        [&](union bpf_attr &attr) {
-          attr.map_fd = m_fd;
-          attr.key = (uintptr_t)k;
-          attr.value = (uintptr_t)v;
-        }
-      )) syscall_error("BPF_MAP_LOOKUP_ELEM");
-
-      Data data_k(k, m_key_size, &s_dp);
-      Data data_v(v, m_value_size, &s_dp);
-      auto ent = pjs::Array::make(2);
-      a->push(ent);
-
-      if (m_key_type) {
-        ent->set(0, m_key_type->decode(data_k));
-      } else {
-        ent->set(0, Data::make(std::move(data_k)));
+    for_each(
+      true, batch_size,
+      [&](const uint8_t *k, const uint8_t *v) {
+        auto ent = pjs::Array::make(2);
+        a->push(ent);
+        ent->set(0, decode_bytes(k, m_key_size, m_key_type));
+        ent->set(1, decode_bytes(v, m_value_size, m_value_type));
       }
-
-      if (m_value_type) {
-        ent->set(1, m_value_type->decode(data_v));
-      } else {
-        ent->set(1, Data::make(std::move(data_v)));
-      }
-
-      p = k;
-    }
-
-    if (errno != ENOENT) syscall_error("BPF_MAP_GET_NEXT_KEY");
-
+    );
   } catch (std::runtime_error &) {
     a->retain();
     a->release();
@@ -779,6 +765,64 @@ void Map::remove(pjs::Object *key) {
   }
 }
 
+void Map::update(pjs::Array *entries, int batch_size) {
+  if (!m_fd || !entries) return;
+
+  std::vector<uint8_t> keys(entries->length() * m_key_size);
+  std::vector<uint8_t> values(entries->length() * m_value_size);
+
+  int n = 0;
+  entries->iterate_all(
+    [&](pjs::Value &v, int) {
+      if (!v.is_array()) return;
+      auto ent = v.as<pjs::Array>();
+      pjs::Value key, value;
+      ent->get(0, key);
+      ent->get(1, value);
+      if (!key.is_object() || !value.is_object()) return;
+      if (
+        encode_bytes(key.o(), m_key_type, &keys[n * m_key_size], m_key_size) &&
+        encode_bytes(value.o(), m_value_type, &values[n * m_value_size], m_value_size)
+      ) n++;
+    }
+  );
+
+  update_batch(keys, values, n, batch_size);
+}
+
+void Map::remove(pjs::Array *keys, int batch_size) {
+  if (!m_fd || !keys) return;
+
+  std::vector<uint8_t> buf(keys->length() * m_key_size);
+
+  int n = 0;
+  keys->iterate_all(
+    [&](pjs::Value &v, int) {
+      if (!v.is_object()) return;
+      if (encode_bytes(v.o(), m_key_type, &buf[n * m_key_size], m_key_size)) n++;
+    }
+  );
+
+  delete_batch(buf, n, batch_size);
+}
+
+auto Map::mmap() -> View* {
+  if (!m_fd) return nullptr;
+  if (m_type != BPF_MAP_TYPE_ARRAY || !(m_flags & BPF_F_MMAPABLE)) {
+    throw std::runtime_error("only array maps created with BPF_F_MMAPABLE can be memory-mapped");
+  }
+
+  auto stride = (m_value_size + 7) & ~7;
+  auto page_size = (size_t)sysconf(_SC_PAGESIZE);
+  auto size = ((size_t)stride * m_max_entries + page_size - 1) / page_size * page_size;
+  auto writable = !(m_flags & BPF_F_RDONLY);
+  auto prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+  auto base = ::mmap(nullptr, size, prot, MAP_SHARED, m_fd, 0);
+  if (base == MAP_FAILED) syscall_error("mmap");
+
+  return View::make(this, (uint8_t *)base, size, stride, writable);
+}
+
 void Map::close() {
   ::close(m_fd);
   m_fd = 0;
@@ -840,6 +884,239 @@ void Map::delete_raw(Data *key) {
   )) syscall_error("BPF_MAP_DELETE_ELEM");
 }
 
+void Map::for_each(bool with_values, int batch_size, const std::function<void(const uint8_t *k, const uint8_t *v)> &cb) {
+  if (batch_size > 1 && !m_batch_unsupported) {
+    if (lookup_batch(batch_size, cb)) return;
+  }
+
+  uint8_t k[m_key_size];
+  uint8_t v[m_value_size];
+  uint8_t *p = nullptr;
+
+  union bpf_attr attr;
+  while (!syscall_bpf(
+    BPF_MAP_GET_NEXT_KEY, &attr, attr_size(next_key),
+    [&](union bpf_attr &attr) {
+      attr.map_fd = m_fd;
+      attr.key = (uintptr_t)p;
+      attr.next_key = (uintptr_t)k;
+    }
+  )) {
+    if (with_values) {
+      if (syscall_bpf(
+        BPF_MAP_LOOKUP_ELEM, &attr, attr_size(flags),
+        [&](union bpf_attr &attr) {
+          attr.map_fd = m_fd;
+          attr.key = (uintptr_t)k;
+          attr.value = (uintptr_t)v;
+        }
+      )) syscall_error("BPF_MAP_LOOKUP_ELEM");
+    }
+    cb(k, v);
+    p = k;
+  }
+
+  if (errno != ENOENT) syscall_error("BPF_MAP_GET_NEXT_KEY");
+}
+
+//
+// Walks the map in chunks of batch_size entries with BPF_MAP_LOOKUP_BATCH.
+// Returns false without having visited any entries if the kernel
+// or the map type does not support batch operations.
+//
+
+bool Map::lookup_batch(int batch_size, const std::function<void(const uint8_t *k, const uint8_t *v)> &cb) {
+  std::vector<uint8_t> keys(batch_size * m_key_size);
+  std::vector<uint8_t> values(batch_size * m_value_size);
+
+  // Opaque position tokens: a bucket index for hash maps, a key for others
+  auto token_size = std::max(m_key_size, 8);
+  uint8_t in_batch[token_size];
+  uint8_t out_batch[token_size];
+  bool first = true;
+
+  for (;;) {
+    union bpf_attr attr;
+    bool done = false;
+    if (syscall_bpf(
+      BPF_MAP_LOOKUP_BATCH, &attr, attr_size(batch),
+      [&](union bpf_attr &attr) {
+        attr.batch.in_batch = first ? 0 : (uintptr_t)in_batch;
+        attr.batch.out_batch = (uintptr_t)out_batch;
+        attr.batch.keys = (uintptr_t)keys.data();
+        attr.batch.values = (uintptr_t)values.data();
+        attr.batch.count = batch_size;
+        attr.batch.map_fd = m_fd;
+      }
+    )) {
+      if (errno == ENOENT) {
+        // The last chunk can still carry a few entries
+        done = true;
+      } else if (errno == ENOSPC && !attr.batch.count) {
+        // A single hash bucket holds more entries than the chunk
+        batch_size *= 2;
+        keys.resize(batch_size * m_key_size);
+        values.resize(batch_size * m_value_size);
+        continue;
+      } else if (first && batch_unsupported(errno)) {
+        m_batch_unsupported = true;
+        return false;
+      } else {
+        syscall_error("BPF_MAP_LOOKUP_BATCH");
+      }
+    }
+
+    auto count = attr.batch.count;
+    for (size_t i = 0; i < count; i++) {
+      cb(&keys[i * m_key_size], &values[i * m_value_size]);
+    }
+
+    if (done || !count) break;
+    std::memcpy(in_batch, out_batch, token_size);
+    first = false;
+  }
+
+  return true;
+}
+
+void Map::update_batch(const std::vector<uint8_t> &keys, const std::vector<uint8_t> &values, int count, int batch_size) {
+  int i = 0;
+
+  if (batch_size > 1 && !m_batch_unsupported) {
+    while (i < count) {
+      auto n = std::min(count - i, batch_size);
+      union bpf_attr attr;
+      if (syscall_bpf(
+        BPF_MAP_UPDATE_BATCH, &attr, attr_size(batch),
+        [&](union bpf_attr &attr) {
+          attr.batch.keys = (uintptr_t)&keys[i * m_key_size];
+          attr.batch.values = (uintptr_t)&values[i * m_value_size];
+          attr.batch.count = n;
+          attr.batch.map_fd = m_fd;
+        }
+      )) {
+        if (i == 0 && !attr.batch.count && batch_unsupported(errno)) {
+          m_batch_unsupported = true;
+          break;
+        }
+        syscall_error("BPF_MAP_UPDATE_BATCH");
+      }
+      i += n;
+    }
+  }
+
+  for (; i < count; i++) {
+    union bpf_attr attr;
+    if (syscall_bpf(
+      BPF_MAP_UPDATE_ELEM, &attr, attr_size(flags),
+      [&](union bpf_attr &attr) {
+        attr.map_fd = m_fd;
+        attr.key = (uintptr_t)&keys[i * m_key_size];
+        attr.value = (uintptr_t)&values[i * m_value_size];
+      }
+    )) syscall_error("BPF_MAP_UPDATE_ELEM");
+  }
+}
+
+void Map::delete_batch(const std::vector<uint8_t> &keys, int count, int batch_size) {
+  int i = 0;
+
+  if (batch_size > 1 && !m_batch_unsupported) {
+    while (i < count) {
+      auto n = std::min(count - i, batch_size);
+      union bpf_attr attr;
+      if (syscall_bpf(
+        BPF_MAP_DELETE_BATCH, &attr, attr_size(batch),
+        [&](union bpf_attr &attr) {
+          attr.batch.keys = (uintptr_t)&keys[i * m_key_size];
+          attr.batch.count = n;
+          attr.batch.map_fd = m_fd;
+        }
+      )) {
+        if (i == 0 && !attr.batch.count && batch_unsupported(errno)) {
+          m_batch_unsupported = true;
+          break;
+        }
+        syscall_error("BPF_MAP_DELETE_BATCH");
+      }
+      i += n;
+    }
+  }
+
+  for (; i < count; i++) {
+    union bpf_attr attr;
+    if (syscall_bpf(
+      BPF_MAP_DELETE_ELEM, &attr, attr_size(flags),
+      [&](union bpf_attr &attr) {
+        attr.map_fd = m_fd;
+        attr.key = (uintptr_t)&keys[i * m_key_size];
+      }
+    )) syscall_error("BPF_MAP_DELETE_ELEM");
+  }
+}
+
+//
+// Map::View
+//
+
+Map::View::View(Map *map, uint8_t *base, size_t size, int stride, bool writable)
+  : m_map(map)
+  , m_base(base)
+  , m_size(size)
+  , m_stride(stride)
+  , m_length(map->max_entries())
+  , m_writable(writable)
+{
+}
+
+Map::View::~View() {
+  munmap(m_base, m_size);
+}
+
+void Map::View::get(int i, pjs::Value &ret) {
+  if (i < 0 || i >= m_length) {
+    ret = pjs::Value::undefined;
+    return;
+  }
+
+  auto p = m_base + i * m_stride;
+  auto size = m_map->value_size();
+  if (auto type = m_map->value_type()) {
+    ret.set(decode_bytes(p, size, type));
+  } else {
+    switch (size) {
+      case 1: ret.set(*(const uint8_t *)p); break;
+      case 2: { uint16_t n; std::memcpy(&n, p, 2); ret.set(n); break; }
+      case 4: { uint32_t n; std::memcpy(&n, p, 4); ret.set(n); break; }
+      case 8: { uint64_t n; std::memcpy(&n, p, 8); ret.set((double)n); break; }
+      default: ret.set(decode_bytes(p, size, nullptr)); break;
+    }
+  }
+}
+
+void Map::View::set(int i, const pjs::Value &value) {
+  if (!m_writable) throw std::runtime_error("map is read-only");
+  if (i < 0 || i >= m_length) throw std::runtime_error("index out of range");
+
+  auto p = m_base + i * m_stride;
+  auto size = m_map->value_size();
+  if (value.is_object()) {
+    uint8_t buf[size];
+    if (encode_bytes(value.o(), m_map->value_type(), buf, size)) {
+      std::memcpy(p, buf, size);
+    }
+  } else if (value.is_number() && !m_map->value_type()) {
+    auto n = value.n();
+    switch (size) {
+      case 1: { uint8_t v = n; std::memcpy(p, &v, 1); break; }
+      case 2: { uint16_t v = n; std::memcpy(p, &v, 2); break; }
+      case 4: { uint32_t v = n; std::memcpy(p, &v, 4); break; }
+      case 8: { uint64_t v = n; std::memcpy(p, &v, 8); break; }
+      default: throw std::runtime_error("value is not a scalar");
+    }
+  }
+}
+
 //
 // BPF
 //
@@ -980,12 +1257,12 @@ auto Map::open(int id, CStructBase *key_type, CStructBase *value_type) -> Map* {
   return nullptr;
 }
 
-auto Map::keys() -> pjs::Array* {
+auto Map::keys(int batch_size) -> pjs::Array* {
   unsupported();
   return nullptr;
 }
 
-auto Map::entries() -> pjs::Array* {
+auto Map::entries(int batch_size) -> pjs::Array* {
   unsupported();
   return nullptr;
 }
@@ -999,14 +1276,48 @@ void Map::update(pjs::Object *key, pjs::Object *value) {
   unsupported();
 }
 
+void Map::update(pjs::Array *entries, int batch_size) {
+  unsupported();
+}
+
 void Map::remove(pjs::Object *key) {
   unsupported();
 }
 
+void Map::remove(pjs::Array *keys, int batch_size) {
+  unsupported();
+}
+
+auto Map::mmap() -> View* {
+  unsupported();
+  return nullptr;
+}
+
 void Map::close() {
   unsupported();
 }
 
+Map::View::View(Map *map, uint8_t *base, size_t size, int stride, bool writable)
+  : m_map(map)
+  , m_base(base)
+  , m_size(size)
+  , m_stride(stride)
+  , m_length(0)
+  , m_writable(writable)
+{
+}
+
+Map::View::~View() {
+}
+
+void Map::View::get(int i, pjs::Value &ret) {
+  unsupported();
+}
+
+void Map::View::set(int i, const pjs::Value &value) {
+  unsupported();
+}
+
 void BPF::pin(const std::string &pathname, int fd) {
   unsupported();
 }
@@ -1146,16 +1457,20 @@ template<> void ClassDef<bpf::Map>::init() {
   });
 
   method("keys", [](Context &ctx, Object *obj, Value &ret) {
+    int batch_size = bpf::Map::DEFAULT_BATCH_SIZE;
+    if (!ctx.arguments(0, &batch_size)) return;
     try {
-      ret.set(obj->as<bpf::Map>()->keys());
+      ret.set(obj->as<bpf::Map>()->keys(batch_size));
     } catch (std::runtime_error &err) {
       ctx.error(err);
     }
   });
 
   method("entries", [](Context &ctx, Object *obj, Value &ret) {
+    int batch_size = bpf::Map::DEFAULT_BATCH_SIZE;
+    if (!ctx.arguments(0, &batch_size)) return;
     try {
-      ret.set(obj->as<bpf::Map>()->entries());
+      ret.set(obj->as<bpf::Map>()->entries(batch_size));
     } catch (std::runtime_error &err) {
       ctx.error(err);
     }
@@ -1190,6 +1505,76 @@ template<> void ClassDef<bpf::Map>::init() {
       ctx.error(err);
     }
   });
+
+  method("updateBatch", [](Context &ctx, Object *obj, Value &ret) {
+    Array *entries;
+    int batch_size = bpf::Map::DEFAULT_BATCH_SIZE;
+    if (!ctx.arguments(1, &entries, &batch_size)) return;
+    try {
+      obj->as<bpf::Map>()->update(entries, batch_size);
+    } catch (std::runtime_error &err) {
+      ctx.error(err);
+    }
+  });
+
+  method("deleteBatch", [](Context &ctx, Object *obj, Value &ret) {
+    Array *keys;
+    int batch_size = bpf::Map::DEFAULT_BATCH_SIZE;
+    if (!ctx.arguments(1, &keys, &batch_size)) return;
+    try {
+      obj->as<bpf::Map>()->remove(keys, batch_size);
+    } catch (std::runtime_error &err) {
+      ctx.error(err);
+    }
+  });
+
+  method("mmap", [](Context &ctx, Object *obj, Value &ret) {
+    try {
+      ret.set(obj->as<bpf::Map>()->mmap());
+    } catch (std::runtime_error &err) {
+      ctx.error(err);
+    }
+  });
+}
+
+//
+// Map::View
+//
+
+template<> void ClassDef<bpf::Map::View>::init() {
+  accessor("map", [](Object *obj, Value &ret) { ret.set(obj->as<bpf::Map::View>()->map()); });
+  accessor("length", [](Object *obj, Value &ret) { ret.set(obj->as<bpf::Map::View>()->length()); });
+
+  geti([](Object *obj, int i, Value &ret) {
+    obj->as<bpf::Map::View>()->get(i, ret);
+  });
+
+  seti([](Object *obj, int i, const Value &val) {
+    try {
+      obj->as<bpf::Map::View>()->set(i, val);
+    } catch (std::runtime_error &) {}
+  });
+
+  method("get", [](Context &ctx, Object *obj, Value &ret) {
+    int i;
+    if (!ctx.arguments(1, &i)) return;
+    try {
+      obj->as<bpf::Map::View>()->get(i, ret);
+    } catch (std::runtime_error &err) {
+      ctx.error(err);
+    }
+  });
+
+  method("set", [](Context &ctx, Object *obj, Value &ret) {
+    int i;
+    Value val;
+    if (!ctx.arguments(2, &i, &val)) return;
+    try {
+      obj->as<bpf::Map::View>()->set(i, val);
+    } catch (std::runtime_error &err) {
+      ctx.error(err);
+    }
+  });
 }
 
 template<> void ClassDef<Constructor<bpf::Map>>::init() {
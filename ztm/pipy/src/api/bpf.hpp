@@ -117,6 +117,34 @@ public:
     int valueSize = 0;
   };
 
+  //
+  // Map::View
+  //
+
+  class View : public pjs::ObjectTemplate<View> {
+  public:
+    auto map() const -> Map* { return m_map; }
+    auto length() const -> int { return m_length; }
+
+    void get(int i, pjs::Value &ret);
+    void set(int i, const pjs::Value &value);
+
+  private:
+    View(Map *map, uint8_t *base, size_t size, int stride, bool writable);
+    ~View();
+
+    pjs::Ref<Map> m_map;
+    uint8_t* m_base;
+    size_t m_size;
+    int m_stride;
+    int m_length;
+    bool m_writable;
+
+    friend class pjs::ObjectTemplate<View>;
+  };
+
+  static const int DEFAULT_BATCH_SIZE = 1024;
+
   static auto list() -> pjs::Array*;
   static auto open(int id, CStructBase *key_type = nullptr, CStructBase *value_type = nullptr) -> Map*;
 
@@ -132,11 +160,14 @@ public:
   auto value_type() const -> CStructBase* { return m_value_type; }
 
   void create();
-  auto keys() -> pjs::Array*;
-  auto entries() -> pjs::Array*;
+  auto keys(int batch_size = DEFAULT_BATCH_SIZE) -> pjs::Array*;
+  auto entries(int batch_size = DEFAULT_BATCH_SIZE) -> pjs::Array*;
   auto lookup(pjs::Object *key) -> pjs::Object*;
   void update(pjs::Object *key, pjs::Object *value);
+  void update(pjs::Array *entries, int batch_size = DEFAULT_BATCH_SIZE);
   void remove(pjs::Object *key);
+  void remove(pjs::Array *keys, int batch_size = DEFAULT_BATCH_SIZE);
+  auto mmap() -> View*;
   void close();
 
 private:
@@ -148,6 +179,11 @@ private:
   void update_raw(Data *key, Data *value);
   void delete_raw(Data *key);
 
+  void for_each(bool with_values, int batch_size, const std::function<void(const uint8_t *k, const uint8_t *v)> &cb);
+  bool lookup_batch(int batch_size, const std::function<void(const uint8_t *k, const uint8_t *v)> &cb);
+  void update_batch(const std::vector<uint8_t> &keys, const std::vector<uint8_t> &values, int count, int batch_size);
+  void delete_batch(const std::vector<uint8_t> &keys, int count, int batch_size);
+
   pjs::Ref<pjs::Str> m_name;
   int m_fd;
   int m_id;
@@ -158,6 +194,7 @@ private:
   int m_value_size;
   pjs::Ref<CStructBase> m_key_type;
   pjs::Ref<CStructBase> m_value_type;
+  bool m_batch_unsupported = false;
 
   friend class pjs::ObjectTemplate<Map>;
 };
@@ -146,12 +146,12 @@ void FilterConfigurator::chain_next() {
   append_filter(new ChainNext());
 }
 
-void FilterConfigurator::compress(const pjs::Value &algorithm) {
-  append_filter(new Compress(algorithm));
+void FilterConfigurator::compress(const pjs::Value &algorithm, pjs::Object *options) {
+  append_filter(new Compress(algorithm, options));
 }
 
-void FilterConfigurator::compress_http(const pjs::Value &algorithm) {
-  append_filter(new CompressHTTP(algorithm));
+void FilterConfigurator::compress_http(const pjs::Value &algorithm, pjs::Object *options) {
+  append_filter(new CompressHTTP(algorithm, options));
 }
 
 void FilterConfigurator::connect(const pjs::Value &target, pjs::Object *options) {
@@ -1206,9 +1206,10 @@ template<> void ClassDef<FilterConfigurator>::init() {
   method("compress", [](Context &ctx, Object *thiz, Value &result) {
     auto config = thiz->as<FilterConfigurator>()->trace_location(ctx);
     Value algorithm;
-    if (!ctx.arguments(1, &algorithm)) return;
+    Object *options = nullptr;
+    if (!ctx.arguments(1, &algorithm, &options)) return;
     try {
-      config->compress(algorithm);
+      config->compress(algorithm, options);
       result.set(thiz);
     } catch (std::runtime_error &err) {
       ctx.error(err);
@@ -1219,9 +1220,10 @@ template<> void ClassDef<FilterConfigurator>::init() {
   method("compressHTTP", [](Context &ctx, Object *thiz, Value &result) {
     auto config = thiz->as<FilterConfigurator>()->trace_location(ctx);
     Value algorithm;
-    if (!ctx.arguments(1, &algorithm)) return;
+    Object *options = nullptr;
+    if (!ctx.arguments(1, &algorithm, &options)) return;
     try {
-      config->compress_http(algorithm);
+      config->compress_http(algorithm, options);
       result.set(thiz);
     } catch (std::runtime_error &err) {
       ctx.error(err);
@@ -63,8 +63,8 @@ public:
   void branch_message(int count, pjs::Function **conds, const pjs::Value *layouts);
   void chain(const std::list<JSModule*> modules);
   void chain_next();
-  void compress(const pjs::Value &algorithm);
-  void compress_http(const pjs::Value &algorithm);
+  void compress(const pjs::Value &algorithm, pjs::Object *options);
+  void compress_http(const pjs::Value &algorithm, pjs::Object *options);
   void connect(const pjs::Value &target, pjs::Object *options);
   void connect_http_tunnel(pjs::Object *handshake);
   void connect_proxy_protocol(const pjs::Value &address);
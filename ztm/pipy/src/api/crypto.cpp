@@ -24,7 +24,9 @@
  */
 
 #include "crypto.hpp"
+#include "input.hpp"
 #include "options.hpp"
+#include "thread-pool.hpp"
 #include "utils.hpp"
 #include "api/json.hpp"
 
@@ -39,7 +41,11 @@
 #include <openssl/x509.h>
 #include <openssl/x509v3.h>
 
+#include <algorithm>
+#include <mutex>
 #include <stdexcept>
+#include <unordered_map>
+#include <vector>
 
 namespace pipy {
 namespace crypto {
@@ -67,6 +73,114 @@ static void read_bio(BIO *bio, Data &data) {
   db.flush();
 }
 
+//
+// ContextPool
+//
+// EVP contexts are costly to set up, so each thread keeps some for reuse:
+// idle digest contexts in a free list, and a public-key context for each
+// recently used key. A cached EVP_PKEY_CTX holds a reference to its key,
+// so no other key can show up at the same address while it's cached.
+//
+
+static const size_t MD_CTX_POOL_SIZE = 16;
+static const size_t PKEY_CTX_POOL_SIZE = 16;
+
+class ContextPool {
+public:
+  auto md_ctx() -> EVP_MD_CTX* {
+    if (m_md_ctxs.empty()) {
+      auto ctx = EVP_MD_CTX_new();
+      if (!ctx) throw_error();
+      return ctx;
+    }
+    auto ctx = m_md_ctxs.back();
+    m_md_ctxs.pop_back();
+    return ctx;
+  }
+
+  void free(EVP_MD_CTX *ctx) {
+    if (m_md_ctxs.size() < MD_CTX_POOL_SIZE) {
+      EVP_MD_CTX_reset(ctx);
+      m_md_ctxs.push_back(ctx);
+    } else {
+      EVP_MD_CTX_free(ctx);
+    }
+  }
+
+  auto pkey_ctx(EVP_PKEY *pkey) -> EVP_PKEY_CTX* {
+    auto i = m_pkey_ctxs.find(pkey);
+    if (i != m_pkey_ctxs.end()) return i->second;
+    auto ctx = EVP_PKEY_CTX_new(pkey, nullptr);
+    if (!ctx) throw_error();
+    if (m_pkey_ctxs.size() >= PKEY_CTX_POOL_SIZE) {
+      for (const auto &p : m_pkey_ctxs) EVP_PKEY_CTX_free(p.second);
+      m_pkey_ctxs.clear();
+    }
+    m_pkey_ctxs[pkey] = ctx;
+    return ctx;
+  }
+
+private:
+  std::vector<EVP_MD_CTX*> m_md_ctxs;
+  std::unordered_map<EVP_PKEY*, EVP_PKEY_CTX*> m_pkey_ctxs;
+};
+
+//
+// Never destructed, as objects going away late
+// at thread exit could still return contexts to it
+//
+
+static auto context_pool() -> ContextPool* {
+  thread_local static ContextPool *s_context_pool = nullptr;
+  if (!s_context_pool) s_context_pool = new ContextPool;
+  return s_context_pool;
+}
+
+//
+// PKeyContext
+//
+
+class PKeyContext {
+public:
+  PKeyContext(EVP_PKEY *pkey, const std::string &id, bool reuse = true) {
+    if (reuse && id.empty()) {
+      m_ctx = context_pool()->pkey_ctx(pkey);
+    } else {
+      m_ctx = EVP_PKEY_CTX_new(pkey, nullptr);
+      if (!m_ctx) throw_error();
+      m_owned = true;
+      if (!id.empty()) EVP_PKEY_CTX_set1_id(m_ctx, id.c_str(), id.length());
+    }
+  }
+
+  ~PKeyContext() {
+    if (m_owned) EVP_PKEY_CTX_free(m_ctx);
+  }
+
+  auto sign(const EVP_MD *md, const unsigned char *hash, unsigned int size) -> std::string {
+    if (EVP_PKEY_sign_init(m_ctx) <= 0) throw_error();
+    if (EVP_PKEY_CTX_set_signature_md(m_ctx, md) <= 0) throw_error();
+    EVP_PKEY_CTX_set_rsa_padding(m_ctx, RSA_PKCS1_PADDING);
+    size_t len;
+    if (EVP_PKEY_sign(m_ctx, nullptr, &len, hash, size) <= 0) throw_error();
+    std::string sig(len, '\0');
+    if (EVP_PKEY_sign(m_ctx, (unsigned char *)&sig[0], &len, hash, size) <= 0) throw_error();
+    sig.resize(len);
+    return sig;
+  }
+
+  auto verify(const EVP_MD *md, const std::string &sig, const unsigned char *hash, unsigned int size) -> int {
+    if (EVP_PKEY_verify_init(m_ctx) <= 0) throw_error();
+    if (EVP_PKEY_CTX_set_signature_md(m_ctx, md) < 0) throw_error();
+    EVP_PKEY_CTX_set_rsa_padding(m_ctx, RSA_PKCS1_PADDING);
+    return EVP_PKEY_verify(m_ctx, (const unsigned char *)sig.c_str(), sig.length(), hash, size);
+  }
+
+private:
+  EVP_PKEY_CTX* m_ctx = nullptr;
+  bool m_owned = false;
+};
+
 //
 // Crypto
 //
@@ -742,12 +856,13 @@ auto Hash::algorithm(const std::string &name) -> const EVP_MD* {
 }
 
 Hash::Hash(const std::string &algorithm) {
-  m_ctx = EVP_MD_CTX_new();
-  EVP_DigestInit_ex(m_ctx, Hash::algorithm(algorithm), nullptr);
+  auto md = Hash::algorithm(algorithm);
+  m_ctx = context_pool()->md_ctx();
+  EVP_DigestInit_ex(m_ctx, md, nullptr);
 }
 
 Hash::~Hash() {
-  EVP_MD_CTX_free(m_ctx);
+  context_pool()->free(m_ctx);
 }
 
 void Hash::update(Data *data) {
@@ -891,13 +1006,15 @@ auto Hmac::digest(Data::Encoding enc) -> pjs::Str* {
 
 Sign::Sign(const std::string &algorithm) {
   m_md = Hash::algorithm(algorithm);
-  m_ctx = EVP_MD_CTX_new();
-  if (!m_ctx) throw_error();
-  if (!EVP_DigestInit_ex(m_ctx, m_md, nullptr)) throw_error();
+  m_ctx = context_pool()->md_ctx();
+  if (!EVP_DigestInit_ex(m_ctx, m_md, nullptr)) {
+    context_pool()->free(m_ctx);
+    throw_error();
+  }
 }
 
 Sign::~Sign() {
-  EVP_MD_CTX_free(m_ctx);
+  context_pool()->free(m_ctx);
 }
 
 void Sign::update(Data *data) {
@@ -926,24 +1043,10 @@ auto Sign::sign(PrivateKey *key, const SignOptions &options) -> Data* {
   unsigned int size;
   if (!EVP_DigestFinal_ex(m_ctx, hash, &size)) throw_error();
 
-  auto ctx = EVP_PKEY_CTX_new(key->pkey(), nullptr);
-  if (!ctx) throw_error();
-  if (options.id) {
-    auto id = options.id->to_bytes();
-    EVP_PKEY_CTX_set1_id(ctx, id.data(), id.size());
-  }
-  if (EVP_PKEY_sign_init(ctx) <= 0) throw_error();
-  if (EVP_PKEY_CTX_set_signature_md(ctx, m_md) <= 0) throw_error();
-
-  EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_PADDING);
-
-  size_t sig_len;
-  if (EVP_PKEY_sign(ctx, nullptr, &sig_len, hash, size) <= 0) throw_error();
-  pjs::vl_array<unsigned char, 1000> sig(sig_len);
-  if (EVP_PKEY_sign(ctx, sig, &sig_len, hash, size) <= 0) throw_error();
-
-  EVP_PKEY_CTX_free(ctx);
-  return s_dp_sign.make(&sig[0], sig_len);
+  std::string id;
+  if (options.id) id = options.id->to_string();
+  auto sig = PKeyContext(key->pkey(), id).sign(m_md, hash, size);
+  return s_dp_sign.make(sig);
 }
 
 auto Sign::sign(PrivateKey *key, Data::Encoding enc, const SignOptions &options) -> pjs::Str* {
@@ -951,19 +1054,62 @@ auto Sign::sign(PrivateKey *key, Data::Encoding enc, const SignOptions &options)
   return pjs::Str::make(data->to_string(enc));
 }
 
+auto Sign::sign_async(PrivateKey *key, const SignOptions &options) -> pjs::Promise* {
+  unsigned char hash[EVP_MAX_MD_SIZE];
+  unsigned int size;
+  if (!EVP_DigestFinal_ex(m_ctx, hash, &size)) throw_error();
+
+  auto promise = pjs::Promise::make();
+  pjs::Ref<pjs::Promise::Settler> settler(pjs::Promise::Settler::make(promise));
+  CryptoPool::sign(
+    key->pkey(), m_md, hash, size, options.id,
+    [=](CryptoPool::Job *job) {
+      if (job->ok()) {
+        settler->resolve(s_dp_sign.make(job->signature()));
+      } else {
+        settler->reject(pjs::Error::make(pjs::Str::make(job->error())));
+      }
+    }
+  );
+  return promise;
+}
+
+auto Sign::sign_async(PrivateKey *key, Data::Encoding enc, const SignOptions &options) -> pjs::Promise* {
+  unsigned char hash[EVP_MAX_MD_SIZE];
+  unsigned int size;
+  if (!EVP_DigestFinal_ex(m_ctx, hash, &size)) throw_error();
+
+  auto promise = pjs::Promise::make();
+  pjs::Ref<pjs::Promise::Settler> settler(pjs::Promise::Settler::make(promise));
+  CryptoPool::sign(
+    key->pkey(), m_md, hash, size, options.id,
+    [=](CryptoPool::Job *job) {
+      if (job->ok()) {
+        Data sig(job->signature(), &s_dp_sign);
+        settler->resolve(pjs::Str::make(sig.to_string(enc)));
+      } else {
+        settler->reject(pjs::Error::make(pjs::Str::make(job->error())));
+      }
+    }
+  );
+  return promise;
+}
+
 //
 // Verify
 //
 
 Verify::Verify(const std::string &algorithm) {
   m_md = Hash::algorithm(algorithm);
-  m_ctx = EVP_MD_CTX_new();
-  if (!m_ctx) throw_error();
-  if (!EVP_DigestInit_ex(m_ctx, m_md, nullptr)) throw_error();
+  m_ctx = context_pool()->md_ctx();
+  if (!EVP_DigestInit_ex(m_ctx, m_md, nullptr)) {
+    context_pool()->free(m_ctx);
+    throw_error();
+  }
 }
 
 Verify::~Verify() {
-  EVP_MD_CTX_free(m_ctx);
+  context_pool()->free(m_ctx);
 }
 
 void Verify::update(Data *data) {
@@ -992,21 +1138,9 @@ bool Verify::verify(PublicKey *key, Data *signature, const SignOptions &options)
   unsigned int size;
   if (!EVP_DigestFinal_ex(m_ctx, hash, &size)) throw_error();
 
-  auto ctx = EVP_PKEY_CTX_new(key->pkey(), nullptr);
-  if (!ctx) throw_error();
-  if (options.id) {
-    auto id = options.id->to_bytes();
-    EVP_PKEY_CTX_set1_id(ctx, id.data(), id.size());
-  }
-  if (EVP_PKEY_verify_init(ctx) <= 0) throw_error();
-  if (EVP_PKEY_CTX_set_signature_md(ctx, m_md) < 0) throw_error();
-
-  EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_PADDING);
-
-  auto sig = signature->to_bytes();
-  auto result = EVP_PKEY_verify(ctx, &sig[0], sig.size(), hash, size);
-  EVP_PKEY_CTX_free(ctx);
-
+  std::string id;
+  if (options.id) id = options.id->to_string();
+  auto result = PKeyContext(key->pkey(), id).verify(m_md, signature->to_string(), hash, size);
   if (result < 0) throw_error();
   return result == 1;
 }
@@ -1016,6 +1150,31 @@ bool Verify::verify(PublicKey *key, pjs::Str *signature, Data::Encoding enc, con
   return verify(key, &sig, options);
 }
 
+auto Verify::verify_async(PublicKey *key, Data *signature, const SignOptions &options) -> pjs::Promise* {
+  unsigned char hash[EVP_MAX_MD_SIZE];
+  unsigned int size;
+  if (!EVP_DigestFinal_ex(m_ctx, hash, &size)) throw_error();
+
+  auto promise = pjs::Promise::make();
+  pjs::Ref<pjs::Promise::Settler> settler(pjs::Promise::Settler::make(promise));
+  CryptoPool::verify(
+    key->pkey(), m_md, hash, size, signature->to_string(), options.id,
+    [=](CryptoPool::Job *job) {
+      if (job->ok()) {
+        settler->resolve(job->verified());
+      } else {
+        settler->reject(pjs::Error::make(pjs::Str::make(job->error())));
+      }
+    }
+  );
+  return promise;
+}
+
+auto Verify::verify_async(PublicKey *key, pjs::Str *signature, Data::Encoding enc, const SignOptions &options) -> pjs::Promise* {
+  Data sig(signature->str(), enc, &s_dp_verify);
+  return verify_async(key, &sig, options);
+}
+
 //
 // JWK
 //
@@ -1083,6 +1242,12 @@ JWK::~JWK() {
 // JWT
 //
 
+JWT::VerifyOptions::VerifyOptions(pjs::Object *options) {
+  Value(options, "cacheTTL")
+    .get_seconds(cache_ttl)
+    .check_nullable();
+}
+
 JWT::JWT(pjs::Str *token) {
   auto segs = utils::split(token->str(), '.');
   if (segs.size() != 3) return;
@@ -1138,22 +1303,40 @@ void JWT::sign(pjs::Str *key) {
   throw std::runtime_error("TODO");
 }
 
-bool JWT::verify(Data *key) {
+bool JWT::verify(Data *key, const VerifyOptions &options) {
   auto buf = key->to_bytes();
-  return verify((const char *)&buf[0], buf.size());
+  return verify((const char *)buf.data(), buf.size(), options);
 }
 
-bool JWT::verify(pjs::Str *key) {
-  return verify(key->c_str(), key->size());
+bool JWT::verify(pjs::Str *key, const VerifyOptions &options) {
+  return verify(key->c_str(), key->size(), options);
 }
 
-bool JWT::verify(JWK *key) {
+bool JWT::verify(JWK *key, const VerifyOptions &options) {
   if (!key || !key->is_valid()) return false;
-  return verify(key->pkey());
+  return verify(key->pkey(), options);
 }
 
-bool JWT::verify(PublicKey *key) {
-  return verify(key->pkey());
+bool JWT::verify(PublicKey *key, const VerifyOptions &options) {
+  return verify(key->pkey(), options);
+}
+
+auto JWT::verify_async(Data *key, const VerifyOptions &options) -> pjs::Promise* {
+  auto buf = key->to_bytes();
+  return verify_async((const char *)buf.data(), buf.size(), options);
+}
+
+auto JWT::verify_async(pjs::Str *key, const VerifyOptions &options) -> pjs::Promise* {
+  return verify_async(key->c_str(), key->size(), options);
+}
+
+auto JWT::verify_async(JWK *key, const VerifyOptions &options) -> pjs::Promise* {
+  if (!key || !key->is_valid()) return pjs::Promise::resolve(false);
+  return verify_async(key->pkey(), options);
+}
+
+auto JWT::verify_async(PublicKey *key, const VerifyOptions &options) -> pjs::Promise* {
+  return verify_async(key->pkey(), options);
 }
 
 auto JWT::get_md() -> const EVP_MD* {
@@ -1171,76 +1354,256 @@ auto JWT::get_md() -> const EVP_MD* {
   return nullptr;
 }
 
-bool JWT::verify(const char *key, int key_len) {
-  if (!m_is_valid) return false;
+bool JWT::is_hmac() const {
+  return (
+    m_algorithm == Algorithm::HS256 ||
+    m_algorithm == Algorithm::HS384 ||
+    m_algorithm == Algorithm::HS512
+  );
+}
 
-  if (m_algorithm == Algorithm::HS256 ||
-      m_algorithm == Algorithm::HS384 ||
-      m_algorithm == Algorithm::HS512
-  ) {
-    auto md = get_md();
-    if (!md) return false;
+static auto read_key(const char *key, int key_len) -> EVP_PKEY* {
+  auto bio = BIO_new_mem_buf(key, key_len);
+  auto pkey = PEM_read_bio_PUBKEY(bio, nullptr, nullptr, nullptr);
+  if (!pkey) {
+    BIO_reset(bio);
+    pkey = PEM_read_bio_PrivateKey(bio, nullptr, nullptr, nullptr);
+  }
+  BIO_free(bio);
+  if (!pkey) throw_error();
+  return pkey;
+}
 
-    auto ctx = HMAC_CTX_new();
-    char sep = '.';
-    HMAC_Init_ex(ctx, key, key_len, md, nullptr);
-    HMAC_Update(ctx, (unsigned char *)m_header_str.c_str(), m_header_str.length());
-    HMAC_Update(ctx, (unsigned char *)&sep, 1);
-    HMAC_Update(ctx, (unsigned char *)m_payload_str.c_str(), m_payload_str.length());
+static auto key_id_of(const char *key, int key_len) -> std::string {
+  unsigned char hash[EVP_MAX_MD_SIZE];
+  unsigned int size;
+  auto ctx = context_pool()->md_ctx();
+  EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr);
+  EVP_DigestUpdate(ctx, key, key_len);
+  EVP_DigestFinal_ex(ctx, hash, &size);
+  context_pool()->free(ctx);
+  return std::string((const char *)hash, size);
+}
 
-    char hash[EVP_MAX_MD_SIZE];
-    unsigned int hash_size;
-    HMAC_Final(ctx, (unsigned char *)hash, &hash_size);
-    HMAC_CTX_free(ctx);
+static auto key_id_of(EVP_PKEY *pkey) -> std::string {
+  return std::string((const char *)&pkey, sizeof(pkey));
+}
 
-    if (hash_size != m_signature.length()) return false;
-    return std::memcmp(m_signature.c_str(), hash, hash_size) == 0;
+bool JWT::verify(const char *key, int key_len, const VerifyOptions &options) {
+  if (!m_is_valid) return false;
+
+  std::string key_id;
+  if (options.cache_ttl > 0) {
+    key_id = key_id_of(key, key_len);
+    if (cache_find(key_id)) return true;
+  }
 
+  bool result = false;
+  if (is_hmac()) {
+    result = verify_hmac(key, key_len);
   } else {
-    auto bio = BIO_new_mem_buf(key, key_len);
-    auto pkey = PEM_read_bio_PUBKEY(bio, nullptr, nullptr, nullptr);
-    if (!pkey) {
-      BIO_reset(bio);
-      pkey = PEM_read_bio_PrivateKey(bio, nullptr, nullptr, nullptr);
+    auto pkey = read_key(key, key_len);
+    try {
+      result = verify_pkey(pkey, false);
+    } catch (std::runtime_error &) {
+      EVP_PKEY_free(pkey);
+      throw;
     }
-    BIO_free(bio);
-    if (!pkey) throw_error();
-
-    auto result = verify(pkey);
     EVP_PKEY_free(pkey);
-    return result;
   }
+
+  if (result && !key_id.empty()) cache_add(key_id, nullptr, options);
+  return result;
+}
+
+bool JWT::verify(EVP_PKEY *pkey, const VerifyOptions &options) {
+  if (!m_is_valid) return false;
+
+  std::string key_id;
+  if (options.cache_ttl > 0) {
+    key_id = key_id_of(pkey);
+    if (cache_find(key_id)) return true;
+  }
+
+  auto result = verify_pkey(pkey, true);
+  if (result && !key_id.empty()) cache_add(key_id, pkey, options);
+  return result;
 }
 
-bool JWT::verify(EVP_PKEY *pkey) {
+bool JWT::verify_hmac(const char *key, int key_len) {
   auto md = get_md();
   if (!md) return false;
 
-  unsigned char hash[EVP_MAX_MD_SIZE];
+  auto ctx = HMAC_CTX_new();
+  char sep = '.';
+  HMAC_Init_ex(ctx, key, key_len, md, nullptr);
+  HMAC_Update(ctx, (unsigned char *)m_header_str.c_str(), m_header_str.length());
+  HMAC_Update(ctx, (unsigned char *)&sep, 1);
+  HMAC_Update(ctx, (unsigned char *)m_payload_str.c_str(), m_payload_str.length());
+
+  char hash[EVP_MAX_MD_SIZE];
   unsigned int hash_size;
+  HMAC_Final(ctx, (unsigned char *)hash, &hash_size);
+  HMAC_CTX_free(ctx);
+
+  if (hash_size != m_signature.length()) return false;
+  return std::memcmp(m_signature.c_str(), hash, hash_size) == 0;
+}
+
+bool JWT::verify_pkey(EVP_PKEY *pkey, bool reuse_ctx) {
+  auto md = get_md();
+  if (!md) return false;
 
-  auto mdctx = EVP_MD_CTX_new();
-  EVP_DigestInit_ex(mdctx, md, nullptr);
-  EVP_DigestUpdate(mdctx, m_header_str.c_str(), m_header_str.length());
-  EVP_DigestUpdate(mdctx, ".", 1);
-  EVP_DigestUpdate(mdctx, m_payload_str.c_str(), m_payload_str.length());
-  EVP_DigestFinal_ex(mdctx, hash, &hash_size);
+  unsigned char hash[EVP_MAX_MD_SIZE];
+  auto hash_size = digest(hash);
 
-  auto pctx = EVP_PKEY_CTX_new(pkey, nullptr);
-  EVP_PKEY_verify_init(pctx);
-  EVP_PKEY_CTX_set_rsa_padding(pctx, RSA_PKCS1_PADDING);
-  EVP_PKEY_CTX_set_signature_md(pctx, md);
+  // Like a bad signature, failing to set up verification means not verified
+  try {
+    return PKeyContext(pkey, std::string(), reuse_ctx).verify(md, m_signature, hash, hash_size) == 1;
+  } catch (std::runtime_error &) {
+    return false;
+  }
+}
 
-  auto result = EVP_PKEY_verify(
-    pctx,
-    (unsigned char *)m_signature.c_str(),
-    m_signature.length(),
-    hash, hash_size);
+auto JWT::verify_async(const char *key, int key_len, const VerifyOptions &options) -> pjs::Promise* {
+  if (!m_is_valid || is_hmac()) return pjs::Promise::resolve(verify(key, key_len, options));
 
-  EVP_PKEY_CTX_free(pctx);
-  EVP_MD_CTX_free(mdctx);
+  std::string key_id;
+  if (options.cache_ttl > 0) {
+    key_id = key_id_of(key, key_len);
+    if (cache_find(key_id)) return pjs::Promise::resolve(true);
+  }
 
-  return result == 1;
+  auto pkey = read_key(key, key_len);
+  auto promise = verify_async(pkey, key_id, false, options);
+  EVP_PKEY_free(pkey);
+  return promise;
+}
+
+auto JWT::verify_async(EVP_PKEY *pkey, const VerifyOptions &options) -> pjs::Promise* {
+  if (!m_is_valid) return pjs::Promise::resolve(false);
+
+  std::string key_id;
+  if (options.cache_ttl > 0) {
+    key_id = key_id_of(pkey);
+    if (cache_find(key_id)) return pjs::Promise::resolve(true);
+  }
+
+  return verify_async(pkey, key_id, true, options);
+}
+
+auto JWT::verify_async(EVP_PKEY *pkey, const std::string &key_id, bool pin_key, const VerifyOptions &options) -> pjs::Promise* {
+  auto md = get_md();
+  if (!md) return pjs::Promise::resolve(false);
+
+  unsigned char hash[EVP_MAX_MD_SIZE];
+  auto hash_size = digest(hash);
+
+  auto promise = pjs::Promise::make();
+  pjs::Ref<pjs::Promise::Settler> settler(pjs::Promise::Settler::make(promise));
+  pjs::Ref<JWT> thiz(this);
+  CryptoPool::verify(
+    pkey, md, hash, hash_size, m_signature, nullptr,
+    [=](CryptoPool::Job *job) {
+      auto verified = job->ok() && job->verified();
+      if (verified && !key_id.empty()) {
+        thiz->cache_add(key_id, pin_key ? pkey : nullptr, options);
+      }
+      settler->resolve(verified);
+    }
+  );
+  return promise;
+}
+
+auto JWT::digest(unsigned char *hash) -> unsigned int {
+  unsigned int size;
+  auto ctx = context_pool()->md_ctx();
+  EVP_DigestInit_ex(ctx, get_md(), nullptr);
+  EVP_DigestUpdate(ctx, m_header_str.c_str(), m_header_str.length());
+  EVP_DigestUpdate(ctx, ".", 1);
+  EVP_DigestUpdate(ctx, m_payload_str.c_str(), m_payload_str.length());
+  EVP_DigestFinal_ex(ctx, hash, &size);
+  context_pool()->free(ctx);
+  return size;
+}
+
+auto JWT::token_hash() -> const std::string& {
+  if (m_token_hash.empty()) {
+    unsigned char hash[EVP_MAX_MD_SIZE];
+    unsigned int size;
+    auto ctx = context_pool()->md_ctx();
+    EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr);
+    EVP_DigestUpdate(ctx, m_header_str.c_str(), m_header_str.length());
+    EVP_DigestUpdate(ctx, ".", 1);
+    EVP_DigestUpdate(ctx, m_payload_str.c_str(), m_payload_str.length());
+    EVP_DigestUpdate(ctx, ".", 1);
+    EVP_DigestUpdate(ctx, m_signature_str.c_str(), m_signature_str.length());
+    EVP_DigestFinal_ex(ctx, hash, &size);
+    context_pool()->free(ctx);
+    m_token_hash.assign((const char *)hash, size);
+  }
+  return m_token_hash;
+}
+
+//
+// JWT verification cache
+//
+// Remembers tokens that have passed verification by their SHA-256,
+// along with the key they passed with. Keys given as bytes are told apart
+// by their SHA-256 and key objects by their EVP_PKEY, which is referenced
+// by the entry. An entry lasts no longer than the token's "exp" claim.
+//
+
+static const size_t JWT_CACHE_SIZE = 10000;
+
+struct JWTCacheEntry {
+  std::string key_id;
+  EVP_PKEY *pkey = nullptr;
+  double expiration = 0;
+
+  JWTCacheEntry() {}
+  JWTCacheEntry(const JWTCacheEntry &) = delete;
+  ~JWTCacheEntry() { if (pkey) EVP_PKEY_free(pkey); }
+};
+
+thread_local static std::unordered_map<std::string, JWTCacheEntry> s_jwt_cache;
+
+bool JWT::cache_find(const std::string &key_id) {
+  auto i = s_jwt_cache.find(token_hash());
+  if (i == s_jwt_cache.end()) return false;
+  if (i->second.expiration <= utils::now() / 1000) {
+    s_jwt_cache.erase(i);
+    return false;
+  }
+  return i->second.key_id == key_id;
+}
+
+void JWT::cache_add(const std::string &key_id, EVP_PKEY *pkey, const VerifyOptions &options) {
+  auto now = utils::now() / 1000;
+  auto expiration = now + options.cache_ttl;
+
+  pjs::Value exp;
+  m_payload.o()->get("exp", exp);
+  if (exp.is_number()) expiration = std::min(expiration, exp.n());
+  if (expiration <= now) return;
+
+  if (s_jwt_cache.size() >= JWT_CACHE_SIZE) {
+    for (auto i = s_jwt_cache.begin(); i != s_jwt_cache.end(); ) {
+      if (i->second.expiration <= now) {
+        i = s_jwt_cache.erase(i);
+      } else {
+        i++;
+      }
+    }
+    if (s_jwt_cache.size() >= JWT_CACHE_SIZE) s_jwt_cache.clear();
+  }
+
+  auto &e = s_jwt_cache[token_hash()];
+  if (e.pkey) EVP_PKEY_free(e.pkey);
+  if (pkey) EVP_PKEY_up_ref(pkey);
+  e.key_id = key_id;
+  e.pkey = pkey;
+  e.expiration = expiration;
 }
 
 int JWT::jose2der(char *out, const char *inp, int len) {
@@ -1284,6 +1647,89 @@ int JWT::jose2der(char *out, const char *inp, int len) {
   return i;
 }
 
+//
+// CryptoPool
+//
+
+static ThreadPool *s_pool = new ThreadPool(1, 8, 2);
+
+void CryptoPool::sign(
+  EVP_PKEY *pkey, const EVP_MD *md,
+  const unsigned char *hash, unsigned int hash_size,
+  Data *id, const Callback &cb
+) {
+  submit(new Job(pkey, md, hash, hash_size, std::string(), id, true, cb));
+}
+
+void CryptoPool::verify(
+  EVP_PKEY *pkey, const EVP_MD *md,
+  const unsigned char *hash, unsigned int hash_size,
+  const std::string &signature, Data *id, const Callback &cb
+) {
+  submit(new Job(pkey, md, hash, hash_size, signature, id, false, cb));
+}
+
+void CryptoPool::submit(Job *job) {
+  s_pool->submit(
+    [=]() { job->run(); },
+    [=]() { job->complete(); }
+  );
+}
+
+auto CryptoPool::queued() -> int {
+  return s_pool->queued();
+}
+
+auto CryptoPool::running() -> int {
+  return s_pool->running();
+}
+
+//
+// CryptoPool::Job
+//
+
+CryptoPool::Job::Job(
+  EVP_PKEY *pkey, const EVP_MD *md,
+  const unsigned char *hash, unsigned int hash_size,
+  const std::string &signature, Data *id, bool is_sign,
+  const std::function<void(Job*)> &cb
+) : m_pkey(pkey)
+  , m_md(md)
+  , m_hash_size(hash_size)
+  , m_signature(signature)
+  , m_callback(cb)
+  , m_is_sign(is_sign)
+{
+  EVP_PKEY_up_ref(pkey);
+  std::memcpy(m_hash, hash, hash_size);
+  if (id) m_id = id->to_string();
+}
+
+CryptoPool::Job::~Job() {
+  EVP_PKEY_free(m_pkey);
+}
+
+void CryptoPool::Job::run() {
+  ERR_clear_error();
+  try {
+    PKeyContext ctx(m_pkey, m_id);
+    if (m_is_sign) {
+      m_signature = ctx.sign(m_md, m_hash, m_hash_size);
+    } else {
+      auto result = ctx.verify(m_md, m_signature, m_hash, m_hash_size);
+      if (result < 0) throw_error();
+      m_verified = (result == 1);
+    }
+  } catch (std::runtime_error &err) {
+    m_error = err.what();
+  }
+}
+
+void CryptoPool::Job::complete() {
+  m_callback(this);
+  delete this;
+}
+
 } // namespace crypto
 } // namespace pipy
 
@@ -1715,6 +2161,31 @@ template<> void ClassDef<Sign>::init() {
       ctx.error(err);
     }
   });
+
+  method("signAsync", [](Context &ctx, Object *obj, Value &ret) {
+    PrivateKey *key;
+    EnumValue<pipy::Data::Encoding> encoding = pipy::Data::Encoding::utf8;
+    Object *options = nullptr;
+    try {
+      if (ctx.try_arguments(1, &key, &options) ||
+          ctx.try_arguments(1, &key, &encoding, &options)
+      ) {
+        if (!key) {
+          ctx.error_argument_type(0, "a PrivateKey object");
+          return;
+        }
+        if (ctx.is_string(1)) {
+          ret.set(obj->as<Sign>()->sign_async(key, encoding, options));
+        } else {
+          ret.set(obj->as<Sign>()->sign_async(key, options));
+        }
+      } else if (ctx.arguments(1, &key)) {
+        ctx.error_argument_type(1, "a object or a string");
+      }
+    } catch (std::runtime_error &err) {
+      ctx.error(err);
+    }
+  });
 }
 
 template<> void ClassDef<Constructor<Sign>>::init() {
@@ -1785,6 +2256,33 @@ template<> void ClassDef<Verify>::init() {
       ctx.error(err);
     }
   });
+
+  method("verifyAsync", [](Context &ctx, Object *obj, Value &ret) {
+    PublicKey *key;
+    Str *signature_str = nullptr;
+    EnumValue<pipy::Data::Encoding> encoding = pipy::Data::Encoding::utf8;
+    pipy::Data *signature = nullptr;
+    Object *options = nullptr;
+    try {
+      if (ctx.try_arguments(2, &key, &signature, &options) ||
+          ctx.try_arguments(2, &key, &signature_str, &encoding, &options)
+      ) {
+        if (!key) {
+          ctx.error_argument_type(0, "a PublicKey object");
+          return;
+        }
+        if (signature) {
+          ret.set(obj->as<Verify>()->verify_async(key, signature, options));
+        } else {
+          ret.set(obj->as<Verify>()->verify_async(key, signature_str, encoding, options));
+        }
+      } else if (ctx.arguments(1, &key)) {
+        ctx.error_argument_type(1, "a Data object or a string");
+      }
+    } catch (std::runtime_error &err) {
+      ctx.error(err);
+    }
+  });
 }
 
 template<> void ClassDef<Constructor<Verify>>::init() {
@@ -1848,20 +2346,52 @@ template<> void ClassDef<JWT>::init() {
     Str *str = nullptr;
     JWK *jwk = nullptr;
     PublicKey *pkey = nullptr;
-    if ((ctx.try_arguments(1, &data) && data) ||
-        ctx.try_arguments(1, &str) ||
-        ctx.try_arguments(1, &jwk) ||
-        ctx.try_arguments(1, &pkey)
+    Object *options = nullptr;
+    if ((ctx.try_arguments(1, &data, &options) && data) ||
+        ctx.try_arguments(1, &str, &options) ||
+        ctx.try_arguments(1, &jwk, &options) ||
+        ctx.try_arguments(1, &pkey, &options)
+    ) {
+      try {
+        JWT::VerifyOptions opts(options);
+        if (data) {
+          ret.set(obj->as<JWT>()->verify(data, opts));
+        } else if (str) {
+          ret.set(obj->as<JWT>()->verify(str, opts));
+        } else if (jwk) {
+          ret.set(obj->as<JWT>()->verify(jwk, opts));
+        } else if (pkey) {
+          ret.set(obj->as<JWT>()->verify(pkey, opts));
+        }
+      } catch (std::runtime_error &err) {
+        ctx.error(err);
+      }
+    } else {
+      ctx.error_argument_type(0, "a Data object or a string or a public key object");
+    }
+  });
+
+  method("verifyAsync", [](Context &ctx, Object *obj, Value &ret) {
+    pipy::Data *data = nullptr;
+    Str *str = nullptr;
+    JWK *jwk = nullptr;
+    PublicKey *pkey = nullptr;
+    Object *options = nullptr;
+    if ((ctx.try_arguments(1, &data, &options) && data) ||
+        ctx.try_arguments(1, &str, &options) ||
+        ctx.try_arguments(1, &jwk, &options) ||
+        ctx.try_arguments(1, &pkey, &options)
     ) {
       try {
+        JWT::VerifyOptions opts(options);
         if (data) {
-          ret.set(obj->as<JWT>()->verify(data));
+          ret.set(obj->as<JWT>()->verify_async(data, opts));
         } else if (str) {
-          ret.set(obj->as<JWT>()->verify(str));
+          ret.set(obj->as<JWT>()->verify_async(str, opts));
         } else if (jwk) {
-          ret.set(obj->as<JWT>()->verify(jwk));
+          ret.set(obj->as<JWT>()->verify_async(jwk, opts));
         } else if (pkey) {
-          ret.set(obj->as<JWT>()->verify(pkey));
+          ret.set(obj->as<JWT>()->verify_async(pkey, opts));
         }
       } catch (std::runtime_error &err) {
         ctx.error(err);
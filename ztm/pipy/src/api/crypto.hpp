@@ -32,6 +32,9 @@
 
 #include <openssl/evp.h>
 
+#include <functional>
+#include <string>
+
 namespace pipy {
 namespace crypto {
 
@@ -286,6 +289,8 @@ public:
   void update(pjs::Str *str, Data::Encoding enc);
   auto sign(PrivateKey *key, const SignOptions &options) -> Data*;
   auto sign(PrivateKey *key, Data::Encoding enc, const SignOptions &options) -> pjs::Str*;
+  auto sign_async(PrivateKey *key, const SignOptions &options) -> pjs::Promise*;
+  auto sign_async(PrivateKey *key, Data::Encoding enc, const SignOptions &options) -> pjs::Promise*;
 
 private:
   Sign(const std::string &algorithm);
@@ -307,6 +312,8 @@ public:
   void update(pjs::Str *str, Data::Encoding enc);
   bool verify(PublicKey *key, Data *signature, const SignOptions &options);
   bool verify(PublicKey *key, pjs::Str *signature, Data::Encoding enc, const SignOptions &options);
+  auto verify_async(PublicKey *key, Data *signature, const SignOptions &options) -> pjs::Promise*;
+  auto verify_async(PublicKey *key, pjs::Str *signature, Data::Encoding enc, const SignOptions &options) -> pjs::Promise*;
 
 private:
   Verify(const std::string &algorithm);
@@ -354,14 +361,24 @@ public:
     ES512,
   };
 
+  struct VerifyOptions : public Options {
+    double cache_ttl = 0;
+    VerifyOptions() {}
+    VerifyOptions(pjs::Object *options);
+  };
+
   bool is_valid() const { return m_is_valid; }
   auto header() const -> const pjs::Value& { return m_header; }
   auto payload() const -> const pjs::Value& { return m_payload; }
   void sign(pjs::Str *key);
-  bool verify(Data *key);
-  bool verify(pjs::Str *key);
-  bool verify(JWK *key);
-  bool verify(PublicKey *key);
+  bool verify(Data *key, const VerifyOptions &options = VerifyOptions());
+  bool verify(pjs::Str *key, const VerifyOptions &options = VerifyOptions());
+  bool verify(JWK *key, const VerifyOptions &options = VerifyOptions());
+  bool verify(PublicKey *key, const VerifyOptions &options = VerifyOptions());
+  auto verify_async(Data *key, const VerifyOptions &options) -> pjs::Promise*;
+  auto verify_async(pjs::Str *key, const VerifyOptions &options) -> pjs::Promise*;
+  auto verify_async(JWK *key, const VerifyOptions &options) -> pjs::Promise*;
+  auto verify_async(PublicKey *key, const VerifyOptions &options) -> pjs::Promise*;
 
 private:
   JWT(pjs::Str *token);
@@ -375,15 +392,96 @@ private:
   std::string m_payload_str;
   std::string m_signature_str;
   std::string m_signature;
+  std::string m_token_hash;
 
   auto get_md() -> const EVP_MD*;
-  bool verify(const char *key, int key_len);
-  bool verify(EVP_PKEY *pkey);
+  bool is_hmac() const;
+  bool verify(const char *key, int key_len, const VerifyOptions &options);
+  bool verify(EVP_PKEY *pkey, const VerifyOptions &options);
+  bool verify_hmac(const char *key, int key_len);
+  bool verify_pkey(EVP_PKEY *pkey, bool reuse_ctx);
+  auto verify_async(const char *key, int key_len, const VerifyOptions &options) -> pjs::Promise*;
+  auto verify_async(EVP_PKEY *pkey, const VerifyOptions &options) -> pjs::Promise*;
+  auto verify_async(EVP_PKEY *pkey, const std::string &key_id, bool pin_key, const VerifyOptions &options) -> pjs::Promise*;
+  auto digest(unsigned char *hash) -> unsigned int;
+  auto token_hash() -> const std::string&;
+  bool cache_find(const std::string &key_id);
+  void cache_add(const std::string &key_id, EVP_PKEY *pkey, const VerifyOptions &options);
   int jose2der(char *out, const char *inp, int len);
 
   friend class pjs::ObjectTemplate<JWT>;
 };
 
+//
+// CryptoPool
+//
+// Runs public-key signing and verification on a ThreadPool shared by
+// all workers. Digests are computed by the caller, and the results are
+// posted back to the submitting thread.
+//
+
+class CryptoPool {
+public:
+
+  //
+  // CryptoPool::Job
+  //
+
+  class Job {
+  public:
+    bool ok() const { return m_error.empty(); }
+    bool verified() const { return m_verified; }
+    auto signature() const -> const std::string& { return m_signature; }
+    auto error() const -> const std::string& { return m_error; }
+
+  private:
+    Job(
+      EVP_PKEY *pkey, const EVP_MD *md,
+      const unsigned char *hash, unsigned int hash_size,
+      const std::string &signature, Data *id, bool is_sign,
+      const std::function<void(Job*)> &cb
+    );
+
+    ~Job();
+
+    EVP_PKEY* m_pkey;
+    const EVP_MD* m_md;
+    unsigned char m_hash[EVP_MAX_MD_SIZE];
+    unsigned int m_hash_size;
+    std::string m_signature;
+    std::string m_id;
+    std::string m_error;
+    std::function<void(Job*)> m_callback;
+    bool m_is_sign;
+    bool m_verified = false;
+
+    void run();
+    void complete();
+
+    friend class CryptoPool;
+  };
+
+  typedef std::function<void(Job*)> Callback;
+
+  static void sign(
+    EVP_PKEY *pkey, const EVP_MD *md,
+    const unsigned char *hash, unsigned int hash_size,
+    Data *id, const Callback &cb
+  );
+
+  static void verify(
+    EVP_PKEY *pkey, const EVP_MD *md,
+    const unsigned char *hash, unsigned int hash_size,
+    const std::string &signature, Data *id, const Callback &cb
+  );
+
+  static auto queued() -> int;
+  static auto running() -> int;
+
+private:
+  static void submit(Job *job);
+};
+
 //
 // Crypto
 //
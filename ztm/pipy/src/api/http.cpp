@@ -29,8 +29,14 @@
 #include "filters/tls.hpp"
 #include "codebase.hpp"
 #include "fs.hpp"
+#include "file-io.hpp"
 #include "compressor.hpp"
+#include "str-map.hpp"
 #include "utils.hpp"
+#include "worker.hpp"
+
+#include <cctype>
+#include <cstring>
 
 namespace pipy {
 namespace http {
@@ -62,6 +68,16 @@ thread_local static const pjs::ConstStr s_content_type("content-type");
 thread_local static const pjs::ConstStr s_application_octet_stream("application/octet-stream");
 thread_local static const pjs::ConstStr s_gzip("gzip");
 thread_local static const pjs::ConstStr s_br("br");
+thread_local static const pjs::ConstStr s_etag("etag");
+thread_local static const pjs::ConstStr s_last_modified("last-modified");
+thread_local static const pjs::ConstStr s_accept_ranges("accept-ranges");
+thread_local static const pjs::ConstStr s_content_range("content-range");
+thread_local static const pjs::ConstStr s_range("range");
+thread_local static const pjs::ConstStr s_if_range("if-range");
+thread_local static const pjs::ConstStr s_if_none_match("if-none-match");
+thread_local static const pjs::ConstStr s_if_modified_since("if-modified-since");
+thread_local static const pjs::ConstStr s_vary("vary");
+thread_local static const pjs::ConstStr s_bytes("bytes");
 
 static const std::map<std::string, std::string> s_default_content_types = {
   { "html"  , "text/html" },
@@ -79,9 +95,226 @@ static const std::map<std::string, std::string> s_default_content_types = {
   { "json"  , "application/json" },
 };
 
+//
+// HeaderList
+//
+
+thread_local static const pjs::ConstStr s_cookie("cookie");
+thread_local static const pjs::ConstStr s_set_cookie("set-cookie");
+
+static const size_t s_header_index_threshold = 16;
+
+thread_local static const StrMap s_strmap_well_known_headers({
+  "accept",
+  "accept-encoding",
+  "accept-language",
+  "accept-ranges",
+  "age",
+  "authorization",
+  "cache-control",
+  "connection",
+  "content-encoding",
+  "content-length",
+  "content-range",
+  "content-type",
+  "cookie",
+  "date",
+  "etag",
+  "expect",
+  "expires",
+  "forwarded",
+  "host",
+  "if-match",
+  "if-modified-since",
+  "if-none-match",
+  "if-range",
+  "keep-alive",
+  "last-modified",
+  "location",
+  "origin",
+  "pragma",
+  "proxy-authorization",
+  "range",
+  "referer",
+  "server",
+  "set-cookie",
+  "te",
+  "trailer",
+  "transfer-encoding",
+  "upgrade",
+  "user-agent",
+  "vary",
+  "via",
+  "www-authenticate",
+  "x-forwarded-for",
+  "x-forwarded-host",
+  "x-forwarded-proto",
+  "x-real-ip",
+  "x-request-id",
+});
+
+auto HeaderList::lookup(const char *name, size_t len) -> pjs::Str* {
+  StrMap::Parser p(s_strmap_well_known_headers);
+  pjs::Str *found = nullptr;
+  for (size_t i = 0; i < len; i++) {
+    found = p.parse(std::tolower((unsigned char)name[i]));
+    if (found == pjs::Str::empty) return nullptr;
+  }
+  return found;
+}
+
+void HeaderList::add(pjs::Str *known, const char *name, size_t name_len, const char *value, size_t value_len) {
+  Field f;
+  f.known = known;
+  f.name = m_buffer.size();
+  f.name_len = name_len;
+  m_buffer.append(name, name_len);
+  f.value = m_buffer.size();
+  f.value_len = value_len;
+  m_buffer.append(value, value_len);
+  f.next = 0;
+  f.dup = false;
+
+  // Keep the same order and overriding as setting them on an object,
+  // where cookies with the same name are grouped into one array
+  auto n = uint32_t(m_fields.size());
+  auto i = find(known, name, name_len);
+  if (i < 0) {
+    f.last = n;
+    m_fields.push_back(f);
+    if (!m_index.empty()) {
+      m_index[key(known, name, name_len)] = n;
+    } else if (m_fields.size() >= s_header_index_threshold) {
+      for (uint32_t j = 0; j <= n; j++) {
+        const auto &h = m_fields[j];
+        if (!h.dup) m_index[key(h.known, m_buffer.c_str() + h.name, h.name_len)] = j;
+      }
+    }
+  } else if (known == s_cookie || known == s_set_cookie) {
+    auto &head = m_fields[i];
+    m_fields[head.last].next = n;
+    head.last = n;
+    f.last = n;
+    f.dup = true;
+    m_fields.push_back(f);
+  } else {
+    auto &old = m_fields[i];
+    old.value = f.value;
+    old.value_len = f.value_len;
+    for (size_t j = 0; j < name_len; j++) {
+      if (std::tolower((unsigned char)name[j]) != (unsigned char)name[j]) {
+        old.name = f.name;
+        break;
+      }
+    }
+  }
+}
+
+bool HeaderList::get(pjs::Str *name, pjs::Value &value) const {
+  auto known = lookup(name->c_str(), name->size());
+  auto i = find(known, name->c_str(), name->size());
+  value = pjs::Value::undefined;
+  if (i < 0) return false;
+  pjs::Array *a = nullptr;
+  for (auto p = &m_fields[i];; p = &m_fields[p->next]) {
+    auto s = pjs::Str::make(m_buffer.c_str() + p->value, p->value_len);
+    if (value.is_undefined()) {
+      value.set(s);
+    } else if (a) {
+      a->push(s);
+    } else {
+      a = pjs::Array::make(2);
+      a->set(0, value);
+      a->set(1, s);
+      value.set(a);
+    }
+    if (!p->next) break;
+  }
+  return true;
+}
+
+void HeaderList::to_object(pjs::Object *headers, pjs::Object *names) const {
+  iterate([&](const Field &f) {
+    auto name = m_buffer.c_str() + f.name;
+    pjs::Ref<pjs::Str> key(f.known);
+    if (!key) {
+      pjs::vl_array<char, 256> buf(f.name_len);
+      for (size_t i = 0; i < f.name_len; i++) buf[i] = std::tolower((unsigned char)name[i]);
+      key = pjs::Str::make(buf.data(), f.name_len);
+    }
+    pjs::Ref<pjs::Str> val(pjs::Str::make(m_buffer.c_str() + f.value, f.value_len));
+    pjs::Value old;
+    if ((key == s_cookie || key == s_set_cookie) && headers->get(key, old)) {
+      if (old.is_array()) {
+        old.as<pjs::Array>()->push(val.get());
+      } else {
+        auto a = pjs::Array::make(2);
+        a->set(0, old);
+        a->set(1, val.get());
+        headers->set(key, a);
+      }
+    } else {
+      headers->set(key, val.get());
+    }
+    if (names && std::memcmp(key->c_str(), name, f.name_len)) {
+      names->set(key, pjs::Str::make(name, f.name_len));
+    }
+  });
+}
+
+auto HeaderList::find(pjs::Str *known, const char *name, size_t len) const -> int {
+  if (!m_index.empty()) {
+    auto i = m_index.find(key(known, name, len));
+    return i == m_index.end() ? -1 : int(i->second);
+  }
+  for (size_t i = 0; i < m_fields.size(); i++) {
+    const auto &f = m_fields[i];
+    if (!f.dup && match(f, known, name, len)) return i;
+  }
+  return -1;
+}
+
+auto HeaderList::key(pjs::Str *known, const char *name, size_t len) const -> std::string {
+  if (known) return known->str();
+  std::string s(name, len);
+  for (auto &c : s) c = std::tolower((unsigned char)c);
+  return s;
+}
+
+bool HeaderList::match(const Field &f, pjs::Str *known, const char *name, size_t len) const {
+  if (known || f.known) return f.known == known;
+  if (f.name_len != len) return false;
+  auto s = m_buffer.c_str() + f.name;
+  for (size_t i = 0; i < len; i++) {
+    if (std::tolower((unsigned char)s[i]) != std::tolower((unsigned char)name[i])) return false;
+  }
+  return true;
+}
+
+//
+// Headers
+//
+
+bool Headers::find(pjs::Str *name, pjs::Value &value) const {
+  if (m_list) return m_list->get(name, value);
+  if (auto obj = get()) return obj->get(name, value);
+  return false;
+}
+
+void Headers::materialize() const {
+  pjs::Ref<HeaderList> list(std::move(m_list));
+  m_object = pjs::Object::make();
+  m_names = pjs::Object::make();
+  list->to_object(m_object, m_names);
+}
+
+//
+// MessageHead
+//
+
 bool MessageHead::is_final() const {
   pjs::Value v;
-  if (headers && headers->get(s_connection, v)) {
+  if (headers.find(s_connection, v)) {
     return v.is_string() && v.s() == s_close;
   } else {
     return protocol == s_http_1_0;
@@ -99,7 +332,7 @@ bool MessageHead::is_final(pjs::Str *header_connection) const {
 auto RequestHead::tunnel_type() const -> TunnelType {
   if (method == s_CONNECT) return TunnelType::CONNECT;
   pjs::Value v;
-  if (headers && headers->get(s_upgrade, v) && v.is_string()) {
+  if (headers.find(s_upgrade, v) && v.is_string()) {
     if (v.s() == s_websocket) return TunnelType::WEBSOCKET;
     if (v.s() == s_h2c) return TunnelType::HTTP2;
   }
@@ -242,7 +475,7 @@ auto Match::exec(pjs::Object *head) -> pjs::Object* {
 }
 
 void Match::operator()(pjs::Context &ctx, pjs::Object *obj, pjs::Value &ret) {
-  pjs::Str *path;
+  pjs::Str *path = nullptr;
   pjs::Object *head = nullptr;
   if (!ctx.get(0, path) && !ctx.get(0, head)) {
     return ctx.error_argument_type(0, "a string or an object");
@@ -385,6 +618,12 @@ Directory::Options::Options(pjs::Object *options) {
   Value(options, "tarball")
     .get(tarball)
     .check_nullable();
+  Value(options, "cache")
+    .get(cache)
+    .check_nullable();
+  Value(options, "cacheSize")
+    .get_binary_size(cache_size)
+    .check_nullable();
   Value(options, "index")
     .get(index)
     .get(index_list)
@@ -413,7 +652,13 @@ Directory::Directory(const std::string &path)
 Directory::Directory(const std::string &path, const Options &options)
   : m_options(options)
 {
-  if (options.tarball) {
+  if (options.cache) {
+    if (!options.fs || options.tarball) {
+      throw std::runtime_error("option cache only works with fs");
+    }
+    m_root_path = path;
+    FileCache::reserve(options.cache_size);
+  } else if (options.tarball) {
     std::vector<uint8_t> data;
     if (options.fs) {
       fs::read_file(path, data);
@@ -426,7 +671,7 @@ Directory::Directory(const std::string &path, const Options &options)
       }
     }
     if (data.size() > 0) {
-      m_loader = new TarballLoader((const char *)&data[0], data.size());
+      m_loader = new TarballLoader(std::move(data));
     }
   } else if (options.fs) {
     m_loader = new FileSystemLoader(path);
@@ -468,14 +713,15 @@ Directory::~Directory() {
   delete m_loader;
 }
 
-auto Directory::serve(pjs::Context &ctx, Message *request) -> Message* {
-  if (!m_loader) return nullptr;
-
+auto Directory::serve(pjs::Context &ctx, Message *request) -> pjs::Object* {
   pjs::Ref<RequestHead> head = pjs::coerce<RequestHead>(request->head());
   auto path = head->path ? utils::path_normalize(head->path->str()) : std::string();
   auto n = path.find('?');
   if (n != std::string::npos) path = path.substr(0, n);
 
+  if (m_options.cache) return serve_cached(ctx, request, path);
+  if (!m_loader) return nullptr;
+
   auto k = path;
   auto i = m_cache.find(k);
   if (i == m_cache.end()) {
@@ -501,40 +747,189 @@ auto Directory::serve(pjs::Context &ctx, Message *request) -> Message* {
     f.raw = std::move(raw);
     f.gz = std::move(gz);
     f.br = std::move(br);
+    if (!get_content_type(ctx, request, f.pathname, f.content_type)) {
+      m_cache.erase(k);
+      return nullptr;
+    }
 
-    std::string ext;
-    auto p = path.find('.', path.rfind('/'));
-    if (p != std::string::npos) ext = path.substr(p+1);
-    for (auto &c : ext) c = std::tolower(c);
-
-    if (auto *cb = m_options.content_types_f.get()) {
-      pjs::Value arg[2], ret;
-      arg[0].set(request);
-      arg[1].set(f.pathname);
-      (*cb)(ctx, 2, arg, ret);
-      if (!ctx.ok()) return nullptr;
-      if (ret.is_object()) {
-        pjs::Value ct;
-        ret.o()->get(ext, ct);
-        auto s = ct.to_string();
-        f.content_type = s;
-        s->release();
-      } else if (!ret.is_nullish()) {
-        auto s = ret.to_string();
-        f.content_type = s;
-        s->release();
+    return get_encoded_response(ctx, f, head);
+  }
+
+  return get_encoded_response(ctx, i->second, head);
+}
+
+//
+// Requests for files already in memory are answered right away.
+// Otherwise, a Promise is returned and the files are loaded, or
+// gzipped, on a FileIO thread so that the event loop never blocks.
+//
+
+auto Directory::serve_cached(pjs::Context &ctx, Message *request, const std::string &path) -> pjs::Object* {
+  pjs::Ref<RequestHead> head = pjs::coerce<RequestHead>(request->head());
+  auto lookup = std::make_shared<CachedLookup>();
+  lookup->path = path;
+  get_accept_encoding(head, lookup->has_gz, lookup->has_br);
+
+  auto i = m_cached_files.find(path);
+  if (i != m_cached_files.end()) lookup->full_path = i->second.full_path;
+
+  if (find_cached(m_root_path, m_index_filenames, *lookup, false)) {
+    if (!lookup->entry) return nullptr;
+    if (!prepare_cached(ctx, request, *lookup)) return nullptr;
+    if (!lookup->use_gzip || lookup->gz) return get_cached_response(*lookup, head);
+  }
+
+  auto promise = pjs::Promise::make();
+  load_cached(request, lookup, pjs::Promise::Settler::make(promise));
+  return promise;
+}
+
+void Directory::load_cached(Message *request, const std::shared_ptr<CachedLookup> &lookup, pjs::Promise::Settler *settler) {
+  pjs::Ref<Directory> self(this);
+  pjs::Ref<Message> req(request);
+  pjs::Ref<pjs::Promise::Settler> s(settler);
+  auto root = m_root_path;
+  auto index_filenames = m_index_filenames;
+  auto prepared = bool(lookup->entry) && lookup->content_type;
+
+  FileIO::submit(
+    FileIO::Op::read,
+    [=]() {
+      if (!prepared) {
+        lookup->entry = nullptr;
+        lookup->br = nullptr;
+        lookup->gz = nullptr;
+        find_cached(root, index_filenames, *lookup, true);
+      } else if (auto e = lookup->entry.get()) {
+        lookup->gz = e->gzip();
       }
+    },
+    [=]() {
+      pjs::Ref<RequestHead> head = pjs::coerce<RequestHead>(req->head());
+      if (!lookup->entry) {
+        s->resolve(pjs::Value::null);
+        return;
+      }
+      if (!prepared) {
+        pjs::Context ctx(Worker::current());
+        if (!self->prepare_cached(ctx, req, *lookup)) {
+          s->reject(ctx.error().to_exception());
+          return;
+        }
+        if (lookup->use_gzip && !lookup->gz) {
+          self->load_cached(req, lookup, s);
+          return;
+        }
+      }
+      s->resolve(self->get_cached_response(*lookup, head));
     }
+  );
+}
 
-    if (!f.content_type) {
-      auto i = m_content_types.find(ext);
-      f.content_type = i == m_content_types.end() ? m_default_content_type.get() : i->second.get();
+//
+// Resolves a request path to the cached file and its precompressed
+// variants. Unless loading is allowed, it gives up by returning false
+// as soon as it runs into a file that is not in memory yet.
+//
+
+bool Directory::find_cached(const std::string &root, const std::list<std::string> &index_filenames, CachedLookup &lookup, bool load) {
+  auto open = [=](const std::string &path, pjs::Ref<FileCache::Entry> &entry) {
+    if (load) {
+      entry = FileCache::get(path);
+      return true;
+    }
+    bool missing;
+    entry = FileCache::find(path, missing);
+    return entry || missing;
+  };
+
+  auto &entry = lookup.entry;
+  if (!lookup.full_path.empty() && !open(lookup.full_path, entry)) return false;
+
+  if (!entry) {
+    lookup.pathname = lookup.path;
+    if (!open(utils::path_join(root, lookup.pathname), entry)) return false;
+    if (!entry) {
+      auto dir = lookup.path;
+      if (dir.empty() || dir.back() != '/') dir += '/';
+      for (const auto &s : index_filenames) {
+        lookup.pathname = dir + s;
+        if (!open(utils::path_join(root, lookup.pathname), entry)) return false;
+        if (entry) break;
+      }
+      if (!entry) return true;
     }
+  }
 
-    return get_encoded_response(ctx, f, head);
+  const auto &full_path = entry->path();
+  if (lookup.has_br && !open(full_path + ".br", lookup.br)) return false;
+  if (!lookup.br && lookup.has_gz && !open(full_path + ".gz", lookup.gz)) return false;
+  return true;
+}
+
+//
+// Runs the callbacks on the file found for a request,
+// remembering its content type for the requests to come
+//
+
+bool Directory::prepare_cached(pjs::Context &ctx, Message *request, CachedLookup &lookup) {
+  auto entry = lookup.entry.get();
+  auto i = m_cached_files.find(lookup.path);
+  if (i == m_cached_files.end() || i->second.full_path != entry->path()) {
+    CachedFile f;
+    f.pathname = pjs::Str::make(lookup.pathname);
+    f.full_path = entry->path();
+    if (!get_content_type(ctx, request, f.pathname, f.content_type)) return false;
+    m_cached_files[lookup.path] = f;
+    i = m_cached_files.find(lookup.path);
   }
 
-  return get_encoded_response(ctx, i->second, head);
+  lookup.content_type = i->second.content_type;
+  lookup.use_gzip = false;
+
+  if (!lookup.br && !lookup.gz && (lookup.has_gz || lookup.has_br) && m_options.compression_f) {
+    pjs::Ref<RequestHead> head = pjs::coerce<RequestHead>(request->head());
+    if (!get_compression(ctx, head, lookup.has_gz, lookup.has_br, i->second.pathname, entry->size(), lookup.use_gzip)) return false;
+    if (lookup.use_gzip) lookup.gz = entry->gzipped();
+  }
+
+  return true;
+}
+
+bool Directory::get_content_type(pjs::Context &ctx, Message *request, pjs::Str *pathname, pjs::Ref<pjs::Str> &content_type) {
+  const auto &path = pathname->str();
+  std::string ext;
+  auto p = path.find('.', path.rfind('/'));
+  if (p != std::string::npos) ext = path.substr(p+1);
+  for (auto &c : ext) c = std::tolower(c);
+
+  content_type = nullptr;
+
+  if (auto *cb = m_options.content_types_f.get()) {
+    pjs::Value arg[2], ret;
+    arg[0].set(request);
+    arg[1].set(pathname);
+    (*cb)(ctx, 2, arg, ret);
+    if (!ctx.ok()) return false;
+    if (ret.is_object()) {
+      pjs::Value ct;
+      ret.o()->get(ext, ct);
+      auto s = ct.to_string();
+      content_type = s;
+      s->release();
+    } else if (!ret.is_nullish()) {
+      auto s = ret.to_string();
+      content_type = s;
+      s->release();
+    }
+  }
+
+  if (!content_type) {
+    auto i = m_content_types.find(ext);
+    content_type = i == m_content_types.end() ? m_default_content_type.get() : i->second.get();
+  }
+
+  return true;
 }
 
 void Directory::set_content_types(pjs::Object *obj) {
@@ -550,9 +945,9 @@ void Directory::set_content_types(pjs::Object *obj) {
   }
 }
 
-auto Directory::get_encoded_response(pjs::Context &ctx, File &file, RequestHead *request) -> Message* {
-  bool has_gz = false;
-  bool has_br = false;
+void Directory::get_accept_encoding(RequestHead *request, bool &has_gz, bool &has_br) {
+  has_gz = false;
+  has_br = false;
 
   pjs::Value accept_encoding;
   if (auto headers = request->headers.get()) {
@@ -571,6 +966,11 @@ auto Directory::get_encoded_response(pjs::Context &ctx, File &file, RequestHead
       }
     }
   }
+}
+
+auto Directory::get_encoded_response(pjs::Context &ctx, File &file, RequestHead *request) -> Message* {
+  bool has_gz, has_br;
+  get_accept_encoding(request, has_gz, has_br);
 
   Message *response = nullptr;
   auto head = ResponseHead::make();
@@ -592,29 +992,12 @@ auto Directory::get_encoded_response(pjs::Context &ctx, File &file, RequestHead
     auto output = [&](const Data &data) { body->push(data); };
 
     if ((has_gz || has_br) && m_options.compression_f) {
-      auto accept_encoding = pjs::Object::make();
-      if (has_gz) accept_encoding->set(s_gzip, true);
-      if (has_br) accept_encoding->set(s_br, true);
-      pjs::Value args[4], ret;
-      args[0].set(request);
-      args[1].set(accept_encoding);
-      args[2].set(file.pathname.get());
-      args[3].set(file.raw.size());
-      (*m_options.compression_f)(ctx, 4, args, ret);
-      if (!ctx.ok()) return nullptr;
-      if (ret.to_boolean()) {
-        if (!ret.is_string()) {
-          ctx.error("callback expected to return a string");
-          return nullptr;
-        }
-        if (ret.s() == s_gzip) {
-          compressor = Compressor::gzip(output);
-          body = &file.gz;
-          headers->set(s_content_encoding.get(), s_gzip.get());
-        } else {
-          ctx.error("callback returned an unsupported compression algorithm");
-          return nullptr;
-        }
+      bool use_gzip;
+      if (!get_compression(ctx, request, has_gz, has_br, file.pathname, file.raw.size(), use_gzip)) return nullptr;
+      if (use_gzip) {
+        compressor = Compressor::gzip(output);
+        body = &file.gz;
+        headers->set(s_content_encoding.get(), s_gzip.get());
       }
     }
 
@@ -630,6 +1013,172 @@ auto Directory::get_encoded_response(pjs::Context &ctx, File &file, RequestHead
   return response;
 }
 
+bool Directory::get_compression(
+  pjs::Context &ctx, RequestHead *request,
+  bool has_gz, bool has_br,
+  pjs::Str *pathname, size_t size,
+  bool &use_gzip
+) {
+  use_gzip = false;
+  auto accept_encoding = pjs::Object::make();
+  if (has_gz) accept_encoding->set(s_gzip, true);
+  if (has_br) accept_encoding->set(s_br, true);
+  pjs::Value args[4], ret;
+  args[0].set(request);
+  args[1].set(accept_encoding);
+  args[2].set(pathname);
+  args[3].set(double(size));
+  (*m_options.compression_f)(ctx, 4, args, ret);
+  if (!ctx.ok()) return false;
+  if (ret.to_boolean()) {
+    if (!ret.is_string()) {
+      ctx.error("callback expected to return a string");
+      return false;
+    }
+    if (ret.s() == s_gzip) {
+      use_gzip = true;
+    } else {
+      ctx.error("callback returned an unsupported compression algorithm");
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool parse_size(const std::string &str, size_t &size) {
+  if (str.empty() || str.length() > 18) return false;
+  size = 0;
+  for (auto c : str) {
+    if (c < '0' || c > '9') return false;
+    size = size * 10 + (c - '0');
+  }
+  return true;
+}
+
+//
+// Parses a single byte range. Returns 1 for a valid range, -1 for
+// an unsatisfiable one and 0 if the header should be ignored, which
+// is also what we do with multi-range requests.
+//
+
+static int parse_byte_range(const std::string &str, size_t size, size_t &first, size_t &last) {
+  if (!utils::starts_with(str, "bytes=")) return 0;
+  auto r = utils::trim(str.substr(6));
+  if (r.find(',') != std::string::npos) return 0;
+  auto p = r.find('-');
+  if (p == std::string::npos) return 0;
+  auto a = utils::trim(r.substr(0, p));
+  auto b = utils::trim(r.substr(p + 1));
+  if (a.empty()) {
+    size_t n;
+    if (!parse_size(b, n)) return 0;
+    if (n == 0 || size == 0) return -1;
+    first = n >= size ? 0 : size - n;
+    last = size - 1;
+    return 1;
+  }
+  if (!parse_size(a, first)) return 0;
+  if (b.empty()) {
+    last = size - 1;
+  } else {
+    if (!parse_size(b, last)) return 0;
+    if (last < first) return 0;
+    if (last >= size) last = size - 1;
+  }
+  if (first >= size) return -1;
+  return 1;
+}
+
+static bool etag_matches(const std::string &header, const std::string &etag) {
+  size_t i = 0;
+  while (i < header.length()) {
+    auto p = header.find(',', i);
+    if (p == std::string::npos) p = header.length();
+    auto tag = utils::trim(header.substr(i, p - i));
+    if (tag == "*") return true;
+    if (utils::starts_with(tag, "W/")) tag = tag.substr(2);
+    if (tag == etag) return true;
+    i = p + 1;
+  }
+  return false;
+}
+
+auto Directory::get_cached_response(CachedLookup &lookup, RequestHead *request) -> Message* {
+  auto head = ResponseHead::make();
+  auto headers = Object::make();
+  head->headers = headers;
+  headers->set(s_content_type.get(), lookup.content_type.get());
+  headers->set(s_vary.get(), s_accept_encoding.get());
+
+  FileCache::Entry *encoded = nullptr;
+  if (auto br = lookup.br.get()) {
+    encoded = br;
+    headers->set(s_content_encoding.get(), s_br.get());
+  } else if (auto gz = lookup.gz.get()) {
+    encoded = gz;
+    headers->set(s_content_encoding.get(), s_gzip.get());
+  }
+
+  auto rep = encoded ? encoded : lookup.entry.get();
+  auto etag = pjs::Str::make(rep->etag());
+  auto last_modified = pjs::Str::make(rep->last_modified());
+  headers->set(s_etag.get(), etag);
+  headers->set(s_last_modified.get(), last_modified);
+  headers->set(s_accept_ranges.get(), s_bytes.get());
+
+  auto request_headers = request->headers.get();
+  auto get_header = [&](pjs::Str *name) -> pjs::Str* {
+    pjs::Value v;
+    if (request_headers) request_headers->get(name, v);
+    return v.is_string() ? v.s() : nullptr;
+  };
+
+  if (auto s = get_header(s_if_none_match)) {
+    if (etag_matches(s->str(), rep->etag())) {
+      head->status = 304;
+      return Message::make(head, nullptr);
+    }
+  } else if (auto s = get_header(s_if_modified_since)) {
+    if (s->str() == rep->last_modified()) {
+      head->status = 304;
+      return Message::make(head, nullptr);
+    }
+  }
+
+  auto size = rep->size();
+  auto body = Data::make();
+
+  if (auto s = get_header(s_range)) {
+    auto if_range = get_header(s_if_range);
+    if (!if_range || if_range->str() == rep->etag() || if_range->str() == rep->last_modified()) {
+      size_t first = 0, last = 0;
+      char str[100];
+      switch (parse_byte_range(s->str(), size, first, last)) {
+        case 1:
+          std::snprintf(
+            str, sizeof(str), "bytes %llu-%llu/%llu",
+            (unsigned long long)first,
+            (unsigned long long)last,
+            (unsigned long long)size
+          );
+          head->status = 206;
+          headers->set(s_content_range.get(), pjs::Str::make(str));
+          rep->to_data(*body, first, last - first + 1);
+          return Message::make(head, body);
+        case -1:
+          std::snprintf(str, sizeof(str), "bytes */%llu", (unsigned long long)size);
+          head->status = 416;
+          headers->set(s_content_range.get(), pjs::Str::make(str));
+          return Message::make(head, body);
+        default: break;
+      }
+    }
+  }
+
+  rep->to_data(*body);
+  return Message::make(head, body);
+}
+
 //
 // Directory::CodebaseLoader
 //
@@ -675,8 +1224,9 @@ bool Directory::FileSystemLoader::load_file(const std::string &path, Data &data)
 // TarballLoader
 //
 
-Directory::TarballLoader::TarballLoader(const char *data, size_t size)
-  : m_tarball(data, size)
+Directory::TarballLoader::TarballLoader(std::vector<uint8_t> &&data)
+  : m_data(std::move(data))
+  , m_tarball((const char *)m_data.data(), m_data.size())
 {
 }
 
@@ -882,8 +1432,16 @@ template<> void EnumDef<StringConstants>::init() {
 
 template<> void ClassDef<MessageHead>::init() {
   field<Ref<Str>>("protocol", [](MessageHead *obj) { return &obj->protocol; });
-  field<Ref<Object>>("headers", [](MessageHead *obj) { return &obj->headers; });
-  field<Ref<Object>>("headerNames", [](MessageHead *obj) { return &obj->headerNames; });
+  accessor("headers",
+    [](Object *obj, Value &ret) { ret.set(obj->as<MessageHead>()->headers.get()); },
+    [](Object *obj, const Value &val) { obj->as<MessageHead>()->headers = val.is_object() ? val.o() : nullptr; },
+    Field::Enumerable
+  );
+  accessor("headerNames",
+    [](Object *obj, Value &ret) { ret.set(obj->as<MessageHead>()->headers.names()); },
+    [](Object *obj, const Value &val) { obj->as<MessageHead>()->headers.set_names(val.is_object() ? val.o() : nullptr); },
+    Field::Enumerable
+  );
 }
 
 template<> void ClassDef<MessageTail>::init() {
@@ -31,8 +31,10 @@
 #include "module.hpp"
 #include "message.hpp"
 #include "tar.hpp"
+#include "file-cache.hpp"
 #include "options.hpp"
 
+#include <memory>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -50,11 +52,112 @@ enum class TunnelType {
   HTTP2,
 };
 
+//
+// HeaderList
+//
+// Header fields as they came off the wire. Fields sharing a name are
+// chained after the first one, so they are visited together in the
+// same order as setting them on an object would give. Names are
+// looked up by a linear scan until the list grows long enough to be
+// worth indexing.
+//
+
+class HeaderList :
+  public pjs::Pooled<HeaderList>,
+  public pjs::RefCount<HeaderList>
+{
+public:
+  struct Field {
+    pjs::Str* known; // pre-interned lowercase name of a well-known header
+    uint32_t name;
+    uint32_t name_len;
+    uint32_t value;
+    uint32_t value_len;
+    uint32_t next; // next field with the same name, 0 if none
+    uint32_t last; // last field in the chain, only kept on the first one
+    bool dup;      // follows an earlier field with the same name
+  };
+
+  static auto make() -> HeaderList* {
+    return new HeaderList();
+  }
+
+  static auto lookup(const char *name, size_t len) -> pjs::Str*;
+
+  template<class F>
+  void iterate(const F &cb) const {
+    for (const auto &f : m_fields) {
+      if (f.dup) continue;
+      for (auto p = &f;; p = &m_fields[p->next]) {
+        cb(*p);
+        if (!p->next) break;
+      }
+    }
+  }
+
+  auto name(const Field &f) const -> const char* { return m_buffer.c_str() + f.name; }
+  auto value(const Field &f) const -> const char* { return m_buffer.c_str() + f.value; }
+
+  void add(pjs::Str *known, const char *name, size_t name_len, const char *value, size_t value_len);
+  bool get(pjs::Str *name, pjs::Value &value) const;
+  void to_object(pjs::Object *headers, pjs::Object *names) const;
+
+private:
+  HeaderList() {}
+
+  std::string m_buffer;
+  std::vector<Field> m_fields;
+  std::unordered_map<std::string, uint32_t> m_index;
+
+  auto find(pjs::Str *known, const char *name, size_t len) const -> int;
+  auto key(pjs::Str *known, const char *name, size_t len) const -> std::string;
+  bool match(const Field &f, pjs::Str *known, const char *name, size_t len) const;
+
+  friend class pjs::RefCount<HeaderList>;
+};
+
+//
+// Headers
+//
+// Headers of a message as an object for scripts to work with. Messages
+// from the HTTP/1 decoder start with a native HeaderList and have
+// their objects made only when somebody asks for them.
+//
+
+class Headers {
+public:
+  Headers() {}
+  Headers(pjs::Object *obj) : m_object(obj) {}
+
+  auto native() const -> HeaderList* { return m_list; }
+  auto get() const -> pjs::Object* { if (m_list) materialize(); return m_object; }
+  auto names() const -> pjs::Object* { if (m_list) materialize(); return m_names; }
+  bool find(pjs::Str *name, pjs::Value &value) const;
+
+  void set_native(HeaderList *list) { m_object = nullptr; m_names = nullptr; m_list = list; }
+  void set_names(pjs::Object *names) { if (m_list) materialize(); m_names = names; }
+
+  auto operator=(pjs::Object *obj) -> Headers& { m_list = nullptr; m_object = obj; return *this; }
+  auto operator->() const -> pjs::Object* { return get(); }
+  operator pjs::Object*() const { return get(); }
+  explicit operator bool() const { return m_list || m_object; }
+
+private:
+  mutable pjs::Ref<pjs::Object> m_object;
+  mutable pjs::Ref<pjs::Object> m_names;
+  mutable pjs::Ref<HeaderList> m_list;
+
+  void materialize() const;
+};
+
+//
+// MessageHead
+//
+
 class MessageHead : public pjs::ObjectTemplate<MessageHead> {
 public:
   pjs::Ref<pjs::Str> protocol;
-  pjs::Ref<pjs::Object> headers;
-  pjs::Ref<pjs::Object> headerNames;
+  Headers headers;
 
   bool is_final() const;
   bool is_final(pjs::Str *header_connection) const;
@@ -176,6 +279,8 @@ public:
   struct Options : public pipy::Options {
     bool fs = false;
     bool tarball = false;
+    bool cache = false;
+    size_t cache_size = 64*1024*1024;
     pjs::Ref<pjs::Str> index;
     pjs::Ref<pjs::Array> index_list;
     pjs::Ref<pjs::Object> content_types;
@@ -190,7 +295,7 @@ public:
   Directory(const std::string &path, const Options &options);
   ~Directory();
 
-  auto serve(pjs::Context &ctx, Message *request) -> Message*;
+  auto serve(pjs::Context &ctx, Message *request) -> pjs::Object*;
   void set_content_types(pjs::Object *obj);
 
 private:
@@ -200,6 +305,25 @@ private:
     Data raw, gz, br;
   };
 
+  struct CachedFile {
+    pjs::Ref<pjs::Str> pathname;
+    pjs::Ref<pjs::Str> content_type;
+    std::string full_path;
+  };
+
+  struct CachedLookup {
+    std::string path;
+    std::string pathname;
+    std::string full_path;
+    pjs::Ref<pjs::Str> content_type;
+    pjs::Ref<FileCache::Entry> entry;
+    pjs::Ref<FileCache::Entry> br;
+    pjs::Ref<FileCache::Entry> gz;
+    bool has_br = false;
+    bool has_gz = false;
+    bool use_gzip = false;
+  };
+
   class Loader {
   public:
     virtual ~Loader() {}
@@ -222,19 +346,31 @@ private:
 
   class TarballLoader : public Loader {
   public:
-    TarballLoader(const char *data, size_t size);
+    TarballLoader(std::vector<uint8_t> &&data);
     virtual bool load_file(const std::string &path, Data &data) override;
+    std::vector<uint8_t> m_data; // Tarball only points into it
     Tarball m_tarball;
   };
 
   Options m_options;
   Loader* m_loader = nullptr;
   std::unordered_map<std::string, File> m_cache;
+  std::unordered_map<std::string, CachedFile> m_cached_files;
+  std::string m_root_path;
   std::list<std::string> m_index_filenames;
   std::map<std::string, pjs::Ref<pjs::Str>> m_content_types;
   pjs::Ref<pjs::Str> m_default_content_type;
 
+  auto serve_cached(pjs::Context &ctx, Message *request, const std::string &path) -> pjs::Object*;
+  void load_cached(Message *request, const std::shared_ptr<CachedLookup> &lookup, pjs::Promise::Settler *settler);
+  bool prepare_cached(pjs::Context &ctx, Message *request, CachedLookup &lookup);
+  bool get_content_type(pjs::Context &ctx, Message *request, pjs::Str *pathname, pjs::Ref<pjs::Str> &content_type);
+  bool get_compression(pjs::Context &ctx, RequestHead *request, bool has_gz, bool has_br, pjs::Str *pathname, size_t size, bool &use_gzip);
   auto get_encoded_response(pjs::Context &ctx, File &file, RequestHead *request) -> Message*;
+  auto get_cached_response(CachedLookup &lookup, RequestHead *request) -> Message*;
+
+  static void get_accept_encoding(RequestHead *request, bool &has_gz, bool &has_br);
+  static bool find_cached(const std::string &root, const std::list<std::string> &index_filenames, CachedLookup &lookup, bool load);
 
   static Data::Producer s_dp;
 };
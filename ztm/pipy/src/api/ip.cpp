@@ -345,7 +345,7 @@ auto IPMask::first() -> pjs::Str* {
   if (!m_first) {
     if (m_ip_full.is_v6()) {
       uint16_t data[8];
-      for (int i = 0; i < 7; i++) data[i] = m_ip_base.v6()[i];
+      for (int i = 0; i < 8; i++) data[i] = m_ip_base.v6()[i];
       data[7] |= (~m_ip_mask.v6()[7] & 1);
       m_first = IPAddressData(data).to_string();
     } else {
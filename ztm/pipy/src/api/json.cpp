@@ -25,9 +25,17 @@
 
 #include "json.hpp"
 #include "utils.hpp"
-#include "yajl/yajl_parse.h"
 
-#include <stack>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PIPY_JSON_SIMD
+#include <immintrin.h>
+#endif
 
 namespace pjs {
 
@@ -131,6 +139,66 @@ template<> void ClassDef<JSON>::init() {
     JSON::encode(val, rep, space, *data);
     ret.set(data);
   });
+
+  method("view", [](Context &ctx, Object *obj, Value &ret) {
+    Str *str;
+    pipy::Data *data;
+    JSON::View *view = nullptr;
+    std::string err;
+    if (ctx.get(0, str)) {
+      view = JSON::view(str->str(), err);
+    } else if (ctx.get(0, data) && data) {
+      view = JSON::view(*data, err);
+    } else {
+      ctx.error_argument_type(0, "a string or a Data");
+      return;
+    }
+    if (!view) {
+      ctx.error(err);
+      return;
+    }
+    ret.set(view);
+  });
+}
+
+//
+// JSON::View
+//
+
+template<> void ClassDef<JSON::View>::init() {
+  method("get", [](Context &ctx, Object *obj, Value &ret) {
+    try {
+      ret = obj->as<JSON::View>()->get(ctx.argc(), ctx.argv());
+    } catch (std::runtime_error &err) {
+      ctx.error(err);
+    }
+  });
+
+  method("has", [](Context &ctx, Object *obj, Value &ret) {
+    try {
+      ret.set(obj->as<JSON::View>()->has(ctx.argc(), ctx.argv()));
+    } catch (std::runtime_error &err) {
+      ctx.error(err);
+    }
+  });
+
+  method("keys", [](Context &ctx, Object *obj, Value &ret) {
+    try {
+      auto a = obj->as<JSON::View>()->keys(ctx.argc(), ctx.argv());
+      if (a) ret.set(a); else ret = Value::undefined;
+    } catch (std::runtime_error &err) {
+      ctx.error(err);
+    }
+  });
+
+  method("size", [](Context &ctx, Object *obj, Value &ret) {
+    try {
+      auto n = obj->as<JSON::View>()->size(ctx.argc(), ctx.argv());
+      if (n >= 0) ret.set(n); else ret = Value::undefined;
+    } catch (std::runtime_error &err) {
+      ctx.error(err);
+    }
+  });
 }
 
 } // namespace pjs
@@ -140,93 +208,669 @@ namespace pipy {
 static Data::Producer s_dp("JSON");
 
 //
-// JSONVisitor
+// Scanners
+//
+// Each scanner returns the offset of the first byte it stops at, or
+// the length of the input if there is none. On x86-64, 16 bytes are
+// tested at a time with SSE2, or 32 bytes with AVX2 when the CPU
+// supports it.
+//
+
+static inline bool is_space(char c) {
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+// Stops at '"', '\\' or a control character. Sets non_ascii when
+// any byte skipped over has its high bit set.
+static size_t scan_string_scalar(const char *p, size_t n, bool &non_ascii) {
+  for (size_t i = 0; i < n; i++) {
+    auto c = (uint8_t)p[i];
+    if (c == '"' || c == '\\' || c < 0x20) return i;
+    if (c & 0x80) non_ascii = true;
+  }
+  return n;
+}
+
+// Stops at anything that is not whitespace.
+static size_t scan_space_scalar(const char *p, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    if (!is_space(p[i])) return i;
+  }
+  return n;
+}
+
+// Stops at '"' or a bracket.
+static size_t scan_structure_scalar(const char *p, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    switch (p[i]) {
+      case '"': case '{': case '}': case '[': case ']': return i;
+    }
+  }
+  return n;
+}
+
+#ifdef PIPY_JSON_SIMD
+
+static size_t scan_string_sse2(const char *p, size_t n, bool &non_ascii) {
+  const auto quote = _mm_set1_epi8('"');
+  const auto slash = _mm_set1_epi8('\\');
+  const auto ctrl = _mm_set1_epi8(0x1f);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    auto v = _mm_loadu_si128((const __m128i *)(p + i));
+    auto m = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, slash)),
+      _mm_cmpeq_epi8(_mm_min_epu8(v, ctrl), v)
+    );
+    auto hits = (unsigned)_mm_movemask_epi8(m);
+    auto high = (unsigned)_mm_movemask_epi8(v);
+    if (hits) {
+      auto k = __builtin_ctz(hits);
+      if (high & ((1u << k) - 1)) non_ascii = true;
+      return i + k;
+    }
+    if (high) non_ascii = true;
+  }
+  return i + scan_string_scalar(p + i, n - i, non_ascii);
+}
+
+static size_t scan_space_sse2(const char *p, size_t n) {
+  const auto sp = _mm_set1_epi8(' ');
+  const auto lf = _mm_set1_epi8('\n');
+  const auto cr = _mm_set1_epi8('\r');
+  const auto ht = _mm_set1_epi8('\t');
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    auto v = _mm_loadu_si128((const __m128i *)(p + i));
+    auto m = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, lf)),
+      _mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, ht))
+    );
+    auto hits = ~(unsigned)_mm_movemask_epi8(m) & 0xffff;
+    if (hits) return i + __builtin_ctz(hits);
+  }
+  return i + scan_space_scalar(p + i, n - i);
+}
+
+static size_t scan_structure_sse2(const char *p, size_t n) {
+  const auto quote = _mm_set1_epi8('"');
+  const auto lb = _mm_set1_epi8('{');
+  const auto rb = _mm_set1_epi8('}');
+  const auto ls = _mm_set1_epi8('[');
+  const auto rs = _mm_set1_epi8(']');
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    auto v = _mm_loadu_si128((const __m128i *)(p + i));
+    auto m = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, lb)),
+      _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, rb), _mm_cmpeq_epi8(v, ls)),
+        _mm_cmpeq_epi8(v, rs)
+      )
+    );
+    auto hits = (unsigned)_mm_movemask_epi8(m);
+    if (hits) return i + __builtin_ctz(hits);
+  }
+  return i + scan_structure_scalar(p + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static size_t scan_string_avx2(const char *p, size_t n, bool &non_ascii) {
+  const auto quote = _mm256_set1_epi8('"');
+  const auto slash = _mm256_set1_epi8('\\');
+  const auto ctrl = _mm256_set1_epi8(0x1f);
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    auto v = _mm256_loadu_si256((const __m256i *)(p + i));
+    auto m = _mm256_or_si256(
+      _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, slash)),
+      _mm256_cmpeq_epi8(_mm256_min_epu8(v, ctrl), v)
+    );
+    auto hits = (unsigned)_mm256_movemask_epi8(m);
+    auto high = (unsigned)_mm256_movemask_epi8(v);
+    if (hits) {
+      auto k = __builtin_ctz(hits);
+      if (high & ((1u << k) - 1)) non_ascii = true;
+      return i + k;
+    }
+    if (high) non_ascii = true;
+  }
+  return i + scan_string_sse2(p + i, n - i, non_ascii);
+}
+
+__attribute__((target("avx2")))
+static size_t scan_space_avx2(const char *p, size_t n) {
+  const auto sp = _mm256_set1_epi8(' ');
+  const auto lf = _mm256_set1_epi8('\n');
+  const auto cr = _mm256_set1_epi8('\r');
+  const auto ht = _mm256_set1_epi8('\t');
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    auto v = _mm256_loadu_si256((const __m256i *)(p + i));
+    auto m = _mm256_or_si256(
+      _mm256_or_si256(_mm256_cmpeq_epi8(v, sp), _mm256_cmpeq_epi8(v, lf)),
+      _mm256_or_si256(_mm256_cmpeq_epi8(v, cr), _mm256_cmpeq_epi8(v, ht))
+    );
+    auto hits = ~(unsigned)_mm256_movemask_epi8(m);
+    if (hits) return i + __builtin_ctz(hits);
+  }
+  return i + scan_space_sse2(p + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static size_t scan_structure_avx2(const char *p, size_t n) {
+  const auto quote = _mm256_set1_epi8('"');
+  const auto lb = _mm256_set1_epi8('{');
+  const auto rb = _mm256_set1_epi8('}');
+  const auto ls = _mm256_set1_epi8('[');
+  const auto rs = _mm256_set1_epi8(']');
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    auto v = _mm256_loadu_si256((const __m256i *)(p + i));
+    auto m = _mm256_or_si256(
+      _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, lb)),
+      _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, rb), _mm256_cmpeq_epi8(v, ls)),
+        _mm256_cmpeq_epi8(v, rs)
+      )
+    );
+    auto hits = (unsigned)_mm256_movemask_epi8(m);
+    if (hits) return i + __builtin_ctz(hits);
+  }
+  return i + scan_structure_sse2(p + i, n - i);
+}
+
+#endif // PIPY_JSON_SIMD
+
+struct Scanners {
+  size_t (*string)(const char *p, size_t n, bool &non_ascii);
+  size_t (*space)(const char *p, size_t n);
+  size_t (*structure)(const char *p, size_t n);
+};
+
+static const Scanners& scanners() {
+#ifdef PIPY_JSON_SIMD
+  static const Scanners s_scanners = __builtin_cpu_supports("avx2")
+    ? Scanners{ scan_string_avx2, scan_space_avx2, scan_structure_avx2 }
+    : Scanners{ scan_string_sse2, scan_space_sse2, scan_structure_sse2 };
+#else
+  static const Scanners s_scanners = { scan_string_scalar, scan_space_scalar, scan_structure_scalar };
+#endif
+  return s_scanners;
+}
+
+static auto error_message(size_t position, const char *msg) -> std::string {
+  char buf[1000];
+  std::snprintf(buf, sizeof(buf), "In JSON at position %d: %s", int(position), msg);
+  return buf;
+}
+
+//
+// JSONReader
+//
+// Streaming parser driving a JSON::Visitor. Input can be fed in any
+// number of pieces, with tokens split anywhere between them. Strings
+// that have no escapes and sit within one piece are passed on without
+// being copied. Errors are reported at the offset of the byte where
+// they are found.
 //
 
-class JSONVisitor {
+class JSONReader {
 public:
-  JSONVisitor(JSON::Visitor *visitor) : m_parser(yajl_alloc(&s_callbacks, nullptr, visitor)) {}
-  ~JSONVisitor() { yajl_free(m_parser); }
+  JSONReader(JSON::Visitor *visitor, size_t offset = 0)
+    : m_visitor(visitor)
+    , m_offset(offset) {}
 
-  bool visit(const std::string &str, std::string &err) {
-    if (yajl_status_ok == yajl_parse(m_parser, (const unsigned char*)str.c_str(), str.length()) &&
-        yajl_status_ok == yajl_complete_parse(m_parser)
-    ) return true;
-    get_error(0, err);
+  bool visit(const char *str, size_t len, std::string &err) {
+    if (feed(str, len) && finish()) return true;
+    err = m_error;
     return false;
   }
 
+  bool visit(const std::string &str, std::string &err) {
+    return visit(str.c_str(), str.length(), err);
+  }
+
   bool visit(const Data &data, std::string &err) {
-    size_t pos = 0;
     for (const auto c : data.chunks()) {
-      auto ptr = std::get<0>(c);
-      auto len = std::get<1>(c);
-      auto ret = yajl_parse(m_parser, (const unsigned char*)ptr, len);
-      if (ret != yajl_status_ok) {
-        get_error(pos, err);
+      if (!feed(std::get<0>(c), std::get<1>(c))) {
+        err = m_error;
         return false;
       }
-      pos += len;
     }
-    if (yajl_status_ok != yajl_complete_parse(m_parser)) {
-      get_error(pos, err);
+    if (finish()) return true;
+    err = m_error;
+    return false;
+  }
+
+private:
+  enum State {
+    VALUE,
+    FIRST_ELEMENT,
+    FIRST_KEY,
+    KEY,
+    COLON,
+    AFTER_VALUE,
+    STRING,
+    ESCAPE,
+    UNICODE,
+    NUMBER,
+    LITERAL,
+    DONE,
+    ERROR,
+  };
+
+  JSON::Visitor* m_visitor;
+  State m_state = VALUE;
+  std::string m_stack;
+  std::string m_buffer;
+  std::string m_error;
+  const char* m_chunk = nullptr;
+  size_t m_offset;
+  size_t m_token = 0;
+  bool m_is_key = false;
+  bool m_in_place = false;
+  int m_utf8_remaining = 0;
+  uint8_t m_utf8_min = 0x80;
+  uint8_t m_utf8_max = 0xbf;
+  int m_hex_digits = 0;
+  uint32_t m_hex = 0;
+  uint32_t m_surrogate = 0;
+
+  auto position(const char *p) const -> size_t {
+    return m_offset + (p - m_chunk);
+  }
+
+  bool feed(const char *data, size_t size) {
+    if (m_state == ERROR) return false;
+    auto p = data;
+    auto end = data + size;
+    m_chunk = data;
+    while (p < end) {
+      switch (m_state) {
+        case STRING: p = read_string(p, end); break;
+        case ESCAPE: p = read_escape(p); break;
+        case UNICODE: p = read_unicode(p); break;
+        case NUMBER: p = read_number(p, end); break;
+        case LITERAL: p = read_literal(p, end); break;
+        default: p = read_structure(p, end); break;
+      }
+      if (!p) return false;
+    }
+    m_offset += size;
+    return true;
+  }
+
+  bool finish() {
+    if (m_state == ERROR) return false;
+    if (m_state == NUMBER && !end_number()) return false;
+    if (m_state == LITERAL && !end_literal()) return false;
+    if (m_state != DONE) {
+      fail(m_offset, "parse error: premature EOF");
       return false;
     }
     return true;
   }
 
-private:
-  yajl_handle m_parser;
-
-  void get_error(size_t base_position, std::string &err) {
-    auto err_str = yajl_get_error(m_parser, false, nullptr, 0);
-    char str_buf[1000];
-    std::snprintf(
-      str_buf, sizeof(str_buf),
-      "In JSON at position %d: %s",
-      int(base_position + yajl_get_bytes_consumed(m_parser)),
-      err_str
-    );
-    err.assign(str_buf);
-    yajl_free_error(m_parser, err_str);
-  }
-
-  static yajl_callbacks s_callbacks;
-
-  static int yajl_null(void *ctx) { static_cast<JSON::Visitor*>(ctx)->null(); return 1; }
-  static int yajl_boolean(void *ctx, int val) { static_cast<JSON::Visitor*>(ctx)->boolean(val); return 1; }
-  static int yajl_integer(void *ctx, long long val) { static_cast<JSON::Visitor*>(ctx)->integer(val); return 1; }
-  static int yajl_double(void *ctx, double val) { static_cast<JSON::Visitor*>(ctx)->number(val); return 1; }
-  static int yajl_string(void *ctx, const unsigned char *val, size_t len) { static_cast<JSON::Visitor*>(ctx)->string((const char *)val, len); return 1; }
-  static int yajl_start_map(void *ctx) { static_cast<JSON::Visitor*>(ctx)->map_start(); return 1; }
-  static int yajl_map_key(void *ctx, const unsigned char *key, size_t len) { static_cast<JSON::Visitor*>(ctx)->map_key((const char *)key, len); return 1; }
-  static int yajl_end_map(void *ctx) { static_cast<JSON::Visitor*>(ctx)->map_end(); return 1; }
-  static int yajl_start_array(void *ctx) { static_cast<JSON::Visitor*>(ctx)->array_start(); return 1; }
-  static int yajl_end_array(void *ctx) { static_cast<JSON::Visitor*>(ctx)->array_end(); return 1; }
-};
+  auto read_structure(const char *p, const char *end) -> const char* {
+    auto c = *p;
+    if (is_space(c)) {
+      p++;
+      return p + scanners().space(p, end - p);
+    }
+    switch (m_state) {
+      case VALUE:
+        return start_value(p);
+      case FIRST_ELEMENT:
+        if (c == ']') return end_container(p);
+        return start_value(p);
+      case FIRST_KEY:
+        if (c == '}') return end_container(p);
+        // fall through
+      case KEY:
+        if (c != '"') return fail(position(p), "parse error: invalid object key (must be a string)");
+        m_is_key = true;
+        return start_string(p);
+      case COLON:
+        if (c != ':') return fail(position(p), "parse error: object key and value must be separated by a colon (':')");
+        m_state = VALUE;
+        return p + 1;
+      case AFTER_VALUE:
+        if (c == ',') {
+          m_state = (m_stack.back() == ']' ? VALUE : KEY);
+          return p + 1;
+        }
+        if (c == m_stack.back()) return end_container(p);
+        return fail(
+          position(p), m_stack.back() == ']'
+            ? "parse error: after array element, I expect ',' or ']'"
+            : "parse error: after key and value, inside map, I expect ',' or '}'"
+        );
+      default:
+        return fail(position(p), "parse error: trailing garbage");
+    }
+  }
+
+  auto start_value(const char *p) -> const char* {
+    switch (*p) {
+      case '{':
+        m_stack.push_back('}');
+        m_visitor->map_start();
+        m_state = FIRST_KEY;
+        return p + 1;
+      case '[':
+        m_stack.push_back(']');
+        m_visitor->array_start();
+        m_state = FIRST_ELEMENT;
+        return p + 1;
+      case '"':
+        m_is_key = false;
+        return start_string(p);
+      case '-': case '0': case '1': case '2': case '3': case '4':
+      case '5': case '6': case '7': case '8': case '9':
+        m_state = NUMBER;
+        m_token = position(p);
+        m_buffer.clear();
+        return p;
+      case 't': case 'f': case 'n':
+        m_state = LITERAL;
+        m_token = position(p);
+        m_buffer.clear();
+        return p;
+      default:
+        return fail(position(p), "parse error: unallowed token at this point in JSON text");
+    }
+  }
+
+  auto end_container(const char *p) -> const char* {
+    auto c = m_stack.back();
+    m_stack.pop_back();
+    if (c == '}') {
+      m_visitor->map_end();
+    } else {
+      m_visitor->array_end();
+    }
+    end_value();
+    return p + 1;
+  }
+
+  void end_value() {
+    m_state = (m_stack.empty() ? DONE : AFTER_VALUE);
+  }
+
+  auto start_string(const char *p) -> const char* {
+    m_state = STRING;
+    m_in_place = true;
+    m_buffer.clear();
+    m_utf8_remaining = 0;
+    m_surrogate = 0;
+    return p + 1;
+  }
+
+  auto read_string(const char *p, const char *end) -> const char* {
+    bool non_ascii = false;
+    auto n = scanners().string(p, end - p, non_ascii);
+    auto q = p + n;
+    if ((non_ascii || m_utf8_remaining > 0) && !check_utf8(p, q)) return nullptr;
+    if (q == end) {
+      append(p, n);
+      return end;
+    }
+    switch (*q) {
+      case '"':
+        if (m_utf8_remaining > 0) return fail(position(q), "lexical error: invalid bytes in UTF8 string");
+        if (m_in_place) {
+          end_string(p, n);
+        } else {
+          append(p, n);
+          flush_surrogate();
+          end_string(m_buffer.c_str(), m_buffer.length());
+        }
+        return q + 1;
+      case '\\':
+        if (m_utf8_remaining > 0) return fail(position(q), "lexical error: invalid bytes in UTF8 string");
+        append(p, n);
+        m_state = ESCAPE;
+        return q + 1;
+      default:
+        return fail(position(q), "lexical error: invalid character inside string");
+    }
+  }
+
+  auto read_escape(const char *p) -> const char* {
+    char c;
+    switch (*p) {
+      case '"': c = '"'; break;
+      case '\\': c = '\\'; break;
+      case '/': c = '/'; break;
+      case 'b': c = '\b'; break;
+      case 'f': c = '\f'; break;
+      case 'n': c = '\n'; break;
+      case 'r': c = '\r'; break;
+      case 't': c = '\t'; break;
+      case 'u':
+        m_state = UNICODE;
+        m_hex = 0;
+        m_hex_digits = 0;
+        return p + 1;
+      default:
+        return fail(position(p), "lexical error: inside a string, '\\' occurs before a character which it may not");
+    }
+    flush_surrogate();
+    m_buffer.push_back(c);
+    m_state = STRING;
+    return p + 1;
+  }
+
+  auto read_unicode(const char *p) -> const char* {
+    auto c = *p;
+    int d;
+    if ('0' <= c && c <= '9') d = c - '0';
+    else if ('a' <= c && c <= 'f') d = c - 'a' + 10;
+    else if ('A' <= c && c <= 'F') d = c - 'A' + 10;
+    else return fail(position(p), "lexical error: invalid (non-hex) character occurs after '\\u' inside string");
+    m_hex = (m_hex << 4) | d;
+    if (++m_hex_digits == 4) {
+      auto u = m_hex;
+      if (0xdc00 <= u && u <= 0xdfff) {
+        if (m_surrogate) {
+          append_utf8(0x10000 + ((m_surrogate - 0xd800) << 10) + (u - 0xdc00));
+          m_surrogate = 0;
+        } else {
+          m_buffer.push_back('?');
+        }
+      } else {
+        flush_surrogate();
+        if (0xd800 <= u && u <= 0xdbff) {
+          m_surrogate = u;
+        } else {
+          append_utf8(u);
+        }
+      }
+      m_state = STRING;
+    }
+    return p + 1;
+  }
+
+  void end_string(const char *s, size_t n) {
+    if (m_is_key) {
+      m_visitor->map_key(s, n);
+      m_state = COLON;
+    } else {
+      m_visitor->string(s, n);
+      end_value();
+    }
+  }
+
+  void append(const char *s, size_t n) {
+    if (m_in_place) {
+      m_buffer.assign(s, n);
+      m_in_place = false;
+    } else if (n > 0) {
+      flush_surrogate();
+      m_buffer.append(s, n);
+    }
+  }
+
+  void append_utf8(uint32_t c) {
+    if (c < 0x80) {
+      m_buffer.push_back(c);
+    } else if (c < 0x800) {
+      m_buffer.push_back(0xc0 | (c >> 6));
+      m_buffer.push_back(0x80 | (c & 0x3f));
+    } else if (c < 0x10000) {
+      m_buffer.push_back(0xe0 | (c >> 12));
+      m_buffer.push_back(0x80 | ((c >> 6) & 0x3f));
+      m_buffer.push_back(0x80 | (c & 0x3f));
+    } else {
+      m_buffer.push_back(0xf0 | (c >> 18));
+      m_buffer.push_back(0x80 | ((c >> 12) & 0x3f));
+      m_buffer.push_back(0x80 | ((c >> 6) & 0x3f));
+      m_buffer.push_back(0x80 | (c & 0x3f));
+    }
+  }
+
+  // A high surrogate not followed by a low one is replaced with '?'
+  void flush_surrogate() {
+    if (m_surrogate) {
+      m_buffer.push_back('?');
+      m_surrogate = 0;
+    }
+  }
+
+  // Rejects overlong forms, surrogates and code points above U+10FFFF.
+  // Sequences can be split across pieces of input.
+  bool check_utf8(const char *p, const char *end) {
+    for (auto s = p; s < end; s++) {
+      auto c = (uint8_t)*s;
+      if (m_utf8_remaining > 0) {
+        if (c < m_utf8_min || c > m_utf8_max) {
+          fail(position(s), "lexical error: invalid bytes in UTF8 string");
+          return false;
+        }
+        m_utf8_min = 0x80;
+        m_utf8_max = 0xbf;
+        m_utf8_remaining--;
+      } else if (c >= 0x80) {
+        if (0xc2 <= c && c <= 0xdf) {
+          m_utf8_remaining = 1;
+        } else if (0xe0 <= c && c <= 0xef) {
+          m_utf8_remaining = 2;
+          if (c == 0xe0) m_utf8_min = 0xa0;
+          else if (c == 0xed) m_utf8_max = 0x9f;
+        } else if (0xf0 <= c && c <= 0xf4) {
+          m_utf8_remaining = 3;
+          if (c == 0xf0) m_utf8_min = 0x90;
+          else if (c == 0xf4) m_utf8_max = 0x8f;
+        } else {
+          fail(position(s), "lexical error: invalid bytes in UTF8 string");
+          return false;
+        }
+      }
+    }
+    return true;
+  }
 
-yajl_callbacks JSONVisitor::s_callbacks = {
-  &JSONVisitor::yajl_null,
-  &JSONVisitor::yajl_boolean,
-  &JSONVisitor::yajl_integer,
-  &JSONVisitor::yajl_double,
-  nullptr,
-  &JSONVisitor::yajl_string,
-  &JSONVisitor::yajl_start_map,
-  &JSONVisitor::yajl_map_key,
-  &JSONVisitor::yajl_end_map,
-  &JSONVisitor::yajl_start_array,
-  &JSONVisitor::yajl_end_array,
+  auto read_number(const char *p, const char *end) -> const char* {
+    auto q = p;
+    while (q < end) {
+      auto c = *q;
+      if (('0' <= c && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E') {
+        q++;
+      } else {
+        break;
+      }
+    }
+    m_buffer.append(p, q - p);
+    if (q == end) return end;
+    return end_number() ? q : nullptr;
+  }
+
+  bool end_number() {
+    const auto &s = m_buffer;
+    auto n = s.length();
+    auto is_digit = [&](size_t i) { return i < n && '0' <= s[i] && s[i] <= '9'; };
+    auto negative = (s[0] == '-');
+    size_t i = (negative ? 1 : 0);
+    if (!is_digit(i)) {
+      fail(m_token + i, "lexical error: malformed number, a digit is required after the minus sign");
+      return false;
+    }
+    if (s[i] == '0') i++; else while (is_digit(i)) i++;
+    auto is_integer = true;
+    if (i < n && s[i] == '.') {
+      is_integer = false;
+      if (!is_digit(++i)) {
+        fail(m_token + i, "lexical error: malformed number, a digit is required after the decimal point");
+        return false;
+      }
+      while (is_digit(i)) i++;
+    }
+    if (i < n && (s[i] == 'e' || s[i] == 'E')) {
+      is_integer = false;
+      i++;
+      if (i < n && (s[i] == '+' || s[i] == '-')) i++;
+      if (!is_digit(i)) {
+        fail(m_token + i, "lexical error: malformed number, a digit is required after the exponent");
+        return false;
+      }
+      while (is_digit(i)) i++;
+    }
+    if (i < n) {
+      fail(m_token + i, "lexical error: malformed number");
+      return false;
+    }
+    // Up to 18 digits always fit in an int64_t
+    if (is_integer && n - (negative ? 1 : 0) <= 18) {
+      int64_t v = 0;
+      for (i = (negative ? 1 : 0); i < n; i++) v = v * 10 + (s[i] - '0');
+      m_visitor->integer(negative ? -v : v);
+    } else {
+      m_visitor->number(std::strtod(s.c_str(), nullptr));
+    }
+    end_value();
+    return true;
+  }
+
+  auto read_literal(const char *p, const char *end) -> const char* {
+    auto q = p;
+    while (q < end && 'a' <= *q && *q <= 'z') q++;
+    m_buffer.append(p, q - p);
+    if (m_buffer.length() > 5) return fail(m_token, "lexical error: invalid string in json text");
+    if (q == end) return end;
+    return end_literal() ? q : nullptr;
+  }
+
+  bool end_literal() {
+    if (m_buffer == "true") {
+      m_visitor->boolean(true);
+    } else if (m_buffer == "false") {
+      m_visitor->boolean(false);
+    } else if (m_buffer == "null") {
+      m_visitor->null();
+    } else {
+      fail(m_token, "lexical error: invalid string in json text");
+      return false;
+    }
+    end_value();
+    return true;
+  }
+
+  auto fail(size_t position, const char *msg) -> const char* {
+    m_error = error_message(position, msg);
+    m_state = ERROR;
+    return nullptr;
+  }
 };
 
 //
 // JSONParser
 //
 
-class JSONParser : public JSONVisitor, public JSON::Visitor {
+class JSONParser : public JSONReader, public JSON::Visitor {
 public:
-  JSONParser(const std::function<bool(pjs::Object*, const pjs::Value&, pjs::Value&)> &reviver)
-    : JSONVisitor(this)
+  JSONParser(const std::function<bool(pjs::Object*, const pjs::Value&, pjs::Value&)> &reviver, size_t offset = 0)
+    : JSONReader(this, offset)
     , m_reviver(reviver) {}
 
   ~JSONParser() {
@@ -237,6 +881,12 @@ public:
     }
   }
 
+  bool parse(const char *str, size_t len, pjs::Value &val, std::string &err) {
+    if (!visit(str, len, err)) return false;
+    val = m_root;
+    return true;
+  }
+
   bool parse(const std::string &str, pjs::Value &val, std::string &err) {
     if (!visit(str, err)) return false;
     val = m_root;
@@ -265,7 +915,7 @@ private:
   void boolean(bool b) { value(b); }
   void integer(int64_t i) { value(double(i)); }
   void number(double n) { value(n); }
-  void string(const char *s, size_t len) { value(std::string(s, len)); }
+  void string(const char *s, size_t len) { value(pjs::Str::make(s, len)); }
 
   void map_start() {
     if (!m_aborted) {
@@ -343,26 +993,35 @@ private:
   }
 };
 
+
 bool JSON::visit(const std::string &str, Visitor *visitor) {
   std::string err;
-  JSONVisitor v(visitor);
-  return v.visit(str, err);
+  JSONReader r(visitor);
+  return r.visit(str, err);
 }
 
 bool JSON::visit(const std::string &str, Visitor *visitor, std::string &err) {
-  JSONVisitor v(visitor);
-  return v.visit(str, err);
+  JSONReader r(visitor);
+  return r.visit(str, err);
 }
 
 bool JSON::visit(const Data &data, Visitor *visitor) {
   std::string err;
-  JSONVisitor v(visitor);
-  return v.visit(data, err);
+  JSONReader r(visitor);
+  return r.visit(data, err);
 }
 
 bool JSON::visit(const Data &data, Visitor *visitor, std::string &err) {
-  JSONVisitor v(visitor);
-  return v.visit(data, err);
+  JSONReader r(visitor);
+  return r.visit(data, err);
+}
+
+auto JSON::view(const std::string &str, std::string &err) -> View* {
+  return View::index(std::string(str), err);
+}
+
+auto JSON::view(const Data &data, std::string &err) -> View* {
+  return View::index(data.to_string(), err);
 }
 
 bool JSON::parse(
@@ -555,4 +1214,232 @@ bool JSON::encode(
   return ret;
 }
 
+//
+// JSON::View
+//
+
+auto JSON::View::index(std::string &&text, std::string &err) -> View* {
+  const auto *p = text.c_str();
+  const auto n = text.length();
+  if (n > std::numeric_limits<uint32_t>::max()) {
+    err = "JSON text too large to view";
+    return nullptr;
+  }
+
+  const auto &scan = scanners();
+  auto start = scan.space(p, n);
+  if (start == n) {
+    err = error_message(n, "parse error: premature EOF");
+    return nullptr;
+  }
+
+  // Only the root container and everything inside it are indexed,
+  // a scalar at the root is left to be parsed when accessed
+  if (p[start] != '{' && p[start] != '[') {
+    return View::make(std::move(text), std::vector<Container>(), start, n);
+  }
+
+  std::vector<Container> containers;
+  std::vector<size_t> stack;
+  size_t i = start;
+  do {
+    i += scan.structure(p + i, n - i);
+    if (i >= n) {
+      err = error_message(n, "parse error: premature EOF");
+      return nullptr;
+    }
+    switch (p[i]) {
+      case '"':
+        for (i++;;) {
+          bool non_ascii = false;
+          i += scan.string(p + i, n - i, non_ascii);
+          if (i >= n) break;
+          if (p[i] == '"') { i++; break; }
+          if (p[i] == '\\' && i + 1 < n) i += 2; else i++;
+        }
+        break;
+      case '{':
+      case '[':
+        stack.push_back(containers.size());
+        containers.push_back({ uint32_t(i), 0 });
+        i++;
+        break;
+      default: {
+        auto &c = containers[stack.back()];
+        if (p[i] != (p[c.start] == '{' ? '}' : ']')) {
+          err = error_message(i, "parse error: unbalanced brackets");
+          return nullptr;
+        }
+        c.end = ++i;
+        stack.pop_back();
+        break;
+      }
+    }
+  } while (!stack.empty());
+
+  auto end = i;
+  i += scan.space(p + i, n - i);
+  if (i < n) {
+    err = error_message(i, "parse error: trailing garbage");
+    return nullptr;
+  }
+
+  return View::make(std::move(text), std::move(containers), start, end);
+}
+
+auto JSON::View::get(int argc, const pjs::Value argv[]) -> pjs::Value {
+  if (auto e = locate(argc, argv)) return value(e);
+  return pjs::Value::undefined;
+}
+
+bool JSON::View::has(int argc, const pjs::Value argv[]) {
+  return locate(argc, argv);
+}
+
+auto JSON::View::keys(int argc, const pjs::Value argv[]) -> pjs::Array* {
+  auto e = locate(argc, argv);
+  if (!e || m_text[e->start] != '{') return nullptr;
+  auto n = node(e->start);
+  auto a = pjs::Array::make(n->keys.size());
+  int i = 0, j = 0;
+  for (const auto &entry : n->entries) {
+    if (n->keys[entry.key.get()] == i++) a->set(j++, entry.key.get());
+  }
+  return a;
+}
+
+auto JSON::View::size(int argc, const pjs::Value argv[]) -> int {
+  auto e = locate(argc, argv);
+  if (!e) return -1;
+  auto c = m_text[e->start];
+  if (c == '{') return node(e->start)->keys.size();
+  if (c == '[') return node(e->start)->entries.size();
+  return -1;
+}
+
+auto JSON::View::locate(int argc, const pjs::Value argv[]) -> Entry* {
+  auto e = &m_root;
+  for (int i = 0; i < argc; i++) {
+    auto c = m_text[e->start];
+    if (c != '{' && c != '[') return nullptr;
+    auto n = node(e->start);
+    const auto &k = argv[i];
+    if (c == '{') {
+      auto s = k.to_string();
+      auto it = n->keys.find(s);
+      s->release();
+      if (it == n->keys.end()) return nullptr;
+      e = &n->entries[it->second];
+    } else {
+      auto d = k.to_number();
+      if (d < 0 || d >= n->entries.size() || d != std::floor(d)) return nullptr;
+      e = &n->entries[size_t(d)];
+    }
+  }
+  return e;
+}
+
+auto JSON::View::node(uint32_t start) -> Node* {
+  auto i = m_nodes.find(start);
+  if (i != m_nodes.end()) return &i->second;
+
+  const auto &scan = scanners();
+  const auto *p = m_text.c_str();
+  const auto is_object = (p[start] == '{');
+  const auto end = container_end(start) - 1;
+
+  Node node;
+  auto pos = start + 1;
+  auto skip = [&]() { pos += scan.space(p + pos, end - pos); };
+  auto fail = [&](const char *msg) { throw std::runtime_error(error_message(pos, msg)); };
+
+  skip();
+  if (pos < end) {
+    for (;;) {
+      pjs::Ref<pjs::Str> key;
+      if (is_object) {
+        if (p[pos] != '"') fail("parse error: invalid object key (must be a string)");
+        auto key_end = scalar_end(pos);
+        bool non_ascii = false;
+        auto len = scan.string(p + pos + 1, end - pos - 1, non_ascii);
+        if (!non_ascii && pos + 1 + len + 1 == key_end) {
+          key = pjs::Str::make(p + pos + 1, len);
+        } else {
+          Entry k(nullptr, pos, key_end);
+          key = value(&k).to_string();
+          key->release();
+        }
+        pos = key_end;
+        skip();
+        if (pos >= end || p[pos] != ':') fail("parse error: object key and value must be separated by a colon (':')");
+        pos++;
+        skip();
+      }
+      if (pos >= end) fail("parse error: unallowed token at this point in JSON text");
+      auto value_end = (p[pos] == '{' || p[pos] == '[') ? container_end(pos) : scalar_end(pos);
+      if (key) node.keys[key.get()] = node.entries.size();
+      node.entries.emplace_back(key.get(), pos, value_end);
+      pos = value_end;
+      skip();
+      if (pos >= end) break;
+      if (p[pos] != ',') {
+        fail(is_object
+          ? "parse error: after key and value, inside map, I expect ',' or '}'"
+          : "parse error: after array element, I expect ',' or ']'"
+        );
+      }
+      pos++;
+      skip();
+    }
+  }
+
+  return &(m_nodes[start] = std::move(node));
+}
+
+auto JSON::View::value(Entry *entry) -> const pjs::Value& {
+  if (!entry->parsed) {
+    static const std::function<bool(pjs::Object*, const pjs::Value&, pjs::Value&)> no_reviver;
+    JSONParser parser(no_reviver, entry->start);
+    std::string err;
+    if (!parser.parse(m_text.c_str() + entry->start, entry->end - entry->start, entry->value, err)) {
+      throw std::runtime_error(err);
+    }
+    entry->parsed = true;
+  }
+  return entry->value;
+}
+
+auto JSON::View::container_end(uint32_t start) -> uint32_t {
+  auto i = std::lower_bound(
+    m_containers.begin(), m_containers.end(), start,
+    [](const Container &c, uint32_t pos) { return c.start < pos; }
+  );
+  return i->end;
+}
+
+auto JSON::View::scalar_end(uint32_t start) -> uint32_t {
+  const auto *p = m_text.c_str();
+  const auto n = m_text.length();
+  size_t i = start;
+  if (p[i] == '"') {
+    for (i++; i < n;) {
+      bool non_ascii = false;
+      i += scanners().string(p + i, n - i, non_ascii);
+      if (i >= n) break;
+      if (p[i] == '"') return i + 1;
+      if (p[i] == '\\' && i + 1 < n) i += 2; else i++;
+    }
+    return n;
+  }
+  while (i < n) {
+    switch (p[i]) {
+      case ',': case '}': case ']': case ':':
+      case ' ': case '\n': case '\r': case '\t':
+        return i;
+    }
+    i++;
+  }
+  return n;
+}
+
 } // namespace pipy
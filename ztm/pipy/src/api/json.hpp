@@ -30,6 +30,8 @@
 #include "data.hpp"
 
 #include <functional>
+#include <unordered_map>
+#include <vector>
 
 namespace pipy {
 
@@ -59,11 +61,72 @@ public:
     virtual void error(const std::string &err) {}
   };
 
+  //
+  // JSON::View
+  //
+  // Read-only view over a JSON text. Only the bracket structure is
+  // indexed up front. Containers are indexed the first time they are
+  // walked through, and values are parsed the first time they are
+  // accessed.
+  //
+
+  class View : public pjs::ObjectTemplate<View> {
+  public:
+    auto get(int argc, const pjs::Value argv[]) -> pjs::Value;
+    bool has(int argc, const pjs::Value argv[]);
+    auto keys(int argc, const pjs::Value argv[]) -> pjs::Array*;
+    auto size(int argc, const pjs::Value argv[]) -> int;
+
+  private:
+    struct Container {
+      uint32_t start;
+      uint32_t end;
+    };
+
+    struct Entry {
+      Entry(pjs::Str *k, uint32_t s, uint32_t e) : key(k), start(s), end(e) {}
+      pjs::Ref<pjs::Str> key;
+      uint32_t start;
+      uint32_t end;
+      pjs::Value value;
+      bool parsed = false;
+    };
+
+    struct Node {
+      std::vector<Entry> entries;
+      std::unordered_map<pjs::Str*, size_t> keys;
+    };
+
+    View(std::string &&text, std::vector<Container> &&containers, uint32_t start, uint32_t end)
+      : m_text(std::move(text))
+      , m_containers(std::move(containers))
+      , m_root(nullptr, start, end) {}
+
+    std::string m_text;
+    std::vector<Container> m_containers;
+    std::unordered_map<uint32_t, Node> m_nodes;
+    Entry m_root;
+
+    static auto index(std::string &&text, std::string &err) -> View*;
+
+    auto locate(int argc, const pjs::Value argv[]) -> Entry*;
+    auto node(uint32_t start) -> Node*;
+    auto value(Entry *entry) -> const pjs::Value&;
+    auto container_end(uint32_t start) -> uint32_t;
+    auto scalar_end(uint32_t start) -> uint32_t;
+
+    friend class pjs::ObjectTemplate<View>;
+    friend class JSON;
+  };
+
   static bool visit(const std::string &str, Visitor *visitor);
   static bool visit(const std::string &str, Visitor *visitor, std::string &err);
   static bool visit(const Data &data, Visitor *visitor);
   static bool visit(const Data &data, Visitor *visitor, std::string &err);
 
+  static auto view(const std::string &str, std::string &err) -> View*;
+  static auto view(const Data &data, std::string &err) -> View*;
+
   static bool parse(
     const std::string &str,
     const std::function<bool(pjs::Object*, const pjs::Value&, pjs::Value&)> &reviver,
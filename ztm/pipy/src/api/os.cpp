@@ -26,6 +26,7 @@
 #include "os.hpp"
 #include "fs.hpp"
 #include "data.hpp"
+#include "file-io.hpp"
 #include "log.hpp"
 
 #include <fstream>
@@ -126,6 +127,38 @@ void OS::write(const std::string &pathname, const std::string &data) {
   fs.write(data.c_str(), data.length());
 }
 
+auto OS::read_async(const std::string &pathname, const ReadOptions &options) -> pjs::Promise* {
+  auto promise = pjs::Promise::make();
+  pjs::Ref<pjs::Promise::Settler> settler(pjs::Promise::Settler::make(promise));
+  FileIO::read_file(
+    pathname, options.cache,
+    [=](Data *data) {
+      if (data) {
+        settler->resolve(Data::make(std::move(*data)));
+      } else {
+        settler->reject(pjs::Error::make(pjs::Str::make("cannot read file: " + pathname)));
+      }
+    }
+  );
+  return promise;
+}
+
+auto OS::write_async(const std::string &pathname, const Data &data) -> pjs::Promise* {
+  auto promise = pjs::Promise::make();
+  pjs::Ref<pjs::Promise::Settler> settler(pjs::Promise::Settler::make(promise));
+  FileIO::write_file(
+    pathname, data,
+    [=](bool ok) {
+      if (ok) {
+        settler->resolve(pjs::Value::undefined);
+      } else {
+        settler->reject(pjs::Error::make(pjs::Str::make("cannot write file: " + pathname)));
+      }
+    }
+  );
+  return promise;
+}
+
 void OS::rename(const std::string &old_name, const std::string &new_name) {
   if (!fs::rename(old_name, new_name)) {
     throw std::runtime_error("cannot rename file: " + old_name + " -> " + new_name);
@@ -202,6 +235,16 @@ OS::MkdirOptions::MkdirOptions(pjs::Object *options) {
     .check_nullable();
 }
 
+//
+// OS::ReadOptions
+//
+
+OS::ReadOptions::ReadOptions(pjs::Object *options) {
+  Value(options, "cache")
+    .get(cache)
+    .check_nullable();
+}
+
 //
 // OS::RmdirOptions
 //
@@ -424,6 +467,18 @@ template<> void ClassDef<OS>::init() {
     }
   });
 
+  // os.readFileAsync
+  method("readFileAsync", [](Context &ctx, Object*, Value &ret) {
+    Str *filename;
+    Object *options = nullptr;
+    if (!ctx.arguments(1, &filename, &options)) return;
+    try {
+      ret.set(OS::read_async(filename->str(), options));
+    } catch (std::runtime_error &err) {
+      ctx.error(err);
+    }
+  });
+
   // os.writeFile
   method("writeFile", [](Context &ctx, Object*, Value &ret) {
     Str *filename;
@@ -441,6 +496,21 @@ template<> void ClassDef<OS>::init() {
       Log::error("%s", err.what());
     }
   });
+
+  // os.writeFileAsync
+  method("writeFileAsync", [](Context &ctx, Object*, Value &ret) {
+    static pipy::Data::Producer s_dp("os.writeFileAsync()");
+    Str *filename;
+    Str *str = nullptr;
+    pipy::Data *data = nullptr;
+    if (!ctx.check(0, filename)) return;
+    if (!ctx.get(1, data) && !ctx.get(1, str)) return ctx.error_argument_type(1, "a Data or string");
+    if (str) {
+      ret.set(OS::write_async(filename->str(), pipy::Data(str->str(), &s_dp)));
+    } else {
+      ret.set(OS::write_async(filename->str(), *data));
+    }
+  });
 }
 
 template<> void EnumDef<OS::Platform>::init() {
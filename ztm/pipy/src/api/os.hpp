@@ -61,6 +61,12 @@ public:
     RmdirOptions(pjs::Object *options);
   };
 
+  struct ReadOptions : public Options {
+    bool cache = false;
+    ReadOptions() {}
+    ReadOptions(pjs::Object *options);
+  };
+
   class Path : public pjs::ObjectTemplate<Path> {
   public:
     static auto dirname(const std::string &path) -> std::string;
@@ -78,6 +84,8 @@ public:
   static auto read(const std::string &pathname) -> Data*;
   static void write(const std::string &pathname, Data *data);
   static void write(const std::string &pathname, const std::string &data);
+  static auto read_async(const std::string &pathname, const ReadOptions &options = ReadOptions()) -> pjs::Promise*;
+  static auto write_async(const std::string &pathname, const Data &data) -> pjs::Promise*;
   static void rename(const std::string &old_name, const std::string &new_name);
   static bool unlink(const std::string &pathname);
   static void mkdir(const std::string &pathname, const MkdirOptions &options = MkdirOptions());
@@ -157,12 +157,12 @@ void PipelineDesigner::accept_tls(pjs::Object *options) {
   require_sub_pipeline(append_filter(new tls::Server(options)));
 }
 
-void PipelineDesigner::compress(const pjs::Value &algorithm) {
-  append_filter(new Compress(algorithm));
+void PipelineDesigner::compress(const pjs::Value &algorithm, pjs::Object *options) {
+  append_filter(new Compress(algorithm, options));
 }
 
-void PipelineDesigner::compress_http(const pjs::Value &algorithm) {
-  append_filter(new CompressHTTP(algorithm));
+void PipelineDesigner::compress_http(const pjs::Value &algorithm, pjs::Object *options) {
+  append_filter(new CompressHTTP(algorithm, options));
 }
 
 void PipelineDesigner::connect(const pjs::Value &target, pjs::Object *options) {
@@ -723,15 +723,17 @@ template<> void ClassDef<PipelineDesigner>::init() {
   // PipelineDesigner.compress
   filter("compress", [](Context &ctx, PipelineDesigner *obj) {
     Value algorithm;
-    if (!ctx.arguments(1, &algorithm)) return;
-    obj->compress(algorithm);
+    Object *options = nullptr;
+    if (!ctx.arguments(1, &algorithm, &options)) return;
+    obj->compress(algorithm, options);
   });
 
   // PipelineDesigner.compressHTTP
   filter("compressHTTP", [](Context &ctx, PipelineDesigner *obj) {
     Value algorithm;
-    if (!ctx.arguments(1, &algorithm)) return;
-    obj->compress_http(algorithm);
+    Object *options = nullptr;
+    if (!ctx.arguments(1, &algorithm, &options)) return;
+    obj->compress_http(algorithm, options);
   });
 
   // PipelineDesigner.connect
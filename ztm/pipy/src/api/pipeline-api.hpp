@@ -60,8 +60,8 @@ public:
   void accept_proxy_protocol(pjs::Function *handler);
   void accept_socks(pjs::Function *handler);
   void accept_tls(pjs::Object *options);
-  void compress(const pjs::Value &algorithm);
-  void compress_http(const pjs::Value &algorithm);
+  void compress(const pjs::Value &algorithm, pjs::Object *options);
+  void compress_http(const pjs::Value &algorithm, pjs::Object *options);
   void connect(const pjs::Value &target, pjs::Object *options);
   void connect_http_tunnel(pjs::Object *handshake);
   void connect_proxy_protocol(const pjs::Value &address);
@@ -25,11 +25,17 @@
 
 #include "protobuf.hpp"
 
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
 #include <limits>
+#include <stdexcept>
 
 namespace pipy {
 
 static Data::Producer s_dp("Protobuf");
+static const int s_max_depth = 100;
 
 //
 // Protobuf
@@ -610,6 +616,1074 @@ auto Protobuf::Message::encode_sint(int64_t n) -> uint64_t {
   return (n << 1) ^ (n >> 63);
 }
 
+//
+// Wire format helpers
+//
+
+static bool get_varint(const uint8_t *&p, const uint8_t *e, uint64_t &n) {
+  n = 0;
+  for (int i = 0; i < 10 && p < e; i++) {
+    auto c = *p++;
+    n |= (uint64_t)(c & 0x7f) << (i * 7);
+    if (!(c & 0x80)) return true;
+  }
+  return false;
+}
+
+static bool get_fixed32(const uint8_t *&p, const uint8_t *e, uint32_t &n) {
+  if (e - p < 4) return false;
+  n = (
+    ((uint32_t)p[3] << 24)|
+    ((uint32_t)p[2] << 16)|
+    ((uint32_t)p[1] <<  8)|
+    ((uint32_t)p[0]      )
+  );
+  p += 4;
+  return true;
+}
+
+static bool get_fixed64(const uint8_t *&p, const uint8_t *e, uint64_t &n) {
+  uint32_t lo, hi;
+  if (!get_fixed32(p, e, lo) || !get_fixed32(p, e, hi)) return false;
+  n = ((uint64_t)hi << 32) | lo;
+  return true;
+}
+
+static bool get_bytes(const uint8_t *&p, const uint8_t *e, const uint8_t *&s, size_t &n) {
+  uint64_t len;
+  if (!get_varint(p, e, len)) return false;
+  if (len > uint64_t(e - p)) return false;
+  s = p;
+  n = len;
+  p += len;
+  return true;
+}
+
+static bool skip_field(int wire, const uint8_t *&p, const uint8_t *e) {
+  switch (wire) {
+    case 0: { uint64_t n; return get_varint(p, e, n); }
+    case 1: { uint64_t n; return get_fixed64(p, e, n); }
+    case 2: { const uint8_t *s; size_t n; return get_bytes(p, e, s, n); }
+    case 5: { uint32_t n; return get_fixed32(p, e, n); }
+    default: return false;
+  }
+}
+
+static void put_varint(std::string &out, uint64_t n) {
+  do {
+    char c = n & 0x7f;
+    if (n >>= 7) c |= 0x80;
+    out.push_back(c);
+  } while (n);
+}
+
+static void put_fixed32(std::string &out, uint32_t n) {
+  out.push_back(n >>  0);
+  out.push_back(n >>  8);
+  out.push_back(n >> 16);
+  out.push_back(n >> 24);
+}
+
+static void put_fixed64(std::string &out, uint64_t n) {
+  put_fixed32(out, n);
+  put_fixed32(out, n >> 32);
+}
+
+static auto varint_size(uint64_t n) -> size_t {
+  size_t size = 1;
+  while (n >>= 7) size++;
+  return size;
+}
+
+static auto wire_type_of(Protobuf::Schema::Type type) -> int {
+  switch (type) {
+    case Protobuf::Schema::Type::DOUBLE:
+    case Protobuf::Schema::Type::FIXED64:
+    case Protobuf::Schema::Type::SFIXED64:
+      return 1;
+    case Protobuf::Schema::Type::FLOAT:
+    case Protobuf::Schema::Type::FIXED32:
+    case Protobuf::Schema::Type::SFIXED32:
+      return 5;
+    case Protobuf::Schema::Type::STRING:
+    case Protobuf::Schema::Type::BYTES:
+    case Protobuf::Schema::Type::MESSAGE:
+      return 2;
+    case Protobuf::Schema::Type::GROUP:
+      return 3;
+    default:
+      return 0;
+  }
+}
+
+static bool is_packable(Protobuf::Schema::Type type) {
+  auto wire = wire_type_of(type);
+  return wire != 2 && wire != 3;
+}
+
+static auto decode_zigzag(uint32_t n) -> int32_t { return (n >> 1) ^ -(n & 1); }
+static auto decode_zigzag(uint64_t n) -> int64_t { return (n >> 1) ^ -(n & 1); }
+static auto encode_zigzag(int32_t n) -> uint32_t { return (uint32_t(n) << 1) ^ (n >> 31); }
+static auto encode_zigzag(int64_t n) -> uint64_t { return (uint64_t(n) << 1) ^ (n >> 63); }
+
+static auto to_int64(const pjs::Value &v) -> int64_t {
+  if (v.is_string()) return std::strtoll(v.s()->c_str(), nullptr, 0);
+  auto n = v.to_number();
+  if (std::isnan(n)) return 0;
+  if (n >= 9223372036854775807.0) return std::numeric_limits<int64_t>::max();
+  if (n <= -9223372036854775808.0) return std::numeric_limits<int64_t>::min();
+  return (int64_t)n;
+}
+
+static auto to_uint64(const pjs::Value &v) -> uint64_t {
+  if (v.is_string()) return std::strtoull(v.s()->c_str(), nullptr, 0);
+  auto n = v.to_number();
+  if (std::isnan(n)) return 0;
+  if (n < 0) return to_int64(v);
+  if (n >= 18446744073709551615.0) return std::numeric_limits<uint64_t>::max();
+  return (uint64_t)n;
+}
+
+//
+// ProtoParser
+//
+// Reads message and enum definitions from .proto source. Services,
+// extensions and all options except 'packed' are skipped.
+//
+
+class ProtoParser {
+public:
+  ProtoParser(Protobuf::Schema *schema, const std::string &source)
+    : m_schema(schema)
+    , m_source(source) {}
+
+  void parse() {
+    for (;;) {
+      auto t = next();
+      if (t.empty() && !m_quoted) break;
+      if (t == "syntax" || t == "edition") {
+        expect("=");
+        m_syntax = next();
+        expect(";");
+      } else if (t == "package") {
+        m_package = next();
+        expect(";");
+      } else if (t == "import" || t == "option") {
+        skip_statement();
+      } else if (t == "message") {
+        parse_message(m_package);
+      } else if (t == "enum") {
+        parse_enum(m_package);
+      } else if (t == "service" || t == "extend") {
+        next();
+        skip_block();
+      } else if (t != ";") {
+        error("unexpected '" + t + "'");
+      }
+    }
+  }
+
+private:
+  typedef Protobuf::Schema::Type Type;
+  typedef Protobuf::Schema::Field Field;
+  typedef Protobuf::Schema::MessageType MessageType;
+  typedef Protobuf::Schema::EnumType EnumType;
+
+  Protobuf::Schema* m_schema;
+  const std::string& m_source;
+  size_t m_pos = 0;
+  int m_line = 1;
+  bool m_quoted = false;
+  std::string m_package;
+  std::string m_syntax = "proto2";
+
+  static auto join(const std::string &scope, const std::string &name) -> std::string {
+    return scope.empty() ? name : scope + '.' + name;
+  }
+
+  void parse_message(const std::string &scope) {
+    auto name = join(scope, next());
+    auto &msg = m_schema->m_messages[name];
+    msg.name = name;
+    msg.syntax = m_syntax;
+    expect("{");
+    for (;;) {
+      auto t = next();
+      if (t == "}") {
+        break;
+      } else if (t == "message") {
+        parse_message(name);
+      } else if (t == "enum") {
+        parse_enum(name);
+      } else if (t == "option" || t == "reserved" || t == "extensions") {
+        skip_statement();
+      } else if (t == "extend") {
+        next();
+        skip_block();
+      } else if (t == "oneof") {
+        next();
+        expect("{");
+        for (;;) {
+          auto t = next();
+          if (t == "}") break;
+          if (t == "option") skip_statement();
+          else if (t != ";") parse_field(msg, t, false);
+        }
+      } else if (t == "map") {
+        parse_map(msg);
+      } else if (t == "repeated") {
+        parse_field(msg, next(), true);
+      } else if (t == "optional" || t == "required") {
+        parse_field(msg, next(), false);
+      } else if (t == "group") {
+        error("groups are not supported");
+      } else if (t != ";") {
+        parse_field(msg, t, false);
+      }
+    }
+  }
+
+  void parse_field(MessageType &msg, const std::string &type, bool repeated) {
+    if (type.empty()) error("unexpected end of file");
+    Field f;
+    f.name = pjs::Str::make(next());
+    expect("=");
+    f.number = parse_int(next());
+    f.repeated = repeated;
+    set_type(f, type);
+    parse_options(f);
+    expect(";");
+    msg.fields.push_back(f);
+  }
+
+  void parse_map(MessageType &msg) {
+    expect("<");
+    auto key_type = next();
+    expect(",");
+    auto value_type = next();
+    expect(">");
+    auto name = next();
+    auto entry_name = name;
+    for (size_t i = 0; i < entry_name.length(); i++) {
+      if (entry_name[i] == '_' && i + 1 < entry_name.length()) {
+        entry_name.erase(i, 1);
+        entry_name[i] = std::toupper(entry_name[i]);
+      }
+    }
+    entry_name[0] = std::toupper(entry_name[0]);
+    entry_name = join(msg.name, entry_name + "Entry");
+
+    Field key, value;
+    key.name = pjs::Str::make("key");
+    key.number = 1;
+    set_type(key, key_type);
+    value.name = pjs::Str::make("value");
+    value.number = 2;
+    set_type(value, value_type);
+
+    auto &entry = m_schema->m_messages[entry_name];
+    entry.name = entry_name;
+    entry.syntax = m_syntax;
+    entry.map_entry = true;
+    entry.fields.push_back(key);
+    entry.fields.push_back(value);
+
+    Field f;
+    f.name = pjs::Str::make(name);
+    expect("=");
+    f.number = parse_int(next());
+    f.repeated = true;
+    f.type = Type::MESSAGE;
+    f.type_name = '.' + entry_name;
+    parse_options(f);
+    expect(";");
+    msg.fields.push_back(f);
+  }
+
+  void parse_enum(const std::string &scope) {
+    auto name = join(scope, next());
+    auto &enm = m_schema->m_enums[name];
+    enm.name = name;
+    expect("{");
+    for (;;) {
+      auto t = next();
+      if (t == "}") break;
+      if (t == "option" || t == "reserved") {
+        skip_statement();
+      } else if (t != ";") {
+        expect("=");
+        auto n = next();
+        auto number = (n == "-" ? -parse_int(next()) : parse_int(n));
+        Field f;
+        parse_options(f);
+        expect(";");
+        if (enm.names.find(number) == enm.names.end()) {
+          enm.names[number] = pjs::Str::make(t);
+        }
+        enm.values[t] = number;
+      }
+    }
+  }
+
+  void parse_options(Field &f) {
+    if (peek() != "[") return;
+    next();
+    for (;;) {
+      auto name = next();
+      if (name == "(") {
+        while (next() != ")") {}
+        name = "(";
+        while (peek() != "=") next();
+      }
+      expect("=");
+      auto value = next();
+      if (value == "{") {
+        skip_braces();
+      } else if (value == "-") {
+        next();
+      }
+      if (name == "packed") f.packed_option = (value == "true" ? 1 : 0);
+      auto t = next();
+      if (t == "]") break;
+      if (t != ",") error("expected ',' or ']'");
+    }
+  }
+
+  void set_type(Field &f, const std::string &type) {
+    static const std::map<std::string, Type> scalars = {
+      { "double", Type::DOUBLE },
+      { "float", Type::FLOAT },
+      { "int64", Type::INT64 },
+      { "uint64", Type::UINT64 },
+      { "int32", Type::INT32 },
+      { "fixed64", Type::FIXED64 },
+      { "fixed32", Type::FIXED32 },
+      { "bool", Type::BOOL },
+      { "string", Type::STRING },
+      { "bytes", Type::BYTES },
+      { "uint32", Type::UINT32 },
+      { "sfixed32", Type::SFIXED32 },
+      { "sfixed64", Type::SFIXED64 },
+      { "sint32", Type::SINT32 },
+      { "sint64", Type::SINT64 },
+    };
+    auto i = scalars.find(type);
+    if (i != scalars.end()) {
+      f.type = i->second;
+    } else {
+      f.type = Type::MESSAGE;
+      f.type_name = type;
+    }
+  }
+
+  auto parse_int(const std::string &s) -> int {
+    char *end;
+    auto n = std::strtol(s.c_str(), &end, 0);
+    if (s.empty() || *end) error("invalid number '" + s + "'");
+    return n;
+  }
+
+  void skip_statement() {
+    for (;;) {
+      auto t = next();
+      if (t == ";") break;
+      if (t == "{") { skip_braces(); break; }
+      if (t.empty() && !m_quoted) error("unexpected end of file");
+    }
+  }
+
+  void skip_block() {
+    expect("{");
+    skip_braces();
+  }
+
+  void skip_braces() {
+    int depth = 1;
+    while (depth > 0) {
+      auto t = next();
+      if (m_quoted) continue;
+      if (t == "{") depth++;
+      else if (t == "}") depth--;
+      else if (t.empty()) error("unexpected end of file");
+    }
+  }
+
+  void expect(const char *token) {
+    auto t = next();
+    if (t != token || m_quoted) error(std::string("expected '") + token + "' but got '" + t + "'");
+  }
+
+  auto peek() -> std::string {
+    auto pos = m_pos;
+    auto line = m_line;
+    auto quoted = m_quoted;
+    auto t = next();
+    m_pos = pos;
+    m_line = line;
+    m_quoted = quoted;
+    return t;
+  }
+
+  auto next() -> std::string {
+    const auto &s = m_source;
+    const auto n = s.length();
+    m_quoted = false;
+    for (;;) {
+      while (m_pos < n && std::isspace(s[m_pos])) {
+        if (s[m_pos++] == '\n') m_line++;
+      }
+      if (m_pos + 1 < n && s[m_pos] == '/' && s[m_pos+1] == '/') {
+        while (m_pos < n && s[m_pos] != '\n') m_pos++;
+      } else if (m_pos + 1 < n && s[m_pos] == '/' && s[m_pos+1] == '*') {
+        auto end = s.find("*/", m_pos + 2);
+        if (end == std::string::npos) end = n; else end += 2;
+        for (; m_pos < end; m_pos++) if (s[m_pos] == '\n') m_line++;
+      } else {
+        break;
+      }
+    }
+    if (m_pos >= n) return std::string();
+    auto c = s[m_pos];
+    if (c == '"' || c == '\'') {
+      std::string str;
+      m_pos++;
+      while (m_pos < n && s[m_pos] != c) {
+        if (s[m_pos] == '\\' && m_pos + 1 < n) m_pos++;
+        str += s[m_pos++];
+      }
+      if (m_pos >= n) error("unterminated string");
+      m_pos++;
+      m_quoted = true;
+      return str;
+    }
+    if (std::isalnum(c) || c == '_' || c == '.') {
+      auto start = m_pos;
+      while (m_pos < n && (std::isalnum(s[m_pos]) || s[m_pos] == '_' || s[m_pos] == '.')) m_pos++;
+      return s.substr(start, m_pos - start);
+    }
+    m_pos++;
+    return std::string(1, c);
+  }
+
+  void error(const std::string &msg) {
+    throw std::runtime_error("protobuf: line " + std::to_string(m_line) + ": " + msg);
+  }
+};
+
+//
+// DescriptorReader
+//
+// Reads message and enum definitions from a serialized
+// google.protobuf.FileDescriptorSet.
+//
+
+class DescriptorReader {
+public:
+  DescriptorReader(Protobuf::Schema *schema) : m_schema(schema) {}
+
+  void read(const uint8_t *p, const uint8_t *e) {
+    fields(p, e, [&](int number, uint64_t, const uint8_t *s, size_t n) {
+      if (number == 1 && s) read_file(s, s + n);
+    });
+  }
+
+private:
+  typedef Protobuf::Schema::Type Type;
+  typedef Protobuf::Schema::Field Field;
+
+  Protobuf::Schema* m_schema;
+
+  void read_file(const uint8_t *p, const uint8_t *e) {
+    std::string package, syntax("proto2");
+    fields(p, e, [&](int number, uint64_t, const uint8_t *s, size_t n) {
+      if (number == 2 && s) package.assign((const char *)s, n);
+      else if (number == 12 && s) syntax.assign((const char *)s, n);
+    });
+    fields(p, e, [&](int number, uint64_t, const uint8_t *s, size_t n) {
+      if (number == 4 && s) read_message(package, syntax, s, s + n);
+      else if (number == 5 && s) read_enum(package, s, s + n);
+    });
+  }
+
+  void read_message(const std::string &scope, const std::string &syntax, const uint8_t *p, const uint8_t *e) {
+    std::string name;
+    bool map_entry = false;
+    fields(p, e, [&](int number, uint64_t, const uint8_t *s, size_t n) {
+      if (number == 1 && s) {
+        name = join(scope, std::string((const char *)s, n));
+      } else if (number == 7 && s) {
+        fields(s, s + n, [&](int number, uint64_t v, const uint8_t *s, size_t) {
+          if (number == 7 && !s) map_entry = v;
+        });
+      }
+    });
+    auto &msg = m_schema->m_messages[name];
+    msg.name = name;
+    msg.syntax = syntax;
+    msg.map_entry = map_entry;
+    fields(p, e, [&](int number, uint64_t, const uint8_t *s, size_t n) {
+      if (!s) return;
+      switch (number) {
+        case 2: msg.fields.push_back(read_field(s, s + n)); break;
+        case 3: read_message(name, syntax, s, s + n); break;
+        case 4: read_enum(name, s, s + n); break;
+      }
+    });
+  }
+
+  auto read_field(const uint8_t *p, const uint8_t *e) -> Field {
+    Field f;
+    int type = 0;
+    fields(p, e, [&](int number, uint64_t v, const uint8_t *s, size_t n) {
+      switch (number) {
+        case 1: if (s) f.name = pjs::Str::make((const char *)s, n); break;
+        case 3: f.number = v; break;
+        case 4: f.repeated = (v == 3); break;
+        case 5: type = v; break;
+        case 6: if (s) f.type_name.assign((const char *)s, n); break;
+        case 8:
+          if (s) {
+            fields(s, s + n, [&](int number, uint64_t v, const uint8_t *s, size_t) {
+              if (number == 2 && !s) f.packed_option = (v ? 1 : 0);
+            });
+          }
+          break;
+      }
+    });
+    if (!f.name) error();
+    if (type == int(Type::GROUP)) throw std::runtime_error("protobuf: groups are not supported");
+    if (type < int(Type::DOUBLE) || type > int(Type::SINT64)) {
+      if (f.type_name.empty()) error();
+      type = int(Type::MESSAGE);
+    }
+    f.type = Type(type);
+    if (f.type != Type::MESSAGE && f.type != Type::ENUM) f.type_name.clear();
+    return f;
+  }
+
+  void read_enum(const std::string &scope, const uint8_t *p, const uint8_t *e) {
+    std::string name;
+    fields(p, e, [&](int number, uint64_t, const uint8_t *s, size_t n) {
+      if (number == 1 && s) name = join(scope, std::string((const char *)s, n));
+    });
+    auto &enm = m_schema->m_enums[name];
+    enm.name = name;
+    fields(p, e, [&](int number, uint64_t, const uint8_t *s, size_t n) {
+      if (number != 2 || !s) return;
+      std::string value_name;
+      int value = 0;
+      fields(s, s + n, [&](int number, uint64_t v, const uint8_t *s, size_t n) {
+        if (number == 1 && s) value_name.assign((const char *)s, n);
+        else if (number == 2 && !s) value = int32_t(v);
+      });
+      if (enm.names.find(value) == enm.names.end()) {
+        enm.names[value] = pjs::Str::make(value_name);
+      }
+      enm.values[value_name] = value;
+    });
+  }
+
+  static auto join(const std::string &scope, const std::string &name) -> std::string {
+    return scope.empty() ? name : scope + '.' + name;
+  }
+
+  // Calls back with (number, value, nullptr, 0) for numeric fields
+  // and (number, 0, bytes, size) for length-delimited fields
+  template<class F>
+  static void fields(const uint8_t *p, const uint8_t *e, const F &f) {
+    while (p < e) {
+      uint64_t tag;
+      if (!get_varint(p, e, tag)) error();
+      auto number = int(tag >> 3);
+      switch (tag & 7) {
+        case 0: {
+          uint64_t v;
+          if (!get_varint(p, e, v)) error();
+          f(number, v, nullptr, 0);
+          break;
+        }
+        case 2: {
+          const uint8_t *s;
+          size_t n;
+          if (!get_bytes(p, e, s, n)) error();
+          f(number, 0, s, n);
+          break;
+        }
+        default:
+          if (!skip_field(tag & 7, p, e)) error();
+          break;
+      }
+    }
+  }
+
+  static void error() {
+    throw std::runtime_error("protobuf: malformed FileDescriptorSet");
+  }
+};
+
+//
+// Protobuf::Schema
+//
+
+void Protobuf::Schema::load_proto(const std::string &source) {
+  ProtoParser parser(this, source);
+  parser.parse();
+}
+
+void Protobuf::Schema::load_descriptor_set(const Data &data) {
+  auto buf = data.to_bytes();
+  DescriptorReader reader(this);
+  reader.read(buf.data(), buf.data() + buf.size());
+}
+
+void Protobuf::Schema::compile() {
+  for (auto &p : m_messages) {
+    auto &msg = p.second;
+    int max_table = 0;
+    for (auto &f : msg.fields) {
+      if (!f.type_name.empty()) {
+        MessageType *m = nullptr;
+        EnumType *e = nullptr;
+        if (!resolve(msg.name, f.type_name, &m, &e)) {
+          throw std::runtime_error("protobuf: unknown type '" + f.type_name + "' in " + msg.name);
+        }
+        f.message = m;
+        f.enumeration = e;
+        f.type = (m ? Type::MESSAGE : Type::ENUM);
+      }
+      f.packed = f.repeated && is_packable(f.type) && (
+        f.packed_option >= 0 ? f.packed_option > 0 : msg.syntax != "proto2"
+      );
+      if (f.number < 256) max_table = std::max(max_table, f.number + 1);
+    }
+    msg.table.assign(max_table, 0);
+    msg.sparse.clear();
+    for (size_t i = 0; i < msg.fields.size(); i++) {
+      auto n = msg.fields[i].number;
+      if (n < max_table) {
+        msg.table[n] = i + 1;
+      } else {
+        msg.sparse[n] = i;
+      }
+    }
+  }
+  m_selections.clear();
+}
+
+bool Protobuf::Schema::resolve(const std::string &scope, const std::string &name, MessageType **msg, EnumType **enm) {
+  auto lookup = [&](const std::string &full) {
+    auto i = m_messages.find(full);
+    if (i != m_messages.end()) { *msg = &i->second; return true; }
+    auto j = m_enums.find(full);
+    if (j != m_enums.end()) { *enm = &j->second; return true; }
+    return false;
+  };
+  if (name[0] == '.') return lookup(name.substr(1));
+  auto s = scope;
+  for (;;) {
+    if (lookup(s.empty() ? name : s + '.' + name)) return true;
+    if (s.empty()) return false;
+    auto i = s.rfind('.');
+    if (i == std::string::npos) s.clear(); else s.resize(i);
+  }
+}
+
+bool Protobuf::Schema::has(const std::string &type) const {
+  return m_messages.count(type[0] == '.' ? type.substr(1) : type) > 0;
+}
+
+auto Protobuf::Schema::message_type(const std::string &name) -> MessageType* {
+  auto i = m_messages.find(name[0] == '.' ? name.substr(1) : name);
+  if (i == m_messages.end()) throw std::runtime_error("protobuf: unknown message type '" + name + "'");
+  return &i->second;
+}
+
+auto Protobuf::Schema::decode(const std::string &type, const Data &data, pjs::Array *paths) -> pjs::Object* {
+  auto t = message_type(type);
+  auto sel = paths ? select(t, paths) : nullptr;
+  auto obj = pjs::Object::make();
+  const uint8_t *p = nullptr;
+  size_t n = 0, chunks = 0;
+  for (const auto c : data.chunks()) {
+    if (++chunks > 1) break;
+    p = (const uint8_t *)std::get<0>(c);
+    n = std::get<1>(c);
+  }
+  bool ok;
+  if (chunks <= 1) {
+    ok = decode_message(t, p, p + n, sel, obj, 0);
+  } else {
+    auto buf = data.to_bytes();
+    ok = decode_message(t, buf.data(), buf.data() + buf.size(), sel, obj, 0);
+  }
+  if (!ok) {
+    obj->retain();
+    obj->release();
+    return nullptr;
+  }
+  return obj;
+}
+
+void Protobuf::Schema::encode(const std::string &type, pjs::Object *obj, Data &data) {
+  Output out;
+  encode_message(message_type(type), obj, out, 0);
+  out.flush(data);
+}
+
+auto Protobuf::Schema::select(MessageType *type, pjs::Array *paths) -> const Selection* {
+  std::string key(type->name);
+  paths->iterate_all([&](pjs::Value &v, int) {
+    auto s = v.to_string();
+    key += '\n';
+    key += s->str();
+    s->release();
+  });
+
+  auto i = m_selections.find(key);
+  if (i != m_selections.end()) return &i->second.front();
+
+  std::list<Selection> nodes(1);
+  auto child = [&](Selection *node, int number) {
+    auto &c = node->children[number];
+    if (!c) {
+      nodes.emplace_back();
+      c = &nodes.back();
+    }
+    return c;
+  };
+
+  paths->iterate_all([&](pjs::Value &v, int) {
+    auto s = v.to_string();
+    auto path = s->str();
+    s->release();
+    auto *node = &nodes.front();
+    auto *msg = type;
+    size_t p = 0;
+    for (;;) {
+      auto q = path.find('.', p);
+      auto name = path.substr(p, q == std::string::npos ? q : q - p);
+      if (!msg) throw std::runtime_error("protobuf: cannot select '" + name + "' in '" + path + "'");
+      const Field *field = nullptr;
+      for (const auto &f : msg->fields) {
+        if (f.name->str() == name) { field = &f; break; }
+      }
+      if (!field) throw std::runtime_error("protobuf: unknown field '" + name + "' in '" + path + "'");
+      node = child(node, field->number);
+      msg = field->message;
+      if (msg && msg->map_entry) {
+        child(node, 1)->all = true;
+        node = child(node, 2);
+        auto value = msg->find(2);
+        msg = value ? value->message : nullptr;
+      }
+      if (q == std::string::npos) break;
+      p = q + 1;
+    }
+    node->all = true;
+  });
+
+  if (m_selections.size() >= 1000) m_selections.clear();
+  auto &list = m_selections[key];
+  list.splice(list.end(), nodes);
+  return &list.front();
+}
+
+bool Protobuf::Schema::decode_message(const MessageType *type, const uint8_t *p, const uint8_t *e, const Selection *sel, pjs::Object *obj, int depth) {
+  if (depth >= s_max_depth) return false;
+  while (p < e) {
+    uint64_t tag;
+    if (!get_varint(p, e, tag)) return false;
+    auto number = int(tag >> 3);
+    auto wire = int(tag & 7);
+    auto f = type->find(number);
+    const Selection *sub = nullptr;
+    if (f && sel && !sel->all) {
+      auto i = sel->children.find(number);
+      if (i == sel->children.end()) f = nullptr; else sub = i->second;
+    }
+    if (sub && sub->all) sub = nullptr;
+
+    if (f && wire == 2 && f->repeated && is_packable(f->type)) {
+      const uint8_t *s; size_t n;
+      if (!get_bytes(p, e, s, n)) return false;
+      pjs::Value v;
+      obj->get(f->name, v);
+      if (!v.is_array()) {
+        v.set(pjs::Array::make());
+        obj->set(f->name, v);
+      }
+      if (!decode_packed(*f, s, s + n, v.as<pjs::Array>())) return false;
+      continue;
+    }
+
+    if (!f || wire != wire_type_of(f->type)) {
+      if (!skip_field(wire, p, e)) return false;
+      continue;
+    }
+
+    if (f->message && f->message->map_entry) {
+      const uint8_t *s; size_t n;
+      if (!get_bytes(p, e, s, n)) return false;
+      pjs::Value v;
+      obj->get(f->name, v);
+      if (!v.is_object()) {
+        v.set(pjs::Object::make());
+        obj->set(f->name, v);
+      }
+      pjs::Ref<pjs::Object> entry(pjs::Object::make());
+      if (!decode_message(f->message, s, s + n, sub, entry, depth + 1)) return false;
+      auto &key_field = f->message->fields[0];
+      auto &value_field = f->message->fields[1];
+      pjs::Value key, value;
+      entry->get(key_field.name, key);
+      entry->get(value_field.name, value);
+      auto k = key.to_string();
+      v.o()->set(k, value);
+      k->release();
+      continue;
+    }
+
+    pjs::Value val;
+    if (!decode_value(*f, wire, p, e, sub, val, depth)) return false;
+    if (f->repeated) {
+      pjs::Value v;
+      obj->get(f->name, v);
+      if (!v.is_array()) {
+        v.set(pjs::Array::make());
+        obj->set(f->name, v);
+      }
+      v.as<pjs::Array>()->push(val);
+    } else {
+      obj->set(f->name, val);
+    }
+  }
+  return true;
+}
+
+bool Protobuf::Schema::decode_value(const Field &field, int wire, const uint8_t *&p, const uint8_t *e, const Selection *sel, pjs::Value &val, int depth) {
+  switch (wire) {
+    case 0: {
+      uint64_t n;
+      if (!get_varint(p, e, n)) return false;
+      scalar_value(field, n, val);
+      return true;
+    }
+    case 1: {
+      uint64_t n;
+      if (!get_fixed64(p, e, n)) return false;
+      scalar_value(field, n, val);
+      return true;
+    }
+    case 5: {
+      uint32_t n;
+      if (!get_fixed32(p, e, n)) return false;
+      scalar_value(field, n, val);
+      return true;
+    }
+    case 2: {
+      const uint8_t *s; size_t n;
+      if (!get_bytes(p, e, s, n)) return false;
+      switch (field.type) {
+        case Type::STRING:
+          val.set(pjs::Str::make((const char *)s, n));
+          return true;
+        case Type::BYTES:
+          val.set(Data::make(s, n, &s_dp));
+          return true;
+        default: {
+          auto obj = pjs::Object::make();
+          val.set(obj);
+          return decode_message(field.message, s, s + n, sel, obj, depth + 1);
+        }
+      }
+    }
+    default: return false;
+  }
+}
+
+bool Protobuf::Schema::decode_packed(const Field &field, const uint8_t *p, const uint8_t *e, pjs::Array *a) {
+  auto wire = wire_type_of(field.type);
+  while (p < e) {
+    pjs::Value v;
+    if (!decode_value(field, wire, p, e, nullptr, v, 0)) return false;
+    a->push(v);
+  }
+  return true;
+}
+
+void Protobuf::Schema::scalar_value(const Field &field, uint64_t bits, pjs::Value &val) {
+  switch (field.type) {
+    case Type::DOUBLE: { double d; std::memcpy(&d, &bits, sizeof(d)); val.set(d); break; }
+    case Type::FLOAT: { float f; auto b = uint32_t(bits); std::memcpy(&f, &b, sizeof(f)); val.set(double(f)); break; }
+    case Type::INT64: case Type::SFIXED64: val.set(double(int64_t(bits))); break;
+    case Type::UINT64: case Type::FIXED64: val.set(double(bits)); break;
+    case Type::INT32: case Type::SFIXED32: val.set(int(int32_t(bits))); break;
+    case Type::UINT32: case Type::FIXED32: val.set(double(uint32_t(bits))); break;
+    case Type::SINT32: val.set(int(decode_zigzag(uint32_t(bits)))); break;
+    case Type::SINT64: val.set(double(decode_zigzag(bits))); break;
+    case Type::BOOL: val.set(bits != 0); break;
+    case Type::ENUM: {
+      auto n = int32_t(bits);
+      if (field.enumeration) {
+        auto i = field.enumeration->names.find(n);
+        if (i != field.enumeration->names.end()) {
+          val.set(i->second.get());
+          break;
+        }
+      }
+      val.set(int(n));
+      break;
+    }
+    default: val = pjs::Value::undefined; break;
+  }
+}
+
+void Protobuf::Schema::encode_message(const MessageType *type, pjs::Object *obj, Output &out, int depth) {
+  if (depth >= s_max_depth) throw std::runtime_error("protobuf: message nested too deeply");
+  for (const auto &f : type->fields) {
+    pjs::Value v;
+    obj->get(f.name, v);
+    if (v.is_undefined() || v.is_null()) continue;
+    encode_field(f, v, out, depth);
+  }
+}
+
+void Protobuf::Schema::encode_field(const Field &field, const pjs::Value &val, Output &out, int depth) {
+  auto tag = uint64_t(field.number) << 3;
+  if (field.message && field.message->map_entry) {
+    if (!val.is_object()) return;
+    auto &key_field = field.message->fields[0];
+    auto &value_field = field.message->fields[1];
+    val.o()->iterate_all([&](pjs::Str *k, pjs::Value &v) {
+      put_varint(out.buf, tag | 2);
+      auto start = out.begin_length();
+      encode_field(key_field, pjs::Value(k), out, depth + 1);
+      if (!v.is_undefined() && !v.is_null()) encode_field(value_field, v, out, depth + 1);
+      out.end_length(start);
+    });
+  } else if (field.repeated && val.is_array()) {
+    auto a = val.as<pjs::Array>();
+    if (field.packed) {
+      put_varint(out.buf, tag | 2);
+      auto start = out.begin_length();
+      a->iterate_all([&](pjs::Value &v, int) { encode_value(field, v, out, depth); });
+      out.end_length(start);
+    } else {
+      a->iterate_all([&](pjs::Value &v, int) {
+        put_varint(out.buf, tag | wire_type_of(field.type));
+        encode_value(field, v, out, depth);
+      });
+    }
+  } else {
+    put_varint(out.buf, tag | wire_type_of(field.type));
+    encode_value(field, val, out, depth);
+  }
+}
+
+void Protobuf::Schema::encode_value(const Field &field, const pjs::Value &val, Output &output, int depth) {
+  auto &out = output.buf;
+  switch (field.type) {
+    case Type::DOUBLE: {
+      double d = val.to_number();
+      uint64_t bits;
+      std::memcpy(&bits, &d, sizeof(bits));
+      put_fixed64(out, bits);
+      break;
+    }
+    case Type::FLOAT: {
+      float f = val.to_number();
+      uint32_t bits;
+      std::memcpy(&bits, &f, sizeof(bits));
+      put_fixed32(out, bits);
+      break;
+    }
+    case Type::INT64: case Type::INT32: put_varint(out, to_int64(val)); break;
+    case Type::UINT64: put_varint(out, to_uint64(val)); break;
+    case Type::UINT32: put_varint(out, uint32_t(to_int64(val))); break;
+    case Type::SINT32: put_varint(out, encode_zigzag(int32_t(to_int64(val)))); break;
+    case Type::SINT64: put_varint(out, encode_zigzag(to_int64(val))); break;
+    case Type::FIXED32: case Type::SFIXED32: put_fixed32(out, to_int64(val)); break;
+    case Type::FIXED64: put_fixed64(out, to_uint64(val)); break;
+    case Type::SFIXED64: put_fixed64(out, to_int64(val)); break;
+    case Type::BOOL: put_varint(out, val.to_boolean() ? 1 : 0); break;
+    case Type::ENUM: {
+      int64_t n = 0;
+      if (val.is_string() && field.enumeration) {
+        auto i = field.enumeration->values.find(val.s()->str());
+        if (i != field.enumeration->values.end()) n = i->second;
+      } else {
+        n = to_int64(val);
+      }
+      put_varint(out, n);
+      break;
+    }
+    case Type::STRING: {
+      auto s = val.to_string();
+      put_varint(out, s->size());
+      out.append(s->c_str(), s->size());
+      s->release();
+      break;
+    }
+    case Type::BYTES: {
+      if (val.is<Data>()) {
+        auto *data = val.as<Data>();
+        put_varint(out, data->size());
+        for (const auto c : data->chunks()) out.append(std::get<0>(c), std::get<1>(c));
+      } else {
+        auto s = val.to_string();
+        put_varint(out, s->size());
+        out.append(s->c_str(), s->size());
+        s->release();
+      }
+      break;
+    }
+    case Type::MESSAGE: {
+      auto start = output.begin_length();
+      if (val.is_object()) encode_message(field.message, val.o(), output, depth + 1);
+      output.end_length(start);
+      break;
+    }
+    default: break;
+  }
+}
+
+//
+// Protobuf::Schema::Output
+//
+
+auto Protobuf::Schema::Output::begin_length() -> std::pair<size_t, size_t> {
+  auto start = std::make_pair(buf.size(), extra);
+  buf.push_back(0);
+  return start;
+}
+
+void Protobuf::Schema::Output::end_length(const std::pair<size_t, size_t> &start) {
+  auto n = buf.size() - start.first - 1 + extra - start.second;
+  lengths.push_back({ start.first, n });
+  extra += varint_size(n) - 1;
+}
+
+void Protobuf::Schema::Output::flush(Data &data) {
+  if (lengths.empty()) {
+    data.push(buf.c_str(), buf.size(), &s_dp);
+    return;
+  }
+
+  // Lengths are recorded as their messages end, so inner
+  // ones come first and need to be put back in offset order
+  std::sort(lengths.begin(), lengths.end());
+  std::string out;
+  out.reserve(buf.size() + extra);
+  size_t p = 0;
+  for (const auto &l : lengths) {
+    out.append(buf, p, l.first - p);
+    put_varint(out, l.second);
+    p = l.first + 1;
+  }
+  out.append(buf, p, std::string::npos);
+  data.push(out.c_str(), out.size(), &s_dp);
+}
+
 } // namespace pipy
 
 namespace pjs {
@@ -624,6 +1698,7 @@ template<> void ClassDef<Protobuf>::init() {
   ctor();
 
   variable("Message", class_of<Constructor<Protobuf::Message>>());
+  variable("Schema", class_of<Constructor<Protobuf::Schema>>());
 
   method("decode", [](Context &ctx, Object *obj, Value &ret) {
     pipy::Data *data;
@@ -1098,4 +2173,77 @@ template<> void ClassDef<Constructor<Protobuf::Message>>::init() {
   ctor();
 }
 
+//
+// Protobuf::Schema
+//
+
+template<> void ClassDef<Protobuf::Schema>::init() {
+  ctor([](Context &ctx) -> Object* {
+    Value source;
+    if (!ctx.arguments(1, &source)) return nullptr;
+    auto schema = Protobuf::Schema::make();
+    try {
+      auto load = [&](const Value &v) {
+        if (v.is_string()) {
+          schema->load_proto(v.s()->str());
+        } else if (v.is<pipy::Data>()) {
+          schema->load_descriptor_set(*v.as<pipy::Data>());
+        } else {
+          throw std::runtime_error("protobuf: schema source must be a string or a Data");
+        }
+      };
+      if (source.is_array()) {
+        source.as<Array>()->iterate_all([&](Value &v, int) { load(v); });
+      } else {
+        load(source);
+      }
+      schema->compile();
+    } catch (std::runtime_error &err) {
+      schema->retain();
+      schema->release();
+      ctx.error(err);
+      return nullptr;
+    }
+    return schema;
+  });
+
+  method("has", [](Context &ctx, Object *obj, Value &ret) {
+    Str *type;
+    if (!ctx.arguments(1, &type)) return;
+    ret.set(obj->as<Protobuf::Schema>()->has(type->str()));
+  });
+
+  method("decode", [](Context &ctx, Object *obj, Value &ret) {
+    Str *type;
+    pipy::Data *data;
+    Array *paths = nullptr;
+    if (!ctx.arguments(2, &type, &data, &paths)) return;
+    if (!data) { ret = Value::null; return; }
+    try {
+      ret.set(obj->as<Protobuf::Schema>()->decode(type->str(), *data, paths));
+    } catch (std::runtime_error &err) {
+      ctx.error(err);
+    }
+  });
+
+  method("encode", [](Context &ctx, Object *obj, Value &ret) {
+    Str *type;
+    Object *msg;
+    if (!ctx.arguments(2, &type, &msg)) return;
+    if (!msg) { ret = Value::null; return; }
+    try {
+      pipy::Data data;
+      obj->as<Protobuf::Schema>()->encode(type->str(), msg, data);
+      ret.set(pipy::Data::make(std::move(data)));
+    } catch (std::runtime_error &err) {
+      ctx.error(err);
+    }
+  });
+}
+
+template<> void ClassDef<Constructor<Protobuf::Schema>>::init() {
+  super<Function>();
+  ctor();
+}
+
 } // namespace pjs
@@ -28,6 +28,12 @@
 
 #include "data.hpp"
 
+#include <list>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 namespace pipy {
 
 //
@@ -288,6 +294,131 @@ public:
     friend class Protobuf;
   };
 
+  //
+  // Protobuf::Schema
+  //
+  // Message types loaded from .proto sources or serialized
+  // FileDescriptorSets. Each message type is compiled into a plan that
+  // looks fields up by number in a jump table, so decoding goes
+  // straight from the wire format to plain objects and can skip
+  // everything outside a set of requested field paths.
+  //
+
+  class Schema : public pjs::ObjectTemplate<Schema> {
+  public:
+
+    // Numbered as in FieldDescriptorProto.Type
+    enum class Type {
+      DOUBLE = 1,
+      FLOAT = 2,
+      INT64 = 3,
+      UINT64 = 4,
+      INT32 = 5,
+      FIXED64 = 6,
+      FIXED32 = 7,
+      BOOL = 8,
+      STRING = 9,
+      GROUP = 10,
+      MESSAGE = 11,
+      BYTES = 12,
+      UINT32 = 13,
+      ENUM = 14,
+      SFIXED32 = 15,
+      SFIXED64 = 16,
+      SINT32 = 17,
+      SINT64 = 18,
+    };
+
+    void load_proto(const std::string &source);
+    void load_descriptor_set(const Data &data);
+    void compile();
+
+    bool has(const std::string &type) const;
+    auto decode(const std::string &type, const Data &data, pjs::Array *paths = nullptr) -> pjs::Object*;
+    void encode(const std::string &type, pjs::Object *obj, Data &data);
+
+  private:
+    struct MessageType;
+
+    struct EnumType {
+      std::string name;
+      std::map<int, pjs::Ref<pjs::Str>> names;
+      std::unordered_map<std::string, int> values;
+    };
+
+    struct Field {
+      int number = 0;
+      pjs::Ref<pjs::Str> name;
+      Type type = Type::INT32;
+      bool repeated = false;
+      bool packed = false;
+      int packed_option = -1;
+      std::string type_name;
+      MessageType* message = nullptr;
+      EnumType* enumeration = nullptr;
+    };
+
+    struct MessageType {
+      std::string name;
+      std::string syntax;
+      std::vector<Field> fields;
+      std::vector<int> table;
+      std::unordered_map<int, int> sparse;
+      bool map_entry = false;
+
+      auto find(int number) const -> const Field* {
+        if (number < table.size()) {
+          auto i = table[number];
+          return i > 0 ? &fields[i-1] : nullptr;
+        }
+        auto i = sparse.find(number);
+        return i == sparse.end() ? nullptr : &fields[i->second];
+      }
+    };
+
+    struct Selection {
+      std::unordered_map<int, Selection*> children;
+      bool all = false;
+    };
+
+    //
+    // Protobuf::Schema::Output
+    //
+    // Length prefixes are written as one placeholder byte each and
+    // spliced in with their full width when the output is flushed.
+    //
+
+    struct Output {
+      std::string buf;
+      std::vector<std::pair<size_t, size_t>> lengths;
+      size_t extra = 0;
+
+      auto begin_length() -> std::pair<size_t, size_t>;
+      void end_length(const std::pair<size_t, size_t> &start);
+      void flush(Data &data);
+    };
+
+    std::map<std::string, MessageType> m_messages;
+    std::map<std::string, EnumType> m_enums;
+    std::unordered_map<std::string, std::list<Selection>> m_selections;
+
+    auto message_type(const std::string &name) -> MessageType*;
+    auto select(MessageType *type, pjs::Array *paths) -> const Selection*;
+    auto resolve(const std::string &scope, const std::string &name, MessageType **msg, EnumType **enm) -> bool;
+
+    bool decode_message(const MessageType *type, const uint8_t *p, const uint8_t *e, const Selection *sel, pjs::Object *obj, int depth);
+    bool decode_value(const Field &field, int wire, const uint8_t *&p, const uint8_t *e, const Selection *sel, pjs::Value &val, int depth);
+    bool decode_packed(const Field &field, const uint8_t *p, const uint8_t *e, pjs::Array *a);
+    void scalar_value(const Field &field, uint64_t bits, pjs::Value &val);
+    void encode_message(const MessageType *type, pjs::Object *obj, Output &out, int depth);
+    void encode_field(const Field &field, const pjs::Value &val, Output &out, int depth);
+    void encode_value(const Field &field, const pjs::Value &val, Output &out, int depth);
+
+    friend class pjs::ObjectTemplate<Schema>;
+    friend class ProtoParser;
+    friend class DescriptorReader;
+  };
+
   static auto decode(const Data &data) -> Message*;
   static void encode(Message *msg, Data &data);
 };
@@ -25,13 +25,26 @@
 
 #include "sqlite.hpp"
 #include "data.hpp"
+#include "input.hpp"
+#include "net.hpp"
 #include "os-platform.hpp"
+#include "utils.hpp"
+
+#include <cmath>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 namespace pipy {
 namespace sqlite {
 
 static Data::Producer s_dp("SQLite");
 
+// How long any connection waits for a lock held by another one
+static const int s_busy_timeout = 5000;
+
 static void free_blob_buffer(void *ptr) {
   std::free(ptr);
 }
@@ -109,16 +122,451 @@ static void throw_error(sqlite3 *db) {
   throw std::runtime_error(msg);
 }
 
+//
+// Cell
+//
+// A value that can cross threads, since pjs values can't
+//
+
+struct Cell {
+  enum class Type { null, integer, real, text, blob };
+  Type type = Type::null;
+  int64_t i = 0;
+  double f = 0;
+  std::string s;
+
+  Cell() {}
+
+  Cell(const pjs::Value &v) {
+    switch (v.type()) {
+      case pjs::Value::Type::Boolean: type = Type::integer; i = v.b() ? 1 : 0; break;
+      case pjs::Value::Type::Number: {
+        // Integral numbers are bound as INTEGER so they compare equal
+        // to integer columns and keep INTEGER PRIMARY KEY lookups fast
+        auto n = v.n();
+        if (std::trunc(n) == n && std::abs(n) < 9007199254740992.0) {
+          type = Type::integer;
+          i = int64_t(n);
+        } else {
+          type = Type::real;
+          f = n;
+        }
+        break;
+      }
+      case pjs::Value::Type::String: type = Type::text; s = v.s()->str(); break;
+      case pjs::Value::Type::Object:
+        if (auto o = v.o()) {
+          if (o->is<pjs::Int>()) {
+            type = Type::integer;
+            i = o->as<pjs::Int>()->value();
+          } else if (o->is<Data>()) {
+            type = Type::blob;
+            s = o->as<Data>()->to_string();
+          } else {
+            type = Type::text;
+            s = o->to_string();
+          }
+        }
+        break;
+      default: break;
+    }
+  }
+
+  Cell(sqlite3_stmt *stmt, int col) {
+    switch (sqlite3_column_type(stmt, col)) {
+      case SQLITE_INTEGER: type = Type::integer; i = sqlite3_column_int64(stmt, col); break;
+      case SQLITE_FLOAT: type = Type::real; f = sqlite3_column_double(stmt, col); break;
+      case SQLITE_TEXT:
+        type = Type::text;
+        s.assign((const char *)sqlite3_column_text(stmt, col), sqlite3_column_bytes(stmt, col));
+        break;
+      case SQLITE_BLOB:
+        type = Type::blob;
+        s.assign((const char *)sqlite3_column_blob(stmt, col), sqlite3_column_bytes(stmt, col));
+        break;
+      default: break;
+    }
+  }
+
+  void bind(sqlite3_stmt *stmt, int col) const {
+    switch (type) {
+      case Type::null: sqlite3_bind_null(stmt, col); break;
+      case Type::integer: sqlite3_bind_int64(stmt, col, i); break;
+      case Type::real: sqlite3_bind_double(stmt, col, f); break;
+      case Type::text: sqlite3_bind_text(stmt, col, s.c_str(), s.length(), SQLITE_TRANSIENT); break;
+      case Type::blob: sqlite3_bind_blob64(stmt, col, s.c_str(), s.length(), SQLITE_TRANSIENT); break;
+    }
+  }
+
+  void get(pjs::Value &v) const {
+    switch (type) {
+      case Type::null: v = pjs::Value::null; break;
+      case Type::integer: if (i >> 32) v.set(int64_t(i)); else v.set(double(i)); break;
+      case Type::real: v.set(f); break;
+      case Type::text: v.set(pjs::Str::make(s)); break;
+      case Type::blob: v.set(s_dp.make(s)); break;
+    }
+  }
+};
+
+//
+// Connection
+//
+// A connection owned by one pool thread, with an LRU cache
+// of prepared statements keyed by the SQL text
+//
+
+class Connection {
+public:
+  Connection(const std::string &path, int flags, size_t cache_size)
+    : m_cache_size(cache_size)
+  {
+    if (sqlite3_open_v2(path.c_str(), &m_db, flags, nullptr) != SQLITE_OK) {
+      m_error = sqlite3_errmsg(m_db);
+    }
+    sqlite3_busy_timeout(m_db, s_busy_timeout);
+  }
+
+  Connection(sqlite3 *db, size_t cache_size)
+    : m_db(db)
+    , m_cache_size(cache_size)
+    , m_is_borrowed(true) {}
+
+  ~Connection() {
+    for (const auto &p : m_statements) sqlite3_finalize(p.second);
+    if (!m_is_borrowed) sqlite3_close(m_db);
+  }
+
+  auto db() const -> sqlite3* { return m_db; }
+  auto error() const -> const std::string& { return m_error; }
+
+  auto prepare(const std::string &sql) -> sqlite3_stmt* {
+    auto i = m_statement_map.find(sql);
+    if (i != m_statement_map.end()) {
+      m_statements.splice(m_statements.begin(), m_statements, i->second);
+      auto stmt = i->second->second;
+      sqlite3_reset(stmt);
+      sqlite3_clear_bindings(stmt);
+      return stmt;
+    }
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(m_db, sql.c_str(), sql.length(), &stmt, nullptr) != SQLITE_OK) {
+      return nullptr;
+    }
+    if (m_cache_size > 0) {
+      m_statements.emplace_front(sql, stmt);
+      m_statement_map[sql] = m_statements.begin();
+      while (m_statements.size() > m_cache_size) {
+        auto &p = m_statements.back();
+        sqlite3_finalize(p.second);
+        m_statement_map.erase(p.first);
+        m_statements.pop_back();
+      }
+    }
+    return stmt;
+  }
+
+  void done(sqlite3_stmt *stmt) {
+    if (m_cache_size > 0) {
+      sqlite3_reset(stmt);
+    } else {
+      sqlite3_finalize(stmt);
+    }
+  }
+
+private:
+  sqlite3* m_db = nullptr;
+  size_t m_cache_size;
+  bool m_is_borrowed = false;
+  std::string m_error;
+  std::list<std::pair<std::string, sqlite3_stmt*>> m_statements;
+  std::unordered_map<std::string, std::list<std::pair<std::string, sqlite3_stmt*>>::iterator> m_statement_map;
+};
+
+//
+// Job
+//
+
+class Job {
+public:
+  Job(const std::string &sql, pjs::Promise::Settler *settler, bool is_batch)
+    : m_net(&Net::current())
+    , m_work_guard(asio::make_work_guard(Net::context()))
+    , m_settler(settler)
+    , m_sql(sql)
+    , m_is_batch(is_batch) {}
+
+  auto net() const -> Net* { return m_net; }
+  bool is_batch() const { return m_is_batch; }
+  bool is_read() const;
+  auto params() -> std::vector<std::vector<Cell>>& { return m_params; }
+
+  bool run(Connection &conn, bool read_only);
+  void complete();
+
+private:
+  Net* m_net;
+  asio::executor_work_guard<asio::io_context::executor_type> m_work_guard;
+  pjs::Ref<pjs::Promise::Settler> m_settler;
+  std::string m_sql;
+  std::vector<std::vector<Cell>> m_params;
+  std::vector<std::string> m_columns;
+  std::vector<std::vector<Cell>> m_rows;
+  std::string m_error;
+  int m_changes = 0;
+  bool m_is_batch;
+
+  bool step(Connection &conn, sqlite3_stmt *stmt, const std::vector<Cell> &params, bool collect);
+};
+
+bool Job::is_read() const {
+  if (m_is_batch) return false;
+  size_t i = 0;
+  while (i < m_sql.length() && std::isspace((unsigned char)m_sql[i])) i++;
+  auto p = m_sql.c_str() + i;
+  auto n = m_sql.length() - i;
+  return (
+    (n > 6 && utils::iequals(p, "select", 6)) ||
+    (n > 4 && utils::iequals(p, "with", 4))
+  );
+}
+
+bool Job::step(Connection &conn, sqlite3_stmt *stmt, const std::vector<Cell> &params, bool collect) {
+  for (size_t i = 0; i < params.size(); i++) {
+    params[i].bind(stmt, i + 1);
+  }
+  for (;;) {
+    switch (sqlite3_step(stmt)) {
+      case SQLITE_ROW:
+        if (collect) {
+          auto n = sqlite3_column_count(stmt);
+          if (m_columns.empty()) {
+            for (int i = 0; i < n; i++) m_columns.push_back(sqlite3_column_name(stmt, i));
+          }
+          m_rows.emplace_back();
+          auto &row = m_rows.back();
+          for (int i = 0; i < n; i++) row.emplace_back(stmt, i);
+        }
+        break;
+      case SQLITE_DONE:
+        m_changes += sqlite3_changes(conn.db());
+        conn.done(stmt);
+        return true;
+      default:
+        m_error = "SQLite error: ";
+        m_error += sqlite3_errmsg(conn.db());
+        conn.done(stmt);
+        return false;
+    }
+  }
+}
+
+bool Job::run(Connection &conn, bool read_only) {
+  if (!conn.error().empty()) {
+    m_error = "SQLite error: " + conn.error();
+    return true;
+  }
+
+  auto stmt = conn.prepare(m_sql);
+  if (!stmt) {
+    m_error = "SQLite error: ";
+    m_error += sqlite3_errmsg(conn.db());
+    return true;
+  }
+
+  if (read_only && !sqlite3_stmt_readonly(stmt)) {
+    conn.done(stmt);
+    return false;
+  }
+
+  if (!m_is_batch) {
+    static const std::vector<Cell> no_params;
+    step(conn, stmt, m_params.empty() ? no_params : m_params.front(), true);
+    return true;
+  }
+
+  auto db = conn.db();
+  if (sqlite3_exec(db, "BEGIN IMMEDIATE", nullptr, nullptr, nullptr) != SQLITE_OK) {
+    m_error = "SQLite error: ";
+    m_error += sqlite3_errmsg(db);
+    conn.done(stmt);
+    return true;
+  }
+
+  for (const auto &params : m_params) {
+    if (!step(conn, stmt, params, false)) {
+      sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+      return true;
+    }
+    sqlite3_clear_bindings(stmt);
+  }
+
+  if (sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr) != SQLITE_OK) {
+    m_error = "SQLite error: ";
+    m_error += sqlite3_errmsg(db);
+    sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+  }
+
+  return true;
+}
+
+void Job::complete() {
+  InputContext ic;
+  if (!m_error.empty()) {
+    m_settler->reject(pjs::Error::make(pjs::Str::make(m_error)));
+  } else if (m_is_batch) {
+    m_settler->resolve(m_changes);
+  } else {
+    std::vector<pjs::Ref<pjs::Str>> keys;
+    for (const auto &name : m_columns) keys.push_back(pjs::Str::make(name));
+    auto rows = pjs::Array::make(m_rows.size());
+    for (size_t i = 0; i < m_rows.size(); i++) {
+      const auto &row = m_rows[i];
+      auto o = pjs::Object::make();
+      for (size_t j = 0; j < row.size(); j++) {
+        pjs::Value v;
+        row[j].get(v);
+        o->ht_set(keys[j], v);
+      }
+      rows->set(i, o);
+    }
+    m_settler->resolve(rows);
+  }
+  delete this;
+}
+
+//
+// ConnectionPool
+//
+// One writer thread and a few reader threads, each with its own
+// connection to a database in WAL mode. Jobs are picked up in order
+// and the results are posted back to the thread that submitted them.
+// Threads quit after draining their queues once the pool is shut down.
+// The writer quits last, as readers can hand jobs over to it until
+// they are all gone. The pool joins them all before it goes away.
+//
+
+class ConnectionPool : public pjs::RefCountMT<ConnectionPool> {
+public:
+  ConnectionPool(const std::string &path, int flags, int readers, int cache_size)
+    : m_path(path)
+    , m_flags(flags ? flags : SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE)
+    , m_cache_size(std::max(0, cache_size))
+  {
+    m_live_readers = readers;
+    m_has_readers = readers > 0;
+    start(false);
+    for (int i = 0; i < readers; i++) start(true);
+  }
+
+  ~ConnectionPool() {
+    shutdown();
+    for (auto &t : m_threads) t.join();
+  }
+
+  void submit(Job *job) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_has_readers && job->is_read()) {
+      m_read_jobs.push_back(job);
+      m_read_cv.notify_one();
+    } else {
+      m_write_jobs.push_back(job);
+      m_write_cv.notify_one();
+    }
+  }
+
+  void shutdown() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_shutdown = true;
+    m_read_cv.notify_all();
+    m_write_cv.notify_all();
+  }
+
+private:
+  std::string m_path;
+  int m_flags;
+  int m_cache_size;
+  bool m_has_readers = false;
+  bool m_shutdown = false;
+  int m_live_readers = 0;
+  std::mutex m_mutex;
+  std::condition_variable m_read_cv;
+  std::condition_variable m_write_cv;
+  std::list<Job*> m_read_jobs;
+  std::list<Job*> m_write_jobs;
+  std::vector<std::thread> m_threads;
+
+  void start(bool read_only) {
+    m_threads.emplace_back(
+      [=]() {
+        main(read_only);
+      }
+    );
+  }
+
+  void main(bool read_only) {
+    auto flags = m_flags;
+    if (read_only) {
+      flags &= ~(SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+      flags |= SQLITE_OPEN_READONLY;
+    }
+
+    Connection conn(m_path, flags, m_cache_size);
+    auto &jobs = read_only ? m_read_jobs : m_write_jobs;
+    auto &cv = read_only ? m_read_cv : m_write_cv;
+
+    for (;;) {
+      Job *job = nullptr;
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        cv.wait(lock, [&]() {
+          return !jobs.empty() || (m_shutdown && (read_only || m_live_readers == 0));
+        });
+        if (jobs.empty()) {
+          if (read_only && !--m_live_readers) m_write_cv.notify_one();
+          break;
+        }
+        job = jobs.front();
+        jobs.pop_front();
+      }
+      if (job->run(conn, read_only)) {
+        job->net()->post([=]() { job->complete(); });
+      } else {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_write_jobs.push_back(job);
+        m_write_cv.notify_one();
+      }
+    }
+  }
+};
+
+//
+// Database::Options
+//
+
+Database::Options::Options(pjs::Object *options) {
+  Value(options, "readers")
+    .get(readers)
+    .check_nullable();
+  Value(options, "statementCacheSize")
+    .get(statement_cache_size)
+    .check_nullable();
+}
+
 //
 // Database
 //
 
-Database::Database(pjs::Str *filename, int flags) {
+Database::Database(pjs::Str *filename, int flags, const Options &options)
+  : m_flags(flags)
+  , m_options(options)
+{
 #ifdef _WIN32
   auto path = os::windows::to_back_slash(filename->str());
 #else
   const auto &path = filename->str();
 #endif
+  m_path = path;
   if (!flags) {
     if (sqlite3_open(path.c_str(), &m_db) != SQLITE_OK) {
       throw_error(m_db);
@@ -128,12 +576,70 @@ Database::Database(pjs::Str *filename, int flags) {
       throw_error(m_db);
     }
   }
+  sqlite3_busy_timeout(m_db, s_busy_timeout);
 }
 
 Database::~Database() {
+  if (m_pool) {
+    m_pool->shutdown();
+    m_pool->release();
+  }
+  delete m_inline_connection;
   sqlite3_close(m_db);
 }
 
+//
+// In-memory databases can't be opened by other threads,
+// so queries on them are run inline on the current connection
+//
+
+void Database::submit(Job *job) {
+  if (m_path.empty() || m_path == ":memory:" || m_path.find("mode=memory") != std::string::npos) {
+    if (!m_inline_connection) {
+      m_inline_connection = new Connection(m_db, m_options.statement_cache_size);
+    }
+    job->run(*m_inline_connection, false);
+    job->complete();
+    return;
+  }
+  if (!m_pool) {
+    sqlite3_exec(m_db, "PRAGMA journal_mode=WAL", nullptr, nullptr, nullptr);
+    m_pool = new ConnectionPool(m_path, m_flags, m_options.readers, m_options.statement_cache_size);
+    m_pool->retain();
+  }
+  m_pool->submit(job);
+}
+
+auto Database::query(pjs::Str *sql, pjs::Array *params) -> pjs::Promise* {
+  auto promise = pjs::Promise::make();
+  auto job = new Job(sql->str(), pjs::Promise::Settler::make(promise), false);
+  if (params) {
+    job->params().emplace_back();
+    auto &cells = job->params().back();
+    params->iterate_all([&](pjs::Value &v, int) { cells.emplace_back(v); });
+  }
+  submit(job);
+  return promise;
+}
+
+auto Database::batch(pjs::Str *sql, pjs::Array *rows) -> pjs::Promise* {
+  auto promise = pjs::Promise::make();
+  auto job = new Job(sql->str(), pjs::Promise::Settler::make(promise), true);
+  rows->iterate_all(
+    [&](pjs::Value &row, int) {
+      job->params().emplace_back();
+      auto &cells = job->params().back();
+      if (row.is_array()) {
+        row.as<pjs::Array>()->iterate_all([&](pjs::Value &v, int) { cells.emplace_back(v); });
+      } else {
+        cells.emplace_back(row);
+      }
+    }
+  );
+  submit(job);
+  return promise;
+}
+
 auto Database::sql(pjs::Str *sql) -> Statement* {
   sqlite3_stmt *stmt = nullptr;
   if (SQLITE_OK != sqlite3_prepare_v2(m_db, sql->c_str(), sql->size(), &stmt, nullptr)) {
@@ -235,16 +741,17 @@ auto Statement::row() -> pjs::Object* {
 // Sqlite
 //
 
-auto Sqlite::database(pjs::Str *filename, int flags) -> Database* {
-  return Database::make(filename, flags);
+auto Sqlite::database(pjs::Str *filename, int flags, pjs::Object *options) -> Database* {
+  return Database::make(filename, flags, options);
 }
 
 void Sqlite::operator()(pjs::Context &ctx, pjs::Object *obj, pjs::Value &ret) {
   pjs::Str *filename;
   int flags = 0;
-  if (!ctx.arguments(1, &filename, &flags)) return;
+  pjs::Object *options = nullptr;
+  if (!ctx.arguments(1, &filename, &flags, &options)) return;
   try {
-    ret.set(database(filename, flags));
+    ret.set(database(filename, flags, options));
   } catch (std::runtime_error &err) {
     ctx.error(err);
   }
@@ -282,6 +789,20 @@ template<> void ClassDef<Database>::init() {
       ctx.error(err);
     }
   });
+
+  method("query", [](Context &ctx, Object *obj, Value &ret) {
+    Str *sql;
+    Array *params = nullptr;
+    if (!ctx.arguments(1, &sql, &params)) return;
+    ret.set(static_cast<Database*>(obj)->query(sql, params));
+  });
+
+  method("batch", [](Context &ctx, Object *obj, Value &ret) {
+    Str *sql;
+    Array *rows;
+    if (!ctx.arguments(2, &sql, &rows)) return;
+    ret.set(static_cast<Database*>(obj)->batch(sql, rows));
+  });
 }
 
 template<> void ClassDef<Statement>::init() {
@@ -27,6 +27,7 @@
 #define SQLITE_HPP
 
 #include "pjs/pjs.hpp"
+#include "options.hpp"
 
 #include <sqlite3.h>
 
@@ -34,6 +35,9 @@ namespace pipy {
 namespace sqlite {
 
 class Statement;
+class Connection;
+class ConnectionPool;
+class Job;
 
 //
 // Database
@@ -41,14 +45,30 @@ class Statement;
 
 class Database : public pjs::ObjectTemplate<Database> {
 public:
+  struct Options : public pipy::Options {
+    int readers = 2;
+    int statement_cache_size = 64;
+    Options() {}
+    Options(pjs::Object *options);
+  };
+
   auto sql(pjs::Str *sql) -> Statement*;
   auto exec(pjs::Str *sql) -> pjs::Array*;
+  auto query(pjs::Str *sql, pjs::Array *params) -> pjs::Promise*;
+  auto batch(pjs::Str *sql, pjs::Array *rows) -> pjs::Promise*;
 
 private:
-  Database(pjs::Str *filename, int flags = 0);
+  Database(pjs::Str *filename, int flags = 0, const Options &options = Options());
   ~Database();
 
   sqlite3* m_db;
+  std::string m_path;
+  int m_flags;
+  Options m_options;
+  ConnectionPool* m_pool = nullptr;
+  Connection* m_inline_connection = nullptr;
+
+  void submit(Job *job);
 
   friend class pjs::ObjectTemplate<Database>;
   friend class Statement;
@@ -83,7 +103,7 @@ private:
 
 class Sqlite : public pjs::FunctionTemplate<Sqlite> {
 public:
-  static auto database(pjs::Str *filename, int flags = 0) -> Database*;
+  static auto database(pjs::Str *filename, int flags = 0, pjs::Object *options = nullptr) -> Database*;
 
   void operator()(pjs::Context &ctx, pjs::Object *obj, pjs::Value &ret);
 };
@@ -88,6 +88,7 @@ auto Metric::local() -> MetricSet& {
 
 Metric::Metric(pjs::Str *name, pjs::Array *label_names, MetricSet *set)
   : m_root(nullptr)
+  , m_family(this)
   , m_name(name)
   , m_label_index(-1)
   , m_label_names(std::make_shared<std::vector<pjs::Ref<pjs::Str>>>())
@@ -118,6 +119,7 @@ Metric::Metric(pjs::Str *name, pjs::Array *label_names, MetricSet *set)
 
 Metric::Metric(Metric *parent, pjs::Str **labels)
   : m_root(parent->m_root)
+  , m_family(parent->m_family)
   , m_name(parent->m_name)
   , m_label(labels[parent->m_label_index + 1])
   , m_label_index(parent->m_label_index + 1)
@@ -126,6 +128,7 @@ Metric::Metric(Metric *parent, pjs::Str **labels)
   parent->m_subs.emplace_back();
   parent->m_subs.back() = this;
   parent->m_sub_map[m_label] = this;
+  m_family->m_dirty = true;
 }
 
 auto Metric::submetrics() -> pjs::Array* {
@@ -172,10 +175,12 @@ void Metric::clear() {
   m_subs.clear();
   m_sub_map.clear();
   m_has_value = false;
+  m_family->m_dirty = true;
 }
 
 void Metric::create_value() {
   m_has_value = true;
+  m_family->m_dirty = true;
 }
 
 void Metric::zero_all() {
@@ -369,6 +374,20 @@ MetricData::~MetricData() {
 }
 
 void MetricData::update(MetricSet &metrics) {
+  auto **ent = &m_entries;
+  for (const auto &i : metrics.m_metrics) {
+    update(i.get(), ent);
+    ent = &(*ent)->next;
+  }
+
+  auto e = *ent; *ent = nullptr;
+  while (e) {
+    auto ent = e; e = e->next;
+    delete ent;
+  }
+}
+
+void MetricData::update(Metric *metric, Entry **ent) {
   std::function<void(int, Node*, Metric*)> update;
 
   update = [&](int level, Node *node, Metric *metric) {
@@ -395,33 +414,22 @@ void MetricData::update(MetricSet &metrics) {
     }
   };
 
-  auto **ent = &m_entries;
-  for (const auto &i : metrics.m_metrics) {
-    auto metric = i.get();
-    auto e = *ent;
-    if (!e ||
-      e->name != metric->name()->data() ||
-      e->type != metric->type()->data() ||
-      e->shape != metric->shape()->data() ||
-      e->dimensions != metric->dimensions()
-    ) {
-      if (!e) e = *ent = new Entry;
-      e->root.reset(Node::make(metric->dimensions()));
-      e->name = metric->name()->data();
-      e->type = metric->type()->data();
-      e->shape = metric->shape()->data();
-      e->dimensions = metric->dimensions();
-      e->labels.clear();
-    }
-    update(0, e->root.get(), metric);
-    ent = &e->next;
-  }
-
-  auto e = *ent; *ent = nullptr;
-  while (e) {
-    auto ent = e; e = e->next;
-    delete ent;
+  auto e = *ent;
+  if (!e ||
+    e->name != metric->name()->data() ||
+    e->type != metric->type()->data() ||
+    e->shape != metric->shape()->data() ||
+    e->dimensions != metric->dimensions()
+  ) {
+    if (!e) e = *ent = new Entry;
+    e->root.reset(Node::make(metric->dimensions()));
+    e->name = metric->name()->data();
+    e->type = metric->type()->data();
+    e->shape = metric->shape()->data();
+    e->dimensions = metric->dimensions();
+    e->labels.clear();
   }
+  update(0, e->root.get(), metric);
 }
 
 bool MetricData::deserialize(const Data &in) {
@@ -523,6 +531,31 @@ void MetricData::Deserializer::error() {
   m_has_error = true;
 }
 
+void MetricData::Deserializer::create(Level *level) {
+  auto parent = level->parent;
+  level->pending = false;
+  if (parent->kind == Level::Kind::ENTRIES) {
+    m_current_entry = m_entries.next([]() { return new Entry; });
+    level->node = m_current_entry->root.get();
+  } else {
+    level->node = parent->subs.next([this]() { return Node::make(m_current_entry->dimensions); });
+  }
+}
+
+bool MetricData::Deserializer::skip(Level *level, double count) {
+  auto parent = level->parent;
+  level->field = Level::Field::NONE;
+  if (!(count >= 1 && count <= 0x7fffffff)) return false;
+  for (int i = 0, n = count; i < n; i++) {
+    if (parent->kind == Level::Kind::ENTRIES) {
+      if (!m_entries.next()) return false;
+    } else {
+      if (!parent->subs.next()) return false;
+    }
+  }
+  return true;
+}
+
 void MetricData::Deserializer::null() {
   if (!m_has_error) {
     if (auto level = m_current_level) {
@@ -605,7 +638,9 @@ void MetricData::Deserializer::number(double n) {
           break;
         }
         case Level::Kind::METRIC: {
-          if (auto *node = level->node) {
+          if (level->field == Level::Field::UNCHANGED) {
+            if (skip(level, n)) return;
+          } else if (auto *node = level->node) {
             if (level->field == Level::Field::VALUE) {
               node->has_value = true;
               node->values[0] = n;
@@ -679,14 +714,11 @@ void MetricData::Deserializer::map_start() {
   if (!m_has_error) {
     if (auto *level = m_current_level) {
       switch (level->kind) {
-        case Level::Kind::ENTRIES: {
-          m_current_entry = m_entries.next([]() { return new Entry; });
-          push(new Level(Level::Kind::METRIC, m_current_entry->root.get()));
-          break;
-        }
+        case Level::Kind::ENTRIES:
         case Level::Kind::SUBS: {
-          auto sub = level->subs.next([this]() { return Node::make(m_current_entry->dimensions); });
-          push(new Level(Level::Kind::METRIC, sub));
+          auto metric = new Level(Level::Kind::METRIC);
+          metric->pending = true;
+          push(metric);
           break;
         }
         default: error(); break;
@@ -707,6 +739,14 @@ void MetricData::Deserializer::map_key(const char *s, size_t len) {
           if (!std::strncmp(s, "roots", len)) { level->field = Level::Field::ROOTS; return; }
           break;
         case Level::Kind::METRIC:
+          if (level->pending) {
+            if (len == 1 && *s == 'u') {
+              level->pending = false;
+              level->field = Level::Field::UNCHANGED;
+              return;
+            }
+            create(level);
+          }
           if (len == 1) {
             switch (*s) {
               case 'k': level->field = Level::Field::KEY; return;
@@ -727,6 +767,7 @@ void MetricData::Deserializer::map_key(const char *s, size_t len) {
 
 void MetricData::Deserializer::map_end() {
   if (!m_has_error) {
+    if (m_current_level->pending) create(m_current_level);
     pop();
   }
 }
@@ -785,6 +826,32 @@ void MetricData::Deserializer::array_end() {
   }
 }
 
+//
+// MetricShard
+//
+
+void MetricShard::publish(MetricSet &metrics) {
+  auto last = m_snapshot;
+  auto snapshot = std::make_shared<Snapshot>();
+  snapshot->reserve(metrics.m_metrics.size());
+
+  for (const auto &i : metrics.m_metrics) {
+    auto *metric = i.get();
+    auto n = snapshot->size();
+    if (!metric->m_dirty && last && n < last->size() && last->at(n)->m_entries->name == metric->name()->data()) {
+      snapshot->push_back(last->at(n));
+    } else {
+      auto family = std::make_shared<MetricData>();
+      family->update(metric, &family->m_entries);
+      snapshot->push_back(family);
+      metric->m_dirty = false;
+    }
+  }
+
+  std::atomic_store(&m_snapshot, std::shared_ptr<const Snapshot>(snapshot));
+  m_version.fetch_add(1, std::memory_order_release);
+}
+
 //
 // MetricDataSum
 //
@@ -798,70 +865,126 @@ MetricDataSum::~MetricDataSum() {
 }
 
 void MetricDataSum::sum(MetricData &data, bool initial) {
-  std::function<void(int, Node*, MetricData::Node*)> sum;
-
-  sum = [&](int dimensions, Node *node, MetricData::Node* src_node) {
-    node->has_value |= src_node->has_value;
-    for (int i = 0; i < dimensions; i++) {
-      node->values[i] += src_node->values[i];
+  for (auto *e = data.m_entries; e; e = e->next) {
+    auto *ent = entry(e, initial);
+    ent->sources.clear();
+    if (initial) {
+      ent->root->zero(e->dimensions);
     }
+    add(ent, std::min(ent->dimensions, e->dimensions), ent->root.get(), e->root.get());
+  }
+}
 
-    auto &submap = node->submap;
-    for (auto s = src_node->subs; s; s = s->next) {
-      auto *key = pjs::Str::make(s->key)->retain();
-      Node *sub = nullptr;
-      auto i = submap.find(key);
-      if (i == submap.end()) {
-        submap[key] = sub = Node::make(dimensions);
-        sub->key = key;
-        node->subs.push(sub);
-      } else {
-        sub = i->second;
+//
+// Only re-aggregate the families whose snapshots
+// have changed in any of the shards since last time
+//
+
+void MetricDataSum::sum(const std::vector<std::shared_ptr<const MetricShard::Snapshot>> &shards) {
+  std::unordered_map<pjs::Str*, std::vector<std::shared_ptr<const MetricData>>> families;
+  std::vector<pjs::Ref<pjs::Str>> names;
+
+  for (size_t i = 0; i < shards.size(); i++) {
+    if (const auto &snapshot = shards[i]) {
+      for (const auto &family : *snapshot) {
+        pjs::Ref<pjs::Str> name(pjs::Str::make(family->m_entries->name));
+        auto &sources = families[name];
+        if (sources.empty()) {
+          sources.resize(shards.size());
+          names.push_back(name);
+        }
+        sources[i] = family;
       }
-      key->release();
-      sum(dimensions, sub, s);
     }
-  };
+  }
 
-  for (auto *e = data.m_entries; e; e = e->next) {
-    auto *name = pjs::Str::make(e->name)->retain();
-    auto *type = pjs::Str::make(e->type)->retain();
-    auto *shape = pjs::Str::make(e->shape)->retain();
+  for (const auto &name : names) {
+    auto &sources = families[name];
+    auto i = m_entry_map.find(name);
+    if (i != m_entry_map.end() && i->second->sources == sources) continue;
 
-    auto &ent = m_entry_map[name];
-    if (!ent || (initial && (
-      ent->type != type ||
-      ent->shape != shape ||
-      ent->dimensions != e->dimensions
-    ))) {
+    Entry *ent = nullptr;
+    for (const auto &family : sources) {
+      if (!family) continue;
+      auto *e = family->m_entries;
       if (!ent) {
-        ent = new Entry;
-        m_entries.push(ent);
+        ent = entry(e, true);
+        ent->root->zero(ent->dimensions);
       }
-      ent->name = name;
-      ent->type = type;
-      ent->shape = shape;
-      ent->dimensions = e->dimensions;
-      ent->labels.clear();
-      ent->root.reset(Node::make(ent->dimensions));
+      add(ent, std::min(ent->dimensions, e->dimensions), ent->root.get(), e->root.get());
     }
 
-    name->release();
-    type->release();
-    shape->release();
+    ent->sources = std::move(sources);
+  }
 
-    if (initial) {
-      ent->root->zero(e->dimensions);
+  for (auto *ent = m_entries.head(); ent; ent = ent->next()) {
+    if (!ent->sources.empty() && families.find(ent->name.get()) == families.end()) {
+      ent->sources.clear();
+      ent->root->zero(ent->dimensions);
     }
+  }
+}
 
-    sum(
-      std::min(ent->dimensions, e->dimensions),
-      ent->root.get(), e->root.get()
-    );
+auto MetricDataSum::entry(MetricData::Entry *e, bool initial) -> Entry* {
+  auto *name = pjs::Str::make(e->name)->retain();
+  auto *type = pjs::Str::make(e->type)->retain();
+  auto *shape = pjs::Str::make(e->shape)->retain();
+
+  auto &ent = m_entry_map[name];
+  if (!ent || (initial && (
+    ent->type != type ||
+    ent->shape != shape ||
+    ent->dimensions != e->dimensions
+  ))) {
+    if (!ent) {
+      ent = new Entry;
+      m_entries.push(ent);
+    }
+    ent->name = name;
+    ent->type = type;
+    ent->shape = shape;
+    ent->dimensions = e->dimensions;
+    ent->labels.clear();
+    ent->root.reset(Node::make(ent->dimensions));
   }
+
+  name->release();
+  type->release();
+  shape->release();
+
+  return ent;
 }
 
-void MetricDataSum::serialize(Data::Builder &db, bool initial) {
+void MetricDataSum::add(Entry *ent, int dimensions, Node *node, MetricData::Node *src_node) {
+  node->has_value |= src_node->has_value;
+  for (int i = 0; i < dimensions; i++) {
+    node->values[i] += src_node->values[i];
+  }
+
+  auto &submap = node->submap;
+  for (auto s = src_node->subs; s; s = s->next) {
+    auto *key = pjs::Str::make(s->key)->retain();
+    Node *sub = nullptr;
+    auto i = submap.find(key);
+    if (i == submap.end()) {
+      submap[key] = sub = Node::make(ent->dimensions);
+      sub->key = key;
+      node->subs.push(sub);
+    } else {
+      sub = i->second;
+    }
+    key->release();
+    add(ent, dimensions, sub, s);
+  }
+}
+
+//
+// In a delta report, unchanged nodes are not written. A run of
+// them in the middle of a list is replaced with {"u":<count>} and
+// a trailing run is left out, so the receiver keeps what it had.
+//
+
+void MetricDataSum::serialize(Data::Builder &db, bool initial, bool delta) {
   static const std::string s_version("\"version\":"); // version
   static const std::string s_last("\"last\":"); // last
   static const std::string s_roots("\"roots\":"); // roots
@@ -870,20 +993,60 @@ void MetricDataSum::serialize(Data::Builder &db, bool initial) {
   static const std::string s_v("\"v\":"); // value
   static const std::string s_l("\"l\":"); // label
   static const std::string s_s("\"s\":"); // sub
+  static const std::string s_u("{\"u\":"); // unchanged
   static const std::string s_null("null");
 
   auto last_version = m_version;
 
   if (initial) {
     m_version = 0;
+    delta = false;
   } else {
     m_version = utils::now();
   }
 
+  if (delta) {
+    for (auto *e = m_entries.head(); e; e = e->next()) {
+      e->root->check(e->dimensions);
+    }
+  }
+
+  auto write_unchanged = [&](int &count) {
+    if (count > 0) {
+      db.push(s_u);
+      db.push(std::to_string(count));
+      db.push('}');
+      db.push(',');
+      count = 0;
+    }
+  };
+
   std::function<void(int, Entry*, Node*)> write_node;
   write_node = [&](int level, Entry *ent, Node *node) {
+    int dim = ent->dimensions;
     bool keyed = (initial || !node->serialized);
-    bool value_only = (!keyed && node->subs.empty());
+    bool has_subs = false;
+    bool has_value = true;
+
+    if (delta) {
+      for (auto *s = node->subs.head(); s; s = s->next()) {
+        if (s->dirty) { has_subs = true; break; }
+      }
+      if (!keyed && node->has_value == node->sent_value) {
+        auto *last = node->sent(dim);
+        has_value = false;
+        for (int d = 0; d < dim; d++) {
+          if (node->values[d] != last[d]) {
+            has_value = true;
+            break;
+          }
+        }
+      }
+    } else {
+      has_subs = !node->subs.empty();
+    }
+
+    bool value_only = (!keyed && !has_subs);
 
     if (!value_only) {
       db.push('{');
@@ -910,11 +1073,12 @@ void MetricDataSum::serialize(Data::Builder &db, bool initial) {
         db.push(',');
       }
 
-      db.push(s_v);
+      if (has_value) db.push(s_v);
     }
 
-    if (node->has_value) {
-      int dim = ent->dimensions;
+    if (!has_value) {
+      // Only the subs have changed
+    } else if (node->has_value) {
       if (dim > 1) db.push('[');
 
       for (int d = 0; d < dim; d++) {
@@ -930,20 +1094,26 @@ void MetricDataSum::serialize(Data::Builder &db, bool initial) {
       db.push(s_null);
     }
 
-    if (!node->subs.empty()) {
-      db.push(',');
+    if (has_subs) {
+      if (has_value) db.push(',');
       db.push(s_s);
       db.push('[');
+      int unchanged = 0;
       bool first = true;
       for (auto *s = node->subs.head(); s; s = s->next()) {
+        if (delta && !s->dirty) {
+          unchanged++;
+          continue;
+        }
         if (first) first = false; else db.push(',');
+        write_unchanged(unchanged);
         write_node(level + 1, ent, s);
       }
       db.push(']');
     }
 
     if (!value_only) db.push('}');
-    node->serialized = true;
+    node->commit(dim);
   };
 
   db.push('{');
@@ -957,9 +1127,16 @@ void MetricDataSum::serialize(Data::Builder &db, bool initial) {
   }
   db.push(s_roots);
   db.push('[');
+  int unchanged = 0;
+  bool first = true;
   for (auto *e = m_entries.head(); e; e = e->next()) {
     auto *root = e->root.get();
-    if (e->back()) db.push(',');
+    if (delta && !root->dirty) {
+      unchanged++;
+      continue;
+    }
+    if (first) first = false; else db.push(',');
+    write_unchanged(unchanged);
     write_node(0, e, root);
   }
   db.push(']');
@@ -1048,7 +1225,7 @@ void MetricDataSum::to_prometheus(const std::function<void(const void *, size_t)
 //
 
 auto MetricDataSum::Node::make(int dimensions) -> Node* {
-  auto len = sizeof(Node) + (dimensions - 1) * sizeof(double);
+  auto len = sizeof(Node) + (dimensions * 2 - 1) * sizeof(double);
   auto ptr = (Node *)std::calloc(len, 1);
   new (ptr) Node;
   return ptr;
@@ -1070,6 +1247,29 @@ void MetricDataSum::Node::zero(int dimensions) {
   }
 }
 
+bool MetricDataSum::Node::check(int dimensions) {
+  dirty = (!serialized || has_value != sent_value);
+  if (!dirty && has_value) {
+    auto *last = sent(dimensions);
+    for (int i = 0; i < dimensions; i++) {
+      if (values[i] != last[i]) {
+        dirty = true;
+        break;
+      }
+    }
+  }
+  for (auto sub = subs.head(); sub; sub = sub->next()) {
+    if (sub->check(dimensions)) dirty = true;
+  }
+  return dirty;
+}
+
+void MetricDataSum::Node::commit(int dimensions) {
+  serialized = true;
+  sent_value = has_value;
+  std::memcpy(sent(dimensions), values, sizeof(values[0]) * dimensions);
+}
+
 //
 // MetricHistory
 //
@@ -1378,6 +1578,7 @@ void Gauge::zero() {
 }
 
 void Gauge::set(double n) {
+  if (has_value() && n == m_value) return;
   create_value();
   m_value = n;
 }
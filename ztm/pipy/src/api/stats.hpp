@@ -32,6 +32,7 @@
 #include "data.hpp"
 #include "signal.hpp"
 
+#include <atomic>
 #include <chrono>
 #include <memory>
 #include <string>
@@ -45,6 +46,7 @@ class MetricData;
 class MetricDataSum;
 class MetricHistory;
 class MetricSet;
+class MetricShard;
 
 //
 // Metric
@@ -90,12 +92,14 @@ private:
   void truncate(int i);
 
   Metric* m_root;
+  Metric* m_family;
   pjs::Ref<pjs::Str> m_name;
   pjs::Ref<pjs::Str> m_type;
   pjs::Ref<pjs::Str> m_shape;
   pjs::Ref<pjs::Str> m_label;
   int m_label_index;
   bool m_has_value = false;
+  bool m_dirty = true; // only kept on the top metric of a family
   std::shared_ptr<std::vector<pjs::Ref<pjs::Str>>> m_label_names;
   std::vector<pjs::Ref<Metric>> m_subs;
   std::unordered_map<pjs::Ref<pjs::Str>, Metric*> m_sub_map;
@@ -104,6 +108,7 @@ private:
   friend class MetricData;
   friend class MetricDataSum;
   friend class MetricSet;
+  friend class MetricShard;
 };
 
 //
@@ -125,6 +130,7 @@ private:
 
   friend class Metric;
   friend class MetricData;
+  friend class MetricShard;
 };
 
 //
@@ -231,6 +237,7 @@ private:
         LABELS,
         VALUE,
         SUB,
+        UNCHANGED,
       };
 
       Level(Kind k, Node *n = nullptr, Node **s = nullptr)
@@ -244,6 +251,7 @@ private:
       int index = 0;
       Node* node;
       Iterator<Node> subs;
+      bool pending = false;
     };
 
     Level* m_current_level = nullptr;
@@ -257,6 +265,8 @@ private:
     void push(Level *level);
     void pop();
     void error();
+    void create(Level *level);
+    bool skip(Level *level, double count);
 
     virtual void null() override;
     virtual void boolean(bool b) override;
@@ -273,8 +283,40 @@ private:
   Entry* m_entries = nullptr;
   uint64_t m_version = 0;
 
+  void update(Metric *metric, Entry **ent);
+
   friend class MetricDataSum;
   friend class MetricHistory;
+  friend class MetricShard;
+};
+
+//
+// MetricShard
+//
+// Metrics published by one worker thread. The worker builds a new
+// snapshot on its own event loop and swaps it in atomically, so that
+// other threads can read the latest one without a hop to that loop.
+// Every metric family is kept in a separate immutable MetricData and
+// families that haven't been updated are shared with the previous
+// snapshot. Each time a reader gives up waiting for a new snapshot and
+// uses an old one, the shard is counted as stale.
+//
+
+class MetricShard {
+public:
+  typedef std::vector<std::shared_ptr<const MetricData>> Snapshot;
+
+  auto version() const -> uint64_t { return m_version.load(std::memory_order_acquire); }
+  auto snapshot() const -> std::shared_ptr<const Snapshot> { return std::atomic_load(&m_snapshot); }
+  auto stale_count() const -> uint64_t { return m_stale_count.load(std::memory_order_relaxed); }
+
+  void publish(MetricSet &metrics);
+  void stale() { m_stale_count.fetch_add(1, std::memory_order_relaxed); }
+
+private:
+  std::shared_ptr<const Snapshot> m_snapshot;
+  std::atomic<uint64_t> m_version{0};
+  std::atomic<uint64_t> m_stale_count{0};
 };
 
 //
@@ -286,7 +328,8 @@ public:
   ~MetricDataSum();
 
   void sum(MetricData &data, bool initial);
-  void serialize(Data::Builder &db, bool initial);
+  void sum(const std::vector<std::shared_ptr<const MetricShard::Snapshot>> &shards);
+  void serialize(Data::Builder &db, bool initial, bool delta = false);
   auto to_object() -> pjs::Object*;
   void to_prometheus(const std::function<void(const void *, size_t)> &out) const;
 
@@ -302,10 +345,15 @@ private:
     List<Node> subs;
     bool serialized = false;
     bool has_value = false;
+    bool sent_value = false;
+    bool dirty = false;
     double values[1];
     static auto make(int dimensions) -> Node*;
     ~Node();
     void zero(int dimensions);
+    auto sent(int dimensions) -> double* { return values + dimensions; }
+    bool check(int dimensions);
+    void commit(int dimensions);
     auto get_key() -> pjs::Str::CharData* { return key->data(); }
     void for_subs(const std::function<void(Node*)> &cb) {
       for (const auto &p : submap) {
@@ -327,12 +375,16 @@ private:
     std::vector<std::string> labels;
     int dimensions;
     std::unique_ptr<Node> root;
+    std::vector<std::shared_ptr<const MetricData>> sources;
   };
 
   List<Entry> m_entries;
   std::unordered_map<pjs::Str*, Entry*> m_entry_map;
   uint64_t m_version = 0;
 
+  auto entry(MetricData::Entry *e, bool initial) -> Entry*;
+
+  static void add(Entry *ent, int dimensions, Node *node, MetricData::Node *src_node);
   static void create_metrics(Entry *ent, Node *node, Metric *metric);
 
   friend class MetricHistory;
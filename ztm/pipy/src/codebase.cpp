@@ -31,6 +31,7 @@
 #include "api/url.hpp"
 #include "fetch.hpp"
 #include "fs.hpp"
+#include "tar.hpp"
 #include "utils.hpp"
 #include "log.hpp"
 
@@ -44,6 +45,11 @@ namespace pipy {
 static Data::Producer s_dp("Codebase");
 static const pjs::Ref<pjs::Str> s_etag(pjs::Str::make("etag"));
 static const pjs::Ref<pjs::Str> s_date(pjs::Str::make("last-modified"));
+static const pjs::Ref<pjs::Str> s_accept(pjs::Str::make("accept"));
+static const pjs::Ref<pjs::Str> s_content_type(pjs::Str::make("content-type"));
+static const pjs::Ref<pjs::Str> s_if_none_match(pjs::Str::make("if-none-match"));
+static const pjs::Ref<pjs::Str> s_x_pipy_entry(pjs::Str::make("x-pipy-entry"));
+static const pjs::Ref<pjs::Str> s_accept_bundle(pjs::Str::make("application/x-tar, */*"));
 
 Codebase* Codebase::s_current = nullptr;
 
@@ -453,6 +459,13 @@ void CodebaseFromStore::sync(bool force, const std::function<void(bool)> &on_upd
 //
 // CodebaseFromHTTP
 //
+// The codebase at the URL can be a single script, a manifest listing
+// files to download one by one, or a tarball of all files. Tarballs
+// are asked for by accepting application/x-tar, so a repo that can
+// bundle a codebase serves it in one response, while anything else
+// still serves the manifest. Files in a manifest are downloaded
+// with their last ETags so the unchanged ones come back as 304.
+//
 
 class CodebaseFromHTTP : public CodebasePatchable {
 public:
@@ -486,6 +499,8 @@ private:
   std::string m_entry;
   std::map<std::string, pjs::Ref<SharedData>> m_files;
   std::map<std::string, pjs::Ref<SharedData>> m_dl_temp;
+  std::map<std::string, std::string> m_file_etags;
+  std::map<std::string, std::string> m_dl_etags;
   std::map<std::string, WatchedFile> m_watched_files;
   std::list<std::string> m_dl_list;
   pjs::Ref<pjs::Object> m_request_header_post_status;
@@ -493,6 +508,7 @@ private:
 
   void download(const std::function<void(bool)> &on_update);
   void download_next(const std::function<void(bool)> &on_update);
+  void unpack(const Data &tarball, const std::string &entry, const std::function<void(bool)> &on_update);
   void watch_next();
   void cancel_watches();
   void response_error(const char *method, const char *path, http::ResponseHead *head);
@@ -566,11 +582,13 @@ void CodebaseFromHTTP::sync(bool force, const std::function<void(bool)> &on_upda
     return;
   }
 
-  // Check updates
+  // Check updates, accepting a bundle for its ETag just like download()
+  auto headers = pjs::Object::make();
+  headers->set(s_accept, s_accept_bundle.get());
   m_fetch(
     Fetch::HEAD,
     m_url->path(),
-    nullptr,
+    headers,
     nullptr,
     [=](http::ResponseHead *head, Data *body) {
       if (!head || head->status != 200) {
@@ -612,10 +630,12 @@ void CodebaseFromHTTP::sync(bool force, const std::function<void(bool)> &on_upda
 }
 
 void CodebaseFromHTTP::download(const std::function<void(bool)> &on_update) {
+  auto headers = pjs::Object::make();
+  headers->set(s_accept, s_accept_bundle.get());
   m_fetch(
     Fetch::GET,
     m_url->path(),
-    nullptr,
+    headers,
     nullptr,
     [=](http::ResponseHead *head, Data *body) {
       if (!head || head->status != 200) {
@@ -637,6 +657,17 @@ void CodebaseFromHTTP::download(const std::function<void(bool)> &on_update) {
       if (etag.is_string()) m_etag = etag.s()->str(); else m_etag.clear();
       if (date.is_string()) m_date = date.s()->str(); else m_date.clear();
 
+      pjs::Value content_type, entry;
+      head->headers->get(s_content_type, content_type);
+      head->headers->get(s_x_pipy_entry, entry);
+      if (
+        (content_type.is_string() && utils::starts_with(content_type.s()->str(), "application/x-tar")) ||
+        utils::ends_with(m_url->pathname()->str(), ".tar")
+      ) {
+        unpack(*body, entry.is_string() ? entry.s()->str() : "", on_update);
+        return;
+      }
+
       auto text = body->to_string();
       if (text.length() > 2 &&
           text[0] == '/' &&
@@ -644,6 +675,7 @@ void CodebaseFromHTTP::download(const std::function<void(bool)> &on_update) {
           text[1] != '*'
       ) {
         m_dl_temp.clear();
+        m_dl_etags.clear();
         m_dl_list.clear();
         auto lines = utils::split(text, '\n');
         for (const auto &line : lines) {
@@ -656,6 +688,7 @@ void CodebaseFromHTTP::download(const std::function<void(bool)> &on_update) {
         m_mutex.lock();
         m_files.clear();
         m_files[m_root] = SharedData::make(*body);
+        m_file_etags.clear();
         m_entry = m_root;
         m_downloaded = true;
         m_mutex.unlock();
@@ -671,6 +704,7 @@ void CodebaseFromHTTP::download_next(const std::function<void(bool)> &on_update)
   if (m_dl_list.empty()) {
     m_mutex.lock();
     m_files = std::move(m_dl_temp);
+    m_file_etags = std::move(m_dl_etags);
     m_downloaded = true;
     for (auto &wf : m_watched_files) {
       wf.second.etag.clear();
@@ -686,12 +720,36 @@ void CodebaseFromHTTP::download_next(const std::function<void(bool)> &on_update)
   auto name = m_dl_list.front();
   auto path = m_base + name;
   m_dl_list.pop_front();
+
+  // Ask only for the files that have changed since the last download
+  pjs::Ref<SharedData> cached;
+  std::string etag;
+  auto headers = pjs::Object::make();
+  auto i = m_file_etags.find(name);
+  if (i != m_file_etags.end()) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto j = m_files.find(name);
+    if (j != m_files.end()) {
+      cached = j->second;
+      etag = i->second;
+      headers->set(s_if_none_match, pjs::Str::make(etag));
+    }
+  }
+
   m_fetch(
     Fetch::GET,
     pjs::Value(path).s(),
-    nullptr,
+    headers,
     nullptr,
     [=](http::ResponseHead *head, Data *body) {
+      if (head && head->status == 304 && cached) {
+        Log::info("[codebase] GET %s -> not modified", path.c_str());
+        m_dl_temp[name] = cached;
+        m_dl_etags[name] = etag;
+        download_next(on_update);
+        return;
+      }
+
       if (!head || head->status != 200) {
         response_error("GET", path.c_str(), head);
         on_update(false);
@@ -705,12 +763,65 @@ void CodebaseFromHTTP::download_next(const std::function<void(bool)> &on_update)
         );
       }
 
+      pjs::Value etag;
+      head->headers->get(s_etag, etag);
+      if (etag.is_string()) m_dl_etags[name] = etag.s()->str();
       m_dl_temp[name] = SharedData::make(body ? *body : Data());
       download_next(on_update);
     }
   );
 }
 
+void CodebaseFromHTTP::unpack(const Data &tarball, const std::string &entry, const std::function<void(bool)> &on_update) {
+  std::map<std::string, pjs::Ref<SharedData>> files;
+  auto buf = tarball.to_bytes();
+
+  try {
+    Tarball tar((const char *)buf.data(), buf.size());
+    std::set<std::string> paths;
+    tar.list(paths);
+    for (const auto &path : paths) {
+      size_t size = 0;
+      auto data = tar.get(path, size);
+      files[path] = SharedData::make(Data(data, size, &s_dp));
+    }
+  } catch (std::runtime_error &err) {
+    Log::error("[codebase] invalid tarball from %s: %s", m_url->href()->c_str(), err.what());
+    m_fetch.close();
+    on_update(false);
+    return;
+  }
+
+  if (files.empty()) {
+    Log::error("[codebase] empty tarball from %s", m_url->href()->c_str());
+    m_fetch.close();
+    on_update(false);
+    return;
+  }
+
+  Log::info("[codebase] unpacked %d files from %s", int(files.size()), m_url->href()->c_str());
+
+  m_mutex.lock();
+  m_files = std::move(files);
+  m_file_etags.clear();
+  if (!entry.empty() && m_files.count(utils::path_normalize(entry))) {
+    m_entry = utils::path_normalize(entry);
+  } else if (m_files.count("/main.js")) {
+    m_entry = "/main.js";
+  } else {
+    m_entry = m_files.begin()->first;
+  }
+  m_downloaded = true;
+  for (auto &wf : m_watched_files) {
+    wf.second.etag.clear();
+    wf.second.date.clear();
+  }
+  m_mutex.unlock();
+  m_fetch.close();
+  cancel_watches();
+  on_update(true);
+}
+
 void CodebaseFromHTTP::watch_next() {
   if (m_dl_list.empty()) {
     m_fetch.close();
@@ -762,6 +873,7 @@ void CodebaseFromHTTP::watch_next() {
                     if (etag.is_string()) wf.etag = etag.s()->str(); else wf.etag.clear();
                     if (date.is_string()) wf.date = date.s()->str(); else wf.date.clear();
                     m_files[name] = SharedData::make(body ? *body : Data());
+                    m_file_etags.erase(name);
                     for (const auto &w : wf.watches) notify(w);
                   }
                   m_mutex.unlock();
@@ -25,12 +25,16 @@
 
 #include "compressor.hpp"
 #include "data.hpp"
+#include "thread-pool.hpp"
 #include "pjs/pjs.hpp"
 
 #define ZLIB_CONST
 #include <zlib.h>
 
 #include <brotli/decode.h>
+#include <brotli/encode.h>
+
+#include <algorithm>
 
 namespace pipy {
 
@@ -193,7 +197,7 @@ public:
     gzip,
   };
 
-  Deflate(const Output &out, bool gzip)
+  Deflate(const Output &out, bool gzip, int level)
     : m_out(out)
   {
     m_zs.zalloc = Z_NULL;
@@ -204,7 +208,7 @@ public:
 
     deflateInit2(
       &m_zs,
-      Z_DEFAULT_COMPRESSION,
+      level < 0 ? Z_DEFAULT_COMPRESSION : std::min(level, 9),
       Z_DEFLATED,
       gzip ? 16 + MAX_WBITS : MAX_WBITS,
       8,
@@ -268,6 +272,93 @@ private:
 
 Data::Producer Deflate::s_dp("Compress (defalte)");
 
+//
+// BrotliEncoder
+//
+
+class BrotliEncoder : public pjs::Pooled<BrotliEncoder>, public Compressor {
+public:
+  BrotliEncoder(const Output &out, int quality, int window)
+    : m_out(out)
+    , m_es(BrotliEncoderCreateInstance(NULL, NULL, NULL))
+  {
+    if (quality < 0) quality = DEFAULT_QUALITY;
+    BrotliEncoderSetParameter(m_es, BROTLI_PARAM_QUALITY, std::min(quality, BROTLI_MAX_QUALITY));
+    if (window > 0) {
+      window = std::max(window, BROTLI_MIN_WINDOW_BITS);
+      window = std::min(window, BROTLI_MAX_WINDOW_BITS);
+      BrotliEncoderSetParameter(m_es, BROTLI_PARAM_LGWIN, window);
+    }
+  }
+
+private:
+
+  //
+  // Quality 11 (brotli's own default) is meant for static content
+  // and is far too slow for on-the-fly compression
+  //
+
+  static const int DEFAULT_QUALITY = 6;
+
+  Output m_out;
+  BrotliEncoderState* m_es;
+
+  ~BrotliEncoder() {
+    BrotliEncoderDestroyInstance(m_es);
+  }
+
+  virtual bool input(const Data &data, bool flush) override {
+    Data output;
+    Data::Builder db(output, &s_dp);
+
+    for (const auto chk : data.chunks()) {
+      auto buf = std::get<0>(chk);
+      auto len = std::get<1>(chk);
+      if (!encode(buf, len, BROTLI_OPERATION_PROCESS, db)) return false;
+    }
+
+    if (flush && !encode(nullptr, 0, BROTLI_OPERATION_FINISH, db)) return false;
+
+    db.flush();
+    m_out(output);
+    return true;
+  }
+
+  virtual bool flush() override {
+    Data output;
+    Data::Builder db(output, &s_dp);
+    if (!encode(nullptr, 0, BROTLI_OPERATION_FINISH, db)) return false;
+    db.flush();
+    m_out(output);
+    return true;
+  }
+
+  virtual bool finalize() override {
+    delete this;
+    return true;
+  }
+
+  bool encode(const char *data, size_t size, BrotliEncoderOperation op, Data::Builder &db) {
+    uint8_t buf[DATA_CHUNK_SIZE];
+    auto next_in = (const uint8_t *)data;
+    auto avail_in = size;
+    for (;;) {
+      auto next_out = buf;
+      size_t avail_out = sizeof(buf);
+      if (!BrotliEncoderCompressStream(m_es, op, &avail_in, &next_in, &avail_out, &next_out, nullptr)) return false;
+      if (auto size = sizeof(buf) - avail_out) db.push(buf, size);
+      if (avail_in > 0 || BrotliEncoderHasMoreOutput(m_es)) continue;
+      if (op == BROTLI_OPERATION_FINISH && !BrotliEncoderIsFinished(m_es)) continue;
+      break;
+    }
+    return true;
+  }
+
+  static Data::Producer s_dp;
+};
+
+Data::Producer BrotliEncoder::s_dp("Compress (brotli)");
+
 //
 // Decompressor
 //
@@ -288,12 +379,117 @@ Decompressor* Decompressor::brotli(const std::function<void(Data&)> &out) {
 // Compressor
 //
 
-Compressor *Compressor::deflate(const Output &out) {
-  return new Deflate(out, false);
+Compressor *Compressor::deflate(const Output &out, int level) {
+  return new Deflate(out, false, level);
+}
+
+Compressor *Compressor::gzip(const Output &out, int level) {
+  return new Deflate(out, true, level);
+}
+
+Compressor *Compressor::brotli(const Output &out, int quality, int window) {
+  return new BrotliEncoder(out, quality, window);
+}
+
+//
+// CompressorPool
+//
+
+static ThreadPool *s_pool = new ThreadPool(1, 4, 4);
+
+auto CompressorPool::submit(
+  Algorithm algorithm, int level, int window,
+  const Data &input, const Callback &cb
+) -> Job* {
+  return submit(Stream::make(algorithm, level, window), input, true, cb);
+}
+
+auto CompressorPool::submit(
+  Stream *stream, const Data &input, bool flush,
+  const Callback &cb
+) -> Job* {
+  auto job = new Job(stream, input, flush, cb);
+  s_pool->submit(
+    [=]() { job->run(); },
+    [=]() { job->complete(); }
+  );
+  return job;
+}
+
+auto CompressorPool::queued() -> int {
+  return s_pool->queued();
 }
 
-Compressor *Compressor::gzip(const Output &out) {
-  return new Deflate(out, true);
+auto CompressorPool::running() -> int {
+  return s_pool->running();
+}
+
+//
+// CompressorPool::Stream
+//
+
+CompressorPool::Stream::Stream(Algorithm algorithm, int level, int window) {
+  auto out = [this](Data &data) { m_output->push(std::move(data)); };
+  switch (algorithm) {
+    case Algorithm::deflate: m_compressor = Compressor::deflate(out, level); break;
+    case Algorithm::gzip: m_compressor = Compressor::gzip(out, level); break;
+    case Algorithm::brotli: m_compressor = Compressor::brotli(out, level, window); break;
+  }
+}
+
+CompressorPool::Stream::~Stream() {
+  m_compressor->finalize();
+}
+
+bool CompressorPool::Stream::compress(const Data &input, bool flush, Data &output) {
+  m_output = &output;
+  auto ok = m_compressor->input(input, false) && (!flush || m_compressor->flush());
+  m_output = nullptr;
+  return ok;
+}
+
+//
+// CompressorPool::Job
+//
+
+CompressorPool::Job::Job(Stream *stream, const Data &input, bool flush, const Callback &cb)
+  : m_stream(stream)
+  , m_input(SharedData::make(input)->retain())
+  , m_callback(cb)
+  , m_flush(flush)
+{
+}
+
+CompressorPool::Job::~Job() {
+  if (m_input) m_input->release();
+  if (m_output) m_output->release();
+}
+
+void CompressorPool::Job::cancel() {
+  m_canceled = true;
+  m_callback = nullptr;
+}
+
+void CompressorPool::Job::run() {
+  Data input, output;
+  m_input->to_data(input);
+  m_input->release();
+  m_input = nullptr;
+  if (m_stream->compress(input, m_flush, output)) {
+    m_output = SharedData::make(output)->retain();
+  }
+}
+
+void CompressorPool::Job::complete() {
+  if (!m_canceled) {
+    if (m_output) {
+      Data output(*m_output);
+      m_callback(&output);
+    } else {
+      m_callback(nullptr);
+    }
+  }
+  delete this;
 }
 
 } // namespace pipy
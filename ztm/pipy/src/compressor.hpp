@@ -26,12 +26,15 @@
 #ifndef COMPRESSOR_HPP
 #define COMPRESSOR_HPP
 
+#include "pjs/pjs.hpp"
+
 #include <cstddef>
 #include <functional>
 
 namespace pipy {
 
 class Data;
+class SharedData;
 
 //
 // Decompressor
@@ -60,8 +63,9 @@ class Compressor {
 public:
   typedef std::function<void(Data&)> Output;
 
-  static Compressor* deflate(const Output &out);
-  static Compressor* gzip(const Output &out);
+  static Compressor* deflate(const Output &out, int level = -1);
+  static Compressor* gzip(const Output &out, int level = -1);
+  static Compressor* brotli(const Output &out, int quality = -1, int window = -1);
 
   virtual bool input(const Data &data, bool flush) = 0;
   virtual bool flush() = 0;
@@ -70,6 +74,90 @@ public:
 protected:
   ~Compressor() {}
 };
+
+//
+// CompressorPool
+//
+// Compresses data on a ThreadPool shared by all workers. Results are
+// posted back to the submitting thread, where the callback receives
+// the compressed data or null on failure.
+//
+
+class CompressorPool {
+public:
+  enum class Algorithm {
+    deflate,
+    gzip,
+    brotli,
+  };
+
+  typedef std::function<void(Data*)> Callback;
+
+  //
+  // CompressorPool::Stream
+  //
+  // A compressor whose chunks can be compressed on either the worker
+  // thread or the pool. Only one chunk is compressed at a time, so
+  // callers wait for a job to complete before submitting the next.
+  //
+
+  class Stream : public pjs::RefCountMT<Stream> {
+  public:
+    static auto make(Algorithm algorithm, int level, int window) -> Stream* {
+      return new Stream(algorithm, level, window);
+    }
+
+    bool compress(const Data &input, bool flush, Data &output);
+
+  private:
+    Stream(Algorithm algorithm, int level, int window);
+    ~Stream();
+
+    Compressor* m_compressor = nullptr;
+    Data* m_output = nullptr;
+
+    friend class pjs::RefCountMT<Stream>;
+  };
+
+  //
+  // CompressorPool::Job
+  //
+
+  class Job {
+  public:
+    void cancel();
+
+  private:
+    Job(Stream *stream, const Data &input, bool flush, const Callback &cb);
+    ~Job();
+
+    pjs::Ref<Stream> m_stream;
+    SharedData* m_input;
+    SharedData* m_output = nullptr;
+    Callback m_callback;
+    bool m_flush;
+    bool m_canceled = false;
+
+    void run();
+    void complete();
+
+    friend class CompressorPool;
+  };
+
+  static auto submit(
+    Algorithm algorithm, int level, int window,
+    const Data &input, const Callback &cb
+  ) -> Job*;
+
+  static auto submit(
+    Stream *stream, const Data &input, bool flush,
+    const Callback &cb
+  ) -> Job*;
+
+  static auto queued() -> int;
+  static auto running() -> int;
+};
+
 } // namespace pipy
 
 #endif // COMPRESSOR_HPP
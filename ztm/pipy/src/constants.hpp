@@ -30,6 +30,11 @@ namespace pipy {
 
 const size_t DATA_CHUNK_SIZE = 0x4000;
 const size_t RECEIVE_BUFFER_SIZE = 0x4000;
+const size_t FILE_READ_SIZE = 0x40000;
+const size_t UDP_BATCH_SIZE = 32;
+const size_t UDP_GRO_BUFFER_SIZE = 0x10000;
+const size_t UDP_GSO_MAX_SIZE = 0xffff - 8 - 40;
+const size_t UDP_GSO_MAX_SEGMENTS = 64;
 
 } // namespace pipy
 
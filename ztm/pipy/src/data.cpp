@@ -51,7 +51,7 @@ void Data::pack(const Data &data, Producer *producer, double vacancy) {
     auto tail_offset = tail->offset;
     auto tail_length = tail->length;
     if (tail_length < occupancy || view->length + tail_length <= DATA_CHUNK_SIZE) {
-      if (tail_offset > 0 || tail->chunk->retain_count > 1) {
+      if (tail_offset > 0 || tail->chunk->retain_count > 1 || tail->chunk->is_external()) {
         tail = tail->clone(producer);
         delete pop_view();
         push_view(tail);
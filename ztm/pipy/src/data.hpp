@@ -48,6 +48,7 @@ class SharedData;
 class Data : public EventTemplate<Data> {
 private:
   struct Chunk;
+  struct BufferChunk;
   struct View;
 
 public:
@@ -115,7 +116,7 @@ public:
     static List<Producer> s_all_producers;
     static std::mutex s_all_producers_mutex;
 
-    friend struct Chunk;
+    friend struct BufferChunk;
   };
 
   //
@@ -127,7 +128,7 @@ public:
     Builder(Data &data, Producer *producer = nullptr)
       : m_data(data)
       , m_producer(producer)
-      , m_chunk(new Chunk(producer)) {}
+      , m_chunk(new BufferChunk(producer)) {}
 
     ~Builder() {
       delete m_chunk;
@@ -145,7 +146,7 @@ public:
     void flush() {
       if (m_ptr > 0) {
         m_data.push_view(new View(m_chunk, 0, m_ptr));
-        m_chunk = new Chunk(m_producer);
+        m_chunk = new BufferChunk(m_producer);
         m_ptr = 0;
       }
     }
@@ -153,7 +154,7 @@ public:
     void push(char c) {
       m_chunk->data[m_ptr++] = c;
       m_size++;
-      if (m_ptr >= sizeof(m_chunk->data)) {
+      if (m_ptr >= sizeof(m_chunk->buffer)) {
         flush();
       }
     }
@@ -166,14 +167,14 @@ public:
       auto &p = m_ptr;
       m_size += n;
       while (n > 0) {
-        int l = sizeof(m_chunk->data) - p;
+        int l = sizeof(m_chunk->buffer) - p;
         if (l > n) l = n;
         std::memset(m_chunk->data + p, c, l);
         p += l;
         n -= l;
-        if (p >= sizeof(m_chunk->data)) {
+        if (p >= sizeof(m_chunk->buffer)) {
           m_data.push_view(new View(m_chunk, 0, p));
-          m_chunk = new Chunk(m_producer);
+          m_chunk = new BufferChunk(m_producer);
           p = 0;
         }
       }
@@ -187,15 +188,15 @@ public:
       auto &p = m_ptr;
       m_size += n;
       while (n > 0) {
-        int l = sizeof(m_chunk->data) - p;
+        int l = sizeof(m_chunk->buffer) - p;
         if (l > n) l = n;
         std::memcpy(m_chunk->data + p, s, l);
         s += l;
         p += l;
         n -= l;
-        if (p >= sizeof(m_chunk->data)) {
+        if (p >= sizeof(m_chunk->buffer)) {
           m_data.push_view(new View(m_chunk, 0, p));
-          m_chunk = new Chunk(m_producer);
+          m_chunk = new BufferChunk(m_producer);
           p = 0;
         }
       }
@@ -230,7 +231,7 @@ public:
   private:
     Data& m_data;
     Producer* m_producer;
-    Chunk* m_chunk;
+    BufferChunk* m_chunk;
     int m_ptr = 0;
     int m_size = 0;
   };
@@ -359,21 +360,61 @@ private:
   // Data::Chunk
   //
 
-  struct Chunk : public Pooled<Chunk> {
+  struct Chunk {
     std::atomic<int> retain_count;
-    char data[DATA_CHUNK_SIZE];
+    char* data;
 
-    Chunk(Producer *producer)
+    bool is_external() const { return !m_producer; }
+    auto size() const -> int { return m_size; }
+    void retain() { retain_count.fetch_add(1, std::memory_order_relaxed); }
+    void release() { if (retain_count.fetch_sub(1, std::memory_order_acq_rel) == 1) free(); }
+
+  protected:
+    Chunk(char *d, int size, Producer *producer)
       : retain_count(0)
-      , m_producer(producer ? producer : Producer::unknown()) { m_producer->increase(); }
-    ~Chunk() { m_producer->decrease(); }
+      , data(d)
+      , m_size(size)
+      , m_producer(producer) {}
 
-    auto size() const -> int { return sizeof(data); }
-    void retain() { retain_count.fetch_add(1, std::memory_order_relaxed); }
-    void release() { if (retain_count.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this; }
+    int m_size;
+    Producer* m_producer;
 
   private:
-    Producer* m_producer;
+    inline void free();
+  };
+
+  //
+  // Data::BufferChunk
+  //
+
+  struct BufferChunk : public Chunk, public Pooled<BufferChunk> {
+    char buffer[DATA_CHUNK_SIZE];
+
+    BufferChunk(Producer *producer)
+      : Chunk(buffer, sizeof(buffer), producer ? producer : Producer::unknown()) { m_producer->increase(); }
+    ~BufferChunk() { m_producer->decrease(); }
+  };
+
+  //
+  // Data::ExternalChunk
+  //
+  // Wraps memory owned by someone else. It has no writable room, so
+  // pushes never append to it, and the release callback is invoked
+  // when the last view goes away, possibly on a different thread.
+  // Like any other chunk, it is never seen through a view longer than
+  // DATA_CHUNK_SIZE, so a large block is pushed as a run of views.
+  //
+
+  struct ExternalChunk : public Chunk, public Pooled<ExternalChunk> {
+    ExternalChunk(const char *d, void (*free)(void*), void *user_ptr)
+      : Chunk(const_cast<char*>(d), 0, nullptr)
+      , m_free(free)
+      , m_user_ptr(user_ptr) {}
+    ~ExternalChunk() { if (m_free) m_free(m_user_ptr); }
+
+  private:
+    void (*m_free)(void*);
+    void* m_user_ptr;
   };
 
   //
@@ -433,7 +474,7 @@ private:
 
     View* clone(Producer *producer) {
       if (!producer) producer = &s_unknown_producer;
-      auto new_chunk = new Chunk(producer);
+      auto new_chunk = new BufferChunk(producer);
       std::memcpy(new_chunk->data, chunk->data + offset, length);
       return new View(new_chunk, 0, length);
     }
@@ -500,7 +541,7 @@ public:
   {
     if (!producer) producer = &s_unknown_producer;
     while (size > 0) {
-      auto chunk = new Chunk(producer);
+      auto chunk = new BufferChunk(producer);
       auto length = std::min(size, chunk->size());
       push_view(new View(chunk, 0, length));
       size -= length;
@@ -514,7 +555,7 @@ public:
   {
     if (!producer) producer = &s_unknown_producer;
     while (size > 0) {
-      auto chunk = new Chunk(producer);
+      auto chunk = new BufferChunk(producer);
       auto length = std::min(size, chunk->size());
       std::memset(chunk->data, value, length);
       push_view(new View(chunk, 0, length));
@@ -722,7 +763,7 @@ public:
       }
     }
     while (n > 0) {
-      auto view = new View(new Chunk(producer), 0, 0);
+      auto view = new View(new BufferChunk(producer), 0, 0);
       auto added = view->push(p, n);
       p += added;
       n -= added;
@@ -730,6 +771,18 @@ public:
     }
   }
 
+  void push_external(const void *data, int n, void (*free)(void*), void *user_ptr) {
+    assert_same_thread(*this);
+    if (n <= 0) {
+      if (free) free(user_ptr);
+      return;
+    }
+    auto chunk = new ExternalChunk((const char*)data, free, user_ptr);
+    for (int i = 0; i < n; i += DATA_CHUNK_SIZE) {
+      push_view(new View(chunk, i, std::min(n - i, int(DATA_CHUNK_SIZE))));
+    }
+  }
+
   void push(const std::vector<uint8_t> &bytes, Producer *producer) {
     push(bytes.data(), bytes.size(), producer);
   }
@@ -748,7 +801,7 @@ public:
         }
       }
     }
-    auto chunk = new Chunk(producer ? producer : &s_unknown_producer);
+    auto chunk = new BufferChunk(producer ? producer : &s_unknown_producer);
     auto view = new View(chunk, 0, 1);
     chunk->data[0] = ch;
     push_view(view);
@@ -1000,7 +1053,8 @@ private:
     auto size = view->length;
     if (auto tail = m_tail) {
       if (tail->chunk == view->chunk &&
-          tail->offset + tail->length == view->offset)
+          tail->offset + tail->length == view->offset &&
+          tail->length + size <= DATA_CHUNK_SIZE)
       {
         delete view;
         tail->length += size;
@@ -1046,7 +1100,8 @@ private:
     auto size = view->length;
     if (auto head = m_head) {
       if (head->chunk == view->chunk &&
-          head->offset == view->offset + size)
+          head->offset == view->offset + size &&
+          head->length + size <= DATA_CHUNK_SIZE)
       {
         delete view;
         head->offset -= size;
@@ -1068,6 +1123,14 @@ private:
   friend class SharedData;
 };
 
+inline void Data::Chunk::free() {
+  if (is_external()) {
+    delete static_cast<ExternalChunk*>(this);
+  } else {
+    delete static_cast<BufferChunk*>(this);
+  }
+}
+
 //
 // SharedData
 //
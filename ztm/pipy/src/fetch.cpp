@@ -36,8 +36,8 @@
 
 namespace pipy {
 
-auto Fetch::Receiver::clone() -> Filter* {
-  return new Receiver(m_fetch);
+auto Fetch::Receiver::clone(Arena *arena) -> Filter* {
+  return new (arena) Receiver(m_fetch);
 }
 
 void Fetch::Receiver::reset() {
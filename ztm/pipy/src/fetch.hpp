@@ -125,7 +125,7 @@ private:
     Receiver(Fetch *fetch) : m_fetch(fetch) {}
 
   private:
-    virtual auto clone() -> Filter* override;
+    virtual auto clone(Arena *arena) -> Filter* override;
     virtual void reset() override;
     virtual void process(Event *evt) override;
     virtual void dump(Dump &d) override;
@@ -0,0 +1,255 @@
+/*
+ *  Copyright (c) 2019 by flomesh.io
+ *
+ *  Unless prior written consent has been obtained from the copyright
+ *  owner, the following shall not be allowed.
+ *
+ *  1. The distribution of any source codes, header files, make files,
+ *     or libraries of the software.
+ *
+ *  2. Disclosure of any source codes pertaining to the software to any
+ *     additional parties.
+ *
+ *  3. Alteration or removal of any notices in or on the software or
+ *     within the documentation included within the software.
+ *
+ *  ALL SOURCE CODE AS WELL AS ALL DOCUMENTATION INCLUDED WITH THIS
+ *  SOFTWARE IS PROVIDED IN AN “AS IS” CONDITION, WITHOUT WARRANTY OF ANY
+ *  KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ *  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ *  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "file-cache.hpp"
+#include "compressor.hpp"
+#include "data.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+namespace pipy {
+
+//
+// Never destructed, as entries might still be referenced
+// by data being released after static destruction
+//
+
+static struct FileCacheState {
+  std::mutex mutex;
+  std::unordered_map<std::string, FileCache::Entry*> map;
+  std::list<FileCache::Entry*> lru;
+} *s_state = new FileCacheState;
+
+static bool stat_file(const std::string &path, uint64_t &inode, int64_t &mtime, size_t &size) {
+#ifdef _WIN32
+  struct _stat64 st;
+  if (_stat64(path.c_str(), &st)) return false;
+  if ((st.st_mode & _S_IFMT) != _S_IFREG) return false;
+#else
+  struct stat st;
+  if (::stat(path.c_str(), &st)) return false;
+  if (!S_ISREG(st.st_mode)) return false;
+#endif
+  inode = st.st_ino;
+  mtime = st.st_mtime;
+  size = st.st_size;
+  return true;
+}
+
+//
+// FileCache::Entry
+//
+
+FileCache::Entry::Entry(const std::string &path, uint64_t inode, int64_t mtime, size_t size)
+  : m_path(path)
+  , m_size(size)
+  , m_inode(inode)
+  , m_mtime(mtime)
+{
+  char etag[100];
+  std::snprintf(
+    etag, sizeof(etag), "\"%llx-%llx-%llx\"",
+    (unsigned long long)inode,
+    (unsigned long long)mtime,
+    (unsigned long long)size
+  );
+  m_etag = etag;
+  m_last_modified = http_date(mtime);
+}
+
+FileCache::Entry::~Entry() {
+  if (m_gzip) m_gzip->release();
+  delete [] m_ptr;
+}
+
+bool FileCache::Entry::load() {
+  if (!m_size) return true;
+  std::ifstream fs(m_path, std::ios::in | std::ios::binary);
+  if (!fs.is_open()) return false;
+  auto buf = new char[m_size];
+  fs.read(buf, m_size);
+  if ((size_t)fs.gcount() != m_size) {
+    delete [] buf;
+    return false;
+  }
+  m_ptr = buf;
+  return true;
+}
+
+auto FileCache::Entry::gzip() -> pjs::Ref<Entry> {
+  std::lock_guard<std::mutex> lock(m_gzip_mutex);
+  if (!m_gzip) {
+    Data input, output;
+    auto compressor = Compressor::gzip([&](Data &data) { output.push(std::move(data)); });
+    to_data(input);
+    auto ok = compressor->input(input, false) && compressor->flush();
+    compressor->finalize();
+    if (!ok) return nullptr;
+    auto e = new Entry(m_path, m_inode, m_mtime, output.size());
+    auto buf = new char[e->m_size];
+    output.to_bytes((uint8_t *)buf);
+    e->m_ptr = buf;
+    e->m_etag = m_etag.substr(0, m_etag.length() - 1) + "-gz\"";
+    e->m_last_modified = m_last_modified;
+    m_gzip = e->retain();
+  }
+  return m_gzip;
+}
+
+auto FileCache::Entry::gzipped() -> pjs::Ref<Entry> {
+  std::lock_guard<std::mutex> lock(m_gzip_mutex);
+  return m_gzip;
+}
+
+void FileCache::Entry::to_data(Data &data, size_t offset, size_t length) {
+  static const size_t max_view_size = 1 << 30;
+  if (offset >= m_size) return;
+  length = std::min(length, m_size - offset);
+  for (size_t i = 0; i < length; i += max_view_size) {
+    auto n = std::min(length - i, max_view_size);
+    retain();
+    data.push_external(
+      m_ptr + offset + i, n,
+      [](void *entry) { static_cast<Entry*>(entry)->release(); },
+      this
+    );
+  }
+}
+
+//
+// FileCache
+//
+
+std::atomic<size_t> FileCache::s_capacity(0);
+std::atomic<size_t> FileCache::s_size(0);
+
+void FileCache::reserve(size_t capacity) {
+  auto old = s_capacity.load(std::memory_order_relaxed);
+  while (capacity > old && !s_capacity.compare_exchange_weak(old, capacity)) {}
+}
+
+auto FileCache::find(const std::string &path, bool &missing) -> pjs::Ref<Entry> {
+  uint64_t inode;
+  int64_t mtime;
+  size_t size;
+  missing = !stat_file(path, inode, mtime, size);
+  if (missing) {
+    forget(path);
+    return nullptr;
+  }
+  return lookup(path, inode, mtime, size);
+}
+
+auto FileCache::get(const std::string &path) -> pjs::Ref<Entry> {
+  uint64_t inode;
+  int64_t mtime;
+  size_t size;
+
+  if (!stat_file(path, inode, mtime, size)) {
+    forget(path);
+    return nullptr;
+  }
+
+  if (auto e = lookup(path, inode, mtime, size)) return e;
+
+  pjs::Ref<Entry> e = new Entry(path, inode, mtime, size);
+  if (!e->load()) return nullptr;
+
+  if (size <= capacity()) {
+    std::lock_guard<std::mutex> lock(s_state->mutex);
+    auto &map = s_state->map;
+    auto &lru = s_state->lru;
+    auto i = map.find(path);
+    if (i != map.end()) evict(i->second);
+    map[path] = e->retain();
+    lru.push_front(e);
+    e->m_lru = lru.begin();
+    s_size.fetch_add(size, std::memory_order_relaxed);
+    while (s_size.load(std::memory_order_relaxed) > capacity() && lru.back() != e) {
+      evict(lru.back());
+    }
+  }
+
+  return e;
+}
+
+//
+// Returns the cached entry if it is still up to date with the file,
+// or evicts it if it is stale
+//
+
+auto FileCache::lookup(const std::string &path, uint64_t inode, int64_t mtime, size_t size) -> pjs::Ref<Entry> {
+  std::lock_guard<std::mutex> lock(s_state->mutex);
+  auto i = s_state->map.find(path);
+  if (i == s_state->map.end()) return nullptr;
+  auto e = i->second;
+  if (e->m_inode == inode && e->m_mtime == mtime && e->m_size == size) {
+    auto &lru = s_state->lru;
+    lru.splice(lru.begin(), lru, e->m_lru);
+    return e;
+  }
+  evict(e);
+  return nullptr;
+}
+
+void FileCache::forget(const std::string &path) {
+  std::lock_guard<std::mutex> lock(s_state->mutex);
+  auto i = s_state->map.find(path);
+  if (i != s_state->map.end()) evict(i->second);
+}
+
+void FileCache::evict(Entry *entry) {
+  s_state->map.erase(entry->m_path);
+  s_state->lru.erase(entry->m_lru);
+  s_size.fetch_sub(entry->m_size, std::memory_order_relaxed);
+  entry->release();
+}
+
+auto FileCache::http_date(int64_t t) -> std::string {
+  static const char *days[] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+  static const char *months[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+  std::time_t time = t;
+  std::tm tm;
+#ifdef _WIN32
+  gmtime_s(&tm, &time);
+#else
+  gmtime_r(&time, &tm);
+#endif
+  char str[100];
+  std::snprintf(
+    str, sizeof(str), "%s, %02d %s %04d %02d:%02d:%02d GMT",
+    days[tm.tm_wday], tm.tm_mday, months[tm.tm_mon], tm.tm_year + 1900,
+    tm.tm_hour, tm.tm_min, tm.tm_sec
+  );
+  return str;
+}
+
+} // namespace pipy
@@ -0,0 +1,123 @@
+/*
+ *  Copyright (c) 2019 by flomesh.io
+ *
+ *  Unless prior written consent has been obtained from the copyright
+ *  owner, the following shall not be allowed.
+ *
+ *  1. The distribution of any source codes, header files, make files,
+ *     or libraries of the software.
+ *
+ *  2. Disclosure of any source codes pertaining to the software to any
+ *     additional parties.
+ *
+ *  3. Alteration or removal of any notices in or on the software or
+ *     within the documentation included within the software.
+ *
+ *  ALL SOURCE CODE AS WELL AS ALL DOCUMENTATION INCLUDED WITH THIS
+ *  SOFTWARE IS PROVIDED IN AN “AS IS” CONDITION, WITHOUT WARRANTY OF ANY
+ *  KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ *  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ *  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FILE_CACHE_HPP
+#define FILE_CACHE_HPP
+
+#include "pjs/pjs.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace pipy {
+
+class Data;
+
+//
+// FileCache
+//
+// Process-wide cache of regular files loaded into memory, shared by
+// all worker threads. Entries are validated against the file's inode,
+// mtime and size on every lookup, and the least recently used ones
+// are evicted when the total size goes beyond the capacity. An evicted
+// entry stays in memory as long as any Data still refers to it.
+//
+// Only find() is meant for event loops, as it never reads a file and
+// returns what is already in memory. Loading with get() and gzipping
+// are left to FileIO threads.
+//
+// Contents are read into private buffers rather than mapped, because
+// a mapped file that is truncated in place while being served would
+// raise SIGBUS and take down the whole process.
+//
+
+class FileCache {
+public:
+
+  //
+  // FileCache::Entry
+  //
+
+  class Entry : public pjs::RefCountMT<Entry> {
+  public:
+    auto path() const -> const std::string& { return m_path; }
+    auto ptr() const -> const char* { return m_ptr; }
+    auto size() const -> size_t { return m_size; }
+    auto inode() const -> uint64_t { return m_inode; }
+    auto mtime() const -> int64_t { return m_mtime; }
+    auto etag() const -> const std::string& { return m_etag; }
+    auto last_modified() const -> const std::string& { return m_last_modified; }
+
+    void to_data(Data &data) { to_data(data, 0, m_size); }
+    void to_data(Data &data, size_t offset, size_t length);
+
+    // Gzipped copy of the content, made once and kept with the entry
+    auto gzip() -> pjs::Ref<Entry>;
+    auto gzipped() -> pjs::Ref<Entry>;
+
+  private:
+    Entry(const std::string &path, uint64_t inode, int64_t mtime, size_t size);
+    ~Entry();
+
+    std::string m_path;
+    std::string m_etag;
+    std::string m_last_modified;
+    const char* m_ptr = nullptr;
+    size_t m_size;
+    uint64_t m_inode;
+    int64_t m_mtime;
+    Entry* m_gzip = nullptr;
+    std::mutex m_gzip_mutex;
+    std::list<Entry*>::iterator m_lru;
+
+    bool load();
+
+    friend class pjs::RefCountMT<Entry>;
+    friend class FileCache;
+  };
+
+  static void reserve(size_t capacity);
+  static auto find(const std::string &path, bool &missing) -> pjs::Ref<Entry>;
+  static auto get(const std::string &path) -> pjs::Ref<Entry>;
+  static auto capacity() -> size_t { return s_capacity.load(std::memory_order_relaxed); }
+  static auto size() -> size_t { return s_size.load(std::memory_order_relaxed); }
+  static auto http_date(int64_t t) -> std::string;
+
+private:
+  static std::atomic<size_t> s_capacity;
+  static std::atomic<size_t> s_size;
+
+  static auto lookup(const std::string &path, uint64_t inode, int64_t mtime, size_t size) -> pjs::Ref<Entry>;
+  static void forget(const std::string &path);
+  static void evict(Entry *entry);
+};
+
+} // namespace pipy
+
+#endif // FILE_CACHE_HPP
@@ -0,0 +1,201 @@
+/*
+ *  Copyright (c) 2019 by flomesh.io
+ *
+ *  Unless prior written consent has been obtained from the copyright
+ *  owner, the following shall not be allowed.
+ *
+ *  1. The distribution of any source codes, header files, make files,
+ *     or libraries of the software.
+ *
+ *  2. Disclosure of any source codes pertaining to the software to any
+ *     additional parties.
+ *
+ *  3. Alteration or removal of any notices in or on the software or
+ *     within the documentation included within the software.
+ *
+ *  ALL SOURCE CODE AS WELL AS ALL DOCUMENTATION INCLUDED WITH THIS
+ *  SOFTWARE IS PROVIDED IN AN “AS IS” CONDITION, WITHOUT WARRANTY OF ANY
+ *  KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ *  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ *  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "file-io.hpp"
+#include "file-cache.hpp"
+#include "data.hpp"
+#include "thread-pool.hpp"
+#include "api/stats.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace pipy {
+
+//
+// FileIO
+//
+
+static ThreadPool *s_pool = new ThreadPool(2, 8, 2);
+
+static const size_t MAX_READ_BLOCK = 0x40000000;
+static const size_t MIN_READ_BLOCK = 0x10000;
+
+thread_local static pjs::Ref<stats::Histogram> s_metric_latency;
+
+void FileIO::init_metrics() {
+  pjs::Ref<pjs::Array> label_names = pjs::Array::make(1);
+  label_names->set(0, "op");
+
+  pjs::Ref<pjs::Array> buckets = pjs::Array::make(21);
+  double limit = 0.05;
+  for (int i = 0; i < 20; i++) {
+    buckets->set(i, limit);
+    limit *= 2;
+  }
+  buckets->set(20, std::numeric_limits<double>::infinity());
+
+  s_metric_latency = stats::Histogram::make(
+    pjs::Str::make("pipy_file_io_latency"),
+    buckets, label_names
+  );
+}
+
+static void observe_latency(FileIO::Op op, double ms) {
+  thread_local static pjs::ConstStr s_read("read");
+  thread_local static pjs::ConstStr s_write("write");
+
+  if (!s_metric_latency) return;
+
+  pjs::Str *label = (op == FileIO::Op::read ? s_read : s_write);
+  s_metric_latency->with_labels(&label, 1)->observe(ms);
+  s_metric_latency->observe(ms);
+}
+
+void FileIO::submit(Op op, const Work &work, const Done &done) {
+  auto time = std::chrono::steady_clock::now();
+  s_pool->submit(
+    work,
+    [=]() {
+      auto t = std::chrono::steady_clock::now() - time;
+      observe_latency(op, std::chrono::duration<double, std::milli>(t).count());
+      done();
+    }
+  );
+}
+
+auto FileIO::queued() -> int {
+  return s_pool->queued();
+}
+
+auto FileIO::running() -> int {
+  return s_pool->running();
+}
+
+void FileIO::read_file(
+  const std::string &path, bool cache,
+  const std::function<void(Data*)> &cb
+) {
+  struct Result {
+    pjs::Ref<FileCache::Entry> entry;
+    std::vector<std::pair<char*, size_t>> blocks;
+    bool ok = false;
+
+    ~Result() {
+      for (const auto &b : blocks) std::free(b.first);
+    }
+  };
+
+  auto result = std::make_shared<Result>();
+
+  submit(
+    Op::read,
+    [=]() {
+      if (cache) {
+        if (auto e = FileCache::get(path)) {
+          result->entry = e;
+          result->ok = true;
+          return;
+        }
+      }
+
+      std::ifstream fs(path, std::ios::in|std::ios::binary);
+      if (!fs.is_open()) return;
+      fs.seekg(0, std::ios::end);
+      std::streamoff size = fs.tellg();
+      fs.seekg(0, std::ios::beg);
+      fs.clear();
+
+      size_t remaining = size > 0 ? size : 0;
+      for (;;) {
+        auto n = std::min(std::max(remaining + 1, MIN_READ_BLOCK), MAX_READ_BLOCK);
+        auto p = (char*)std::malloc(n);
+        if (!p) return;
+        fs.read(p, n);
+        size_t len = fs.gcount();
+        if (len > 0) {
+          result->blocks.push_back({ p, len });
+        } else {
+          std::free(p);
+        }
+        if (!fs.good()) break;
+        remaining = remaining > len ? remaining - len : 0;
+      }
+
+      result->ok = !fs.bad();
+    },
+    [=]() {
+      if (!result->ok) {
+        cb(nullptr);
+        return;
+      }
+      Data data;
+      if (auto e = result->entry.get()) {
+        e->to_data(data);
+      } else {
+        for (const auto &b : result->blocks) {
+          data.push_external(b.first, b.second, std::free, b.first);
+        }
+        result->blocks.clear();
+      }
+      cb(&data);
+    }
+  );
+}
+
+void FileIO::write_file(
+  const std::string &path, const Data &data,
+  const std::function<void(bool)> &cb
+) {
+  pjs::Ref<Data> buffer(Data::make(data));
+  auto chunks = std::make_shared<std::vector<std::pair<const char*, int>>>();
+  for (const auto c : buffer->chunks()) {
+    chunks->push_back({ std::get<0>(c), std::get<1>(c) });
+  }
+
+  auto ok = std::make_shared<bool>(false);
+
+  submit(
+    Op::write,
+    [=]() {
+      std::ofstream fs(path, std::ios::out|std::ios::binary|std::ios::trunc);
+      if (!fs.is_open()) return;
+      for (const auto &c : *chunks) fs.write(c.first, c.second);
+      fs.close();
+      *ok = !fs.fail();
+    },
+    [=]() {
+      buffer->clear();
+      cb(*ok);
+    }
+  );
+}
+
+} // namespace pipy
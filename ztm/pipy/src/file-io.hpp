@@ -0,0 +1,73 @@
+/*
+ *  Copyright (c) 2019 by flomesh.io
+ *
+ *  Unless prior written consent has been obtained from the copyright
+ *  owner, the following shall not be allowed.
+ *
+ *  1. The distribution of any source codes, header files, make files,
+ *     or libraries of the software.
+ *
+ *  2. Disclosure of any source codes pertaining to the software to any
+ *     additional parties.
+ *
+ *  3. Alteration or removal of any notices in or on the software or
+ *     within the documentation included within the software.
+ *
+ *  ALL SOURCE CODE AS WELL AS ALL DOCUMENTATION INCLUDED WITH THIS
+ *  SOFTWARE IS PROVIDED IN AN “AS IS” CONDITION, WITHOUT WARRANTY OF ANY
+ *  KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ *  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ *  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FILE_IO_HPP
+#define FILE_IO_HPP
+
+#include <functional>
+#include <string>
+
+namespace pipy {
+
+class Data;
+
+//
+// FileIO
+//
+// Runs blocking file operations on a ThreadPool shared by all
+// workers. Work runs on one of the pool threads and its completion
+// is posted back to the submitting thread.
+//
+
+class FileIO {
+public:
+  enum class Op {
+    read,
+    write,
+  };
+
+  typedef std::function<void()> Work;
+  typedef std::function<void()> Done;
+
+  static void init_metrics();
+  static void submit(Op op, const Work &work, const Done &done);
+
+  static void read_file(
+    const std::string &path, bool cache,
+    const std::function<void(Data*)> &cb
+  );
+
+  static void write_file(
+    const std::string &path, const Data &data,
+    const std::function<void(bool)> &cb
+  );
+
+  static auto queued() -> int;
+  static auto running() -> int;
+};
+
+} // namespace pipy
+
+#endif // FILE_IO_HPP
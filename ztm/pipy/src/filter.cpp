@@ -30,19 +30,50 @@
 #include "message.hpp"
 #include "log.hpp"
 
+#include <chrono>
 #include <cstdarg>
+#include <cstddef>
 
 namespace pipy {
 
+std::atomic<bool> Filter::s_profiling(false);
+
+//
+// Filter::Arena
+//
+
+auto Filter::Arena::alloc(size_t size) -> void* {
+  auto a = alignof(std::max_align_t);
+  auto n = (size + a - 1) / a * a;
+  m_size += n;
+  if (m_ptr && m_ptr + n <= m_block + m_capacity) {
+    auto p = m_ptr;
+    m_ptr += n;
+    return p;
+  }
+  return ::operator new(size);
+}
+
+bool Filter::Arena::contains(const void *p) const {
+  auto c = (const char *)p;
+  return m_block && m_block <= c && c < m_block + m_capacity;
+}
+
+//
+// Filter
+//
+
 Filter::Filter()
   : m_subs(std::make_shared<std::vector<Sub>>())
   , m_buffer_stats(std::make_shared<BufferStats>())
+  , m_profile(std::make_shared<Profile>())
 {
 }
 
 Filter::Filter(const Filter &r)
   : m_subs(r.m_subs)
   , m_buffer_stats(r.m_buffer_stats)
+  , m_profile(r.m_profile)
   , m_location(r.m_location)
 {
 }
@@ -202,7 +233,40 @@ auto Filter::sub_pipeline(
 
 void Filter::on_event(Event *evt) {
   Pipeline::auto_release(m_pipeline);
+  if (profiling()) {
+    process_profiled(evt);
+  } else {
+    process(evt);
+  }
+}
+
+//
+// Time spent in the filters downstream is accumulated while
+// process() is running, so that it can be subtracted to get
+// the self time of the current filter
+//
+
+void Filter::process_profiled(Event *evt) {
+  thread_local static uint64_t s_inner_time = 0;
+
+  auto &p = *m_profile;
+  p.events++;
+  if (auto data = evt->as<Data>()) {
+    p.bytes += data->size();
+  }
+
+  auto outer_time = s_inner_time;
+  s_inner_time = 0;
+
+  auto t0 = std::chrono::steady_clock::now();
   process(evt);
+  auto t = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now() - t0
+  ).count();
+
+  p.time += t;
+  p.self_time += t > s_inner_time ? t - s_inner_time : 0;
+  s_inner_time = outer_time + t;
 }
 
 void Filter::output(Message *msg) {
@@ -222,6 +286,7 @@ bool Filter::output(pjs::Object *obj, EventTarget::Input *input) {
 }
 
 bool Filter::callback(pjs::Function *func, int argc, pjs::Value argv[], pjs::Value &result) {
+  if (profiling()) m_profile->callbacks++;
   auto c = context();
   (*func)(*c, argc, argv, result);
   if (c->ok()) return true;
@@ -233,6 +298,7 @@ bool Filter::callback(pjs::Function *func, int argc, pjs::Value argv[], pjs::Val
 
 bool Filter::eval(pjs::Value &param, pjs::Value &result) {
   if (param.is_function()) {
+    if (profiling()) m_profile->callbacks++;
     auto c = context();
     auto f = param.as<pjs::Function>();
     (*f)(*c, 0, nullptr, result);
@@ -249,6 +315,7 @@ bool Filter::eval(pjs::Value &param, pjs::Value &result) {
 
 bool Filter::eval(pjs::Function *func, pjs::Value &result) {
   if (!func) return true;
+  if (profiling()) m_profile->callbacks++;
   auto c = context();
   (*func)(*c, 0, nullptr, result);
   if (c->ok()) return true;
@@ -31,6 +31,7 @@
 #include "list.hpp"
 #include "pipeline.hpp"
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <vector>
@@ -81,12 +82,63 @@ public:
     OutType out_type = OUTPUT_FROM_SELF;
   };
 
+  //
+  // Filter::Arena
+  //
+  // A block of memory that the filters of one pipeline are cloned
+  // into, handed to clone() by the pipeline. Allocations that don't
+  // fit go to the heap. Sizes asked for are added up either way, so an
+  // arena without a block works out how big one needs to be.
+  //
+
+  class Arena {
+  public:
+    Arena(char *block = nullptr, size_t capacity = 0)
+      : m_block(block)
+      , m_ptr(block)
+      , m_capacity(capacity) {}
+
+    auto block() const -> char* { return m_block; }
+    auto capacity() const -> size_t { return m_capacity; }
+    auto size() const -> size_t { return m_size; }
+    auto alloc(size_t size) -> void*;
+    bool contains(const void *p) const;
+
+  private:
+    char* m_block;
+    char* m_ptr;
+    size_t m_capacity;
+    size_t m_size = 0;
+  };
+
+  //
+  // Filter::Profile
+  //
+
+  struct Profile {
+    uint64_t events = 0;
+    uint64_t bytes = 0;
+    uint64_t callbacks = 0;
+    uint64_t time = 0; // nanoseconds spent in process() including the downstream
+    uint64_t self_time = 0; // nanoseconds spent in process() excluding the downstream
+    void clear() { *this = Profile(); }
+  };
+
+  static bool profiling() { return s_profiling.load(std::memory_order_relaxed); }
+  static void profiling(bool enabled) { s_profiling.store(enabled, std::memory_order_relaxed); }
+
   virtual ~Filter() {}
 
+  static void* operator new(size_t size) { return ::operator new(size); }
+  static void* operator new(size_t size, Arena *arena) { return arena->alloc(size); }
+  static void operator delete(void *p) { ::operator delete(p); }
+  static void operator delete(void *p, Arena *arena) { if (!arena->contains(p)) ::operator delete(p); }
+
   auto module_legacy() const -> ModuleBase*;
   auto context() const -> Context*;
   auto location() const -> const pjs::Location& { return m_location; }
   auto buffer_stats() const -> std::shared_ptr<BufferStats> { return m_buffer_stats; }
+  auto profile() const -> Profile& { return *m_profile; }
 
   void set_location(const pjs::Location &loc);
   void add_sub_pipeline(PipelineLayout *layout);
@@ -108,7 +160,7 @@ public:
   ) -> Pipeline*;
 
   virtual void bind();
-  virtual auto clone() -> Filter* = 0;
+  virtual auto clone(Arena *arena) -> Filter* = 0;
   virtual void chain();
   virtual void reset();
   virtual void process(Event *evt) = 0;
@@ -144,12 +196,16 @@ private:
 
   std::shared_ptr<std::vector<Sub>> m_subs;
   std::shared_ptr<BufferStats> m_buffer_stats;
+  std::shared_ptr<Profile> m_profile;
 
   PipelineLayout* m_pipeline_layout = nullptr;
   Pipeline* m_pipeline = nullptr;
   pjs::Location m_location;
 
+  static std::atomic<bool> s_profiling;
+
   virtual void on_event(Event *evt) override;
+  void process_profiled(Event *evt);
 
   friend class Pipeline;
   friend class PipelineLayout;
@@ -67,8 +67,8 @@ void Decoder::dump(Dump &d) {
   d.name = "decodeBGP";
 }
 
-auto Decoder::clone() -> Filter* {
-  return new Decoder(*this);
+auto Decoder::clone(Arena *arena) -> Filter* {
+  return new (arena) Decoder(*this);
 }
 
 void Decoder::reset() {
@@ -135,8 +135,8 @@ void Encoder::dump(Dump &d) {
   d.name = "encodeBGP";
 }
 
-auto Encoder::clone() -> Filter* {
-  return new Encoder(*this);
+auto Encoder::clone(Arena *arena) -> Filter* {
+  return new (arena) Encoder(*this);
 }
 
 void Encoder::reset() {
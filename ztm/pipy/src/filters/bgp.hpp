@@ -57,7 +57,7 @@ private:
   Decoder(const Decoder &r);
   ~Decoder();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void reset() override;
   virtual void process(Event *evt) override;
   virtual void dump(Dump &d) override;
@@ -83,7 +83,7 @@ private:
   Encoder(const Encoder &r);
   ~Encoder();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void reset() override;
   virtual void process(Event *evt) override;
   virtual void dump(Dump &d) override;
@@ -112,8 +112,8 @@ void Branch::dump(Dump &d) {
   d.name = "branch";
 }
 
-auto Branch::clone() -> Filter* {
-  return new Branch(*this);
+auto Branch::clone(Arena *arena) -> Filter* {
+  return new (arena) Branch(*this);
 }
 
 bool Branch::choose(Event *evt) {
@@ -129,8 +129,8 @@ void BranchMessageStart::dump(Dump &d) {
   d.name = "branchMessageStart";
 }
 
-auto BranchMessageStart::clone() -> Filter* {
-  return new BranchMessageStart(*this);
+auto BranchMessageStart::clone(Arena *arena) -> Filter* {
+  return new (arena) BranchMessageStart(*this);
 }
 
 bool BranchMessageStart::choose(Event *evt) {
@@ -151,8 +151,8 @@ void BranchMessage::dump(Dump &d) {
   d.name = "branchMessage";
 }
 
-auto BranchMessage::clone() -> Filter* {
-  return new BranchMessage(*this);
+auto BranchMessage::clone(Arena *arena) -> Filter* {
+  return new (arena) BranchMessage(*this);
 }
 
 void BranchMessage::reset() {
@@ -73,7 +73,7 @@ public:
   using BranchBase::BranchBase;
 
 protected:
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void dump(Dump &d) override;
   virtual bool choose(Event *evt) override;
 };
@@ -87,7 +87,7 @@ public:
   using BranchBase::BranchBase;
 
 protected:
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void dump(Dump &d) override;
   virtual bool choose(Event *evt) override;
 };
@@ -101,7 +101,7 @@ public:
   using BranchBase::BranchBase;
 
 protected:
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void reset() override;
   virtual void dump(Dump &d) override;
   virtual bool choose(Event *evt) override;
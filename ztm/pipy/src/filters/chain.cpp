@@ -84,8 +84,8 @@ void Chain::bind() {
   }
 }
 
-auto Chain::clone() -> Filter* {
-  return new Chain(*this);
+auto Chain::clone(Arena *arena) -> Filter* {
+  return new (arena) Chain(*this);
 }
 
 void Chain::reset() {
@@ -130,8 +130,8 @@ void ChainNext::dump(Dump &d) {
   d.name = "chain";
 }
 
-auto ChainNext::clone() -> Filter* {
-  return new ChainNext(*this);
+auto ChainNext::clone(Arena *arena) -> Filter* {
+  return new (arena) ChainNext(*this);
 }
 
 void ChainNext::reset() {
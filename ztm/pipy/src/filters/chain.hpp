@@ -48,7 +48,7 @@ private:
   ~Chain();
 
   virtual void bind() override;
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void reset() override;
   virtual void process(Event *evt) override;
   virtual void dump(Dump &d) override;
@@ -70,7 +70,7 @@ private:
   ChainNext(const Chain &r);
   ~ChainNext();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void reset() override;
   virtual void process(Event *evt) override;
   virtual void dump(Dump &d) override;
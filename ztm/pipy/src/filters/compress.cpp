@@ -24,7 +24,6 @@
  */
 
 #include "compress.hpp"
-#include "compressor.hpp"
 #include "data.hpp"
 #include "api/http.hpp"
 
@@ -34,27 +33,77 @@ thread_local static const pjs::ConstStr s_headers("headers");
 thread_local static const pjs::ConstStr s_content_encoding("content-encoding");
 thread_local static const pjs::ConstStr s_gzip("gzip");
 thread_local static const pjs::ConstStr s_deflate("deflate");
+thread_local static const pjs::ConstStr s_br("br");
+thread_local static const pjs::ConstStr s_brotli("brotli");
 thread_local static const pjs::ConstStr s_inflate("inflate");
 
 static Data::Producer s_dp("compressMessage()");
 
+static bool get_algorithm(pjs::Str *name, CompressorPool::Algorithm &algorithm) {
+  if (name == s_deflate) {
+    algorithm = CompressorPool::Algorithm::deflate;
+  } else if (name == s_gzip) {
+    algorithm = CompressorPool::Algorithm::gzip;
+  } else if (name == s_br || name == s_brotli) {
+    algorithm = CompressorPool::Algorithm::brotli;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+static auto make_compressor(
+  CompressorPool::Algorithm algorithm,
+  const CompressOptions &options,
+  const Compressor::Output &out
+) -> Compressor* {
+  switch (algorithm) {
+    case CompressorPool::Algorithm::deflate: return Compressor::deflate(out, options.level);
+    case CompressorPool::Algorithm::gzip: return Compressor::gzip(out, options.level);
+    case CompressorPool::Algorithm::brotli: return Compressor::brotli(out, options.level, options.window);
+  }
+  return nullptr;
+}
+
+//
+// CompressOptions
+//
+
+CompressOptions::CompressOptions(pjs::Object *options) {
+  Value(options, "level")
+    .get(level)
+    .check_nullable();
+  Value(options, "window")
+    .get(window)
+    .check_nullable();
+  Value(options, "offload")
+    .get(offload)
+    .check_nullable();
+  Value(options, "offloadThreshold")
+    .get_binary_size(offload_threshold)
+    .check_nullable();
+}
+
 //
 // Compress
 //
 
-Compress::Compress(const pjs::Value &algorithm)
+Compress::Compress(const pjs::Value &algorithm, const CompressOptions &options)
   : m_algorithm(algorithm)
+  , m_options(options)
 {
 }
 
 Compress::Compress(const Compress &r)
   : Filter(r)
   , m_algorithm(r.m_algorithm)
+  , m_options(r.m_options)
 {
 }
 
 Compress::~Compress()
 {
+  if (m_offload_job) m_offload_job->cancel();
 }
 
 void Compress::dump(Dump &d) {
@@ -62,8 +111,8 @@ void Compress::dump(Dump &d) {
   d.name = "compress";
 }
 
-auto Compress::clone() -> Filter* {
-  return new Compress(*this);
+auto Compress::clone(Arena *arena) -> Filter* {
+  return new (arena) Compress(*this);
 }
 
 void Compress::reset() {
@@ -72,10 +121,22 @@ void Compress::reset() {
     m_compressor->finalize();
     m_compressor = nullptr;
   }
+  if (m_offload_job) {
+    m_offload_job->cancel();
+    m_offload_job = nullptr;
+  }
+  m_offload_stream = nullptr;
+  m_offload_buffer.clear();
+  m_offload_pending.clear();
   m_is_started = false;
 }
 
 void Compress::process(Event *evt) {
+  if (m_offload_job) {
+    m_offload_pending.push(evt);
+    return;
+  }
+
   if (!m_is_started) {
     m_is_started = true;
     pjs::Value algorithm;
@@ -84,16 +145,22 @@ void Compress::process(Event *evt) {
       Filter::error("algorithm is not or did not return a string");
       return;
     }
-    auto out = [this](Data &data) { compressor_output(data); };
     auto str = algorithm.s();
-    if (str == s_deflate) {
-      m_compressor = Compressor::deflate(out);
-    } else if (str == s_gzip) {
-      m_compressor = Compressor::gzip(out);
-    } else {
+    if (!get_algorithm(str, m_method)) {
       Filter::error("unknown compression algorithm: %s", str->c_str());
       return;
     }
+    if (m_options.offload) {
+      m_offload_stream = CompressorPool::Stream::make(m_method, m_options.level, m_options.window);
+    } else {
+      auto out = [this](Data &data) { compressor_output(data); };
+      m_compressor = make_compressor(m_method, m_options, out);
+    }
+  }
+
+  if (m_offload_stream) {
+    offload(evt);
+    return;
   }
 
   if (m_compressor) {
@@ -111,6 +178,76 @@ void Compress::process(Event *evt) {
   }
 }
 
+//
+// Data is collected until there is at least offloadThreshold of it,
+// which is then compressed on the pool while later events wait in
+// m_offload_pending. Smaller leftovers before any other event are
+// compressed in place, so events keep their order in the output.
+//
+
+void Compress::offload(Event *evt) {
+  if (auto data = evt->as<Data>()) {
+    m_offload_buffer.push(*data);
+    if (m_offload_buffer.size() < m_options.offload_threshold) return;
+    pjs::Ref<Event> e;
+    m_offload_job = CompressorPool::submit(
+      m_offload_stream, m_offload_buffer, false,
+      [=](Data *data) { offload_done(data, e); }
+    );
+    m_offload_buffer.clear();
+    return;
+  }
+
+  auto end = evt->as<StreamEnd>();
+  if (end && m_offload_buffer.size() >= m_options.offload_threshold) {
+    pjs::Ref<Event> e(evt);
+    m_offload_job = CompressorPool::submit(
+      m_offload_stream, m_offload_buffer, true,
+      [=](Data *data) { offload_done(data, e); }
+    );
+    m_offload_buffer.clear();
+    return;
+  }
+
+  if (!end && m_offload_buffer.empty()) {
+    Filter::output(evt);
+    return;
+  }
+
+  Data output;
+  auto ok = m_offload_stream->compress(m_offload_buffer, end != nullptr, output);
+  m_offload_buffer.clear();
+  offload_done(ok ? &output : nullptr, evt);
+}
+
+void Compress::offload_done(Data *data, Event *evt) {
+  m_offload_job = nullptr;
+
+  if (!data) {
+    m_offload_stream = nullptr;
+    m_offload_pending.clear();
+    Filter::output(StreamEnd::make(StreamEnd::RUNTIME_ERROR));
+    return;
+  }
+
+  if (!data->empty()) compressor_output(*data);
+  if (evt) {
+    if (evt->is<StreamEnd>()) m_offload_stream = nullptr;
+    Filter::output(evt);
+  }
+
+  EventBuffer pending(std::move(m_offload_pending));
+  while (auto evt = pending.shift()) {
+    pjs::Ref<Event> ref(evt);
+    evt->release();
+    if (m_offload_job) {
+      m_offload_pending.push(evt);
+    } else {
+      process(evt);
+    }
+  }
+}
+
 void Compress::compressor_output(Data &data) {
   Filter::output(Data::make(std::move(data)));
 }
@@ -120,19 +257,22 @@ void Compress::compressor_output(Data &data) {
 //
 
 
-CompressHTTP::CompressHTTP(const pjs::Value &algorithm)
+CompressHTTP::CompressHTTP(const pjs::Value &algorithm, const CompressOptions &options)
   : m_algorithm(algorithm)
+  , m_options(options)
 {
 }
 
 CompressHTTP::CompressHTTP(const CompressHTTP &r)
   : Filter(r)
   , m_algorithm(r.m_algorithm)
+  , m_options(r.m_options)
 {
 }
 
 CompressHTTP::~CompressHTTP()
 {
+  if (m_offload_job) m_offload_job->cancel();
 }
 
 void CompressHTTP::dump(Dump &d) {
@@ -140,8 +280,8 @@ void CompressHTTP::dump(Dump &d) {
   d.name = "compressHTTP";
 }
 
-auto CompressHTTP::clone() -> Filter* {
-  return new CompressHTTP(*this);
+auto CompressHTTP::clone(Arena *arena) -> Filter* {
+  return new (arena) CompressHTTP(*this);
 }
 
 void CompressHTTP::reset() {
@@ -150,10 +290,22 @@ void CompressHTTP::reset() {
     m_compressor->finalize();
     m_compressor = nullptr;
   }
+  if (m_offload_job) {
+    m_offload_job->cancel();
+    m_offload_job = nullptr;
+  }
+  m_offload_buffer.clear();
+  m_offload_pending.clear();
   m_is_message_started = false;
+  m_is_offloading = false;
 }
 
 void CompressHTTP::process(Event *evt) {
+  if (m_offload_job) {
+    m_offload_pending.push(evt);
+    return;
+  }
+
   if (auto ms = evt->as<MessageStart>()) {
     if (!m_is_message_started) {
       pjs::Ref<pjs::Str> algorithm;
@@ -179,20 +331,23 @@ void CompressHTTP::process(Event *evt) {
       if (auto headers = head->headers.get()) {
         has_content_encoding = headers->has(s_content_encoding);
       }
-      if (!has_content_encoding) {
+      if (!has_content_encoding && algorithm && get_algorithm(algorithm, m_method)) {
         auto headers = head->headers.get();
         if (!headers) {
           headers = pjs::Object::make();
           if (!ms->head()) ms = MessageStart::make(pjs::Object::make());
           ms->head()->set(s_headers, headers);
         }
-        auto out = [this](Data &data) { compressor_output(data); };
-        if (algorithm == s_gzip) {
-          m_compressor = Compressor::gzip(out);
-          headers->set(s_content_encoding, s_gzip.get());
-        } else if (algorithm == s_deflate) {
-          m_compressor = Compressor::deflate(out);
-          headers->set(s_content_encoding, s_deflate.get());
+        switch (m_method) {
+          case CompressorPool::Algorithm::deflate: headers->set(s_content_encoding, s_deflate.get()); break;
+          case CompressorPool::Algorithm::gzip: headers->set(s_content_encoding, s_gzip.get()); break;
+          case CompressorPool::Algorithm::brotli: headers->set(s_content_encoding, s_br.get()); break;
+        }
+        if (m_options.offload) {
+          m_is_offloading = true;
+        } else {
+          auto out = [this](Data &data) { compressor_output(data); };
+          m_compressor = make_compressor(m_method, m_options, out);
         }
       }
       m_is_message_started = true;
@@ -201,7 +356,9 @@ void CompressHTTP::process(Event *evt) {
 
   } else if (auto data = evt->as<Data>()) {
     if (m_is_message_started) {
-      if (m_compressor) {
+      if (m_is_offloading) {
+        m_offload_buffer.push(*data);
+      } else if (m_compressor) {
         m_compressor->input(*data, false);
       } else {
         Filter::output(data);
@@ -210,17 +367,59 @@ void CompressHTTP::process(Event *evt) {
 
   } else if (evt->is_end()) {
     if (m_is_message_started) {
+      m_is_message_started = false;
+      if (m_is_offloading) {
+        offload(evt);
+        return;
+      }
       if (m_compressor) {
         m_compressor->flush();
         m_compressor->finalize();
         m_compressor = nullptr;
       }
-      m_is_message_started = false;
       Filter::output(evt);
     }
   }
 }
 
+void CompressHTTP::offload(Event *end) {
+  m_is_offloading = false;
+  if (m_offload_buffer.size() < m_options.offload_threshold) {
+    auto out = [this](Data &data) { compressor_output(data); };
+    auto compressor = make_compressor(m_method, m_options, out);
+    compressor->input(m_offload_buffer, false);
+    compressor->flush();
+    compressor->finalize();
+    m_offload_buffer.clear();
+    Filter::output(end);
+  } else {
+    pjs::Ref<Event> e(end);
+    m_offload_job = CompressorPool::submit(
+      m_method, m_options.level, m_options.window, m_offload_buffer,
+      [=](Data *data) {
+        m_offload_job = nullptr;
+        if (data) {
+          compressor_output(*data);
+          Filter::output(e);
+        } else {
+          Filter::output(StreamEnd::make(StreamEnd::RUNTIME_ERROR));
+        }
+        EventBuffer pending(std::move(m_offload_pending));
+        while (auto evt = pending.shift()) {
+          pjs::Ref<Event> ref(evt);
+          evt->release();
+          if (m_offload_job) {
+            m_offload_pending.push(evt);
+          } else {
+            process(evt);
+          }
+        }
+      }
+    );
+    m_offload_buffer.clear();
+  }
+}
+
 void CompressHTTP::compressor_output(Data &data) {
   Filter::output(Data::make(std::move(data)));
 }
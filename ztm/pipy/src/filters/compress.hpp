@@ -27,11 +27,25 @@
 #define COMPRESS_HPP
 
 #include "filter.hpp"
+#include "compressor.hpp"
+#include "buffer.hpp"
+#include "options.hpp"
 
 namespace pipy {
 
-class Compressor;
-class Data;
+//
+// CompressOptions
+//
+
+struct CompressOptions : public Options {
+  int level = -1;
+  int window = -1;
+  bool offload = false;
+  int offload_threshold = 0x10000;
+
+  CompressOptions() {}
+  CompressOptions(pjs::Object *options);
+};
 
 //
 // Compress
@@ -39,22 +53,30 @@ class Data;
 
 class Compress : public Filter {
 public:
-  Compress(const pjs::Value &algorithm);
+  Compress(const pjs::Value &algorithm, const CompressOptions &options);
 
 private:
   Compress(const Compress &r);
   ~Compress();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void reset() override;
   virtual void process(Event *evt) override;
   virtual void dump(Dump &d) override;
 
   pjs::Value m_algorithm;
+  CompressOptions m_options;
+  CompressorPool::Algorithm m_method;
   Compressor* m_compressor = nullptr;
+  pjs::Ref<CompressorPool::Stream> m_offload_stream;
+  CompressorPool::Job* m_offload_job = nullptr;
+  Data m_offload_buffer;
+  EventBuffer m_offload_pending;
   bool m_is_started = false;
 
   void compressor_output(Data &data);
+  void offload(Event *evt);
+  void offload_done(Data *data, Event *evt);
 };
 
 //
@@ -63,22 +85,29 @@ private:
 
 class CompressHTTP : public Filter {
 public:
-  CompressHTTP(const pjs::Value &algorithm);
+  CompressHTTP(const pjs::Value &algorithm, const CompressOptions &options);
 
 private:
   CompressHTTP(const CompressHTTP &r);
   ~CompressHTTP();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void reset() override;
   virtual void process(Event *evt) override;
   virtual void dump(Dump &d) override;
 
   pjs::Value m_algorithm;
+  CompressOptions m_options;
+  CompressorPool::Algorithm m_method;
   Compressor* m_compressor = nullptr;
+  CompressorPool::Job* m_offload_job = nullptr;
+  Data m_offload_buffer;
+  EventBuffer m_offload_pending;
   bool m_is_message_started = false;
+  bool m_is_offloading = false;
 
   void compressor_output(Data &data);
+  void offload(Event *end);
 };
 
 } // namespace pipy
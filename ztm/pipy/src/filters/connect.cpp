@@ -62,6 +62,12 @@ Connect::Options::Options(pjs::Object *options) {
   Value(options, "connectTimeout")
     .get_seconds(connect_timeout)
     .check_nullable();
+  Value(options, "connectAttemptDelay")
+    .get_seconds(connect_attempt_delay)
+    .check_nullable();
+  Value(options, "connectFailureMemory")
+    .get_seconds(connect_failure_memory)
+    .check_nullable();
   Value(options, "readTimeout")
     .get_seconds(read_timeout)
     .check_nullable();
@@ -111,8 +117,8 @@ void Connect::dump(Dump &d) {
   d.name = "connect";
 }
 
-auto Connect::clone() -> Filter* {
-  return new Connect(*this);
+auto Connect::clone(Arena *arena) -> Filter* {
+  return new (arena) Connect(*this);
 }
 
 void Connect::reset() {
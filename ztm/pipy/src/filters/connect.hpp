@@ -54,7 +54,7 @@ private:
   Connect(const Connect &r);
   ~Connect();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void reset() override;
   virtual void process(Event *evt) override;
   virtual void dump(Dump &d) override;
@@ -61,8 +61,8 @@ void Decompress::dump(Dump &d) {
   d.name = "decompress";
 }
 
-auto Decompress::clone() -> Filter* {
-  return new Decompress(*this);
+auto Decompress::clone(Arena *arena) -> Filter* {
+  return new (arena) Decompress(*this);
 }
 
 void Decompress::reset() {
@@ -137,8 +137,8 @@ void DecompressHTTP::dump(Dump &d) {
   d.name = "decompressHTTP";
 }
 
-auto DecompressHTTP::clone() -> Filter* {
-  return new DecompressHTTP(*this);
+auto DecompressHTTP::clone(Arena *arena) -> Filter* {
+  return new (arena) DecompressHTTP(*this);
 }
 
 void DecompressHTTP::reset() {
@@ -45,7 +45,7 @@ private:
   Decompress(const Decompress &r);
   ~Decompress();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void reset() override;
   virtual void process(Event *evt) override;
   virtual void dump(Dump &d) override;
@@ -69,7 +69,7 @@ private:
   DecompressHTTP(const DecompressHTTP &r);
   ~DecompressHTTP();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void reset() override;
   virtual void process(Event *evt) override;
   virtual void dump(Dump &d) override;
@@ -58,8 +58,8 @@ void Deframe::dump(Dump &d) {
   d.name = "deframe";
 }
 
-auto Deframe::clone() -> Filter* {
-  return new Deframe(*this);
+auto Deframe::clone(Arena *arena) -> Filter* {
+  return new (arena) Deframe(*this);
 }
 
 void Deframe::reset() {
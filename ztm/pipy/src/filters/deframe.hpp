@@ -43,7 +43,7 @@ private:
   Deframe(const Deframe &r);
   ~Deframe();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void reset() override;
   virtual void process(Event *evt) override;
   virtual void dump(Dump &d) override;
@@ -370,8 +370,8 @@ void Demux::dump(Dump &d) {
   d.sub_type = Dump::DEMUX;
 }
 
-auto Demux::clone() -> Filter* {
-  return new Demux(*this);
+auto Demux::clone(Arena *arena) -> Filter* {
+  return new (arena) Demux(*this);
 }
 
 void Demux::chain() {
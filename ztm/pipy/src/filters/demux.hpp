@@ -211,7 +211,7 @@ private:
   Demux(const Demux &r);
   ~Demux();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void chain() override;
   virtual void reset() override;
   virtual void process(Event *evt) override;
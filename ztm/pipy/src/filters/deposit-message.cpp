@@ -79,8 +79,8 @@ void DepositMessage::dump(Dump &d) {
   d.name = "depositMessage";
 }
 
-auto DepositMessage::clone() -> Filter* {
-  return new DepositMessage(*this);
+auto DepositMessage::clone(Arena *arena) -> Filter* {
+  return new (arena) DepositMessage(*this);
 }
 
 void DepositMessage::reset() {
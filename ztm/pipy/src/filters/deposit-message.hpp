@@ -62,7 +62,7 @@ private:
   DepositMessage(const DepositMessage &r);
   ~DepositMessage();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void reset() override;
   virtual void process(Event *evt) override;
   virtual void dump(Dump &d) override;
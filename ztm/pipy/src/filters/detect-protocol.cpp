@@ -192,8 +192,8 @@ ProtocolDetector::~ProtocolDetector()
 {
 }
 
-auto ProtocolDetector::clone() -> Filter* {
-  return new ProtocolDetector(*this);
+auto ProtocolDetector::clone(Arena *arena) -> Filter* {
+  return new (arena) ProtocolDetector(*this);
 }
 
 void ProtocolDetector::reset() {
@@ -46,7 +46,7 @@ private:
   ProtocolDetector(const ProtocolDetector &r);
   ~ProtocolDetector();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void reset() override;
   virtual void process(Event *evt) override;
   virtual void dump(Dump &d) override;
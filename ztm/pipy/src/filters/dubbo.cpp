@@ -52,8 +52,8 @@ void Decoder::dump(Dump &d) {
   d.name = "decodeDubbo";
 }
 
-auto Decoder::clone() -> Filter* {
-  return new Decoder(*this);
+auto Decoder::clone(Arena *arena) -> Filter* {
+  return new (arena) Decoder(*this);
 }
 
 void Decoder::reset() {
@@ -143,8 +143,8 @@ void Encoder::dump(Dump &d) {
   d.name = "encodeDubbo";
 }
 
-auto Encoder::clone() -> Filter* {
-  return new Encoder(*this);
+auto Encoder::clone(Arena *arena) -> Filter* {
+  return new (arena) Encoder(*this);
 }
 
 void Encoder::reset() {
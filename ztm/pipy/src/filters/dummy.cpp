@@ -49,8 +49,8 @@ void Dummy::dump(Dump &d) {
   d.name = "dummy";
 }
 
-auto Dummy::clone() -> Filter* {
-  return new Dummy(*this);
+auto Dummy::clone(Arena *arena) -> Filter* {
+  return new (arena) Dummy(*this);
 }
 
 void Dummy::process(Event *evt) {
@@ -42,7 +42,7 @@ private:
   Dummy(const Dummy &r);
   ~Dummy();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void process(Event *evt) override;
   virtual void dump(Dump &d) override;
 };
@@ -61,8 +61,8 @@ void Dump::dump(Filter::Dump &d) {
   d.name = "dump";
 }
 
-auto Dump::clone() -> Filter* {
-  return new Dump(*this);
+auto Dump::clone(Arena *arena) -> Filter* {
+  return new (arena) Dump(*this);
 }
 
 void Dump::process(Event *evt) {
@@ -43,7 +43,7 @@ private:
   Dump(const Dump &r);
   ~Dump();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void process(Event *evt) override;
   virtual void dump(Filter::Dump &d) override;
 
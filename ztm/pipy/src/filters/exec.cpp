@@ -97,8 +97,8 @@ void Exec::dump(Dump &d) {
   d.name = "exec";
 }
 
-auto Exec::clone() -> Filter* {
-  return new Exec(*this);
+auto Exec::clone(Arena *arena) -> Filter* {
+  return new (arena) Exec(*this);
 }
 
 void Exec::reset() {
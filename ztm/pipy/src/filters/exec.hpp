@@ -59,7 +59,7 @@ private:
   Exec(const Exec &r);
   ~Exec();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void reset() override;
   virtual void process(Event *evt) override;
   virtual void dump(Dump &d) override;
@@ -156,10 +156,10 @@ private:
     };
 
     std::atomic<bool> m_exited;
-    std::thread m_thread;
     std::mutex m_mutex;
     std::condition_variable m_workload_cv;
     std::map<int, Monitor> m_monitors;
+    std::thread m_thread; // started last as it uses all of the above
   };
 
   static ChildProcessMonitor s_child_process_monitor;
@@ -204,7 +204,6 @@ void Endpoint::request_close(Request *request) {
 void Endpoint::process_event(Event *evt) {
   if (auto data = evt->as<Data>()) {
     Deframer::deframe(*data);
-  } else if (auto eos = evt->as<StreamEnd>()) {
   }
 }
 
@@ -662,8 +661,8 @@ void Demux::dump(Dump &d) {
   d.sub_type = Dump::DEMUX;
 }
 
-auto Demux::clone() -> Filter* {
-  return new Demux(*this);
+auto Demux::clone(Arena *arena) -> Filter* {
+  return new (arena) Demux(*this);
 }
 
 void Demux::reset() {
@@ -742,8 +741,8 @@ void Mux::dump(Dump &d) {
   d.sub_type = Dump::MUX;
 }
 
-auto Mux::clone() -> Filter* {
-  return new Mux(*this);
+auto Mux::clone(Arena *arena) -> Filter* {
+  return new (arena) Mux(*this);
 }
 
 auto Mux::on_mux_new_pool(pjs::Object *options) -> MuxSessionPool* {
@@ -261,7 +261,7 @@ protected:
   Demux(const Demux &r);
   ~Demux();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void reset() override;
   virtual void process(Event *evt) override;
   virtual void shutdown() override;
@@ -292,7 +292,7 @@ private:
   MuxSession::Options m_options;
 
   virtual void dump(Dump &d) override;
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual auto on_mux_new_pool(pjs::Object *options) -> MuxSessionPool* override;
 
   //
@@ -79,8 +79,8 @@ void Fork::dump(Dump &d) {
   }
 }
 
-auto Fork::clone() -> Filter* {
-  return new Fork(*this);
+auto Fork::clone(Arena *arena) -> Filter* {
+  return new (arena) Fork(*this);
 }
 
 void Fork::reset() {
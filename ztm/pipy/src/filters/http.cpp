@@ -33,7 +33,7 @@
 #include "str-map.hpp"
 #include "utils.hpp"
 
-#include <cctype>
+#include <cstring>
 #include <queue>
 #include <limits>
 
@@ -92,26 +92,6 @@ thread_local static const StrMap s_strmap_statuses({
   "OK", "Created", "Continue",
 });
 
-
-thread_local static const StrMap s_strmap_headers({
-  "host",
-  "user-agent",
-  "accept",
-  "connection",
-  "content-length",
-  "content-type",
-  "transfer-encoding",
-});
-
-thread_local static const StrMap s_strmap_header_values({
-  "*/*",
-  "text/html",
-  "application/json",
-  "chunked",
-  "close",
-  "keep-alive",
-});
-
 // HTTP status code as in:
 // https://www.iana.org/assignments/http-status-codes/http-status-codes.txt
 
@@ -291,28 +271,6 @@ static auto read_str(Data::Reader &dr, char ending, const StrMap &strmap, char *
   }
 }
 
-static auto read_str_lower(Data::Reader &dr, char ending, const StrMap &strmap, char *buf, char *buf_lower) -> pjs::Str* {
-  size_t i = 0;
-  StrMap::Parser p(strmap);
-  pjs::Str *found = nullptr;
-  for (;;) {
-    auto c = dr.get();
-    if (c < 0) return nullptr;
-    if (c == ending) {
-      if (found && found != pjs::Str::empty) {
-        return found;
-      } else {
-        return i > 0 ? pjs::Str::make(buf_lower, i) : nullptr;
-      }
-    }
-    if (c == ' ' && !i) continue;
-    auto l = std::tolower(c);
-    found = p.parse(l);
-    buf_lower[i] = l;
-    buf[i++] = c;
-  }
-}
-
 static auto read_uint(Data::Reader &dr, char ending) -> int {
   int n = 0;
   for (;;) {
@@ -511,8 +469,7 @@ void Decoder::on_event(Event *evt) {
             m_head = req;
           }
         }
-        m_head->headers = pjs::Object::make();
-        m_head->headerNames = pjs::Object::make();
+        m_head->headers.set_native(HeaderList::make());
         m_header_transfer_encoding = nullptr;
         m_header_content_length = nullptr;
         m_header_connection = nullptr;
@@ -523,41 +480,29 @@ void Decoder::on_event(Event *evt) {
       }
       case HEADER_EOL: {
         auto len = m_head_buffer.size();
-        pjs::vl_array<char, DATA_CHUNK_SIZE> buf(len);
-        pjs::vl_array<char, DATA_CHUNK_SIZE> buf_lower(len);
         m_head_size += len;
         if (len > 2) {
-          Data::Reader dr(m_head_buffer);
-          pjs::Ref<pjs::Str> key(read_str_lower(dr, ':', s_strmap_headers, buf, buf_lower));
-          pjs::Ref<pjs::Str> val(read_str(dr, '\r', s_strmap_header_values, buf_lower));
-          if (!key || !val) { error(); break; }
-          auto headers = m_head->headers.get();
-          if (key == s_cookie || key == s_set_cookie) {
-            pjs::Value old;
-            headers->get(key, old);
-            if (old.is_array()) {
-              old.as<pjs::Array>()->push(val.get());
-            } else if (old.is_string()) {
-              auto a = pjs::Array::make(2);
-              a->set(0, old.s());
-              a->set(1, val.get());
-              headers->set(key, a);
-            } else {
-              headers->set(key, val.get());
-            }
+          pjs::vl_array<char, DATA_CHUNK_SIZE> buf(len);
+          m_head_buffer.to_bytes((uint8_t *)buf.data());
+          auto end = buf.data() + len;
+          auto key = buf.data();
+          while (key < end && *key == ' ') key++;
+          auto key_end = (char *)std::memchr(key, ':', end - key);
+          if (!key_end || key_end == key) { error(); break; }
+          auto val = key_end + 1;
+          while (val < end && *val == ' ') val++;
+          auto val_end = (char *)std::memchr(val, '\r', end - val);
+          if (!val_end) { error(); break; }
+          auto key_len = key_end - key;
+          auto val_len = val_end - val;
+          auto known = HeaderList::lookup(key, key_len);
+          if (known == s_connection) {
+            m_header_connection = pjs::Str::make(val, val_len);
           } else {
-            auto v = val.get();
-            if (key == s_transfer_encoding) m_header_transfer_encoding = v;
-            else if (key == s_content_length) m_header_content_length = v;
-            else if (key == s_connection) { m_header_connection = v; v = nullptr; }
-            else if (key == s_upgrade) m_header_upgrade = v;
-            if (v) headers->set(key, v);
-          }
-          if (auto names = m_head->headerNames.get()) {
-            pjs::Ref<pjs::Str> name(pjs::Str::make(buf, key->size()));
-            if (name != key) {
-              names->set(key, name.get());
-            }
+            if (known == s_transfer_encoding) m_header_transfer_encoding = pjs::Str::make(val, val_len);
+            else if (known == s_content_length) m_header_content_length = pjs::Str::make(val, val_len);
+            else if (known == s_upgrade) m_header_upgrade = pjs::Str::make(val, val_len);
+            m_head->headers.native()->add(known, key, key_len, val, val_len);
           }
           state = HEADER;
           m_head_buffer.clear();
@@ -843,8 +788,28 @@ void Encoder::output_head() {
     db.push("\r\n");
   }
 
-  if (auto headers = m_head->headers.get()) {
-    auto names = m_head->headerNames.get();
+  if (auto list = m_head->headers.native()) {
+    list->iterate([&](const HeaderList::Field &f) {
+      auto k = f.known;
+      if (k == s_keep_alive) return;
+      if (k == s_transfer_encoding) return;
+      if (k == s_content_length) {
+        if (m_method == s_HEAD) {
+          no_content_length = true;
+        } else {
+          return;
+        }
+      } else if (k == s_upgrade) {
+        m_header_upgrade = pjs::Str::make(list->value(f), f.value_len);
+      }
+      db.push(list->name(f), f.name_len);
+      db.push(": ", 2);
+      db.push(list->value(f), f.value_len);
+      db.push("\r\n", 2);
+    });
+
+  } else if (auto headers = m_head->headers.get()) {
+    auto names = m_head->headers.names();
     headers->iterate_all(
       [&](pjs::Str *k, pjs::Value &v) {
         if (k == s_keep_alive) return;
@@ -1001,8 +966,8 @@ void RequestDecoder::dump(Dump &d) {
   d.name = "decodeHTTPRequest";
 }
 
-auto RequestDecoder::clone() -> Filter* {
-  return new RequestDecoder(*this);
+auto RequestDecoder::clone(Arena *arena) -> Filter* {
+  return new (arena) RequestDecoder(*this);
 }
 
 void RequestDecoder::chain() {
@@ -1067,8 +1032,8 @@ void ResponseDecoder::reset() {
   Decoder::reset();
 }
 
-auto ResponseDecoder::clone() -> Filter* {
-  return new ResponseDecoder(*this);
+auto ResponseDecoder::clone(Arena *arena) -> Filter* {
+  return new (arena) ResponseDecoder(*this);
 }
 
 void ResponseDecoder::process(Event *evt) {
@@ -1128,8 +1093,8 @@ void RequestEncoder::dump(Dump &d) {
   d.name = "encodeHTTPRequest";
 }
 
-auto RequestEncoder::clone() -> Filter* {
-  return new RequestEncoder(*this);
+auto RequestEncoder::clone(Arena *arena) -> Filter* {
+  return new (arena) RequestEncoder(*this);
 }
 
 void RequestEncoder::chain() {
@@ -1197,8 +1162,8 @@ void ResponseEncoder::dump(Dump &d) {
   d.name = "encodeHTTPResponse";
 }
 
-auto ResponseEncoder::clone() -> Filter* {
-  return new ResponseEncoder(*this);
+auto ResponseEncoder::clone(Arena *arena) -> Filter* {
+  return new (arena) ResponseEncoder(*this);
 }
 
 void ResponseEncoder::chain() {
@@ -1287,8 +1252,8 @@ void Demux::dump(Dump &d) {
   d.sub_type = Dump::DEMUX;
 }
 
-auto Demux::clone() -> Filter* {
-  return new Demux(*this);
+auto Demux::clone(Arena *arena) -> Filter* {
+  return new (arena) Demux(*this);
 }
 
 void Demux::chain() {
@@ -1484,8 +1449,8 @@ void Mux::dump(Dump &d) {
   d.sub_type = Dump::MUX;
 }
 
-auto Mux::clone() -> Filter* {
-  return new Mux(*this);
+auto Mux::clone(Arena *arena) -> Filter* {
+  return new (arena) Mux(*this);
 }
 
 auto Mux::on_mux_new_pool(pjs::Object *options) -> MuxSessionPool* {
@@ -1572,6 +1537,12 @@ void Mux::Session::mux_session_close() {
   }
 }
 
+bool Mux::Session::mux_session_ping() {
+  if (!m_http2) return false;
+  http2::Client::ping();
+  return true;
+}
+
 void Mux::Session::on_encode_request(RequestQueue::Request *req) {
   m_request_queue.push(req);
 }
@@ -1685,8 +1656,8 @@ void Server::dump(Dump &d) {
   d.name = "serveHTTP";
 }
 
-auto Server::clone() -> Filter* {
-  return new Server(*this);
+auto Server::clone(Arena *arena) -> Filter* {
+  return new (arena) Server(*this);
 }
 
 auto Server::on_demux_open_stream() -> EventFunction* {
@@ -1790,8 +1761,8 @@ void TunnelServer::dump(Dump &d) {
   d.name = "acceptHTTPTunnel";
 }
 
-auto TunnelServer::clone() -> Filter* {
-  return new TunnelServer(*this);
+auto TunnelServer::clone(Arena *arena) -> Filter* {
+  return new (arena) TunnelServer(*this);
 }
 
 void TunnelServer::reset() {
@@ -1855,8 +1826,8 @@ void TunnelClient::dump(Dump &d) {
   d.name = "connectHTTPTunnel";
 }
 
-auto TunnelClient::clone() -> Filter* {
-  return new TunnelClient(*this);
+auto TunnelClient::clone(Arena *arena) -> Filter* {
+  return new (arena) TunnelClient(*this);
 }
 
 void TunnelClient::reset() {
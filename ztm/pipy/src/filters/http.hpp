@@ -185,7 +185,7 @@ private:
   RequestDecoder(const RequestDecoder &r);
   ~RequestDecoder();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void chain() override;
   virtual void reset() override;
   virtual void process(Event *evt) override;
@@ -208,7 +208,7 @@ private:
   ResponseDecoder(const ResponseDecoder &r);
   ~ResponseDecoder();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void chain() override;
   virtual void reset() override;
   virtual void process(Event *evt) override;
@@ -237,7 +237,7 @@ private:
   RequestEncoder(const RequestEncoder &r);
   ~RequestEncoder();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void chain() override;
   virtual void reset() override;
   virtual void process(Event *evt) override;
@@ -267,7 +267,7 @@ private:
   ResponseEncoder(const ResponseEncoder &r);
   ~ResponseEncoder();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void chain() override;
   virtual void reset() override;
   virtual void process(Event *evt) override;
@@ -305,7 +305,7 @@ protected:
   Demux(const Demux &r);
   ~Demux();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void chain() override;
   virtual void reset() override;
   virtual void process(Event *evt) override;
@@ -392,6 +392,7 @@ public:
     virtual auto mux_session_open_stream(MuxSource *source) -> EventFunction* override;
     virtual void mux_session_close_stream(EventFunction *stream) override;
     virtual void mux_session_close() override;
+    virtual bool mux_session_ping() override;
 
     virtual void on_encode_request(RequestQueue::Request *req) override;
     virtual auto on_decode_response(ResponseHead *head) -> RequestQueue::Request* override;
@@ -419,7 +420,7 @@ private:
   Options m_options;
   EventBuffer m_waiting_events;
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void dump(Dump &d) override;
   virtual auto on_mux_new_pool(pjs::Object *options) -> MuxSessionPool* override;
 
@@ -480,7 +481,7 @@ private:
   Server(const Server &r);
   ~Server();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void dump(Dump &d) override;
 
   virtual auto on_demux_open_stream() -> EventFunction* override;
@@ -502,7 +503,7 @@ private:
   TunnelServer(const TunnelServer &r);
   ~TunnelServer();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void reset() override;
   virtual void process(Event *evt) override;
   virtual void dump(Dump &d) override;
@@ -524,7 +525,7 @@ private:
   TunnelClient(const TunnelClient &r);
   ~TunnelClient();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void reset() override;
   virtual void process(Event *evt) override;
   virtual void on_reply(Event *evt) override;
@@ -28,6 +28,8 @@
 #include "api/console.hpp"
 #include "log.hpp"
 
+#include <cstring>
+
 #define DEBUG_HTTP2 1
 
 #if DEBUG_HTTP2
@@ -53,6 +55,9 @@ namespace http2 {
 
 static Data::Producer s_dp("HTTP/2");
 
+static const uint8_t s_bdp_ping[8] = { 'p', 'i', 'p', 'y', '-', 'b', 'd', 'p' };
+static const uint8_t s_keep_alive_ping[8] = { 'p', 'i', 'p', 'y', '-', 'k', 'a', 'p' };
+
 //
 // HPACK static table
 //
@@ -1277,6 +1282,15 @@ Endpoint::Options::Options(pjs::Object *options) {
   Value(options, "streamWindowSize")
     .get_binary_size(stream_window_size)
     .check_nullable();
+  Value(options, "maxConnectionWindowSize")
+    .get_binary_size(connection_window_size_max)
+    .check_nullable();
+  Value(options, "maxStreamWindowSize")
+    .get_binary_size(stream_window_size_max)
+    .check_nullable();
+  Value(options, "streamQuantum")
+    .get_binary_size(stream_quantum)
+    .check_nullable();
 }
 
 Endpoint::Endpoint(bool is_server_side, const Options &options)
@@ -1287,9 +1301,11 @@ Endpoint::Endpoint(bool is_server_side, const Options &options)
 {
   init_metrics();
   m_settings.enable_push = false;
-  m_settings.initial_window_size = options.stream_window_size;
-  m_recv_window_max = options.connection_window_size;
+  m_settings.initial_window_size = std::min(options.stream_window_size, size_t(MAX_WINDOW_SIZE));
+  m_recv_window_max = std::min(options.connection_window_size, size_t(MAX_WINDOW_SIZE));
   m_recv_window_low = m_recv_window_max / 2;
+  m_recv_window_ceiling = std::min(std::max(options.connection_window_size_max, options.connection_window_size), size_t(MAX_WINDOW_SIZE));
+  m_stream_window_ceiling = std::min(std::max(options.stream_window_size_max, options.stream_window_size), size_t(MAX_WINDOW_SIZE));
 }
 
 Endpoint::~Endpoint() {
@@ -1307,6 +1323,12 @@ void Endpoint::reset() {
   m_last_received_stream_id = 0;
   m_send_window = INITIAL_SEND_WINDOW_SIZE;
   m_recv_window = INITIAL_RECV_WINDOW_SIZE;
+  m_settings.initial_window_size = std::min(m_options.stream_window_size, size_t(MAX_WINDOW_SIZE));
+  m_recv_window_max = std::min(m_options.connection_window_size, size_t(MAX_WINDOW_SIZE));
+  m_recv_window_low = m_recv_window_max / 2;
+  m_bdp_sample = 0;
+  m_bdp_bandwidth_max = 0;
+  m_bdp_ping_sent = false;
   m_has_sent_preface = false;
   m_has_shutdown = false;
   m_has_gone_away = false;
@@ -1370,6 +1392,16 @@ void Endpoint::connection_error(ErrorCode err) {
   on_endpoint_close(eos);
 }
 
+void Endpoint::ping() {
+  Frame frm;
+  frm.stream_id = 0;
+  frm.type = Frame::PING;
+  frm.flags = 0;
+  frm.payload.push(s_keep_alive_ping, sizeof(s_keep_alive_ping), &s_dp);
+  frame(frm);
+  flush();
+}
+
 void Endpoint::shutdown() {
   m_has_shutdown = true;
 }
@@ -1471,6 +1503,10 @@ void Endpoint::on_deframe(Frame &frm) {
         } else if (!frm.is_ACK()) {
           frm.flags |= Frame::BIT_ACK;
           frame(frm);
+        } else if (m_bdp_ping_sent) {
+          uint8_t buf[8];
+          frm.payload.to_bytes(buf);
+          if (!std::memcmp(buf, s_bdp_ping, sizeof(buf))) bdp_update();
         }
         break;
       case Frame::GOAWAY:
@@ -1488,12 +1524,7 @@ void Endpoint::on_deframe(Frame &frm) {
               connection_error(FLOW_CONTROL_ERROR);
             } else {
               m_send_window = n;
-              for_each_pending_stream(
-                [this](StreamBase *s) {
-                  s->update_connection_send_window();
-                  return m_send_window > 0;
-                }
-              );
+              schedule();
             }
           }
         } else {
@@ -1569,6 +1600,112 @@ void Endpoint::send_window_updates() {
   }
 }
 
+//
+// Shares the connection send window among pending streams in
+// rounds, each stream sending up to a quantum scaled by its weight
+// per round. The stream holding the window when it runs out goes
+// to the back of the queue, so the next round starts with others.
+//
+
+void Endpoint::schedule() {
+  auto quantum = std::max(int(std::min(m_options.stream_quantum, size_t(MAX_WINDOW_SIZE / 256))), 1);
+  bool progress = true;
+  while (progress && m_send_window > 0) {
+    progress = false;
+    for_each_pending_stream(
+      [&](StreamBase *s) {
+        auto n = s->pump(std::max(quantum * s->m_weight / 16, 1));
+        if (n > 0) progress = true;
+        if (m_send_window > 0 || s->m_send_buffer.empty()) {
+          s->recycle();
+          return m_send_window > 0;
+        }
+        if (s->m_is_pending && !s->m_is_clearing) {
+          m_streams_pending.remove(s);
+          m_streams_pending.push(s);
+        }
+        return false;
+      }
+    );
+  }
+}
+
+//
+// Estimates the bandwidth-delay product by counting the bytes received
+// within a PING round trip. When a sample fills most of the current
+// window and the bandwidth is higher than ever seen, both the connection
+// and stream receive windows are raised to twice the sample, up to
+// their ceilings.
+//
+
+void Endpoint::bdp_sample(int size) {
+  if (
+    m_recv_window_ceiling <= m_recv_window_max &&
+    m_stream_window_ceiling <= m_settings.initial_window_size
+  ) return;
+
+  if (m_bdp_ping_sent) {
+    m_bdp_sample += size;
+    return;
+  }
+
+  m_bdp_sample = size;
+  m_bdp_ping_sent = true;
+  m_bdp_ping_time = std::chrono::steady_clock::now();
+
+  Frame frm;
+  frm.stream_id = 0;
+  frm.type = Frame::PING;
+  frm.flags = 0;
+  frm.payload.push(s_bdp_ping, sizeof(s_bdp_ping), &s_dp);
+  frame(frm);
+}
+
+void Endpoint::bdp_update() {
+  m_bdp_ping_sent = false;
+
+  auto rtt = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_bdp_ping_time).count();
+  if (rtt <= 0) return;
+
+  auto sample = m_bdp_sample;
+  auto bandwidth = sample / rtt;
+  if (bandwidth <= m_bdp_bandwidth_max) return;
+  if (sample < std::max(m_recv_window_max, m_settings.initial_window_size) * 2 / 3) return;
+  m_bdp_bandwidth_max = bandwidth;
+
+  auto size = (int64_t)sample * 2;
+
+  auto conn_size = (int)std::min(size, (int64_t)m_recv_window_ceiling);
+  if (conn_size > m_recv_window_max) {
+    m_recv_window_max = conn_size;
+    m_recv_window_low = conn_size / 2;
+  }
+
+  auto stream_size = (int)std::min(size, (int64_t)m_stream_window_ceiling);
+  if (stream_size > m_settings.initial_window_size) {
+    auto delta = stream_size - m_settings.initial_window_size;
+    m_settings.initial_window_size = stream_size;
+    for_each_stream(
+      [=](StreamBase *s) {
+        s->m_recv_window += delta;
+        s->m_recv_window_max += delta;
+        s->m_recv_window_low = s->m_recv_window_max / 2;
+        return true;
+      }
+    );
+    uint8_t buf[Settings::MAX_SIZE];
+    auto len = m_settings.encode(buf);
+    Frame frm;
+    frm.stream_id = 0;
+    frm.type = Frame::SETTINGS;
+    frm.flags = 0;
+    frm.payload.push(buf, len, &s_dp);
+    frame(frm);
+  }
+
+  FlushTarget::need_flush();
+}
+
 void Endpoint::frame(Frame &frm) {
   if (m_has_gone_away) return;
 
@@ -2005,6 +2142,7 @@ bool Endpoint::StreamBase::parse_priority(Frame &frm) {
     connection_error(PROTOCOL_ERROR);
     return false;
   }
+  m_weight = int(buf[4]) + 1;
   return true;
 }
 
@@ -2086,6 +2224,7 @@ bool Endpoint::StreamBase::deduct_recv(int size) {
   }
   connection_recv_window -= size;
   m_recv_window -= size;
+  m_endpoint->bdp_sample(size);
   if (m_recv_window <= m_recv_window_low) set_clearing(true);
   if (m_is_clearing || connection_recv_window <= m_endpoint->m_recv_window_low) flush();
   return true;
@@ -2118,11 +2257,6 @@ bool Endpoint::StreamBase::update_send_window(int delta) {
   return true;
 }
 
-void Endpoint::StreamBase::update_connection_send_window() {
-  pump();
-  recycle();
-}
-
 void Endpoint::StreamBase::write_header_block(Data &data) {
   Frame frm;
   frm.stream_id = m_id;
@@ -2190,10 +2324,11 @@ void Endpoint::StreamBase::set_clearing(bool clearing) {
   }
 }
 
-void Endpoint::StreamBase::pump() {
+auto Endpoint::StreamBase::pump(int quota) -> int {
   bool is_empty_end = (m_end_stream_send && m_send_buffer.empty() && m_tail_buffer.empty());
   int size = m_send_buffer.size();
   if (size > m_send_window) size = m_send_window;
+  if (size > quota) size = quota;
   if (size > 0) size = deduct_send(size);
   if (size > 0 || is_empty_end) {
     auto remain = size;
@@ -2220,6 +2355,7 @@ void Endpoint::StreamBase::pump() {
   } else {
     set_pending(true);
   }
+  return std::max(size, 0);
 }
 
 void Endpoint::StreamBase::recycle() {
@@ -37,6 +37,7 @@
 #include "demux.hpp"
 #include "options.hpp"
 
+#include <chrono>
 #include <map>
 #include <vector>
 #include <iostream>
@@ -363,6 +364,9 @@ public:
   struct Options : public pipy::Options {
     size_t connection_window_size = 0x100000;
     size_t stream_window_size = 0x100000;
+    size_t connection_window_size_max = 0;
+    size_t stream_window_size_max = 0;
+    size_t stream_quantum = 0x4000;
     Options() {}
     Options(pjs::Object *options);
   };
@@ -385,12 +389,14 @@ protected:
   void stream_close(int id);
   void stream_error(int id, ErrorCode err);
   void connection_error(ErrorCode err);
+  void ping();
   void shutdown();
 
 private:
   enum {
     INITIAL_SEND_WINDOW_SIZE = 0xffff,
     INITIAL_RECV_WINDOW_SIZE = 0xffff,
+    MAX_WINDOW_SIZE = 0x7fffffff,
   };
 
   uint32_t m_id;
@@ -408,6 +414,12 @@ private:
   int m_recv_window = INITIAL_RECV_WINDOW_SIZE;
   int m_recv_window_max;
   int m_recv_window_low;
+  int m_recv_window_ceiling;
+  int m_stream_window_ceiling;
+  int m_bdp_sample = 0;
+  double m_bdp_bandwidth_max = 0;
+  std::chrono::steady_clock::time_point m_bdp_ping_time;
+  bool m_bdp_ping_sent = false;
   bool m_is_server_side;
   bool m_has_sent_preface = false;
   bool m_has_shutdown = false;
@@ -428,6 +440,9 @@ private:
   bool for_each_stream(const std::function<bool(StreamBase*)> &cb);
   bool for_each_pending_stream(const std::function<bool(StreamBase*)> &cb);
   void send_window_updates();
+  void schedule();
+  void bdp_sample(int size);
+  void bdp_update();
   void frame(Frame &frm);
   void flush();
   void end(StreamEnd *eos);
@@ -484,7 +499,6 @@ protected:
     bool deduct_recv(int size);
     auto deduct_send(int size) -> int;
     bool update_send_window(int delta);
-    void update_connection_send_window();
     void write_header_block(Data &data);
     void stream_end(http::MessageTail *tail);
 
@@ -496,7 +510,7 @@ protected:
   
     void set_pending(bool pending);
     void set_clearing(bool clearing);
-    void pump();
+    auto pump(int quota = MAX_WINDOW_SIZE) -> int;
     void recycle();
 
     Endpoint* m_endpoint;
@@ -523,6 +537,7 @@ protected:
     int m_recv_window_max;
     int m_recv_window_low;
     int m_recv_payload_size = 0;
+    int m_weight = 16;
     const Settings& m_peer_settings;
 
     friend class Endpoint;
@@ -614,6 +629,7 @@ public:
 
   auto stream() -> EventFunction*;
   void close(EventFunction *stream);
+  void ping() { Endpoint::ping(); }
   void shutdown() { Endpoint::shutdown(); }
 
 private:
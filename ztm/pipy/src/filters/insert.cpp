@@ -52,8 +52,8 @@ void Insert::dump(Dump &d) {
   d.name = "insert";
 }
 
-auto Insert::clone() -> Filter* {
-  return new Insert(*this);
+auto Insert::clone(Arena *arena) -> Filter* {
+  return new (arena) Insert(*this);
 }
 
 void Insert::reset() {
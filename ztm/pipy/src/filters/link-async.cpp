@@ -58,8 +58,8 @@ void LinkAsync::dump(Dump &d) {
   d.name = "linkAsync";
 }
 
-auto LinkAsync::clone() -> Filter* {
-  return new LinkAsync(*this);
+auto LinkAsync::clone(Arena *arena) -> Filter* {
+  return new (arena) LinkAsync(*this);
 }
 
 void LinkAsync::reset() {
@@ -106,7 +106,7 @@ void LinkAsync::process(Event *evt) {
 
   if (!m_is_started) {
     m_buffer.push(evt);
-  } else if (auto p = m_pipeline.get()) {
+  } else if (m_pipeline) {
     m_buffer.push(evt);
     Net::current().io_context().post(FlushHandler(this));
   } else if (auto aw = m_async_wrapper) {
@@ -58,8 +58,8 @@ void Link::dump(Dump &d) {
   d.name = "link";
 }
 
-auto Link::clone() -> Filter* {
-  return new Link(*this);
+auto Link::clone(Arena *arena) -> Filter* {
+  return new (arena) Link(*this);
 }
 
 void Link::reset() {
@@ -44,7 +44,7 @@ private:
   Link(const Link &r);
   ~Link();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void reset() override;
   virtual void process(Event *evt) override;
   virtual void on_reply(Event *evt) override;
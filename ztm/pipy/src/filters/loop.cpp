@@ -53,8 +53,8 @@ void Loop::dump(Dump &d) {
   d.name = "loop";
 }
 
-auto Loop::clone() -> Filter* {
-  return new Loop(*this);
+auto Loop::clone(Arena *arena) -> Filter* {
+  return new (arena) Loop(*this);
 }
 
 void Loop::reset() {
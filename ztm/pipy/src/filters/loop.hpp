@@ -43,7 +43,7 @@ private:
   Loop(const Loop &r);
   ~Loop();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void reset() override;
   virtual void process(Event *evt) override;
   virtual void on_reply(Event *evt) override;
@@ -58,8 +58,8 @@ void MultipartDecoder::dump(Dump &d) {
   d.name = "decodeMultipart";
 }
 
-auto MultipartDecoder::clone() -> Filter* {
-  return new MultipartDecoder(*this);
+auto MultipartDecoder::clone(Arena *arena) -> Filter* {
+  return new (arena) MultipartDecoder(*this);
 }
 
 void MultipartDecoder::reset() {
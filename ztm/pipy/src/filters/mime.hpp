@@ -45,7 +45,7 @@ private:
   MultipartDecoder(const MultipartDecoder &r);
   ~MultipartDecoder();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void reset() override;
   virtual void process(Event *evt) override;
   virtual void dump(Dump &d) override;
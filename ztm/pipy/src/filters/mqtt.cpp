@@ -895,8 +895,8 @@ void Decoder::dump(Dump &d) {
   d.name = "decodeMQTT";
 }
 
-auto Decoder::clone() -> Filter* {
-  return new Decoder(*this);
+auto Decoder::clone(Arena *arena) -> Filter* {
+  return new (arena) Decoder(*this);
 }
 
 void Decoder::reset() {
@@ -995,8 +995,8 @@ void Encoder::dump(Dump &d) {
   d.name = "encodeMQTT";
 }
 
-auto Encoder::clone() -> Filter* {
-  return new Encoder(*this);
+auto Encoder::clone(Arena *arena) -> Filter* {
+  return new (arena) Encoder(*this);
 }
 
 void Encoder::reset() {
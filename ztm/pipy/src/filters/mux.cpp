@@ -30,7 +30,9 @@
 
 #include "api/console.hpp"
 
+#include <cmath>
 #include <limits>
+#include <random>
 
 //
 // All mux filters should derive from MuxSource.
@@ -96,6 +98,8 @@ MuxSession::Options::Options(pjs::Object *options) {
   thread_local static pjs::ConstStr s_max_idle("maxIdle");
   thread_local static pjs::ConstStr s_max_queue("maxQueue");
   thread_local static pjs::ConstStr s_max_messages("maxMessages");
+  thread_local static pjs::ConstStr s_min_idle("minIdle");
+  thread_local static pjs::ConstStr s_ping_interval("pingInterval");
   Value(options, s_max_idle)
     .get_seconds(max_idle)
     .check_nullable();
@@ -105,6 +109,12 @@ MuxSession::Options::Options(pjs::Object *options) {
   Value(options, s_max_messages)
     .get(max_messages)
     .check_nullable();
+  Value(options, s_min_idle)
+    .get(min_idle)
+    .check_nullable();
+  Value(options, s_ping_interval)
+    .get_seconds(ping_interval)
+    .check_nullable();
 }
 
 //
@@ -165,19 +175,50 @@ void MuxSession::free() {
   }
 }
 
+void MuxSession::first_reply() {
+  if (auto p = m_pool) {
+    auto t = utils::now() - m_open_time;
+    p->m_metric_wait->observe(t);
+    MuxSessionPool::s_metric_wait->observe(t);
+  }
+  m_open_time = 0;
+}
+
 //
 // MuxSessionPool
 //
 // Will be deleted when the number of MuxSessions goes down to zero.
 //
+// With minIdle, every new stream tops the pool up to that many idle
+// sessions, each connected right away, and recycling keeps that many
+// past maxIdle. Sessions that have taken maxMessages are not counted,
+// so their replacements are connected before they retire. Once no new
+// stream has come for maxIdle, the warm sessions expire like any other
+// and the pool is free to go.
+//
+// Pool metrics are labeled by key only for the first few distinct keys
+// seen on a thread. Any other key, as well as weak keys, counts toward
+// the unlabeled entry so that per-request keys can't grow them forever.
+//
+
+thread_local pjs::Ref<stats::Counter> MuxSessionPool::s_metric_hit;
+thread_local pjs::Ref<stats::Counter> MuxSessionPool::s_metric_miss;
+thread_local pjs::Ref<stats::Histogram> MuxSessionPool::s_metric_wait;
+thread_local std::unordered_set<std::string> MuxSessionPool::s_metric_keys;
+
+static const size_t s_max_metric_keys = 100;
 
 MuxSessionPool::MuxSessionPool(const MuxSession::Options &options) {
   m_max_idle = options.max_idle;
   m_max_queue = options.max_queue;
   m_max_messages = options.max_messages;
+  m_min_idle = options.min_idle;
+  m_ping_interval = options.ping_interval;
+  init_metrics();
 }
 
 auto MuxSessionPool::alloc() -> MuxSession* {
+  m_alloc_time = utils::now();
   auto max_share_count = m_max_queue;
   auto max_message_count = m_max_messages;
   auto *s = m_sessions.head();
@@ -188,6 +229,8 @@ auto MuxSessionPool::alloc() -> MuxSession* {
       s->m_share_count++;
       s->m_message_count++;
       sort(s);
+      m_metric_hit->increase();
+      s_metric_hit->increase();
       return s;
     }
     s = s->next();
@@ -195,7 +238,10 @@ auto MuxSessionPool::alloc() -> MuxSession* {
   s = session();
   s->retain();
   s->m_pool = this;
+  s->m_open_time = utils::now();
   m_sessions.unshift(s);
+  m_metric_miss->increase();
+  s_metric_miss->increase();
   return s;
 }
 
@@ -203,6 +249,7 @@ void MuxSessionPool::free(MuxSession *session) {
   session->m_share_count--;
   if (session->is_free()) {
     session->m_free_time = utils::now();
+    session->m_ping_time = 0;
   }
   sort(session);
 }
@@ -213,6 +260,34 @@ void MuxSessionPool::detach(MuxSession *session) {
   sort(nullptr);
 }
 
+void MuxSessionPool::warm_up(MuxSource *source) {
+  if (m_min_idle <= 0 || m_weak_ptr_gone || m_map->m_has_shutdown) return;
+
+  int idle = 0;
+  for (auto s = m_sessions.head(); s && s->is_free(); s = s->next()) {
+    if (s->is_open() && !is_retiring(s)) idle++;
+  }
+
+  while (idle++ < m_min_idle) {
+    pjs::Ref<MuxSession> s(session());
+    s->retain();
+    s->m_pool = this;
+    s->m_share_count = 0;
+    s->m_free_time = utils::now();
+    m_sessions.unshift(s);
+    s->open(source, source->on_mux_new_pipeline());
+    if (s->m_eos) break;
+
+    // Get the protocol handshake going if there is one, or else feed
+    // an empty Data into the pipeline, which is enough for connect()
+    // to dial out but doesn't send anything (as with HTTP/1)
+    if (!s->mux_session_ping()) s->input()->input(Data::make());
+    if (s->m_eos) break;
+  }
+
+  schedule_recycling();
+}
+
 void MuxSessionPool::sort(MuxSession *session) {
   if (session) {
     auto p = session->back();
@@ -268,22 +343,92 @@ void MuxSessionPool::schedule_recycling() {
 
 void MuxSessionPool::recycle(double now) {
   auto max_idle = m_max_idle * 1000;
+  auto keep = m_min_idle;
+  if (m_weak_ptr_gone || m_map->m_has_shutdown || now - m_alloc_time >= max_idle) keep = 0;
   auto s = m_sessions.head();
   while (s) {
     auto session = s; s = s->next();
     if (session->m_share_count > 0) break;
-    if (session->m_is_pending || m_weak_ptr_gone ||
-       (m_max_messages > 0 && session->m_message_count >= m_max_messages) ||
-       (now - session->m_free_time >= max_idle))
+    if (session->m_is_pending || m_weak_ptr_gone || is_retiring(session) ||
+       (now - session->m_free_time >= max_idle && keep <= 0))
     {
       MuxSession::auto_release(session);
       session->forward(StreamEnd::make());
       session->close();
       session->detach();
+    } else if (keep > 0) {
+      keep--;
+      ping(session, now);
     }
   }
 }
 
+void MuxSessionPool::ping(MuxSession *session, double now) {
+  thread_local static std::minstd_rand s_rand(std::random_device{}());
+  auto interval = m_ping_interval * 1000;
+  if (interval <= 0 || !session->is_open()) return;
+  if (session->m_ping_time > 0) {
+    if (now < session->m_ping_time) return;
+    session->mux_session_ping();
+  }
+
+  // Jitter by 20% so that sessions opened together don't ping together
+  session->m_ping_time = now + interval * (0.8 + 0.4 * (s_rand() % 1000) / 1000);
+}
+
+void MuxSessionPool::collect_metrics() {
+  pjs::Ref<pjs::Str> key;
+  if (!m_weak_key && (m_key.is_string() || m_key.is_number())) {
+    auto s = m_key.to_string();
+    if (s_metric_keys.count(s->str()) > 0 || s_metric_keys.size() < s_max_metric_keys) {
+      s_metric_keys.insert(s->str());
+      key = s;
+    }
+    s->release();
+  }
+  if (key) {
+    pjs::Str *k = key;
+    m_metric_hit = s_metric_hit->with_labels(&k, 1);
+    m_metric_miss = s_metric_miss->with_labels(&k, 1);
+    m_metric_wait = s_metric_wait->with_labels(&k, 1);
+  } else {
+    m_metric_hit = s_metric_hit;
+    m_metric_miss = s_metric_miss;
+    m_metric_wait = s_metric_wait;
+  }
+}
+
+void MuxSessionPool::init_metrics() {
+  if (!s_metric_hit) {
+    pjs::Ref<pjs::Array> label_names = pjs::Array::make();
+    label_names->length(1);
+    label_names->set(0, "key");
+
+    s_metric_hit = stats::Counter::make(
+      pjs::Str::make("pipy_mux_pool_hit"),
+      label_names
+    );
+
+    s_metric_miss = stats::Counter::make(
+      pjs::Str::make("pipy_mux_pool_miss"),
+      label_names
+    );
+
+    pjs::Ref<pjs::Array> buckets = pjs::Array::make(21);
+    double limit = 1.5;
+    for (int i = 0; i < 20; i++) {
+      buckets->set(i, std::floor(limit));
+      limit *= 1.5;
+    }
+    buckets->set(20, std::numeric_limits<double>::infinity());
+
+    s_metric_wait = stats::Histogram::make(
+      pjs::Str::make("pipy_mux_pool_wait"),
+      buckets, label_names
+    );
+  }
+}
+
 void MuxSessionPool::on_weak_ptr_gone() {
   m_weak_ptr_gone = true;
   m_map->m_weak_pools.erase(m_weak_key);
@@ -310,6 +455,7 @@ auto MuxSessionMap::alloc(const pjs::Value &key, MuxSource *source) -> MuxSessio
 
   pool->m_map = this;
   pool->m_key = key;
+  pool->collect_metrics();
   m_pools[key] = pool;
 
   return pool->alloc();
@@ -326,6 +472,7 @@ auto MuxSessionMap::alloc(pjs::Object::WeakPtr *weak_key, MuxSource *source) ->
 
   pool->m_map = this;
   pool->m_weak_key = weak_key;
+  pool->collect_metrics();
   pool->watch(weak_key);
   m_weak_pools[weak_key] = pool;
 
@@ -460,6 +607,10 @@ void MuxSource::alloc_stream() {
     auto s = m_session->mux_session_open_stream(this);
     s->chain(m_output);
     m_stream = s;
+
+    if (auto pool = session->m_pool) {
+      pool->warm_up(this);
+    }
   }
 }
 
@@ -788,8 +939,8 @@ void Mux::dump(Dump &d) {
   d.sub_type = Dump::MUX;
 }
 
-auto Mux::clone() -> Filter* {
-  return new Mux(*this);
+auto Mux::clone(Arena *arena) -> Filter* {
+  return new (arena) Mux(*this);
 }
 
 auto Mux::on_mux_new_pool(pjs::Object *options) -> MuxSessionPool* {
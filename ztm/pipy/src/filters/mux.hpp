@@ -34,8 +34,10 @@
 #include "list.hpp"
 #include "timer.hpp"
 #include "options.hpp"
+#include "api/stats.hpp"
 
 #include <unordered_map>
+#include <unordered_set>
 
 namespace pipy {
 
@@ -63,6 +65,8 @@ public:
     double max_idle = 60;
     int max_queue = 0;
     int max_messages = 0;
+    int min_idle = 0;
+    double ping_interval = 0;
     Options() {}
     Options(pjs::Object *options);
   };
@@ -71,6 +75,7 @@ public:
   virtual auto mux_session_open_stream(MuxSource *source) -> EventFunction* = 0;
   virtual void mux_session_close_stream(EventFunction *stream) = 0;
   virtual void mux_session_close() = 0;
+  virtual bool mux_session_ping() { return false; }
 
 protected:
   auto pool() const -> MuxSessionPool* { return m_pool; }
@@ -94,10 +99,15 @@ private:
   int m_share_count = 1;
   int m_message_count = 0;
   double m_free_time = 0;
+  double m_open_time = 0;
+  double m_ping_time = 0;
   bool m_is_pending = false;
 
+  void first_reply();
+
   virtual void on_reply(Event *evt) override {
     MuxSession::auto_release(this);
+    if (m_open_time > 0) first_reply();
     EventProxy::output(evt);
   }
 
@@ -124,6 +134,7 @@ private:
   auto alloc() -> MuxSession*;
   void free(MuxSession *session);
   void detach(MuxSession *session);
+  void warm_up(MuxSource *source);
 
   pjs::Value m_key;
   pjs::Ref<pjs::Object::WeakPtr> m_weak_key;
@@ -132,12 +143,31 @@ private:
   double m_max_idle;
   int m_max_queue;
   int m_max_messages;
+  int m_min_idle;
+  double m_ping_interval;
+  double m_alloc_time = 0;
   bool m_weak_ptr_gone = false;
   bool m_recycle_scheduled = false;
+  pjs::Ref<stats::Counter> m_metric_hit;
+  pjs::Ref<stats::Counter> m_metric_miss;
+  pjs::Ref<stats::Histogram> m_metric_wait;
+
+  bool is_retiring(MuxSession *session) const {
+    return m_max_messages > 0 && session->m_message_count >= m_max_messages;
+  }
 
   void sort(MuxSession *session);
   void schedule_recycling();
   void recycle(double now);
+  void ping(MuxSession *session, double now);
+  void collect_metrics();
+
+  thread_local static pjs::Ref<stats::Counter> s_metric_hit;
+  thread_local static pjs::Ref<stats::Counter> s_metric_miss;
+  thread_local static pjs::Ref<stats::Histogram> s_metric_wait;
+  thread_local static std::unordered_set<std::string> s_metric_keys;
+
+  static void init_metrics();
 
   virtual void on_weak_ptr_gone() override;
 
@@ -208,6 +238,7 @@ private:
   void close_stream();
 
   friend class MuxSession;
+  friend class MuxSessionPool;
   friend class MuxSessionMap;
 };
 
@@ -335,7 +366,7 @@ protected:
   ~Mux();
 
   virtual void dump(Dump &d) override;
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual auto on_mux_new_pool(pjs::Object *options) -> MuxSessionPool* override;
 
   //
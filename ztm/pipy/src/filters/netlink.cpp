@@ -64,8 +64,8 @@ void Decoder::dump(Dump &d) {
   d.name = "decodeNetlink";
 }
 
-auto Decoder::clone() -> Filter* {
-  return new Decoder(*this);
+auto Decoder::clone(Arena *arena) -> Filter* {
+  return new (arena) Decoder(*this);
 }
 
 void Decoder::reset() {
@@ -144,8 +144,8 @@ void Encoder::dump(Dump &d) {
   d.name = "encodeNetlink";
 }
 
-auto Encoder::clone() -> Filter* {
-  return new Encoder(*this);
+auto Encoder::clone(Arena *arena) -> Filter* {
+  return new (arena) Encoder(*this);
 }
 
 void Encoder::reset() {
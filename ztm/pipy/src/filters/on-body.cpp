@@ -52,8 +52,8 @@ void OnBody::dump(Dump &d) {
   d.name = "handleMessageBody";
 }
 
-auto OnBody::clone() -> Filter* {
-  return new OnBody(*this);
+auto OnBody::clone(Arena *arena) -> Filter* {
+  return new (arena) OnBody(*this);
 }
 
 void OnBody::reset() {
@@ -55,8 +55,8 @@ void OnEvent::dump(Dump &d) {
   }
 }
 
-auto OnEvent::clone() -> Filter* {
-  return new OnEvent(*this);
+auto OnEvent::clone(Arena *arena) -> Filter* {
+  return new (arena) OnEvent(*this);
 }
 
 void OnEvent::handle(Event *evt) {
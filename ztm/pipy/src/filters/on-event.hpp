@@ -42,7 +42,7 @@ private:
   OnEvent(const OnEvent &r);
   ~OnEvent();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void dump(Dump &d) override;
   virtual void handle(Event *evt) override;
 
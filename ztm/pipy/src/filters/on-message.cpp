@@ -53,8 +53,8 @@ void OnMessage::dump(Dump &d) {
   d.name = "handleMessage";
 }
 
-auto OnMessage::clone() -> Filter* {
-  return new OnMessage(*this);
+auto OnMessage::clone(Arena *arena) -> Filter* {
+  return new (arena) OnMessage(*this);
 }
 
 void OnMessage::reset() {
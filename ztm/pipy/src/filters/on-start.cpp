@@ -46,8 +46,8 @@ void OnStart::dump(Dump &d) {
   d.name = "handleStreamStart";
 }
 
-auto OnStart::clone() -> Filter* {
-  return new OnStart(*this);
+auto OnStart::clone(Arena *arena) -> Filter* {
+  return new (arena) OnStart(*this);
 }
 
 void OnStart::reset() {
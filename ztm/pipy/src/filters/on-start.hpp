@@ -42,7 +42,7 @@ private:
   OnStart(const OnStart &r);
   ~OnStart();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void reset() override;
   virtual void dump(Dump &d) override;
   virtual void handle(Event *evt) override;
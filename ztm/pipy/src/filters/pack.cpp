@@ -87,8 +87,8 @@ void Pack::dump(Dump &d) {
   d.name = "pack";
 }
 
-auto Pack::clone() -> Filter* {
-  return new Pack(*this);
+auto Pack::clone(Arena *arena) -> Filter* {
+  return new (arena) Pack(*this);
 }
 
 void Pack::reset() {
@@ -64,8 +64,8 @@ void Pipe::dump(Dump &d) {
   d.name = "pipe";
 }
 
-auto Pipe::clone() -> Filter* {
-  return new Pipe(*this);
+auto Pipe::clone(Arena *arena) -> Filter* {
+  return new (arena) Pipe(*this);
 }
 
 void Pipe::reset() {
@@ -223,8 +223,8 @@ void PipeNext::dump(Dump &d) {
   d.name = "pipeNext";
 }
 
-auto PipeNext::clone() -> Filter* {
-  return new PipeNext(*this);
+auto PipeNext::clone(Arena *arena) -> Filter* {
+  return new (arena) PipeNext(*this);
 }
 
 void PipeNext::reset() {
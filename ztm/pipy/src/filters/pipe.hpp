@@ -46,7 +46,7 @@ private:
   Pipe(const Pipe &r);
   ~Pipe();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void reset() override;
   virtual void process(Event *evt) override;
   virtual void dump(Dump &d) override;
@@ -76,7 +76,7 @@ private:
   PipeNext(const PipeNext &r);
   ~PipeNext();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void reset() override;
   virtual void process(Event *evt) override;
   virtual void dump(Dump &d) override;
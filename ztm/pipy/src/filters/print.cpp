@@ -47,8 +47,8 @@ void Print::dump(Dump &d) {
   d.name = "print";
 }
 
-auto Print::clone() -> Filter* {
-  return new Print(*this);
+auto Print::clone(Arena *arena) -> Filter* {
+  return new (arena) Print(*this);
 }
 
 void Print::process(Event *evt) {
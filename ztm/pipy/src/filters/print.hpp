@@ -42,7 +42,7 @@ private:
   Print(const Print &r);
   ~Print();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void process(Event *evt) override;
   virtual void dump(Dump &d) override;
 };
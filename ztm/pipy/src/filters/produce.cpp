@@ -51,8 +51,8 @@ void Produce::dump(Dump &d) {
   d.name = "produce";
 }
 
-auto Produce::clone() -> Filter* {
-  return new Produce(*this);
+auto Produce::clone(Arena *arena) -> Filter* {
+  return new (arena) Produce(*this);
 }
 
 void Produce::reset() {
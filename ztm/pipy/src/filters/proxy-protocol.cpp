@@ -82,8 +82,8 @@ void Server::dump(Dump &d) {
   d.name = "acceptProxyProtocol";
 }
 
-auto Server::clone() -> Filter* {
-  return new Server(*this);
+auto Server::clone(Arena *arena) -> Filter* {
+  return new (arena) Server(*this);
 }
 
 void Server::reset() {
@@ -327,8 +327,8 @@ void Client::dump(Dump &d) {
   d.name = "connectProxyProtocol";
 }
 
-auto Client::clone() -> Filter* {
-  return new Client(*this);
+auto Client::clone(Arena *arena) -> Filter* {
+  return new (arena) Client(*this);
 }
 
 void Client::reset() {
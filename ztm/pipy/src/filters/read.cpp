@@ -53,8 +53,8 @@ void Read::dump(Dump &d) {
   d.name = "read";
 }
 
-auto Read::clone() -> Filter* {
-  return new Read(*this);
+auto Read::clone(Arena *arena) -> Filter* {
+  return new (arena) Read(*this);
 }
 
 void Read::reset() {
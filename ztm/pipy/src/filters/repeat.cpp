@@ -54,8 +54,8 @@ void Repeat::dump(Dump &d) {
   d.name = "repeat";
 }
 
-auto Repeat::clone() -> Filter* {
-  return new Repeat(*this);
+auto Repeat::clone(Arena *arena) -> Filter* {
+  return new (arena) Repeat(*this);
 }
 
 void Repeat::reset() {
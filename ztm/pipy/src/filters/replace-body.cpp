@@ -52,8 +52,8 @@ void ReplaceBody::dump(Dump &d) {
   d.name = "replaceMessageBody";
 }
 
-auto ReplaceBody::clone() -> Filter* {
-  return new ReplaceBody(*this);
+auto ReplaceBody::clone(Arena *arena) -> Filter* {
+  return new (arena) ReplaceBody(*this);
 }
 
 void ReplaceBody::reset() {
@@ -55,8 +55,8 @@ void ReplaceEvent::dump(Dump &d) {
   }
 }
 
-auto ReplaceEvent::clone() -> Filter* {
-  return new ReplaceEvent(*this);
+auto ReplaceEvent::clone(Arena *arena) -> Filter* {
+  return new (arena) ReplaceEvent(*this);
 }
 
 void ReplaceEvent::handle(Event *evt) {
@@ -42,7 +42,7 @@ private:
   ReplaceEvent(const ReplaceEvent &r);
   ~ReplaceEvent();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void handle(Event *evt) override;
   virtual void dump(Dump &d) override;
 
@@ -53,8 +53,8 @@ void ReplaceMessage::dump(Dump &d) {
   d.name = "replaceMessage";
 }
 
-auto ReplaceMessage::clone() -> Filter* {
-  return new ReplaceMessage(*this);
+auto ReplaceMessage::clone(Arena *arena) -> Filter* {
+  return new (arena) ReplaceMessage(*this);
 }
 
 void ReplaceMessage::reset() {
@@ -43,7 +43,7 @@ private:
   ReplaceMessage(const ReplaceMessage &r);
   ~ReplaceMessage();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void reset() override;
   virtual void dump(Dump &d) override;
   virtual void handle(Event *evt) override;
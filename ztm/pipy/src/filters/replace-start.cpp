@@ -46,8 +46,8 @@ void ReplaceStart::dump(Dump &d) {
   d.name = "replaceStreamStart";
 }
 
-auto ReplaceStart::clone() -> Filter* {
-  return new ReplaceStart(*this);
+auto ReplaceStart::clone(Arena *arena) -> Filter* {
+  return new (arena) ReplaceStart(*this);
 }
 
 void ReplaceStart::reset() {
@@ -65,8 +65,8 @@ void Replay::dump(Dump &d) {
   d.name = "replay";
 }
 
-auto Replay::clone() -> Filter* {
-  return new Replay(*this);
+auto Replay::clone(Arena *arena) -> Filter* {
+  return new (arena) Replay(*this);
 }
 
 void Replay::reset() {
@@ -52,7 +52,7 @@ private:
   Replay(const Replay &r);
   ~Replay();
 
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void reset() override;
   virtual void shutdown() override;
   virtual void process(Event *evt) override;
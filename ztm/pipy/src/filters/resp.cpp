@@ -50,8 +50,8 @@ void Decoder::dump(Dump &d) {
   d.name = "decodeRESP";
 }
 
-auto Decoder::clone() -> Filter* {
-  return new Decoder(*this);
+auto Decoder::clone(Arena *arena) -> Filter* {
+  return new (arena) Decoder(*this);
 }
 
 void Decoder::reset() {
@@ -102,8 +102,8 @@ void Encoder::dump(Dump &d) {
   d.name = "encodeRESP";
 }
 
-auto Encoder::clone() -> Filter* {
-  return new Encoder(*this);
+auto Encoder::clone(Arena *arena) -> Filter* {
+  return new (arena) Encoder(*this);
 }
 
 void Encoder::reset() {
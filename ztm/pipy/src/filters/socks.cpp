@@ -57,8 +57,8 @@ void Server::dump(Dump &d) {
   d.name = "acceptSOCKS";
 }
 
-auto Server::clone() -> Filter* {
-  return new Server(*this);
+auto Server::clone(Arena *arena) -> Filter* {
+  return new (arena) Server(*this);
 }
 
 void Server::reset() {
@@ -276,8 +276,8 @@ void Client::dump(Dump &d) {
   d.name = "connectSOCKS";
 }
 
-auto Client::clone() -> Filter* {
-  return new Client(*this);
+auto Client::clone(Arena *arena) -> Filter* {
+  return new (arena) Client(*this);
 }
 
 void Client::reset() {
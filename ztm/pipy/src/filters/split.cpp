@@ -68,8 +68,8 @@ void Split::dump(Dump &d) {
   d.name = "split";
 }
 
-auto Split::clone() -> Filter* {
-  return new Split(*this);
+auto Split::clone(Arena *arena) -> Filter* {
+  return new (arena) Split(*this);
 }
 
 void Split::reset() {
@@ -54,8 +54,8 @@ void Swap::dump(Dump &d) {
   d.name = "swap";
 }
 
-auto Swap::clone() -> Filter* {
-  return new Swap(*this);
+auto Swap::clone(Arena *arena) -> Filter* {
+  return new (arena) Swap(*this);
 }
 
 void Swap::reset() {
@@ -63,8 +63,8 @@ void Tee::dump(Dump &d) {
   d.name = "tee";
 }
 
-auto Tee::clone() -> Filter* {
-  return new Tee(*this);
+auto Tee::clone(Arena *arena) -> Filter* {
+  return new (arena) Tee(*this);
 }
 
 void Tee::reset() {
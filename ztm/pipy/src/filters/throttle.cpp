@@ -157,8 +157,8 @@ void ThrottleMessageRate::dump(Dump &d) {
   d.name = "throttleMessageRate";
 }
 
-auto ThrottleMessageRate::clone() -> Filter* {
-  return new ThrottleMessageRate(*this);
+auto ThrottleMessageRate::clone(Arena *arena) -> Filter* {
+  return new (arena) ThrottleMessageRate(*this);
 }
 
 auto ThrottleMessageRate::consume(Event *evt, algo::Quota *quota) -> Event* {
@@ -184,8 +184,8 @@ void ThrottleDataRate::dump(Dump &d) {
   d.name = "throttleDataRate";
 }
 
-auto ThrottleDataRate::clone() -> Filter* {
-  return new ThrottleDataRate(*this);
+auto ThrottleDataRate::clone(Arena *arena) -> Filter* {
+  return new (arena) ThrottleDataRate(*this);
 }
 
 auto ThrottleDataRate::consume(Event *evt, algo::Quota *quota) -> Event* {
@@ -215,8 +215,8 @@ void ThrottleConcurrency::dump(Dump &d) {
   d.name = "throttleConcurrency";
 }
 
-auto ThrottleConcurrency::clone() -> Filter* {
-  return new ThrottleConcurrency(*this);
+auto ThrottleConcurrency::clone(Arena *arena) -> Filter* {
+  return new (arena) ThrottleConcurrency(*this);
 }
 
 void ThrottleConcurrency::reset() {
@@ -105,7 +105,7 @@ public:
   using ThrottleBase::ThrottleBase;
 
 protected:
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual auto consume(Event *evt, algo::Quota *quota) -> Event* override;
   virtual void dump(Dump &d) override;
 };
@@ -119,7 +119,7 @@ public:
   using ThrottleBase::ThrottleBase;
 
 protected:
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual auto consume(Event *evt, algo::Quota *quota) -> Event* override;
   virtual void dump(Dump &d) override;
 };
@@ -133,7 +133,7 @@ public:
   using ThrottleBase::ThrottleBase;
 
 protected:
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void reset() override;
   virtual auto consume(Event *evt, algo::Quota *quota) -> Event* override;
   virtual void dump(Dump &d) override;
@@ -803,8 +803,8 @@ void Client::dump(Dump &d) {
   d.name = "connectTLS";
 }
 
-auto Client::clone() -> Filter* {
-  return new Client(*this);
+auto Client::clone(Arena *arena) -> Filter* {
+  return new (arena) Client(*this);
 }
 
 void Client::reset() {
@@ -937,8 +937,8 @@ void Server::dump(Dump &d) {
   d.name = "acceptTLS";
 }
 
-auto Server::clone() -> Filter* {
-  return new Server(*this);
+auto Server::clone(Arena *arena) -> Filter* {
+  return new (arena) Server(*this);
 }
 
 void Server::reset() {
@@ -1113,8 +1113,8 @@ void OnClientHello::dump(Dump &d) {
   d.name = "handleTLSClientHello";
 }
 
-auto OnClientHello::clone() -> Filter* {
-  return new OnClientHello(*this);
+auto OnClientHello::clone(Arena *arena) -> Filter* {
+  return new (arena) OnClientHello(*this);
 }
 
 void OnClientHello::reset() {
@@ -177,8 +177,8 @@ void Use::bind() {
   }
 }
 
-auto Use::clone() -> Filter* {
-  return new Use(*this);
+auto Use::clone(Arena *arena) -> Filter* {
+  return new (arena) Use(*this);
 }
 
 void Use::reset() {
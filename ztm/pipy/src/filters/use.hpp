@@ -69,7 +69,7 @@ private:
   ~Use();
 
   virtual void bind() override;
-  virtual auto clone() -> Filter* override;
+  virtual auto clone(Arena *arena) -> Filter* override;
   virtual void reset() override;
   virtual void process(Event *evt) override;
   virtual void dump(Dump &d) override;
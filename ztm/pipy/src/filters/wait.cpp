@@ -66,8 +66,8 @@ void Wait::dump(Dump &d) {
   d.name = "wait";
 }
 
-auto Wait::clone() -> Filter* {
-  return new Wait(*this);
+auto Wait::clone(Arena *arena) -> Filter* {
+  return new (arena) Wait(*this);
 }
 
 void Wait::reset() {
@@ -72,8 +72,8 @@ void Decoder::dump(Dump &d) {
   d.name = "decodeWebSocket";
 }
 
-auto Decoder::clone() -> Filter* {
-  return new Decoder(*this);
+auto Decoder::clone(Arena *arena) -> Filter* {
+  return new (arena) Decoder(*this);
 }
 
 void Decoder::reset() {
@@ -213,8 +213,8 @@ void Encoder::dump(Dump &d) {
   d.name = "encodeWebSocket";
 }
 
-auto Encoder::clone() -> Filter* {
-  return new Encoder(*this);
+auto Encoder::clone(Arena *arena) -> Filter* {
+  return new (arena) Encoder(*this);
 }
 
 void Encoder::reset() {
@@ -29,18 +29,41 @@
 #include "pipeline.hpp"
 #include "log.hpp"
 #include "os-platform.hpp"
+#include "file-io.hpp"
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <memory>
+#include <vector>
+#endif
 
 namespace pipy {
 
 FileStream::FileStream(bool read, handle_t fd, Data::Producer *dp)
   : FlushTarget(true)
   , m_stream(Net::context(), fd)
+  , m_fd(fd)
   , m_dp(dp)
 {
+#ifndef _WIN32
+  struct stat st;
+  if (!fstat(fd, &st) && S_ISREG(st.st_mode)) {
+    m_regular_file = true;
+  }
+#endif
   if (read) this->read();
 }
 
 void FileStream::close() {
+  if (m_io_pending) {
+    m_close_pending = true;
+    return;
+  }
+
   std::error_code ec;
   if (m_no_close) {
     m_stream.release();
@@ -93,6 +116,13 @@ void FileStream::on_tap_close() {
 }
 
 void FileStream::read() {
+#ifndef _WIN32
+  if (m_regular_file) {
+    read_regular_file();
+    return;
+  }
+#endif
+
   pjs::Ref<Data> buffer(m_dp->make(RECEIVE_BUFFER_SIZE));
 
   auto on_received = [=](const std::error_code &ec, size_t n) {
@@ -178,6 +208,13 @@ void FileStream::pump() {
   if (m_pumping) return;
   if (m_buffer.empty()) return;
 
+#ifndef _WIN32
+  if (m_regular_file) {
+    pump_regular_file();
+    return;
+  }
+#endif
+
   auto on_sent = [=](const std::error_code &ec, std::size_t n) {
     m_file_pointer += n;
     m_buffer.shift(n);
@@ -221,4 +258,125 @@ void FileStream::pump() {
   m_pumping = true;
 }
 
+#ifndef _WIN32
+
+//
+// Only one operation at a time is in flight on a stream, as it either
+// reads or writes. The stream is retained and not closed until the
+// operation comes back, so that the I/O thread never sees a stale fd.
+//
+
+struct FileStreamIO {
+  std::vector<iovec> iov;
+  ssize_t n = 0;
+  int err = 0;
+};
+
+void FileStream::read_regular_file() {
+  pjs::Ref<Data> buffer(m_dp->make(FILE_READ_SIZE));
+  auto io = std::make_shared<FileStreamIO>();
+  for (const auto c : buffer->chunks()) {
+    io->iov.push_back({ std::get<0>(c), (size_t)std::get<1>(c) });
+  }
+
+  auto fd = m_fd;
+
+  FileIO::submit(
+    FileIO::Op::read,
+    [=]() {
+      auto n = ::readv(fd, io->iov.data(), io->iov.size());
+      if (n < 0) io->err = errno; else io->n = n;
+    },
+    [=]() {
+      InputContext ic(this);
+      m_io_pending = false;
+
+      if (m_close_pending) {
+        m_close_pending = false;
+        close();
+
+      } else if (io->err) {
+        Log::warn(
+          "FileStream: %p, error reading from stream [fd = %d]: %s",
+          this, m_fd, std::strerror(io->err));
+        output(StreamEnd::make(StreamEnd::READ_ERROR));
+
+      } else if (io->n == 0) {
+        Log::debug(Log::FILES, "FileStream: %p, end of stream [fd = %d]", this, m_fd);
+        output(StreamEnd::make(StreamEnd::NO_ERROR));
+
+      } else {
+        m_file_pointer += io->n;
+        buffer->pop(buffer->size() - io->n);
+        output(buffer);
+
+        if (m_receiving_state == PAUSING) {
+          m_receiving_state = PAUSED;
+          retain();
+        } else if (m_receiving_state == RECEIVING) {
+          read();
+        }
+      }
+
+      release();
+    }
+  );
+
+  m_io_pending = true;
+  retain();
+}
+
+void FileStream::pump_regular_file() {
+  auto io = std::make_shared<FileStreamIO>();
+  for (const auto c : m_buffer.chunks()) {
+    io->iov.push_back({ std::get<0>(c), (size_t)std::get<1>(c) });
+    if (io->iov.size() >= IOV_MAX) break;
+  }
+
+  auto fd = m_fd;
+
+  FileIO::submit(
+    FileIO::Op::write,
+    [=]() {
+      auto n = ::writev(fd, io->iov.data(), io->iov.size());
+      if (n < 0) io->err = errno; else io->n = n;
+    },
+    [=]() {
+      m_io_pending = false;
+      m_file_pointer += io->n;
+      m_buffer.shift(io->n);
+      m_pumping = false;
+
+      if (io->err) {
+        Log::warn(
+          "FileStream: %p, error writing to stream [fd = %d], %s",
+          this, m_fd, std::strerror(io->err));
+        m_buffer.clear();
+
+      } else if (!m_close_pending) {
+        pump();
+      }
+
+      if (m_overflowed && m_buffer.size() < m_buffer_limit) {
+        m_overflowed = false;
+      }
+
+      if (m_close_pending) {
+        m_close_pending = false;
+        close();
+      } else if (m_ended && m_buffer.empty()) {
+        close();
+      }
+
+      release();
+    }
+  );
+
+  m_io_pending = true;
+  m_pumping = true;
+  retain();
+}
+
+#endif // !_WIN32
+
 } // namespace pipy
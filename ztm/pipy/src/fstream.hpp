@@ -39,6 +39,10 @@ class Data;
 //
 // FileStream
 //
+// Regular files are always ready in the eyes of the event loop, so
+// reading and writing them would block the whole worker. On POSIX,
+// these are done on the FileIO threads instead.
+//
 
 class FileStream :
   public pjs::RefCount<FileStream>,
@@ -90,12 +94,20 @@ private:
   bool m_overflowed = false;
   bool m_pumping = false;
   bool m_ended = false;
+  bool m_regular_file = false;
+  bool m_io_pending = false;
+  bool m_close_pending = false;
 
   void read();
   void write(Data *data);
   void end();
   void pump();
 
+#ifndef _WIN32
+  void read_regular_file();
+  void pump_regular_file();
+#endif
+
   friend class pjs::RefCount<FileStream>;
 };
 
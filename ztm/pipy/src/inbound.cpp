@@ -52,6 +52,7 @@ std::atomic<uint64_t> Inbound::s_inbound_id;
 thread_local pjs::Ref<stats::Gauge> Inbound::s_metric_concurrency;
 thread_local pjs::Ref<stats::Counter> Inbound::s_metric_traffic_in;
 thread_local pjs::Ref<stats::Counter> Inbound::s_metric_traffic_out;
+thread_local pjs::Ref<stats::Counter> Inbound::s_metric_shed;
 
 auto Inbound::count() -> int {
   int n = 0;
@@ -116,7 +117,7 @@ auto Inbound::ori_dst_address() -> pjs::Str* {
 
 void Inbound::start() {
   if (!m_pipeline) {
-    auto layout = m_listener->pipeline_layout();
+    auto layout = m_listener->admit_layout();
     auto ctx = layout->new_context();
     ctx->m_inbound = this;
     auto p = Pipeline::make(layout, ctx);
@@ -236,6 +237,32 @@ void Inbound::init_metrics() {
         });
       }
     );
+
+    label_names->set(1, "action");
+
+    s_metric_shed = stats::Counter::make(
+      pjs::Str::make("pipy_inbound_shed"),
+      label_names,
+      [](stats::Counter *counter) {
+        thread_local static pjs::ConstStr s_paused("paused");
+        thread_local static pjs::ConstStr s_rejected("rejected");
+        Listener::for_each([&](Listener *listener) {
+          pjs::Str *labels[2];
+          labels[0] = listener->label();
+          if (auto n = listener->shed_paused()) {
+            labels[1] = s_paused;
+            counter->with_labels(labels, 2)->increase(n);
+            counter->increase(n);
+          }
+          if (auto n = listener->shed_rejected()) {
+            labels[1] = s_rejected;
+            counter->with_labels(labels, 2)->increase(n);
+            counter->increase(n);
+          }
+          return true;
+        });
+      }
+    );
   }
 }
 
@@ -309,7 +336,8 @@ void InboundTCP::on_get_address() {
     m_local_port = ep.port();
   }
 
-  m_remote_addr = m_peer.address().to_string();
+  m_remote_ip = m_peer.address();
+  m_remote_addr = m_remote_ip.to_string();
   m_remote_port = m_peer.port();
 
 #ifdef __linux__
@@ -402,7 +430,8 @@ void InboundUDP::on_get_address() {
     const auto &peer = SocketUDP::Peer::peer();
     m_local_addr = local.address().to_string();
     m_local_port = local.port();
-    m_remote_addr = peer.address().to_string();
+    m_remote_ip = peer.address();
+    m_remote_addr = m_remote_ip.to_string();
     m_remote_port = peer.port();
   }
 }
@@ -66,6 +66,7 @@ public:
   auto local_port() -> int { address(); return m_local_port; }
   auto remote_address() -> pjs::Str*;
   auto remote_port() -> int { address(); return m_remote_port; }
+  auto remote_ip() -> const asio::ip::address& { address(); return m_remote_ip; }
   auto ori_dst_address() -> pjs::Str*;
   auto ori_dst_port() -> int { address(); return m_ori_dst_port; }
   bool is_receiving() const { return m_receiving_state == RECEIVING; }
@@ -92,6 +93,7 @@ protected:
   std::string m_local_addr;
   std::string m_remote_addr;
   std::string m_ori_dst_addr;
+  asio::ip::address m_remote_ip;
   int m_local_port = 0;
   int m_remote_port = 0;
   int m_ori_dst_port = 0;
@@ -108,6 +110,7 @@ protected:
   thread_local static pjs::Ref<stats::Gauge> s_metric_concurrency;
   thread_local static pjs::Ref<stats::Counter> s_metric_traffic_in;
   thread_local static pjs::Ref<stats::Counter> s_metric_traffic_out;
+  thread_local static pjs::Ref<stats::Counter> s_metric_shed;
 
   pjs::Ref<stats::Counter> m_metric_traffic_in;
   pjs::Ref<stats::Counter> m_metric_traffic_out;
@@ -28,6 +28,7 @@
 #include "worker.hpp"
 #include "worker-thread.hpp"
 #include "log.hpp"
+#include "api/pipeline-api.hpp"
 
 namespace pipy {
 
@@ -106,6 +107,17 @@ Listener::Options::Options(pjs::Object *options) {
   Value(options, "maxPortConnections")
     .get(max_port_connections)
     .check_nullable();
+  Value(options, "maxPipelines")
+    .get(max_pipelines)
+    .check_nullable();
+  Value(options, "maxLoopLag")
+    .get_seconds(max_loop_lag)
+    .check_nullable();
+  pjs::Ref<PipelineLayoutWrapper> plw;
+  Value(options, "onOverload")
+    .get(plw)
+    .check_nullable();
+  if (plw) on_overload = plw->get();
   Value(options, "readTimeout")
     .get_seconds(read_timeout)
     .check_nullable();
@@ -189,6 +201,7 @@ Listener::Listener(Port::Protocol protocol, const std::string &ip, int port)
 }
 
 Listener::~Listener() {
+  LoopMonitor::get()->unwatch(this);
   m_port->remove_listener(this);
   s_listeners.erase(this);
 }
@@ -218,6 +231,7 @@ void Listener::set_options(const Options &options) {
     } else {
       resume();
     }
+    admit();
   }
 }
 
@@ -310,6 +324,7 @@ bool Listener::start_accepting() {
       pause();
     }
 
+    LoopMonitor::get()->watch(this);
     Log::info("[listener] Listening on %s", desc);
     return true;
 
@@ -328,6 +343,7 @@ void Listener::pause() {
 }
 
 void Listener::resume() {
+  if (m_shedding && !m_options.on_overload) return;
   if (m_paused) {
     m_acceptor->accept();
     m_paused = false;
@@ -335,6 +351,8 @@ void Listener::resume() {
 }
 
 void Listener::stop() {
+  LoopMonitor::get()->unwatch(this);
+  m_shedding = false;
   List<Inbound> inbounds(std::move(m_inbounds));
   for (auto i = inbounds.head(); i; i = i->next()) {
     i->dangle();
@@ -370,6 +388,7 @@ void Listener::open(Inbound *inbound) {
     pause();
   }
   m_peak_connections = std::max(m_peak_connections, int(m_inbounds.size()));
+  if (m_options.max_pipelines >= 0 && !m_shedding) admit();
   if (Log::is_enabled(Log::LISTENER)) print_state("accept");
 }
 
@@ -392,6 +411,74 @@ void Listener::wake_up() {
   });
 }
 
+bool Listener::has_room() {
+  auto n = m_inbounds.size();
+  auto max = m_options.max_connections;
+  return (max < 0 || n < max) && m_port->has_room();
+}
+
+//
+// Admission control: a listener starts shedding load when its thread's
+// event loop lags or carries too many pipelines, and stops shedding only
+// after both have come down by a margin, so it doesn't flap around the
+// thresholds. While shedding, new connections are either not accepted,
+// or handed to the 'onOverload' pipeline in place of the normal one.
+//
+
+static const double ADMISSION_RESUME_RATIO = 0.8;
+
+bool Listener::overloaded(bool shedding) {
+  auto ratio = shedding ? ADMISSION_RESUME_RATIO : 1.0;
+  auto max_lag = m_options.max_loop_lag;
+  auto max_pipelines = m_options.max_pipelines;
+  if (max_lag > 0 && LoopMonitor::get()->lag() > max_lag * ratio) return true;
+  if (max_pipelines >= 0) {
+    auto n = PipelineLayout::active_pipeline_count();
+    if (auto pl = m_options.on_overload.get()) n -= pl->active(); // Rejected ones don't count
+    if (n > max_pipelines * ratio) return true;
+  }
+  return false;
+}
+
+void Listener::admit() {
+  if (!m_acceptor) return;
+  auto shedding = overloaded(m_shedding);
+  if (shedding == m_shedding) return;
+  m_shedding = shedding;
+
+  char desc[200];
+  describe(desc, sizeof(desc));
+  if (shedding) {
+    Log::info(
+      "[listener] Overloaded on %s (loop lag %.1fms, %d pipelines), %s",
+      desc, LoopMonitor::get()->lag() * 1000,
+      int(PipelineLayout::active_pipeline_count()),
+      m_options.on_overload ? "rejecting new connections" : "paused accepting"
+    );
+    if (!m_options.on_overload && !m_paused) {
+      pause();
+      m_shed_paused++;
+    }
+  } else {
+    Log::info("[listener] Recovered from overload on %s", desc);
+    if (has_room()) resume();
+  }
+}
+
+auto Listener::admit_layout() -> PipelineLayout* {
+  if (m_shedding && m_options.on_overload) {
+    m_shed_rejected++;
+    return m_options.on_overload;
+  }
+  return m_pipeline_layout;
+}
+
+void Listener::on_loop_sample() {
+  if (m_shedding || m_options.max_loop_lag > 0 || m_options.max_pipelines >= 0) {
+    admit();
+  }
+}
+
 void Listener::print_state(const char *msg) {
   auto wt = WorkerThread::current();
   Log::debug(
@@ -751,7 +838,6 @@ template<> void ClassDef<ListenerArray>::init() {
         ctx.error_argument_type(0, "a number or string");
         return;
       }
-      obj->as<ListenerArray>()->add_listener(port, options);
     } catch (std::runtime_error &err) {
       ctx.error(err);
     }
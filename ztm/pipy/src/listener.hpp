@@ -29,6 +29,8 @@
 #include "net.hpp"
 #include "socket.hpp"
 #include "inbound.hpp"
+#include "pipeline.hpp"
+#include "timer.hpp"
 #include "signal.h"
 #include "options.hpp"
 
@@ -98,13 +100,16 @@ private:
 // Listener
 //
 
-class Listener {
+class Listener : public LoopMonitor::Watcher {
 public:
   struct Options : public Inbound::Options, public pipy::Options {
     Port::Protocol protocol = Port::Protocol::TCP;
     size_t max_packet_size = 16 * 1024;
     int max_connections = -1;
     int max_port_connections = -1;
+    int max_pipelines = -1;
+    double max_loop_lag = 0;
+    pjs::Ref<PipelineLayout> on_overload;
     Options() {}
     Options(pjs::Object *options);
   };
@@ -144,6 +149,9 @@ public:
   bool pipeline_layout(PipelineLayout *layout);
   auto current_connections() const -> int { return m_inbounds.size(); }
   auto peak_connections() const -> int { return m_peak_connections; }
+  bool shedding() const { return m_shedding; }
+  auto shed_paused() -> int { auto n = m_shed_paused; m_shed_paused = 0; return n; }
+  auto shed_rejected() -> int { auto n = m_shed_rejected; m_shed_rejected = 0; return n; }
 
   void set_reserved(bool b) { m_reserved = b; }
   void set_options(const Options &options);
@@ -227,6 +235,10 @@ private:
   void open(Inbound *inbound);
   void close(Inbound *inbound);
   void wake_up();
+  bool has_room();
+  bool overloaded(bool shedding);
+  void admit();
+  auto admit_layout() -> PipelineLayout*;
   void print_state(const char *msg);
   void describe(char *buf, size_t len);
   void set_sock_opts(int sock);
@@ -236,8 +248,11 @@ private:
   Options m_options_next;
   pjs::Ref<Port> m_port;
   int m_peak_connections = 0;
+  int m_shed_paused = 0;
+  int m_shed_rejected = 0;
   bool m_reserved = false;
   bool m_paused = false;
+  bool m_shedding = false;
   bool m_new_listen = false; // TODO: Remove this
   asio::ip::address m_address;
   std::unique_ptr<Signal> m_keep_alive;
@@ -252,6 +267,8 @@ private:
 
   static auto find(Port::Protocol protocol, const std::string &ip, int port) -> Listener*;
 
+  virtual void on_loop_sample() override;
+
   friend class Port;
   friend class Inbound;
   friend class pjs::RefCount<Listener>;
@@ -219,6 +219,7 @@ public:
 
   void reset() {
     m_initial_metrics = true;
+    m_delta_metrics = false;
   }
 
 private:
@@ -248,7 +249,7 @@ private:
     Data buffer_metrics;
     if (metrics) {
       Data::Builder db(buffer_metrics);
-      metrics->serialize(db, m_initial_metrics);
+      metrics->serialize(db, m_initial_metrics, m_delta_metrics);
       db.flush();
       m_initial_metrics = false;
     }
@@ -272,6 +273,15 @@ private:
         // to indicate that subsequent metric reports can be incremental
         if (head->status != 206) {
           m_initial_metrics = true;
+          m_delta_metrics = false;
+        } else {
+          static pjs::ConstStr s_x_pipy_metrics("x-pipy-metrics");
+          pjs::Value v;
+          m_delta_metrics = (
+            head->headers &&
+            head->headers->get(s_x_pipy_metrics, v) &&
+            v.is_string() && v.s()->str() == "delta"
+          );
         }
       }
     );
@@ -283,6 +293,7 @@ private:
   pjs::Ref<pjs::Object> m_headers;
   bool m_send_metrics = true;
   bool m_initial_metrics = true;
+  bool m_delta_metrics = false;
 };
 
 static StatusReporter s_status_reporter;
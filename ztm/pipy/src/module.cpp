@@ -124,7 +124,7 @@ bool JSModule::load(const std::string &path, pjs::Value &result) {
   int error_line, error_column;
 
   pjs::Module::load(path, m_source.content);
-  if (!pjs::Module::compile(error, error_line, error_column)) {
+  if (!ModuleCache::compile(this, error, error_line, error_column)) {
     Log::pjs_location(m_source.content, path, error_line, error_column);
     Log::error(
       "[pjs] Syntax error: %s at line %d column %d in %s",
@@ -233,4 +233,49 @@ void JSModule::bind_pipelines() {
   );
 }
 
+//
+// ModuleCache
+//
+
+std::map<std::string, ModuleCache::Entry> ModuleCache::s_entries;
+std::mutex ModuleCache::s_mutex;
+
+bool ModuleCache::compile(pjs::Module *mod, std::string &error, int &error_line, int &error_column) {
+  const auto &name = mod->name();
+  const auto &source = mod->source().content;
+  auto hash = std::hash<std::string>()(source);
+
+  std::shared_ptr<const pjs::Parser::Tokens> tokens;
+  {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    auto i = s_entries.find(name);
+    if (i != s_entries.end()) {
+      const auto &e = i->second;
+      if (e.hash == hash && e.source == source) {
+        tokens = e.tokens.lock();
+      }
+    }
+  }
+
+  if (tokens) {
+    return mod->compile(tokens, error, error_line, error_column);
+  }
+
+  if (!mod->compile(tokens, error, error_line, error_column)) return false;
+
+  std::lock_guard<std::mutex> lock(s_mutex);
+  for (auto i = s_entries.begin(); i != s_entries.end(); ) {
+    if (i->second.tokens.expired()) {
+      i = s_entries.erase(i);
+    } else {
+      i++;
+    }
+  }
+  auto &e = s_entries[name];
+  e.hash = hash;
+  e.source = source;
+  e.tokens = tokens;
+  return true;
+}
+
 } // namespace pipy
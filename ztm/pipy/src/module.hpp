@@ -31,6 +31,8 @@
 #include "pipeline-lb.hpp"
 
 #include <map>
+#include <memory>
+#include <mutex>
 #include <set>
 
 namespace pipy {
@@ -143,6 +145,32 @@ private:
   friend class Worker;
 };
 
+//
+// ModuleCache
+//
+// Keeps the tokens of every script parsed in the process, so that
+// other worker threads and later reloads don't tokenize an unchanged
+// script again. Syntax trees hold thread-local values and are still
+// built by each thread, but only from the replayed tokens.
+// Tokens are owned by the modules compiled from them, and an entry
+// is dropped once no module is left using its tokens.
+//
+
+class ModuleCache {
+public:
+  static bool compile(pjs::Module *mod, std::string &error, int &error_line, int &error_column);
+
+private:
+  struct Entry {
+    size_t hash;
+    std::string source;
+    std::weak_ptr<const pjs::Parser::Tokens> tokens;
+  };
+
+  static std::map<std::string, Entry> s_entries;
+  static std::mutex s_mutex;
+};
+
 } // namespace pipy
 
 #endif // MODULE_HPP
@@ -143,11 +143,36 @@ void Pipeline::check_thread() {
 }
 
 void Pipeline::input(Event *evt) {
+  if (m_layout->m_pipeline_process_batch) {
+    m_batch.push_back(evt);
+    if (int(m_batch.size()) >= MAX_BATCH_SIZE || !InputContext::origin()) {
+      flush_batch();
+    } else {
+      need_flush();
+    }
+  } else {
+    LocalRefPool lrf;
+    auto e = nmi::s_values.alloc(evt);
+    lrf.add(e);
+    NativeModule::set_current(module());
+    m_layout->m_pipeline_process(m_id, m_user_ptr, e);
+    NativeModule::set_current(nullptr);
+  }
+}
+
+void Pipeline::flush_batch() {
+  if (m_batch.empty()) return;
   LocalRefPool lrf;
-  auto e = nmi::s_values.alloc(evt);
-  lrf.add(e);
+  pjs_value evts[MAX_BATCH_SIZE];
+  int n = 0;
+  for (const auto &evt : m_batch) {
+    auto e = nmi::s_values.alloc(evt.get());
+    lrf.add(e);
+    evts[n++] = e;
+  }
+  m_batch.clear();
   NativeModule::set_current(module());
-  m_layout->m_pipeline_process(m_id, m_user_ptr, e);
+  m_layout->m_pipeline_process_batch(m_id, m_user_ptr, evts, n);
   NativeModule::set_current(nullptr);
 }
 
@@ -157,6 +182,7 @@ void Pipeline::output(Event *evt) {
 
 void Pipeline::release() {
   if (m_retain_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    flush_batch();
     LocalRefPool lrf;
     NativeModule::set_current(module());
     m_layout->m_pipeline_free(m_id, m_user_ptr);
@@ -271,9 +297,9 @@ NativeModule::NativeModule(int index, const std::string &filename)
         msg += filename;
         throw std::runtime_error(msg + filename);
       }
-      m_pipeline_layouts[pd.name] = new PipelineLayout(this, pd.init, pd.free, pd.process);
+      m_pipeline_layouts[pd.name] = new PipelineLayout(this, pd.init, pd.free, pd.process, pd.process_batch);
     } else {
-      m_entry_pipeline = new PipelineLayout(this, pd.init, pd.free, pd.process);
+      m_entry_pipeline = new PipelineLayout(this, pd.init, pd.free, pd.process, pd.process_batch);
     }
   }
 }
@@ -296,6 +322,17 @@ void NativeModule::define_pipeline(const char *name, fn_pipeline_init init, fn_p
   p.init = init;
   p.free = free;
   p.process = process;
+  p.process_batch = nullptr;
+}
+
+void NativeModule::define_pipeline(const char *name, fn_pipeline_init init, fn_pipeline_free free, fn_pipeline_process_batch process_batch) {
+  m_pipeline_defs.emplace_back();
+  auto &p = m_pipeline_defs.back();
+  p.name = name ? pjs::Str::make(name) : nullptr;
+  p.init = init;
+  p.free = free;
+  p.process = nullptr;
+  p.process_batch = process_batch;
 }
 
 auto NativeModule::pipeline_layout(pjs::Str *name) -> PipelineLayout* {
@@ -895,6 +932,27 @@ NMI_EXPORT int pipy_Data_get_data(pjs_value obj, char *buf, int len) {
   return -1;
 }
 
+NMI_EXPORT int pipy_Data_iterate(pjs_value obj, int (*cb)(const char *ptr, int len, void *user_ptr), void *user_ptr) {
+  if (auto *pv = nmi::s_values.get(obj)) {
+    auto &v = pv->v;
+    if (v.is_instance_of<Data>()) {
+      int n = 0;
+      for (const auto c : v.as<Data>()->chunks()) {
+        n++;
+        if (!(*cb)(std::get<0>(c), std::get<1>(c), user_ptr)) break;
+      }
+      return n;
+    }
+  }
+  return -1;
+}
+
+NMI_EXPORT pjs_value pipy_Data_new_external(const char *buf, int len, fn_object_free free, void *user_ptr) {
+  auto *data = Data::make();
+  data->push_external(buf, len, free, user_ptr);
+  return to_local_value(data);
+}
+
 NMI_EXPORT pjs_value pipy_MessageStart_new(pjs_value head) {
   pjs::Object *head_obj = nullptr;
   if (head) {
@@ -998,6 +1056,12 @@ NMI_EXPORT void pipy_define_pipeline(const char *name, fn_pipeline_init init, fn
   }
 }
 
+NMI_EXPORT void pipy_define_pipeline_batch(const char *name, fn_pipeline_init init, fn_pipeline_free free, fn_pipeline_process_batch process_batch) {
+  if (auto *m = nmi::NativeModule::current()) {
+    m->define_pipeline(name, init, free, process_batch);
+  }
+}
+
 NMI_EXPORT void pipy_hold(pipy_pipeline ppl) {
   if (auto *p = nmi::Pipeline::get(ppl)) {
     p->check_thread();
@@ -1032,6 +1096,22 @@ NMI_EXPORT void pipy_output_event(pipy_pipeline ppl, pjs_value evt) {
   }
 }
 
+NMI_EXPORT void pipy_output_events(pipy_pipeline ppl, pjs_value evts[], int count) {
+  if (nmi::NativeModule::current()) {
+    if (auto *p = nmi::Pipeline::get(ppl)) {
+      p->check_thread();
+      for (int i = 0; i < count; i++) {
+        if (auto *pv = nmi::s_values.get(evts[i])) {
+          auto &v = pv->v;
+          if (v.is_instance_of<pipy::Event>()) {
+            p->output(v.as<pipy::Event>());
+          }
+        }
+      }
+    }
+  }
+}
+
 NMI_EXPORT void pipy_get_variable(pipy_pipeline ppl, int id, pjs_value value) {
   if (auto *m = nmi::NativeModule::current()) {
     if (auto *p = nmi::Pipeline::get(ppl)) {
@@ -31,6 +31,7 @@
 #include "context.hpp"
 #include "module.hpp"
 #include "event.hpp"
+#include "input.hpp"
 #include "table.hpp"
 
 #include <list>
@@ -62,6 +63,7 @@ public:
   auto filename() const -> pjs::Str* { return m_filename; }
   auto define_variable(int id, const char *name, const char *ns, const pjs::Value &value) -> int;
   void define_pipeline(const char *name, fn_pipeline_init init, fn_pipeline_free free, fn_pipeline_process process);
+  void define_pipeline(const char *name, fn_pipeline_init init, fn_pipeline_free free, fn_pipeline_process_batch process_batch);
   auto pipeline_layout(pjs::Str *name) -> PipelineLayout*;
   void schedule(double timeout, const std::function<void()> &fn);
 
@@ -80,6 +82,7 @@ private:
     fn_pipeline_init init;
     fn_pipeline_free free;
     fn_pipeline_process process;
+    fn_pipeline_process_batch process_batch;
   };
 
   struct LegacyExport {
@@ -124,18 +127,21 @@ public:
     NativeModule *mod,
     fn_pipeline_init init,
     fn_pipeline_free free,
-    fn_pipeline_process process
+    fn_pipeline_process process,
+    fn_pipeline_process_batch process_batch
   )
     : m_module(mod)
     , m_pipeline_init(init)
     , m_pipeline_free(free)
-    , m_pipeline_process(process) {}
+    , m_pipeline_process(process)
+    , m_pipeline_process_batch(process_batch) {}
 
 private:
   NativeModule* m_module;
   fn_pipeline_init m_pipeline_init;
   fn_pipeline_free m_pipeline_free;
   fn_pipeline_process m_pipeline_process;
+  fn_pipeline_process_batch m_pipeline_process_batch;
 
   friend class Pipeline;
 };
@@ -144,8 +150,13 @@ private:
 // Pipeline
 //
 
-class Pipeline : public pjs::Pooled<Pipeline> {
+class Pipeline :
+  public pjs::Pooled<Pipeline>,
+  public FlushTarget
+{
 public:
+  static const int MAX_BATCH_SIZE = 256;
+
   static auto get(int id) -> Pipeline* {
     auto *pp = m_pipeline_table.get(id);
     return pp ? *pp : nullptr;
@@ -171,8 +182,13 @@ private:
   void* m_user_ptr = nullptr;
   pjs::Ref<Context> m_context;
   pjs::Ref<EventTarget::Input> m_output;
+  std::vector<pjs::Ref<Event>> m_batch;
   std::atomic<int> m_retain_count;
 
+  void flush_batch();
+
+  virtual void on_flush() override { flush_batch(); }
+
   static SharedTable<Pipeline*> m_pipeline_table;
 
   friend class PipelineLayout;
@@ -29,6 +29,7 @@
 #include "utils.hpp"
 #include "log.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 #ifdef __linux__
@@ -49,6 +50,7 @@ thread_local pjs::Ref<stats::Gauge> Outbound::s_metric_concurrency;
 thread_local pjs::Ref<stats::Counter> Outbound::s_metric_traffic_in;
 thread_local pjs::Ref<stats::Counter> Outbound::s_metric_traffic_out;
 thread_local pjs::Ref<stats::Histogram> Outbound::s_metric_conn_time;
+thread_local pjs::Ref<stats::Histogram> Outbound::s_metric_conn_attempt;
 
 static const std::string s_localhost("localhost");
 static const std::string s_localhost_ip("127.0.0.1");
@@ -161,6 +163,15 @@ void Outbound::collect_metrics() {
   m_metric_traffic_out = Outbound::s_metric_traffic_out->with_labels(keys, 2);
   m_metric_traffic_in = Outbound::s_metric_traffic_in->with_labels(keys, 2);
   m_metric_conn_time = Outbound::s_metric_conn_time->with_labels(keys, 2);
+  m_metric_conn_attempt = Outbound::s_metric_conn_attempt->with_labels(keys, 2);
+}
+
+void Outbound::observe_connection(double conn_time) {
+  m_connection_time += conn_time;
+  m_metric_conn_time->observe(conn_time);
+  m_metric_conn_attempt->observe(m_connection_attempt);
+  s_metric_conn_time->observe(conn_time);
+  s_metric_conn_attempt->observe(m_connection_attempt);
 }
 
 void Outbound::collect() {
@@ -248,6 +259,15 @@ void Outbound::init_metrics() {
       pjs::Str::make("pipy_outbound_conn_time"),
       buckets, label_names
     );
+
+    pjs::Ref<pjs::Array> attempt_buckets = pjs::Array::make(6);
+    for (int i = 0; i < 5; i++) attempt_buckets->set(i, i);
+    attempt_buckets->set(5, std::numeric_limits<double>::infinity());
+
+    s_metric_conn_attempt = stats::Histogram::make(
+      pjs::Str::make("pipy_outbound_conn_attempt"),
+      attempt_buckets, label_names
+    );
   }
 }
 
@@ -255,6 +275,8 @@ void Outbound::init_metrics() {
 // OutboundTCP
 //
 
+thread_local std::map<tcp::endpoint, double> OutboundTCP::s_failed_targets;
+
 OutboundTCP::OutboundTCP(EventTarget::Input *output, const Outbound::Options &options)
   : pjs::ObjectTemplate<OutboundTCP, Outbound>(output, options)
   , SocketTCP(false, Outbound::m_options)
@@ -321,6 +343,7 @@ void OutboundTCP::close() {
       m_resolver.cancel();
       m_connect_timer.cancel();
       SocketTCP::socket().cancel(ec);
+      race_end();
       break;
     case Outbound::State::connected:
       SocketTCP::close();
@@ -401,11 +424,15 @@ void OutboundTCP::resolve() {
           connect_error(StreamEnd::CANNOT_RESOLVE);
 
         } else if (state() == Outbound::State::resolving) {
-          auto &result = *results;
-          const auto &target = result.endpoint();
-          m_remote_addr = target.address().to_string();
-          m_remote_addr_str = nullptr;
-          connect(target);
+          if (options().connect_attempt_delay > 0 && results.size() > 1 && !socket().is_open()) {
+            race(results);
+          } else {
+            auto &result = *results;
+            const auto &target = result.endpoint();
+            m_remote_addr = target.address().to_string();
+            m_remote_addr_str = nullptr;
+            connect(target);
+          }
         }
       }
 
@@ -451,25 +478,8 @@ void OutboundTCP::connect(const asio::ip::tcp::endpoint &target) {
           connect_error(StreamEnd::CONNECTION_REFUSED);
 
         } else if (state() == Outbound::State::connecting) {
-          const auto &ep = socket().local_endpoint();
-          m_local_addr = ep.address().to_string();
-          m_local_port = ep.port();
-          m_local_addr_str = nullptr;
-
-          auto conn_time = utils::now() - m_start_time;
-          m_connection_time += conn_time;
-          m_metric_conn_time->observe(conn_time);
-          s_metric_conn_time->observe(conn_time);
-
-          if (Log::is_enabled(Log::OUTBOUND)) {
-            char desc[200];
-            describe(desc, sizeof(desc));
-            Log::debug(Log::OUTBOUND, "%s connected in %g ms", desc, conn_time);
-          }
-
-          retain();
-          SocketTCP::open();
-          state(Outbound::State::connected);
+          m_connection_attempt = 0;
+          connected(utils::now() - m_start_time);
         }
       }
 
@@ -482,7 +492,219 @@ void OutboundTCP::connect(const asio::ip::tcp::endpoint &target) {
   state(Outbound::State::connecting);
 }
 
+void OutboundTCP::connected(double conn_time) {
+  const auto &ep = socket().local_endpoint();
+  m_local_addr = ep.address().to_string();
+  m_local_port = ep.port();
+  m_local_addr_str = nullptr;
+
+  observe_connection(conn_time);
+
+  if (Log::is_enabled(Log::OUTBOUND)) {
+    char desc[200];
+    describe(desc, sizeof(desc));
+    Log::debug(Log::OUTBOUND, "%s connected in %g ms (attempt %d)", desc, conn_time, m_connection_attempt);
+  }
+
+  retain();
+  SocketTCP::open();
+  state(Outbound::State::connected);
+}
+
+//
+// Connection racing as in RFC 8305 (Happy Eyeballs v2):
+// all resolved addresses are tried one after another, each attempt
+// starting after connect_attempt_delay or as soon as the previous one fails,
+// whichever comes first. The first one that succeeds wins the race.
+//
+
+void OutboundTCP::race(const tcp::resolver::results_type &results) {
+  race_end();
+  m_race_targets.clear();
+  for (const auto &r : results) m_race_targets.push_back(r.endpoint());
+  sort_targets(m_race_targets, options().connect_failure_memory);
+  m_attempts.clear();
+  m_attempt_failures = 0;
+  m_race_id++;
+  race_next();
+}
+
+void OutboundTCP::race_next() {
+  while (m_attempts.size() < m_race_targets.size()) {
+    int index = m_attempts.size();
+    const auto &target = m_race_targets[index];
+    auto *attempt = new Attempt(target);
+    m_attempts.push_back(std::unique_ptr<Attempt>(attempt));
+
+    m_remote_addr = target.address().to_string();
+    m_remote_addr_str = nullptr;
+
+    if (Log::is_enabled(Log::OUTBOUND)) {
+      char desc[200];
+      describe(desc, sizeof(desc));
+      Log::debug(Log::OUTBOUND, "%s connecting... (attempt %d)", desc, index);
+    }
+
+    std::error_code ec;
+    attempt->socket.open(target.protocol(), ec);
+    if (ec) {
+      attempt->failed = true;
+      remember_failure(target, options().connect_failure_memory);
+      if (++m_attempt_failures >= m_race_targets.size()) {
+        connect_error(StreamEnd::CONNECTION_REFUSED);
+        return;
+      }
+      continue;
+    }
+
+    // Go through open to connecting on the first socket as a single connect does
+    if (state() != Outbound::State::connecting) {
+      state(Outbound::State::open);
+    }
+
+    auto race_id = m_race_id;
+    attempt->socket.async_connect(
+      target,
+      [=](const std::error_code &ec) {
+        if (ec != asio::error::operation_aborted && race_id == m_race_id) {
+          InputContext ic;
+          on_attempt(index, ec);
+        }
+        release();
+      }
+    );
+
+    retain();
+
+    state(Outbound::State::connecting);
+
+    if (m_attempts.size() < m_race_targets.size()) {
+      m_attempt_timer.schedule(
+        options().connect_attempt_delay,
+        [this]() {
+          InputContext ic;
+          race_next();
+        }
+      );
+    }
+
+    break;
+  }
+}
+
+void OutboundTCP::race_end(int winner) {
+  m_attempt_timer.cancel();
+  for (int i = 0; i < m_attempts.size(); i++) {
+    auto &s = m_attempts[i]->socket;
+    if (i == winner) {
+      socket() = std::move(s);
+    } else if (s.is_open()) {
+      std::error_code ec;
+      s.close(ec);
+    }
+  }
+}
+
+void OutboundTCP::on_attempt(int index, const std::error_code &ec) {
+  if (state() != Outbound::State::connecting) return;
+
+  auto *attempt = m_attempts[index].get();
+  if (attempt->failed) return;
+
+  if (ec) {
+    if (Log::is_enabled(Log::OUTBOUND)) {
+      char desc[200];
+      describe(desc, sizeof(desc));
+      Log::debug(Log::OUTBOUND, "%s cannot connect to %s (attempt %d): %s",
+        desc, attempt->target.address().to_string().c_str(), index, ec.message().c_str()
+      );
+    }
+
+    std::error_code ec_close;
+    attempt->socket.close(ec_close);
+    attempt->failed = true;
+    remember_failure(attempt->target, options().connect_failure_memory);
+
+    if (++m_attempt_failures >= m_race_targets.size()) {
+      if (options().connect_timeout > 0) {
+        m_connect_timer.cancel();
+      }
+      connect_error(StreamEnd::CONNECTION_REFUSED);
+    } else if (m_attempts.size() < m_race_targets.size()) {
+      m_attempt_timer.cancel();
+      race_next();
+    }
+
+  } else {
+    if (options().connect_timeout > 0) {
+      m_connect_timer.cancel();
+    }
+
+    forget_failure(attempt->target);
+    m_remote_addr = attempt->target.address().to_string();
+    m_remote_addr_str = nullptr;
+    m_connection_attempt = index;
+    race_end(index);
+    connected(utils::now() - m_start_time);
+  }
+}
+
+void OutboundTCP::sort_targets(std::vector<tcp::endpoint> &targets, double failure_memory) {
+
+  // Interleave address families, starting with the one preferred by the resolver
+  std::vector<tcp::endpoint> primary, secondary;
+  bool v6 = targets.front().address().is_v6();
+  for (const auto &t : targets) {
+    if (t.address().is_v6() == v6) {
+      primary.push_back(t);
+    } else {
+      secondary.push_back(t);
+    }
+  }
+
+  targets.clear();
+  for (size_t i = 0; i < primary.size() || i < secondary.size(); i++) {
+    if (i < primary.size()) targets.push_back(primary[i]);
+    if (i < secondary.size()) targets.push_back(secondary[i]);
+  }
+
+  // Move addresses that failed recently to the back
+  if (!s_failed_targets.empty()) {
+    auto now = utils::now();
+    std::stable_partition(
+      targets.begin(), targets.end(),
+      [&](const tcp::endpoint &t) {
+        auto i = s_failed_targets.find(t);
+        if (i == s_failed_targets.end()) return true;
+        if (now - i->second < failure_memory * 1000) return false;
+        s_failed_targets.erase(i);
+        return true;
+      }
+    );
+  }
+}
+
+void OutboundTCP::remember_failure(const tcp::endpoint &target, double failure_memory) {
+  if (failure_memory <= 0) return;
+  auto now = utils::now();
+  if (s_failed_targets.size() >= 1000) {
+    for (auto i = s_failed_targets.begin(); i != s_failed_targets.end(); ) {
+      if (now - i->second >= failure_memory * 1000) {
+        i = s_failed_targets.erase(i);
+      } else {
+        i++;
+      }
+    }
+  }
+  s_failed_targets[target] = now;
+}
+
+void OutboundTCP::forget_failure(const tcp::endpoint &target) {
+  s_failed_targets.erase(target);
+}
+
 void OutboundTCP::connect_error(StreamEnd::Error err) {
+  race_end();
   if (options().retry_count >= 0 && m_retries >= options().retry_count) {
     error(err);
   } else {
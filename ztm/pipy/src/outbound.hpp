@@ -36,6 +36,9 @@
 #include "api/stats.hpp"
 
 #include <functional>
+#include <map>
+#include <memory>
+#include <vector>
 
 namespace pipy {
 
@@ -72,6 +75,8 @@ public:
     int       retry_count = 0;
     double    retry_delay = 0;
     double    connect_timeout = 0;
+    double    connect_attempt_delay = 0;
+    double    connect_failure_memory = 10;
 
     std::function<void(Outbound*)> on_state_changed;
   };
@@ -102,6 +107,7 @@ public:
   auto remote_port() -> int { address(); return m_port; }
   auto retries() const -> int { return m_retries; }
   auto connection_time() const -> double { return m_connection_time; }
+  auto connection_attempt() const -> int { return m_connection_attempt; }
 
   virtual void bind(const std::string &address) = 0;
   virtual void connect(const std::string &address) = 0;
@@ -135,6 +141,7 @@ protected:
   int m_port = 0;
   int m_local_port = 0;
   int m_retries = 0;
+  int m_connection_attempt = 0;
   double m_start_time = 0;
   double m_connection_time = 0;
 
@@ -153,10 +160,14 @@ protected:
   thread_local static pjs::Ref<stats::Counter> s_metric_traffic_in;
   thread_local static pjs::Ref<stats::Counter> s_metric_traffic_out;
   thread_local static pjs::Ref<stats::Histogram> s_metric_conn_time;
+  thread_local static pjs::Ref<stats::Histogram> s_metric_conn_attempt;
 
   pjs::Ref<stats::Counter> m_metric_traffic_out;
   pjs::Ref<stats::Counter> m_metric_traffic_in;
   pjs::Ref<stats::Histogram> m_metric_conn_time;
+  pjs::Ref<stats::Histogram> m_metric_conn_attempt;
+
+  void observe_connection(double conn_time);
 
 private:
   thread_local static List<Outbound> s_all_outbounds;
@@ -187,14 +198,42 @@ private:
   OutboundTCP(EventTarget::Input *output, const Outbound::Options &options);
   ~OutboundTCP();
 
+  //
+  // OutboundTCP::Attempt
+  //
+
+  struct Attempt {
+    asio::ip::tcp::endpoint target;
+    asio::ip::tcp::socket socket;
+    bool failed = false;
+    Attempt(const asio::ip::tcp::endpoint &target)
+      : target(target), socket(Net::context()) {}
+  };
+
   asio::ip::tcp::resolver m_resolver;
   Timer m_connect_timer;
   Timer m_retry_timer;
+  Timer m_attempt_timer;
+  std::vector<asio::ip::tcp::endpoint> m_race_targets;
+  std::vector<std::unique_ptr<Attempt>> m_attempts;
+  int m_attempt_failures = 0;
+  int m_race_id = 0;
 
   void start(double delay);
   void resolve();
   void connect(const asio::ip::tcp::endpoint &target);
   void connect_error(StreamEnd::Error err);
+  void connected(double conn_time);
+  void race(const asio::ip::tcp::resolver::results_type &results);
+  void race_next();
+  void race_end(int winner = -1);
+  void on_attempt(int index, const std::error_code &ec);
+
+  static void sort_targets(std::vector<asio::ip::tcp::endpoint> &targets, double failure_memory);
+  static void remember_failure(const asio::ip::tcp::endpoint &target, double failure_memory);
+  static void forget_failure(const asio::ip::tcp::endpoint &target);
+
+  thread_local static std::map<asio::ip::tcp::endpoint, double> s_failed_targets;
 
   virtual auto wrap_socket() -> Socket* override;
   virtual auto get_buffered() const -> size_t override { return SocketTCP::buffered(); }
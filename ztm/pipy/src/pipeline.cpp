@@ -102,6 +102,12 @@ auto PipelineLayout::append(Filter *filter) -> Filter* {
   return filter;
 }
 
+void PipelineLayout::for_each_filter(const std::function<void(Filter*)> &callback) {
+  for (const auto &f : m_filters) {
+    callback(f.get());
+  }
+}
+
 auto PipelineLayout::alloc(Context *ctx) -> Pipeline* {
   retain();
   Pipeline *pipeline = nullptr;
@@ -109,7 +115,11 @@ auto PipelineLayout::alloc(Context *ctx) -> Pipeline* {
     pipeline = m_pool;
     m_pool = pipeline->m_next_free;
   } else {
-    pipeline = new Pipeline(this);
+
+    // The filters of a pipeline are cloned into one block. How big it
+    // needs to be is only known after the first pipeline is made.
+    auto arena = m_arena_size > 0 ? (char *)::operator new(m_arena_size) : nullptr;
+    pipeline = new Pipeline(this, arena, m_arena_size);
     m_allocated++;
   }
   pipeline->m_context = ctx;
@@ -161,16 +171,20 @@ void PipelineLayout::free(Pipeline *pipeline) {
 // Pipeline
 //
 
-Pipeline::Pipeline(PipelineLayout *layout)
+Pipeline::Pipeline(PipelineLayout *layout, char *arena, size_t arena_size)
   : m_layout(layout)
+  , m_arena(arena)
+  , m_arena_size(arena_size)
 {
   const auto &filters = layout->m_filters;
+  Filter::Arena a(arena, arena_size);
   for (const auto &f : filters) {
-    auto filter = f->clone();
+    auto filter = f->clone(&a);
     filter->m_pipeline_layout = layout;
     filter->m_pipeline = this;
     m_filters.push(filter);
   }
+  if (!layout->m_arena_size) layout->m_arena_size = a.size();
   if (auto f = m_filters.head()) {
     EventProxy::chain_forward(f->EventFunction::input());
     while (f) {
@@ -190,8 +204,18 @@ Pipeline::~Pipeline() {
   while (p) {
     auto f = p;
     p = p->next();
-    delete f;
+    if (in_arena(f)) {
+      f->~Filter();
+    } else {
+      delete f;
+    }
   }
+  ::operator delete(m_arena);
+}
+
+bool Pipeline::in_arena(Filter *f) const {
+  auto p = (char *)f;
+  return m_arena && m_arena <= p && p < m_arena + m_arena_size;
 }
 
 void Pipeline::start(const pjs::Value &args) {
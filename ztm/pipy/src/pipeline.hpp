@@ -106,10 +106,12 @@ public:
   auto name_or_label() const -> pjs::Str*;
   auto allocated() const -> size_t { return m_allocated; }
   auto active() const -> size_t { return m_pipelines.size(); }
+  auto arena_size() const -> size_t { return m_arena_size; }
   void on_start_location(pjs::Location &loc) { m_on_start_location = loc; }
   void on_start(pjs::Object *e) { m_on_start = e; }
   void on_end(pjs::Function *f) { m_on_end = f; }
   auto append(Filter *filter) -> Filter*;
+  void for_each_filter(const std::function<void(Filter*)> &callback);
   void bind();
   void shutdown();
 
@@ -132,6 +134,7 @@ private:
   pjs::Ref<pjs::Function> m_on_end;
   pjs::Location m_on_start_location;
   std::list<std::unique_ptr<Filter>> m_filters;
+  size_t m_arena_size = 0;
   Pipeline* m_pool = nullptr;
   List<Pipeline> m_pipelines;
   int m_allocated = 0;
@@ -193,7 +196,7 @@ public:
   void on_end(ResultCallback *cb) { m_result_cb = cb; }
 
 private:
-  Pipeline(PipelineLayout *layout);
+  Pipeline(PipelineLayout *layout, char *arena, size_t arena_size);
   ~Pipeline();
 
   virtual void on_input(Event *evt) override;
@@ -203,6 +206,8 @@ private:
   PipelineLayout* m_layout;
   Pipeline* m_next_free = nullptr;
   List<Filter> m_filters;
+  char* m_arena = nullptr;
+  size_t m_arena_size = 0;
   pjs::Ref<Context> m_context;
   pjs::Ref<StartingPromiseCallback> m_starting_promise_callback;
   pjs::Ref<PipelineLayout::Chain> m_chain;
@@ -217,6 +222,7 @@ private:
   void start_with(const pjs::Value &starting_events);
   void shutdown();
   void reset();
+  bool in_arena(Filter *f) const;
 
   friend class pjs::RefCount<Pipeline>;
   friend class PipelineLayout;
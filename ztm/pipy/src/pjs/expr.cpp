@@ -56,6 +56,22 @@ Expr::~Expr()
 
 namespace expr {
 
+//
+// Strings are concatenated without flattening ropes on either side
+//
+
+static auto to_lazy_string(const Value &v) -> Str* {
+  return v.is_string() ? v.s_lazy()->retain() : v.to_string();
+}
+
+static void concat_strings(const Value &a, const Value &b, Value &result) {
+  auto sa = to_lazy_string(a);
+  auto sb = to_lazy_string(b);
+  result.set(Str::concat(sa, sb));
+  sa->release();
+  sb->release();
+}
+
 //
 // Discard
 //
@@ -136,16 +152,37 @@ void Compound::dump(std::ostream &out, const std::string &indent) {
 //
 
 bool Concatenation::eval(Context &ctx, Value &result) {
+  Ref<Str> head;
   std::string str;
+
+  auto append = [&](Str *s) {
+    Ref<Str> tail(s);
+    head = head ? Str::concat(head, tail) : tail.get();
+  };
+
   for (const auto &p : m_exprs) {
     if (!p->eval(ctx, result)) {
       return false;
     }
-    auto s = result.to_string();
-    str += s->str();
+    auto s = to_lazy_string(result);
+    if (s->size() >= Str::ROPE_MIN_SIZE) {
+      if (!str.empty()) {
+        append(Str::make(std::move(str)));
+        str.clear();
+      }
+      append(s);
+    } else {
+      str += s->str();
+    }
     s->release();
   }
-  result.set(str);
+
+  if (!head) {
+    result.set(str);
+  } else {
+    if (!str.empty()) append(Str::make(std::move(str)));
+    result.set(head.get());
+  }
   return true;
 }
 
@@ -1207,11 +1244,7 @@ bool Addition::eval(Context &ctx, Value &result) {
   if (!m_a->eval(ctx, a)) return false;
   if (!m_b->eval(ctx, b)) return false;
   if (a.is_string() || b.is_string()) {
-    auto sa = a.to_string();
-    auto sb = b.to_string();
-    result.set(sa->str() + sb->str());
-    sa->release();
-    sb->release();
+    concat_strings(a, b, result);
     return true;
   }
   if (a.is<Int>() || b.is<Int>()) {
@@ -2386,11 +2419,7 @@ bool AdditionAssignment::eval(Context &ctx, Value &result) {
   if (!m_l->eval(ctx, a)) return false;
   if (!m_r->eval(ctx, b)) return false;
   if (a.is_string() || b.is_string()) {
-    auto sa = a.to_string();
-    auto sb = b.to_string();
-    result.set(sa->str() + sb->str());
-    sa->release();
-    sb->release();
+    concat_strings(a, b, result);
   } else if (a.is<Int>() || b.is<Int>()) {
     auto ia = a.to_int();
     auto ib = b.to_int();
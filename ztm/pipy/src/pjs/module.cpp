@@ -26,6 +26,8 @@
 #include "module.hpp"
 #include "parser.hpp"
 
+#include <chrono>
+
 namespace pjs {
 
 class ExportsObjectBase : public ObjectTemplate<ExportsObjectBase> {
@@ -115,9 +117,23 @@ auto Module::find_export(Str *name) -> int {
 }
 
 bool Module::compile(std::string &error, int &error_line, int &error_column) {
-  auto stmt = Parser::parse(&m_source, error, error_line, error_column);
+  std::shared_ptr<const Parser::Tokens> tokens;
+  return compile(tokens, error, error_line, error_column);
+}
+
+bool Module::compile(std::shared_ptr<const Parser::Tokens> &tokens, std::string &error, int &error_line, int &error_column) {
+  typedef std::chrono::steady_clock clock;
+  auto elapsed = [](clock::time_point t) {
+    return std::chrono::duration<double, std::milli>(clock::now() - t).count();
+  };
+
+  auto t = clock::now();
+  auto stmt = Parser::parse(&m_source, tokens, error, error_line, error_column);
+  m_parse_time = elapsed(t);
   if (!stmt) return false;
+  m_tokens = tokens;
 
+  t = clock::now();
   Tree::Error tree_error;
   if (!stmt->declare(this, m_scope, tree_error)) {
     auto tree = tree_error.tree;
@@ -128,6 +144,7 @@ bool Module::compile(std::string &error, int &error_line, int &error_column) {
   }
 
   m_tree = std::unique_ptr<Stmt>(stmt);
+  m_compile_time = elapsed(t);
   return true;
 }
 
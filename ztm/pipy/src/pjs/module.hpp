@@ -27,6 +27,7 @@
 #define PJS_MODULE_HPP
 
 #include "stmt.hpp"
+#include "parser.hpp"
 
 namespace pjs {
 
@@ -46,6 +47,8 @@ public:
   auto tree() const -> Stmt* { return m_tree.get(); }
   auto scope() -> Tree::Scope& { return m_scope; }
   auto exports_object() const -> Object* { return m_exports_object; }
+  auto parse_time() const -> double { return m_parse_time; }
+  auto compile_time() const -> double { return m_compile_time; }
   bool is_expression() const { return m_tree->is_expression(); }
 
   void load(const std::string &name, const std::string &source);
@@ -57,6 +60,7 @@ public:
   auto find_import(Str *name) -> Tree::Import*;
   auto find_export(Str *name) -> int;
   bool compile(std::string &error, int &error_line, int &error_column);
+  bool compile(std::shared_ptr<const Parser::Tokens> &tokens, std::string &error, int &error_line, int &error_column);
   void resolve(const std::function<Module*(Module*, Str*)> &resolver);
   void execute(Context &ctx, int l, Tree::LegacyImports *imports, Value &result);
 
@@ -64,7 +68,10 @@ private:
   Instance* m_instance;
   int m_id;
   int m_fiber_variable_count = 0;
+  double m_parse_time = 0;
+  double m_compile_time = 0;
   Source m_source;
+  std::shared_ptr<const Parser::Tokens> m_tokens;
   Tree::Scope m_scope;
   std::unique_ptr<Stmt> m_tree;
   std::list<Tree::Import> m_imports;
@@ -30,6 +30,7 @@
 #include <map>
 #include <mutex>
 #include <stack>
+#include <vector>
 
 namespace pjs {
 
@@ -153,14 +154,45 @@ thread_local std::vector<Token::TokenData> Token::s_tokens(1);
 thread_local std::map<double, int> Token::s_number_map;
 thread_local std::map<std::string, int> Token::s_string_map;
 
+//
+// Parser::Tokens
+//
+
+class Parser::Tokens {
+public:
+  struct Item {
+    int id;
+    bool literal;
+    bool eol;
+    Loc loc;
+  };
+
+  struct Literal {
+    double n;
+    std::string s;
+  };
+
+  std::vector<Item> items;
+  std::vector<Literal> literals;
+};
+
 //
 // Tokenizer
 //
 
 class Tokenizer {
 public:
-  Tokenizer(const std::string &script) : m_script(script), m_token(0) {
+  Tokenizer(
+    const std::string &script,
+    Parser::Tokens *recording = nullptr,
+    const Parser::Tokens *replaying = nullptr
+  ) : m_script(script)
+    , m_token(0)
+    , m_recording(recording)
+    , m_replaying(replaying)
+  {
     init_operator_map();
+    if (replaying) m_replayed_literals.resize(replaying->literals.size());
   }
 
   void set_template_mode(bool b) { m_is_template = b; }
@@ -228,7 +260,7 @@ private:
   static std::set<int> s_operator_set;
   static void init_operator_map();
 
-  std::string m_script;
+  const std::string &m_script;
   size_t m_ptr = 0;
   Loc m_loc;
   Loc m_token_loc;
@@ -236,14 +268,63 @@ private:
   bool m_has_peeked = false;
   bool m_has_eol = false;
   bool m_is_template = false;
+  Parser::Tokens* m_recording;
+  const Parser::Tokens* m_replaying;
+  size_t m_replay_ptr = 0;
+  std::vector<int> m_replayed_literals;
 
   void peek_token() {
     if (!m_has_peeked) {
-      m_token = parse(m_token_loc);
+      if (m_replaying) {
+        replay();
+      } else if (m_recording) {
+        auto has_eol = m_has_eol;
+        m_has_eol = false;
+        m_token = parse(m_token_loc);
+        record();
+        m_has_eol = m_has_eol || has_eol;
+      } else {
+        m_token = parse(m_token_loc);
+      }
       m_has_peeked = true;
     }
   }
 
+  void record() {
+    auto id = m_token.id();
+    bool literal = (id > 0 && !m_token.is_builtin());
+    if (literal) {
+      auto &literals = m_recording->literals;
+      if (id >= literals.size()) {
+        literals.resize(id + 1);
+        literals[id].n = m_token.n();
+        literals[id].s = m_token.s();
+      }
+    }
+    m_recording->items.push_back({ id, literal, m_has_eol, m_token_loc });
+  }
+
+  void replay() {
+    const auto &items = m_replaying->items;
+    if (m_replay_ptr >= items.size()) {
+      m_token = Token::eof;
+      return;
+    }
+    const auto &item = items[m_replay_ptr++];
+    if (item.eol) m_has_eol = true;
+    m_token_loc = item.loc;
+    if (item.literal) {
+      auto &id = m_replayed_literals[item.id];
+      if (!id) {
+        const auto &l = m_replaying->literals[item.id];
+        id = (std::isnan(l.n) ? Token(l.s) : Token(l.n)).id();
+      }
+      m_token = Token(id);
+    } else {
+      m_token = Token(item.id);
+    }
+  }
+
   auto parse(Loc &loc) -> Token;
   bool parse_space();
 
@@ -778,7 +859,11 @@ private:
 
 class ScriptParser {
 public:
-  ScriptParser(const Source *source);
+  ScriptParser(
+    const Source *source,
+    Parser::Tokens *recording = nullptr,
+    const Parser::Tokens *replaying = nullptr
+  );
 
   auto parse(
     std::string &error,
@@ -1090,9 +1175,9 @@ const std::unordered_map<int, int> ScriptParser::s_precedence_table = {
   { Token::ID(","   ),  1 },
 };
 
-ScriptParser::ScriptParser(const Source *source)
+ScriptParser::ScriptParser(const Source *source, Parser::Tokens *recording, const Parser::Tokens *replaying)
   : m_source(source)
-  , m_tokenizer(source->content)
+  , m_tokenizer(source->content, recording, replaying)
 {
 }
 
@@ -2036,6 +2121,27 @@ auto Parser::parse(
   return parser.parse(error, error_line, error_column);
 }
 
+auto Parser::parse(
+  const Source *source,
+  std::shared_ptr<const Tokens> &tokens,
+  std::string &error,
+  int &error_line,
+  int &error_column) -> Stmt*
+{
+  Token::clear();
+
+  if (tokens) {
+    ScriptParser parser(source, nullptr, tokens.get());
+    return parser.parse(error, error_line, error_column);
+  }
+
+  auto recording = std::make_shared<Tokens>();
+  ScriptParser parser(source, recording.get());
+  auto stmt = parser.parse(error, error_line, error_column);
+  if (stmt) tokens = recording;
+  return stmt;
+}
+
 
 auto Parser::parse_expr(
   const Source *source,
@@ -28,6 +28,7 @@
 
 #include <initializer_list>
 #include <list>
+#include <memory>
 #include <set>
 #include <string>
 
@@ -39,8 +40,26 @@ class Source;
 
 class Parser {
 public:
+
+  //
+  // Parser::Tokens
+  //
+  // Tokens read from a script, recorded by the first parse
+  // and replayed by later parses of the same script on any thread
+  //
+
+  class Tokens;
+
+  static auto parse(
+    const Source *source,
+    std::string &error,
+    int &error_line,
+    int &error_column
+  ) -> Stmt*;
+
   static auto parse(
     const Source *source,
+    std::shared_ptr<const Tokens> &tokens,
     std::string &error,
     int &error_line,
     int &error_column
@@ -265,14 +265,105 @@ auto Str::parse_float() const -> double {
 auto Str::substring(int start, int end) -> std::string {
   auto a = chr_to_pos(start);
   auto b = chr_to_pos(end);
-  return m_char_data->str().substr(a, b - a);
+  return str().substr(a, b - a);
+}
+
+auto Str::concat(Str *a, Str *b) -> Str* {
+  auto size = a->size() + b->size();
+  if (!a->size()) return b;
+  if (!b->size()) return a;
+  if (size < ROPE_MIN_SIZE || size > s_max_size) {
+    return make(a->str() + b->str());
+  }
+  auto rope = new Rope;
+  rope->left = a->retain();
+  rope->right = b->retain();
+  rope->size = size;
+  return new Str(rope);
+}
+
+auto Str::flatten() const -> Str* {
+  if (!m_rope) return const_cast<Str*>(this);
+  if (!m_rope->flat) {
+    std::string buf;
+    buf.reserve(m_rope->size);
+
+    // Walk from left to right without recursion as ropes
+    // built up in a loop can be arbitrarily deep
+    std::vector<const Str*> stack;
+    stack.push_back(this);
+    while (!stack.empty()) {
+      auto s = stack.back();
+      stack.pop_back();
+      if (auto r = s->m_rope) {
+        if (r->flat) {
+          buf += r->flat->str();
+        } else {
+          stack.push_back(r->right);
+          stack.push_back(r->left);
+        }
+      } else {
+        buf += s->str();
+      }
+    }
+
+    auto rope = m_rope;
+    rope->flat = make(std::move(buf))->retain();
+    release_later(rope->left);
+    release_later(rope->right);
+    rope->left = nullptr;
+    rope->right = nullptr;
+  }
+  return m_rope->flat;
+}
+
+void Str::free_rope(Rope *rope) {
+  release_later(rope->left);
+  release_later(rope->right);
+  release_later(rope->flat);
+  delete rope;
+}
+
+//
+// Releasing a deep rope would recurse as deep as the rope itself,
+// so the nodes are queued and released one at a time
+//
+
+void Str::release_later(Str *str) {
+  thread_local static std::vector<Str*> *s_queue = nullptr;
+  thread_local static bool s_releasing = false;
+  if (!str) return;
+  if (!s_queue) s_queue = new std::vector<Str*>;
+  s_queue->push_back(str);
+  if (s_releasing) return;
+  s_releasing = true;
+  while (!s_queue->empty()) {
+    auto s = s_queue->back();
+    s_queue->pop_back();
+    s->release();
+  }
+  s_releasing = false;
 }
 
 //
 // Str::CharData
 //
 
-Str::CharData::CharData(std::string &&str) : m_str(std::move(str)) {
+void Str::CharData::build_index() const {
+  bool ascii = true;
+  for (const auto c : m_str) {
+    if (c & 0x80) {
+      ascii = false;
+      break;
+    }
+  }
+
+  if (ascii) {
+    m_ascii = true;
+    m_length = m_str.length();
+    return;
+  }
+
   int n = 0, p = 0, i = 0;
   Utf8Decoder decoder(
     [&](int cp) {
@@ -293,9 +384,11 @@ Str::CharData::CharData(std::string &&str) : m_str(std::move(str)) {
 }
 
 auto Str::CharData::pos_to_chr(int i) const -> int {
+  index();
   int p = 0, n = 0;
   if (i >= size()) return m_length;
   if (i < 0) i = 0;
+  if (m_ascii) return i;
   if (!m_chunks.empty() && i >= m_chunks[0]) {
     int a = 0, b = m_chunks.size();
     while (a + 1 < b) {
@@ -335,6 +428,8 @@ auto Str::CharData::pos_to_chr(int i) const -> int {
 }
 
 auto Str::CharData::chr_to_pos(int i) const -> int {
+  index();
+  if (m_ascii) return std::max(0, std::min(i, int(size())));
   int chk = i / CHUNK_SIZE;
   int off = i % CHUNK_SIZE;
   int min, max;
@@ -888,6 +983,14 @@ void SharedValue::from_value(const Value &v) {
   }
 }
 
+void SharedValue::retain() const {
+  switch (m_t) {
+    case Value::Type::String: m_v.s->retain(); break;
+    case Value::Type::Object: if (auto o = m_v.o) o->retain(); break;
+    default: break;
+  }
+}
+
 void SharedValue::release() {
   switch (m_t) {
     case Value::Type::String: m_v.s->release(); break;
@@ -3268,7 +3371,7 @@ void Array::shift(Value &result) {
     if (auto size = m_data->size()) {
       auto *values = m_data->elements();
       values[0].~Value();
-      std::memmove(values, values + 1, (size - 1) * sizeof(Value));
+      std::memmove((void*)values, values + 1, (size - 1) * sizeof(Value));
       new (values + (size - 1)) Value(Value::empty);
     }
     m_size--;
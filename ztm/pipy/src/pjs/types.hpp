@@ -36,6 +36,7 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <regex>
 #include <stdexcept>
 #include <string>
@@ -140,6 +141,15 @@ public:
     return static_cast<T*>(this);
   }
 
+  // Retains only if the object is not already on its way to finalize()
+  bool try_retain() {
+    auto n = m_refs.load(std::memory_order_relaxed);
+    while (n > 0) {
+      if (m_refs.compare_exchange_weak(n, n + 1, std::memory_order_relaxed)) return true;
+    }
+    return false;
+  }
+
   void release() {
     if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
       static_cast<T*>(this)->finalize();
@@ -512,14 +522,12 @@ public:
     Pool(size_t alloc_size)
       : m_alloc_size(alloc_size) {}
 
-    auto alloc() -> PooledArrayBase* {
+    auto alloc() -> void* {
       if (auto p = m_free) {
         m_free = p->m_next;
         return p;
       } else {
-        p = (PooledArrayBase*)std::malloc(m_alloc_size);
-        p->m_pool = this;
-        return p;
+        return std::malloc(m_alloc_size);
       }
     }
 
@@ -537,8 +545,15 @@ public:
     m_pool->free(this);
   }
 
-private:
+protected:
+
+  // The pool is set by the constructor rather than by Pool::alloc(),
+  // since stores made before a placement new can be optimized away
+  PooledArrayBase(Pool *pool) : m_pool(pool) {}
+
   Pool* m_pool;
+
+private:
   PooledArrayBase* m_next;
 };
 
@@ -550,20 +565,19 @@ template<class T>
 class PooledArray : public PooledArrayBase {
 public:
   static auto make(size_t size) -> PooledArray* {
-    auto p = alloc(size);
-    new (p) PooledArray(size);
-    return p;
+    auto pool = pool_of_size(size);
+    return new (pool->alloc()) PooledArray(pool, size);
   }
 
   static auto make(size_t size, const T &initial) -> PooledArray* {
-    auto p = alloc(size);
-    new (p) PooledArray(size, initial);
-    return p;
+    auto pool = pool_of_size(size);
+    return new (pool->alloc()) PooledArray(pool, size, initial);
   }
 
   void free() {
+    auto pool = m_pool;
     this->~PooledArray();
-    recycle();
+    pool->free(this);
   }
 
   auto size() const -> size_t {
@@ -586,13 +600,13 @@ private:
   size_t m_size;
   T m_elements[0];
 
-  PooledArray(size_t size) : m_size(size) {
+  PooledArray(Pool *pool, size_t size) : PooledArrayBase(pool), m_size(size) {
     for (size_t i = 0; i < size; i++) {
       new (m_elements + i) T();
     }
   }
 
-  PooledArray(size_t size, const T &initial) : m_size(size) {
+  PooledArray(Pool *pool, size_t size, const T &initial) : PooledArrayBase(pool), m_size(size) {
     for (size_t i = 0; i < size; i++) {
       new (m_elements + i) T(initial);
     }
@@ -604,13 +618,13 @@ private:
     }
   }
 
-  static auto alloc(size_t size) -> PooledArray* {
+  static auto pool_of_size(size_t size) -> Pool* {
     auto &pools = m_pools;
     auto slot = slot_of_size(size);
     for (auto i = pools.size(); i <= slot; i++) {
       pools.emplace_back(new Pool(sizeof(PooledArray) + sizeof(T) * size_of_slot(i)));
     }
-    return static_cast<PooledArray*>(pools[slot]->alloc());
+    return pools[slot].get();
   }
 
   static auto slot_of_size(size_t size) -> size_t {
@@ -802,7 +816,7 @@ public:
     auto str() const -> const std::string& { return m_str; }
     auto c_str() const -> const char * { return m_str.c_str(); }
     auto size() const -> size_t { return m_str.length(); }
-    auto length() const -> int { return m_length; }
+    auto length() const -> int { index(); return m_length; }
 
     auto pos_to_chr(int i) const -> int;
     auto chr_to_pos(int i) const -> int;
@@ -811,12 +825,23 @@ public:
   private:
     enum { CHUNK_SIZE = 32 };
 
-    CharData(std::string &&str);
+    CharData(std::string &&str) : m_str(std::move(str)) {}
     ~CharData() {}
 
+    //
+    // The character index is only built when it's first needed,
+    // since most strings are never indexed by character position.
+    // Strings of pure ASCII need no index at all.
+    //
+
     const std::string m_str;
-    int m_length;
-    std::vector<uint32_t> m_chunks;
+    mutable std::once_flag m_index_once;
+    mutable int m_length = 0;
+    mutable bool m_ascii = false;
+    mutable std::vector<uint32_t> m_chunks;
+
+    void index() const { std::call_once(m_index_once, [this]() { build_index(); }); }
+    void build_index() const;
 
     friend class RefCountMT<CharData>;
     friend class Str;
@@ -863,15 +888,32 @@ public:
   static auto make(int64_t n) -> Str*;
   static auto make(uint64_t n) -> Str*;
 
-  auto length() const -> int { return m_char_data->length(); }
-  auto size() const -> size_t { return m_char_data->size(); }
-  auto data() const -> CharData* { return m_char_data; }
-  auto str() const -> const std::string& { return m_char_data->str(); }
-  auto c_str() const -> const char* { return m_char_data->c_str(); }
+  //
+  // Concatenation of long strings makes a rope that only refers to
+  // both sides. It is flattened and interned when its content is
+  // first accessed, so building a string piece by piece stays linear.
+  // Ropes are never interned, so they must be flattened before being
+  // compared by pointer, which Value::s() always does. The flattened
+  // string is kept by the rope, so a Value holding a rope is left as is
+  // and its s() stays valid for as long as the Value.
+  //
+
+  enum { ROPE_MIN_SIZE = 256 };
 
-  auto pos_to_chr(int i) const -> int { return m_char_data->pos_to_chr(i); }
-  auto chr_to_pos(int i) const -> int { return m_char_data->chr_to_pos(i); }
-  auto chr_at(int i) const -> int { return m_char_data->chr_at(i); }
+  static auto concat(Str *a, Str *b) -> Str*;
+
+  bool is_rope() const { return m_rope; }
+  auto flatten() const -> Str*;
+
+  auto length() const -> int { return chars()->length(); }
+  auto size() const -> size_t { return m_rope ? m_rope->size : m_char_data->size(); }
+  auto data() const -> CharData* { return chars(); }
+  auto str() const -> const std::string& { return chars()->str(); }
+  auto c_str() const -> const char* { return chars()->c_str(); }
+
+  auto pos_to_chr(int i) const -> int { return chars()->pos_to_chr(i); }
+  auto chr_to_pos(int i) const -> int { return chars()->chr_to_pos(i); }
+  auto chr_at(int i) const -> int { return chars()->chr_at(i); }
 
   auto parse_int(int base = 10) const -> double;
   bool parse_int64(int64_t &i, int base = 10);
@@ -912,7 +954,19 @@ private:
     bool m_destructed = false;
   };
 
+  //
+  // Str::Rope
+  //
+
+  struct Rope : public Pooled<Rope> {
+    Str* left;
+    Str* right;
+    Str* flat = nullptr;
+    size_t size;
+  };
+
   Ref<CharData> m_char_data;
+  Rope* m_rope = nullptr;
 
 #ifdef PIPY_ASSERT_SAME_THREAD
   std::thread::id m_thread_id;
@@ -930,13 +984,32 @@ private:
   Str(const std::string &str) : Str(new CharData(std::string(str))) {}
   Str(std::string &&str) : Str(new CharData(std::move(str))) {}
 
+  Str(Rope *rope)
+    : m_rope(rope)
+#ifdef PIPY_ASSERT_SAME_THREAD
+    , m_thread_id(std::this_thread::get_id())
+#endif
+  {
+  }
+
   ~Str() {
     assert_same_thread(*this);
-    local_map().erase(m_char_data->str());
+    if (m_rope) {
+      free_rope(m_rope);
+    } else {
+      local_map().erase(m_char_data->str());
+    }
+  }
+
+  auto chars() const -> CharData* {
+    return m_rope ? flatten()->m_char_data.get() : m_char_data.get();
   }
 
   static size_t s_max_size;
 
+  static void free_rope(Rope *rope);
+  static void release_later(Str *str);
+
   static auto local_map() -> LocalMap&;
 
   static void assert_same_thread(const Str &str) {
@@ -1428,7 +1501,8 @@ public:
   auto type() const -> Type { return m_t; }
   auto b() const -> bool { return m_v.b; }
   auto n() const -> double { return m_v.n; }
-  auto s() const -> Str* { return m_v.s; }
+  auto s() const -> Str* { return (m_t == Type::String && m_v.s->is_rope()) ? m_v.s->flatten() : m_v.s; }
+  auto s_lazy() const -> Str* { return m_v.s; } // may be a rope, see Str::concat()
   auto o() const -> Object* { return m_v.o; }
   auto f() const -> Function*;
 
@@ -1559,7 +1633,7 @@ private:
     m_t = v.m_t;
     m_v = v.m_v;
     switch (m_t) {
-      case Type::String: s()->retain(); break;
+      case Type::String: m_v.s->retain(); break;
       case Type::Object: if (o()) retain(o()); break;
       default: break;
     }
@@ -1914,9 +1988,11 @@ class SharedValue {
 public:
   SharedValue() : m_t(Value::Type::Empty) {}
   SharedValue(const Value &v) { from_value(v); }
+  SharedValue(const SharedValue &r) : m_t(r.m_t), m_v(r.m_v) { retain(); }
   ~SharedValue() { release(); }
 
   auto operator=(const Value &v) -> SharedValue& { release(); from_value(v); return *this; }
+  auto operator=(const SharedValue &r) -> SharedValue& { r.retain(); release(); m_t = r.m_t; m_v = r.m_v; return *this; }
   void to_value(Value &v) const;
 
 private:
@@ -1929,6 +2005,7 @@ private:
   } m_v;
 
   void from_value(const Value &v);
+  void retain() const;
   void release();
 };
 
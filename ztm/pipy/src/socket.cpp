@@ -26,8 +26,21 @@
 #include "socket.hpp"
 #include "log.hpp"
 
+#include <cstring>
 #include <errno.h>
 
+#ifdef __linux__
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/udp.h>
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+#endif // __linux__
+
 namespace pipy {
 
 using tcp = asio::ip::tcp;
@@ -373,6 +386,10 @@ void SocketUDP::open() {
   m_endpoint = m_socket.local_endpoint();
   m_opened = true;
 
+#ifdef __linux__
+  setup_offload();
+#endif
+
   if (!m_buffer.empty()) {
     m_buffer.flush(
       [this](Event *evt) {
@@ -419,60 +436,43 @@ void SocketUDP::output(Event *evt, Peer *peer) {
   }
 }
 
-void SocketUDP::receive() {
-  if (m_closing) return;
-  if (m_receiving) return;
-  if (m_paused) return;
-
-  auto *buf = Data::make(RECEIVE_BUFFER_SIZE, &s_dp);
-  buf->retain();
-
-  m_socket.async_receive_from(
-    DataChunks(buf->chunks()),
-    m_from,
-    ReceiveHandler(this, buf)
-  );
-
-  m_receiving = true;
-}
-
-void SocketUDP::send(Data *data) {
-  if (m_closing) return;
-
-  data->retain();
-  m_sending_size += data->size();
-  m_sending_count++;
+void SocketUDP::input(Data *data, const udp::endpoint &from) {
+  auto size = data->size();
+  m_traffic_read += size;
 
   if (Log::is_enabled(Log::UDP)) {
     std::cerr << Log::format_elapsed_time();
-    std::cerr << (m_is_inbound ? " udp <<<< send " : " udp send >>>> ");
-    std::cerr << data->size() << std::endl;
+    std::cerr << (m_is_inbound ? " udp >>>> recv " : " udp recv <<<< ");
+    std::cerr << size << std::endl;
   }
 
-  m_socket.async_send(
-    DataChunks(data->chunks()),
-    SendHandler(this, data)
-  );
-}
-
-void SocketUDP::send(Data *data, const asio::ip::udp::endpoint &endpoint) {
-  if (m_closed) return;
-
-  data->retain();
-  m_sending_size += data->size();
-  m_sending_count++;
-
-  if (Log::is_enabled(Log::UDP)) {
-    std::cerr << Log::format_elapsed_time();
-    std::cerr << (m_is_inbound ? " udp <<<< send " : " udp send >>>> ");
-    std::cerr << data->size() << std::endl;
+  Peer *peer = nullptr;
+  auto i = m_peers.find(from);
+  if (i == m_peers.end()) {
+    peer = on_socket_new_peer();
+    if (peer) {
+      peer->m_socket = this;
+      peer->m_endpoint = from;
+      peer->m_tick_write = Ticker::get()->tick();
+      m_peers[from] = peer;
+      peer->on_peer_open();
+      if (peer->m_closed) {
+        peer->on_peer_close();
+        peer = nullptr;
+      } else {
+        peer->m_opened = true;
+      }
+    }
+  } else {
+    peer = i->second;
   }
 
-  m_socket.async_send_to(
-    DataChunks(data->chunks()),
-    endpoint,
-    SendHandler(this, data)
-  );
+  if (peer) {
+    peer->m_tick_read = Ticker::get()->tick();
+    peer->on_peer_input(data);
+  } else {
+    on_socket_input(data);
+  }
 }
 
 void SocketUDP::close_peers(StreamEnd::Error err) {
@@ -525,50 +525,461 @@ void SocketUDP::on_tick(double tick) {
   }
 }
 
-void SocketUDP::on_receive(Data *data, const std::error_code &ec, std::size_t n) {
-  InputContext ic(this);
+#ifdef __linux__
 
-  m_receiving = false;
+//
+// On Linux, datagrams are moved in batches with recvmmsg() and sendmmsg(),
+// and when the kernel supports it, runs of datagrams to or from the
+// same peer are coalesced into one buffer by UDP_GRO and UDP_SEGMENT.
+// Received datagrams are shifted out of a set of receiving slots, so
+// splitting a coalesced buffer into per-peer events only moves views.
+//
 
-  if (ec != asio::error::operation_aborted && !m_closing) {
-    if (n > 0) {
-      data->pop(data->size() - n);
-      auto size = data->size();
-      m_traffic_read += size;
+// Largest UDP payload any IP version can carry without jumbograms
+static const size_t s_max_datagram_size = 0xffff - 8;
 
-      if (Log::is_enabled(Log::UDP)) {
-        std::cerr << Log::format_elapsed_time();
-        std::cerr << (m_is_inbound ? " udp >>>> recv " : " udp recv <<<< ");
-        std::cerr << size << std::endl;
+void SocketUDP::setup_offload() {
+  auto fd = m_socket.native_handle();
+  int on = 1;
+  int segment = 0;
+  socklen_t len = sizeof(segment);
+  m_gro = (setsockopt(fd, IPPROTO_UDP, UDP_GRO, &on, sizeof(on)) == 0);
+  m_gso = (getsockopt(fd, IPPROTO_UDP, UDP_SEGMENT, &segment, &len) == 0);
+}
+
+void SocketUDP::receive() {
+  if (m_closing) return;
+  if (m_receiving) return;
+  if (m_paused) return;
+
+  // Readiness is edge-triggered, so read
+  // whatever is already there before waiting
+  asio::post(m_socket.get_executor(), ReceiveHandler(this));
+
+  m_receiving = true;
+}
+
+void SocketUDP::send(Data *data) {
+  if (m_closing) return;
+  queue(data, nullptr);
+}
+
+void SocketUDP::send(Data *data, const udp::endpoint &endpoint) {
+  if (m_closed) return;
+  queue(data, &endpoint);
+}
+
+void SocketUDP::queue(Data *data, const udp::endpoint *endpoint) {
+  if (data->size() > s_max_datagram_size) {
+    log_warn("datagram dropped", std::error_code(EMSGSIZE, std::system_category()));
+    return;
+  }
+
+  data->retain();
+  m_sending_size += data->size();
+  m_sending_count++;
+
+  if (Log::is_enabled(Log::UDP)) {
+    std::cerr << Log::format_elapsed_time();
+    std::cerr << (m_is_inbound ? " udp <<<< send " : " udp send >>>> ");
+    std::cerr << data->size() << std::endl;
+  }
+
+  m_sending.emplace_back();
+  auto &s = m_sending.back();
+  s.data = data;
+  s.has_endpoint = (endpoint != nullptr);
+  if (endpoint) s.endpoint = *endpoint;
+
+  if (!m_waiting_write) {
+    if (InputContext::origin()) {
+      FlushTarget::need_flush();
+    } else {
+      on_flush();
+    }
+  }
+}
+
+void SocketUDP::on_flush() {
+  if (m_waiting_write) return;
+  if (m_closing) {
+    drop_sending();
+  } else if (auto err = send_batch()) {
+    on_error("error writing to peers", std::error_code(err, std::system_category()), StreamEnd::WRITE_ERROR);
+    drop_sending();
+  }
+  close_async();
+}
+
+auto SocketUDP::receive_batch() -> int {
+  static const size_t max_iov = UDP_GRO_BUFFER_SIZE / DATA_CHUNK_SIZE + 1;
+
+  mmsghdr msgs[UDP_BATCH_SIZE];
+  iovec iovs[UDP_BATCH_SIZE][max_iov];
+  udp::endpoint from[UDP_BATCH_SIZE];
+  char cmsgs[UDP_BATCH_SIZE][CMSG_SPACE(sizeof(int))];
+
+  auto fd = m_socket.native_handle();
+  auto slot_size = m_gro ? UDP_GRO_BUFFER_SIZE : RECEIVE_BUFFER_SIZE;
+  auto max_batch = m_gro ? UDP_BATCH_SIZE / 4 : UDP_BATCH_SIZE;
+
+  for (;;) {
+    auto batch = m_receive_batch;
+    if (m_receive_slots.size() < batch) m_receive_slots.resize(batch);
+
+    for (size_t i = 0; i < batch; i++) {
+      auto &slot = m_receive_slots[i];
+      if (slot.size() < slot_size) {
+        slot.push(Data(slot_size - slot.size(), &s_dp));
+      }
+      size_t n = 0;
+      for (const auto c : slot.chunks()) {
+        if (n >= max_iov) break;
+        iovs[i][n].iov_base = std::get<0>(c);
+        iovs[i][n].iov_len = std::get<1>(c);
+        n++;
       }
+      auto &hdr = msgs[i].msg_hdr;
+      hdr.msg_name = from[i].data();
+      hdr.msg_namelen = from[i].capacity();
+      hdr.msg_iov = iovs[i];
+      hdr.msg_iovlen = n;
+      hdr.msg_control = m_gro ? cmsgs[i] : nullptr;
+      hdr.msg_controllen = m_gro ? sizeof(cmsgs[i]) : 0;
+      hdr.msg_flags = 0;
+      msgs[i].msg_len = 0;
+    }
+
+    auto r = recvmmsg(fd, msgs, batch, MSG_DONTWAIT, nullptr);
+    if (r < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+      return errno;
+    }
 
-      Peer *peer = nullptr;
-      auto i = m_peers.find(m_from);
-      if (i == m_peers.end()) {
-        peer = on_socket_new_peer();
-        if (peer) {
-          peer->m_socket = this;
-          peer->m_endpoint = m_from;
-          peer->m_tick_write = Ticker::get()->tick();
-          m_peers[m_from] = peer;
-          peer->on_peer_open();
-          if (peer->m_closed) {
-            peer->on_peer_close();
-            peer = nullptr;
-          } else {
-            peer->m_opened = true;
+    for (int i = 0; i < r; i++) {
+      auto &hdr = msgs[i].msg_hdr;
+      auto len = msgs[i].msg_len;
+      from[i].resize(hdr.msg_namelen);
+
+      int segment = 0;
+      if (m_gro) {
+        for (auto *c = CMSG_FIRSTHDR(&hdr); c; c = CMSG_NXTHDR(&hdr, c)) {
+          if (c->cmsg_level == IPPROTO_UDP && c->cmsg_type == UDP_GRO) {
+            std::memcpy(&segment, CMSG_DATA(c), sizeof(segment));
+            break;
           }
         }
-      } else {
-        peer = i->second;
       }
 
-      if (peer) {
-        peer->m_tick_read = Ticker::get()->tick();
-        peer->on_peer_input(data);
-      } else {
-        on_socket_input(data);
+      Data data;
+      m_receive_slots[i].shift(len, data);
+
+      if (segment > 0 && len > (unsigned)segment) {
+        while (!data.empty()) {
+          Data seg;
+          data.shift(segment, seg);
+          input(Data::make(std::move(seg)), from[i]);
+          if (m_closing) return 0;
+        }
+      } else if (len > 0) {
+        input(Data::make(std::move(data)), from[i]);
+        if (m_closing) return 0;
+      }
+    }
+
+    // Grow the batch only for sockets that keep filling it up
+    if (size_t(r) < batch) return 0;
+    if (batch >= max_batch) return -1;
+    m_receive_batch = std::min(batch * 2, max_batch);
+  }
+}
+
+auto SocketUDP::send_batch() -> int {
+  static const size_t max_iov = 1024;
+
+  mmsghdr msgs[UDP_BATCH_SIZE];
+  iovec iovs[max_iov];
+  size_t counts[UDP_BATCH_SIZE];
+  char cmsgs[UDP_BATCH_SIZE][CMSG_SPACE(sizeof(uint16_t))];
+
+  auto fd = m_socket.native_handle();
+
+  while (m_sending_head < m_sending.size()) {
+    size_t i = m_sending_head;
+    size_t m = 0;
+    size_t n = 0;
+    bool segmented = false;
+
+    while (m < UDP_BATCH_SIZE && i < m_sending.size()) {
+      const auto &first = m_sending[i];
+      auto segment_size = first.data->size();
+      auto n0 = n;
+      auto i0 = i;
+      size_t total = 0;
+      size_t last = 0;
+
+      // Coalesce a run of equal-sized datagrams to the same peer,
+      // where only the last one is allowed to be shorter
+      do {
+        auto &s = m_sending[i];
+        size_t views = 0;
+        for (const auto c : s.data->chunks()) { (void)c; views++; }
+        if (views > max_iov) {
+          // Too scattered for one message, so copy it into whole chunks
+          auto buf = s.data->to_bytes();
+          auto *data = Data::make(buf.data(), buf.size(), &s_dp);
+          data->retain();
+          s.data->release();
+          s.data = data;
+          views = 0;
+          for (const auto c : s.data->chunks()) { (void)c; views++; }
+        }
+        if (n + views > max_iov) break;
+        for (const auto c : s.data->chunks()) {
+          iovs[n].iov_base = std::get<0>(c);
+          iovs[n].iov_len = std::get<1>(c);
+          n++;
+        }
+        last = s.data->size();
+        total += last;
+        i++;
+      } while (
+        m_gso && i < m_sending.size() &&
+        i - i0 < UDP_GSO_MAX_SEGMENTS &&
+        last == segment_size &&
+        m_sending[i].data->size() <= segment_size &&
+        m_sending[i].has_endpoint == first.has_endpoint &&
+        (!first.has_endpoint || m_sending[i].endpoint == first.endpoint) &&
+        total + m_sending[i].data->size() <= UDP_GSO_MAX_SIZE
+      );
+
+      if (i == i0) break;
+
+      auto &hdr = msgs[m].msg_hdr;
+      auto &ep = m_sending[i0].endpoint;
+      hdr.msg_name = first.has_endpoint ? ep.data() : nullptr;
+      hdr.msg_namelen = first.has_endpoint ? ep.size() : 0;
+      hdr.msg_iov = iovs + n0;
+      hdr.msg_iovlen = n - n0;
+      hdr.msg_control = nullptr;
+      hdr.msg_controllen = 0;
+      hdr.msg_flags = 0;
+      msgs[m].msg_len = 0;
+
+      if (i - i0 > 1) {
+        uint16_t size = segment_size;
+        hdr.msg_control = cmsgs[m];
+        hdr.msg_controllen = sizeof(cmsgs[m]);
+        auto *c = CMSG_FIRSTHDR(&hdr);
+        c->cmsg_level = IPPROTO_UDP;
+        c->cmsg_type = UDP_SEGMENT;
+        c->cmsg_len = CMSG_LEN(sizeof(size));
+        std::memcpy(CMSG_DATA(c), &size, sizeof(size));
+        segmented = true;
+      }
+
+      counts[m++] = i - i0;
+    }
+
+    auto r = sendmmsg(fd, msgs, m, MSG_DONTWAIT);
+    if (r < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        m_waiting_write = true;
+        m_socket.async_wait(udp::socket::wait_write, SendHandler(this));
+        return 0;
+      }
+      if (segmented && (errno == EIO || errno == EINVAL)) {
+        m_gso = false;
+        continue;
       }
+      if (errno == EMSGSIZE) {
+        // Drop the oversized message rather than failing the whole socket
+        log_warn("datagram dropped", std::error_code(errno, std::system_category()));
+        for (size_t k = 0; k < counts[0]; k++) {
+          drop(m_sending[m_sending_head++]);
+        }
+        continue;
+      }
+      return errno;
+    }
+
+    for (int j = 0; j < r; j++) {
+      for (size_t k = 0; k < counts[j]; k++) {
+        sent(m_sending[m_sending_head++]);
+      }
+    }
+  }
+
+  m_sending.clear();
+  m_sending_head = 0;
+  return 0;
+}
+
+void SocketUDP::sent(const Sending &s) {
+  auto data = s.data;
+  m_sending_count--;
+  m_sending_size -= data->size();
+  m_traffic_write += data->size();
+
+  auto limit = m_options.congestion_limit;
+  if (limit > 0 && m_sending_size < limit) {
+    m_congestion.end();
+  }
+
+  data->release();
+}
+
+void SocketUDP::drop(const Sending &s) {
+  auto data = s.data;
+  m_sending_count--;
+  m_sending_size -= data->size();
+
+  auto limit = m_options.congestion_limit;
+  if (limit > 0 && m_sending_size < limit) {
+    m_congestion.end();
+  }
+
+  data->release();
+}
+
+void SocketUDP::drop_sending() {
+  for (auto i = m_sending_head; i < m_sending.size(); i++) {
+    m_sending[i].data->release();
+    m_sending_count--;
+  }
+  m_sending.clear();
+  m_sending_head = 0;
+  m_sending_size = 0;
+}
+
+void SocketUDP::on_receive(const std::error_code &ec) {
+  InputContext ic(this);
+
+  if (ec == asio::error::operation_aborted || m_closing) {
+    m_receiving = false;
+
+  } else if (ec) {
+    m_receiving = false;
+    on_error("error reading from peers", ec, StreamEnd::READ_ERROR);
+
+  } else if (m_paused) {
+    m_receiving = false;
+
+  } else {
+    auto err = receive_batch();
+    if (m_closing) {
+      m_receiving = false;
+    } else if (err > 0) {
+      m_receiving = false;
+      on_error("error reading from peers", std::error_code(err, std::system_category()), StreamEnd::READ_ERROR);
+    } else if (err < 0) {
+      // The batch is full, so yield to other sockets before reading on
+      asio::post(m_socket.get_executor(), ReceiveHandler(this));
+    } else {
+      m_socket.async_wait(udp::socket::wait_read, ReceiveHandler(this));
+    }
+  }
+
+  close_async();
+}
+
+void SocketUDP::on_send(const std::error_code &ec) {
+  InputContext ic;
+
+  m_waiting_write = false;
+
+  if (ec == asio::error::operation_aborted || m_closing) {
+    drop_sending();
+  } else if (ec) {
+    on_error("error writing to peers", ec, StreamEnd::WRITE_ERROR);
+    drop_sending();
+  } else if (auto err = send_batch()) {
+    on_error("error writing to peers", std::error_code(err, std::system_category()), StreamEnd::WRITE_ERROR);
+    drop_sending();
+  }
+
+  close_async();
+}
+
+void SocketUDP::on_error(const char *msg, const std::error_code &ec, StreamEnd::Error err) {
+  log_warn(msg, ec);
+  m_closing = true;
+  close_peers(err);
+  close_socket();
+}
+
+#else // !__linux__
+
+void SocketUDP::receive() {
+  if (m_closing) return;
+  if (m_receiving) return;
+  if (m_paused) return;
+
+  auto *buf = Data::make(RECEIVE_BUFFER_SIZE, &s_dp);
+  buf->retain();
+
+  m_socket.async_receive_from(
+    DataChunks(buf->chunks()),
+    m_from,
+    ReceiveHandler(this, buf)
+  );
+
+  m_receiving = true;
+}
+
+void SocketUDP::send(Data *data) {
+  if (m_closing) return;
+
+  data->retain();
+  m_sending_size += data->size();
+  m_sending_count++;
+
+  if (Log::is_enabled(Log::UDP)) {
+    std::cerr << Log::format_elapsed_time();
+    std::cerr << (m_is_inbound ? " udp <<<< send " : " udp send >>>> ");
+    std::cerr << data->size() << std::endl;
+  }
+
+  m_socket.async_send(
+    DataChunks(data->chunks()),
+    SendHandler(this, data)
+  );
+}
+
+void SocketUDP::send(Data *data, const asio::ip::udp::endpoint &endpoint) {
+  if (m_closed) return;
+
+  data->retain();
+  m_sending_size += data->size();
+  m_sending_count++;
+
+  if (Log::is_enabled(Log::UDP)) {
+    std::cerr << Log::format_elapsed_time();
+    std::cerr << (m_is_inbound ? " udp <<<< send " : " udp send >>>> ");
+    std::cerr << data->size() << std::endl;
+  }
+
+  m_socket.async_send_to(
+    DataChunks(data->chunks()),
+    endpoint,
+    SendHandler(this, data)
+  );
+}
+
+void SocketUDP::on_flush() {
+}
+
+void SocketUDP::on_receive(Data *data, const std::error_code &ec, std::size_t n) {
+  InputContext ic(this);
+
+  m_receiving = false;
+
+  if (ec != asio::error::operation_aborted && !m_closing) {
+    if (n > 0) {
+      data->pop(data->size() - n);
+      input(data, m_from);
     }
 
     if (ec) {
@@ -610,6 +1021,8 @@ void SocketUDP::on_send(Data *data, const std::error_code &ec, std::size_t n) {
   close_async();
 }
 
+#endif // __linux__
+
 //
 // SocketUDP::Peer
 //
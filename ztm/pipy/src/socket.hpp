@@ -33,6 +33,8 @@
 #include "buffer.hpp"
 #include "timer.hpp"
 
+#include <vector>
+
 namespace pipy {
 
 //
@@ -155,6 +157,7 @@ private:
 class SocketUDP :
   public SocketBase,
   public InputSource,
+  public FlushTarget,
   public Ticker::Watcher
 {
 public:
@@ -194,6 +197,7 @@ public:
 protected:
   SocketUDP(bool is_inbound, const Options &options)
     : SocketBase(is_inbound, options)
+    , FlushTarget(true)
     , m_socket(Net::context()) {}
 
   ~SocketUDP();
@@ -206,6 +210,17 @@ protected:
   void output(Event *evt);
 
 private:
+
+  //
+  // SocketUDP::Sending
+  //
+
+  struct Sending {
+    Data* data;
+    asio::ip::udp::endpoint endpoint;
+    bool has_endpoint;
+  };
+
   virtual auto on_socket_new_peer() -> Peer* = 0;
 
   asio::ip::udp::socket m_socket;
@@ -216,6 +231,13 @@ private:
   Congestion m_congestion;
   int m_sending_size = 0;
   int m_sending_count = 0;
+  std::vector<Data> m_receive_slots;
+  std::vector<Sending> m_sending;
+  size_t m_sending_head = 0;
+  size_t m_receive_batch = 1;
+  bool m_gro = false;
+  bool m_gso = false;
+  bool m_waiting_write = false;
   bool m_receiving = false;
   bool m_opened = false;
   bool m_paused = false;
@@ -223,6 +245,7 @@ private:
   bool m_closed = false;
 
   void output(Event *evt, Peer *peer);
+  void input(Data *data, const asio::ip::udp::endpoint &from);
   void receive();
   void send(Data *data);
   void send(Data *data, const asio::ip::udp::endpoint &endpoint);
@@ -232,8 +255,37 @@ private:
 
   virtual void on_tap_open() override;
   virtual void on_tap_close() override;
+  virtual void on_flush() override;
   virtual void on_tick(double tick) override;
 
+#ifdef __linux__
+
+  void setup_offload();
+  void queue(Data *data, const asio::ip::udp::endpoint *endpoint);
+  auto receive_batch() -> int;
+  auto send_batch() -> int;
+  void sent(const Sending &s);
+  void drop(const Sending &s);
+  void drop_sending();
+  void on_receive(const std::error_code &ec);
+  void on_send(const std::error_code &ec);
+  void on_error(const char *msg, const std::error_code &ec, StreamEnd::Error err);
+
+  struct ReceiveHandler : public SelfHandler<SocketUDP> {
+    using SelfHandler::SelfHandler;
+    ReceiveHandler(const ReceiveHandler &r) : SelfHandler(r) {}
+    void operator()() { self->on_receive(std::error_code()); }
+    void operator()(const std::error_code &ec) { self->on_receive(ec); }
+  };
+
+  struct SendHandler : public SelfHandler<SocketUDP> {
+    using SelfHandler::SelfHandler;
+    SendHandler(const SendHandler &r) : SelfHandler(r) {}
+    void operator()(const std::error_code &ec) { self->on_send(ec); }
+  };
+
+#else // !__linux__
+
   void on_receive(Data *data, const std::error_code &ec, std::size_t n);
   void on_send(Data *data, const std::error_code &ec, std::size_t n);
 
@@ -249,6 +301,8 @@ private:
     void operator()(const std::error_code &ec, std::size_t n) { self->on_send(data, ec, n); }
   };
 
+#endif // __linux__
+
   static Data::Producer s_dp;
 };
 
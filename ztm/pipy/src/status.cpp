@@ -25,6 +25,7 @@
 
 #include "status.hpp"
 #include "buffer.hpp"
+#include "filter.hpp"
 #include "worker.hpp"
 #include "worker-thread.hpp"
 #include "module.hpp"
@@ -68,6 +69,8 @@ public:
     version,
     modules,
     graph,
+    parseTime,
+    compileTime,
     metrics,
     logs,
   };
@@ -91,8 +94,8 @@ private:
   int m_depth = 0;
   bool m_capturing = false;
   bool m_capturing_list_start = false;
-  Data::Builder m_capture;
   Data m_capture_buffer;
+  Data::Builder m_capture;
   std::string m_current_module;
 
   virtual void null() override {
@@ -115,6 +118,8 @@ private:
       char str[100];
       auto len = std::snprintf(str, sizeof(str), "%lld", (long long)i);
       m_capture.push(str, len);
+    } else if (m_depth == 3) {
+      module_time(i);
     } else if (m_depth == 1) {
       switch (m_stack[1].key) {
         case Key::timestamp: m_status.timestamp = i; break;
@@ -131,6 +136,8 @@ private:
       char str[100];
       auto len = pjs::Number::to_string(str, sizeof(str), n);
       m_capture.push(str, len);
+    } else if (m_depth == 3) {
+      module_time(n);
     } else if (m_depth == 1) {
       switch (m_stack[1].key) {
         case Key::timestamp: m_status.timestamp = n; break;
@@ -239,6 +246,16 @@ private:
     }
   }
 
+  void module_time(double t) {
+    auto i = m_status.modules.find({ m_current_module });
+    if (i == m_status.modules.end()) return;
+    if (is_at(Key::modules, Key::unknown, Key::parseTime)) {
+      i->parse_time = t;
+    } else if (is_at(Key::modules, Key::unknown, Key::compileTime)) {
+      i->compile_time = t;
+    }
+  }
+
   bool is_at(Key k1) {
     return m_depth == 1 && m_stack[1].key == k1;
   }
@@ -271,6 +288,8 @@ StatusDeserializer::KeyName StatusDeserializer::s_key_names[] = {
   { Key::version, "version" },
   { Key::modules, "modules" },
   { Key::graph, "graph" },
+  { Key::parseTime, "parseTime" },
+  { Key::compileTime, "compileTime" },
   { Key::metrics, "metrics" },
   { Key::logs, "logs" },
   { Key::unknown, nullptr },
@@ -305,16 +324,19 @@ void Status::update_local() {
   objects.clear();
   chunks.clear();
   pipelines.clear();
+  filters.clear();
   buffers.clear();
   inbounds.clear();
   outbounds.clear();
 
   std::map<std::string, std::set<PipelineLayout*>> all_modules;
+  std::map<std::string, JSModule*> js_modules;
   PipelineLayout::for_each([&](PipelineLayout *p) {
     if (auto mod = dynamic_cast<JSModule*>(p->module())) {
       if (mod->worker() == Worker::current()) {
-        auto &set = all_modules[mod->filename()->str()];
-        set.insert(p);
+        auto &name = mod->filename()->str();
+        all_modules[name].insert(p);
+        js_modules[name] = mod;
       }
     }
   });
@@ -325,7 +347,8 @@ void Status::update_local() {
     std::string error;
     std::stringstream ss;
     g.to_json(error, ss);
-    modules.insert({ i.first, ss.str() });
+    auto mod = js_modules[i.first];
+    modules.insert({ i.first, ss.str(), mod->parse_time(), mod->compile_time() });
   }
 
   for (const auto &p : pjs::Pool::all()) {
@@ -383,6 +406,35 @@ void Status::update_local() {
     }
   });
 
+  PipelineLayout::for_each([&](PipelineLayout *p) {
+    auto mod = dynamic_cast<JSModule*>(p->module());
+    auto worker = mod ? mod->worker() : p->worker();
+    if (worker && worker != Worker::current()) return;
+    int index = 0;
+    p->for_each_filter([&](Filter *f) {
+      const auto &prof = f->profile();
+      if (prof.events > 0) {
+        const auto &loc = f->location();
+        Filter::Dump d;
+        f->dump(d);
+        filters.insert({
+          loc.source ? loc.source->filename : (mod ? mod->filename()->str() : std::string()),
+          p->name_or_label()->str(),
+          index,
+          d.name,
+          loc.line,
+          loc.column,
+          prof.events,
+          prof.bytes,
+          prof.callbacks,
+          prof.time,
+          prof.self_time,
+        });
+      }
+      index++;
+    });
+  });
+
   Listener::for_each([&](Listener *listener) {
     auto protocol = Protocol::UNKNOWN;
     switch (listener->protocol()) {
@@ -460,6 +512,7 @@ void Status::merge(const Status &other) {
   merge_sets(objects, other.objects);
   merge_sets(chunks, other.chunks);
   merge_sets(pipelines, other.pipelines);
+  merge_sets(filters, other.filters);
   merge_sets(buffers, other.buffers);
   merge_sets(inbounds, other.inbounds);
   merge_sets(outbounds, other.outbounds);
@@ -481,6 +534,12 @@ void Status::to_json(Data::Builder &db, Data *metrics) const {
     db.push(str, len);
   };
 
+  auto push_num = [&](double n) {
+    char str[100];
+    auto len = pjs::Number::to_string(str, sizeof(str), n);
+    db.push(str, len);
+  };
+
   auto push_str = [&](const std::string &s) {
     db.push('"');
     utils::escape(s, [&](char c) {
@@ -502,6 +561,8 @@ void Status::to_json(Data::Builder &db, Data *metrics) const {
     push_str(mod.filename);
     db.push(":{\"graph\":");
     db.push(mod.graph);
+    db.push(",\"parseTime\":"); push_num(mod.parse_time);
+    db.push(",\"compileTime\":"); push_num(mod.compile_time);
     db.push('}');
   }
   db.push('}');
@@ -566,6 +627,19 @@ static void print_table(Data::Builder &db, const T &header, const std::list<T> &
   }
 }
 
+void Status::dump_modules(Data::Builder &db) {
+  auto ms = [](double t) {
+    char str[100];
+    std::snprintf(str, sizeof(str), "%.3f", t);
+    return std::string(str);
+  };
+  std::list<std::array<std::string, 3>> rows;
+  for (const auto &i : modules) {
+    rows.push_back({ i.filename, ms(i.parse_time), ms(i.compile_time) });
+  }
+  print_table(db, { "MODULE", "PARSE(MS)", "COMPILE(MS)" }, rows);
+}
+
 void Status::dump_pools(Data::Builder &db) {
   std::list<std::array<std::string, 4>> rows;
   for (const auto &i : pools) {
@@ -625,6 +699,63 @@ void Status::dump_pipelines(Data::Builder &db) {
   print_table(db, { "MODULE", "PIPELINE", "STATE", "#ALLOCATED", "#ACTIVE" }, rows);
 }
 
+void Status::dump_filters(Data::Builder &db) {
+  auto ms = [](uint64_t ns) {
+    char str[100];
+    std::sprintf(str, "%.3f", ns / 1e6);
+    return std::string(str);
+  };
+  std::vector<const FilterInfo*> sorted;
+  for (const auto &i : filters) sorted.push_back(&i);
+  std::stable_sort(
+    sorted.begin(), sorted.end(),
+    [](const FilterInfo *a, const FilterInfo *b) {
+      return a->self_time > b->self_time;
+    }
+  );
+  std::list<std::array<std::string, 8>> rows;
+  for (const auto *i : sorted) {
+    rows.push_back({
+      i->module,
+      i->pipeline,
+      i->name + ':' + std::to_string(i->line),
+      std::to_string(i->events),
+      std::to_string(i->bytes),
+      std::to_string(i->callbacks),
+      ms(i->time),
+      ms(i->self_time),
+    });
+  }
+  print_table(db, { "MODULE", "PIPELINE", "FILTER", "#EVENTS", "BYTES", "#CALLBACKS", "TIME(MS)", "SELF(MS)" }, rows);
+}
+
+//
+// Folded stacks as consumed by flamegraph.pl, one line for each filter:
+// "<module>;<pipeline>;<filter>:<line> <self time in microseconds>"
+//
+
+void Status::dump_filters_folded(Data::Builder &db) {
+  auto frame = [&](const std::string &name) {
+    for (auto c : name) {
+      db.push(c == ';' || c == ' ' || c == '\n' ? '_' : c);
+    }
+  };
+  for (const auto &i : filters) {
+    auto us = i.self_time / 1000;
+    if (!us) continue;
+    frame(i.module);
+    db.push(';');
+    frame(i.pipeline.empty() ? std::string("(anonymous)") : i.pipeline);
+    db.push(';');
+    frame(i.name);
+    db.push(':');
+    db.push(std::to_string(i.line));
+    db.push(' ');
+    db.push(std::to_string(us));
+    db.push('\n');
+  }
+}
+
 void Status::dump_inbound(Data::Builder &db) {
   static const std::string s_tcp("TCP");
   static const std::string s_udp("UDP");
@@ -55,12 +55,16 @@ public:
   struct ModuleInfo {
     std::string filename;
     std::string graph;
+    mutable double parse_time;
+    mutable double compile_time;
 
     bool operator<(const ModuleInfo &r) const {
       return filename < r.filename;
     }
 
     auto operator+=(const ModuleInfo &r) const -> const ModuleInfo& {
+      parse_time += r.parse_time;
+      compile_time += r.compile_time;
       return *this;
     }
   };
@@ -132,6 +136,41 @@ public:
     }
   };
 
+  struct FilterInfo {
+    std::string module;
+    std::string pipeline;
+    int index;
+    std::string name;
+    int line;
+    int column;
+    mutable uint64_t events;
+    mutable uint64_t bytes;
+    mutable uint64_t callbacks;
+    mutable uint64_t time;
+    mutable uint64_t self_time;
+
+    bool operator<(const FilterInfo &r) const {
+      if (module < r.module) return true;
+      if (module > r.module) return false;
+      if (pipeline < r.pipeline) return true;
+      if (pipeline > r.pipeline) return false;
+      if (line < r.line) return true;
+      if (line > r.line) return false;
+      if (column < r.column) return true;
+      if (column > r.column) return false;
+      return index < r.index;
+    }
+
+    auto operator+=(const FilterInfo &r) const -> const FilterInfo& {
+      events += r.events;
+      bytes += r.bytes;
+      callbacks += r.callbacks;
+      time += r.time;
+      self_time += r.self_time;
+      return *this;
+    }
+  };
+
   struct BufferInfo {
     std::string name;
     mutable size_t size;
@@ -198,6 +237,7 @@ public:
   std::set<ObjectInfo> objects;
   std::set<ChunkInfo> chunks;
   std::set<PipelineInfo> pipelines;
+  std::set<FilterInfo> filters;
   std::set<BufferInfo> buffers;
   std::set<InboundInfo> inbounds;
   std::set<OutboundInfo> outbounds;
@@ -208,11 +248,14 @@ public:
   void merge(const Status &other);
   bool from_json(const Data &data, Data *metrics = nullptr);
   void to_json(Data::Builder &db, Data *metrics = nullptr) const;
+  void dump_modules(Data::Builder &db);
   void dump_pools(Data::Builder &db);
   void dump_objects(Data::Builder &db);
   void dump_chunks(Data::Builder &db);
   void dump_buffers(Data::Builder &db);
   void dump_pipelines(Data::Builder &db);
+  void dump_filters(Data::Builder &db);
+  void dump_filters_folded(Data::Builder &db);
   void dump_inbound(Data::Builder &db);
   void dump_outbound(Data::Builder &db);
   void dump_json(Data::Builder &db);
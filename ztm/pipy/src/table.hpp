@@ -213,7 +213,7 @@ public:
     auto e = static_cast<Entry*>(get_entry(i));
     if (e->release()) {
       e->data.~T();
-      std::memset(&e->data, 0, sizeof(T));
+      std::memset((void*)&e->data, 0, sizeof(T));
       free_entry(e);
     }
   }
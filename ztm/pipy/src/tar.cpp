@@ -23,6 +23,7 @@
  *  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <cstdio>
 #include <cstring>
 #include "tar.hpp"
 #include "utils.hpp"
@@ -47,7 +48,7 @@ Tarball::Tarball(const char *data, size_t size) {
 
   std::string pax_extended_path;
 
-  for (size_t i = 0; i < size; i += 512) {
+  for (size_t i = 0; i + 512 <= size; i += 512) {
     auto ptr = data + i;
     auto type = *(ptr + 156);
     auto filename = get_str(ptr, 100);
@@ -56,6 +57,8 @@ Tarball::Tarball(const char *data, size_t size) {
 
     (void)checksum;
 
+    if (filesize > size - i - 512) throw std::runtime_error("truncated tarball");
+
     if (type && type != '0' && type != '5' && type != 'x') throw std::runtime_error("unsupported file type in tarball");
 
     // int sum = 8 * ' ';
@@ -101,6 +104,9 @@ Tarball::Tarball(const char *data, size_t size) {
           pax_extended_path = v;
         }
 
+        // The length covers the whole record, so it can never be
+        // shorter than what has just been read
+        if (n < i - p || p + n > filesize) throw std::runtime_error("invalid tarball format");
         i = p + n;
       }
 
@@ -143,4 +149,51 @@ auto Tarball::get(const std::string &path, size_t &size) -> const char* {
   return i->second.data;
 }
 
+void Tarball::write(std::string &out, const std::string &path, const char *data, size_t size) {
+  auto header = [&](const std::string &name, char type, size_t size) {
+    char buf[512] = { 0 };
+    std::strncpy(buf, name.c_str(), 100);
+    std::snprintf(buf + 100, 8, "%07o", 0644);
+    std::snprintf(buf + 108, 8, "%07o", 0);
+    std::snprintf(buf + 116, 8, "%07o", 0);
+    std::snprintf(buf + 124, 12, "%011llo", (unsigned long long)size);
+    std::snprintf(buf + 136, 12, "%011o", 0);
+    std::memset(buf + 148, ' ', 8);
+    buf[156] = type;
+    std::memcpy(buf + 257, "ustar", 6);
+    std::memcpy(buf + 263, "00", 2);
+    unsigned sum = 0;
+    for (int i = 0; i < 512; i++) sum += (unsigned char)buf[i];
+    std::snprintf(buf + 148, 8, "%06o", sum);
+    out.append(buf, sizeof(buf));
+  };
+
+  auto pad = [&]() {
+    if (auto n = out.length() % 512) out.append(512 - n, '\0');
+  };
+
+  auto name = path;
+  while (!name.empty() && name.front() == '/') name.erase(0, 1);
+
+  // Names that don't fit go in a PAX extended header
+  if (name.length() >= 100) {
+    auto record = " path=" + name + '\n';
+    auto len = record.length();
+    auto n = len + std::to_string(len).length();
+    if (std::to_string(n).length() > std::to_string(len).length()) n++;
+    record = std::to_string(n) + record;
+    header("PaxHeader", 'x', record.length());
+    out += record;
+    pad();
+  }
+
+  header(name, '0', size);
+  out.append(data, size);
+  pad();
+}
+
+void Tarball::write_end(std::string &out) {
+  out.append(1024, '\0');
+}
+
 } // namespace pipy
\ No newline at end of file
@@ -39,6 +39,9 @@ public:
   void list(std::set<std::string> &paths);
   auto get(const std::string &path, size_t &size) -> const char*;
 
+  static void write(std::string &out, const std::string &path, const char *data, size_t size);
+  static void write_end(std::string &out);
+
 private:
   struct File {
     const char* data;
@@ -0,0 +1,103 @@
+/*
+ *  Copyright (c) 2019 by flomesh.io
+ *
+ *  Unless prior written consent has been obtained from the copyright
+ *  owner, the following shall not be allowed.
+ *
+ *  1. The distribution of any source codes, header files, make files,
+ *     or libraries of the software.
+ *
+ *  2. Disclosure of any source codes pertaining to the software to any
+ *     additional parties.
+ *
+ *  3. Alteration or removal of any notices in or on the software or
+ *     within the documentation included within the software.
+ *
+ *  ALL SOURCE CODE AS WELL AS ALL DOCUMENTATION INCLUDED WITH THIS
+ *  SOFTWARE IS PROVIDED IN AN “AS IS” CONDITION, WITHOUT WARRANTY OF ANY
+ *  KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ *  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ *  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "thread-pool.hpp"
+#include "net.hpp"
+#include "input.hpp"
+
+#include <algorithm>
+#include <thread>
+
+namespace pipy {
+
+//
+// ThreadPool::Job
+//
+
+struct ThreadPool::Job {
+  Job(const Work &w, const Done &d)
+    : net(&Net::current())
+    , guard(asio::make_work_guard(Net::context()))
+    , work(w)
+    , done(d) {}
+
+  Net* net;
+  asio::executor_work_guard<asio::io_context::executor_type> guard;
+  Work work;
+  Done done;
+};
+
+//
+// ThreadPool
+//
+
+ThreadPool::ThreadPool(unsigned min_threads, unsigned max_threads, unsigned cpus_per_thread)
+  : m_queued(0)
+  , m_running(0)
+{
+  auto n = std::thread::hardware_concurrency() / std::max(1u, cpus_per_thread);
+  m_size = std::max(min_threads, std::min(max_threads, n));
+}
+
+void ThreadPool::submit(const Work &work, const Done &done) {
+  auto job = new Job(work, done);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (!m_started) {
+    for (unsigned i = 0; i < m_size; i++) {
+      std::thread([this]() { main(); }).detach();
+    }
+    m_started = true;
+  }
+  m_jobs.push_back(job);
+  m_queued.fetch_add(1, std::memory_order_relaxed);
+  m_cv.notify_one();
+}
+
+void ThreadPool::main() {
+  for (;;) {
+    Job *job = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cv.wait(lock, [this]() { return !m_jobs.empty(); });
+      job = m_jobs.front();
+      m_jobs.pop_front();
+      m_queued.fetch_sub(1, std::memory_order_relaxed);
+    }
+    m_running.fetch_add(1, std::memory_order_relaxed);
+    job->work();
+    m_running.fetch_sub(1, std::memory_order_relaxed);
+    job->net->post(
+      [=]() {
+        {
+          InputContext ic;
+          job->done();
+        }
+        delete job;
+      }
+    );
+  }
+}
+
+} // namespace pipy
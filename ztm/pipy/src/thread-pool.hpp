@@ -0,0 +1,75 @@
+/*
+ *  Copyright (c) 2019 by flomesh.io
+ *
+ *  Unless prior written consent has been obtained from the copyright
+ *  owner, the following shall not be allowed.
+ *
+ *  1. The distribution of any source codes, header files, make files,
+ *     or libraries of the software.
+ *
+ *  2. Disclosure of any source codes pertaining to the software to any
+ *     additional parties.
+ *
+ *  3. Alteration or removal of any notices in or on the software or
+ *     within the documentation included within the software.
+ *
+ *  ALL SOURCE CODE AS WELL AS ALL DOCUMENTATION INCLUDED WITH THIS
+ *  SOFTWARE IS PROVIDED IN AN “AS IS” CONDITION, WITHOUT WARRANTY OF ANY
+ *  KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ *  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ *  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <mutex>
+
+namespace pipy {
+
+//
+// ThreadPool
+//
+// A few threads shared by all workers that run blocking or CPU-bound
+// work off the event loop. Each job holds a work guard on the event
+// loop of the thread that submitted it, where its completion is posted
+// back. Threads are started on the first job and keep waiting on the
+// pool until the process exits, so pools are never destructed.
+//
+
+class ThreadPool {
+public:
+  typedef std::function<void()> Work;
+  typedef std::function<void()> Done;
+
+  ThreadPool(unsigned min_threads, unsigned max_threads, unsigned cpus_per_thread);
+
+  void submit(const Work &work, const Done &done);
+
+  auto queued() const -> int { return m_queued.load(std::memory_order_relaxed); }
+  auto running() const -> int { return m_running.load(std::memory_order_relaxed); }
+
+private:
+  struct Job;
+
+  unsigned m_size;
+  bool m_started = false;
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::list<Job*> m_jobs;
+  std::atomic<int> m_queued;
+  std::atomic<int> m_running;
+
+  void main();
+};
+
+} // namespace pipy
+
+#endif // THREAD_POOL_HPP
@@ -26,6 +26,15 @@
 #include "timer.hpp"
 #include "input.hpp"
 
+#include <algorithm>
+#include <chrono>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
 namespace pipy {
 
 thread_local List<Timer> Timer::s_all_timers;
@@ -105,4 +114,109 @@ void Ticker::schedule() {
   );
 }
 
+//
+// LoopMonitor
+//
+
+static const double LOOP_MONITOR_INTERVAL = 0.1;
+static const double LOOP_MONITOR_SMOOTHING = 0.3;
+
+static double wall_time() {
+  auto t = std::chrono::steady_clock::now().time_since_epoch();
+  return std::chrono::duration_cast<std::chrono::microseconds>(t).count() / 1e6;
+}
+
+static double thread_cpu_time() {
+#ifdef _WIN32
+  FILETIME creation, exit, kernel, user;
+  if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) return 0;
+  auto k = (uint64_t(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime;
+  auto u = (uint64_t(user.dwHighDateTime) << 32) | user.dwLowDateTime;
+  return (k + u) / 1e7;
+#else
+  struct timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts)) return 0;
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+}
+
+auto LoopMonitor::get() -> LoopMonitor* {
+  thread_local static LoopMonitor s_loop_monitor;
+  return &s_loop_monitor;
+}
+
+auto LoopMonitor::lag_max() -> double {
+  auto t = std::max(m_lag_max, m_lag);
+  m_lag_max = 0;
+  return t;
+}
+
+void LoopMonitor::watch(Watcher *w) {
+  if (!w->m_monitor) {
+    m_watchers.push(w);
+    w->m_monitor = this;
+    start();
+  }
+}
+
+void LoopMonitor::unwatch(Watcher *w) {
+  if (w->m_monitor == this) {
+    if (w == m_visiting) {
+      m_visiting = w->next();
+    }
+    m_watchers.remove(w);
+    w->m_monitor = nullptr;
+    if (m_watchers.empty()) {
+      stop();
+    }
+  }
+}
+
+void LoopMonitor::start() {
+  if (!m_is_running) {
+    m_last_time = wall_time();
+    m_last_cpu_time = thread_cpu_time();
+    schedule();
+    m_is_running = true;
+  }
+}
+
+void LoopMonitor::stop() {
+  if (m_is_running) {
+    m_timer.cancel();
+    m_is_running = false;
+    m_lag = 0;
+    m_busy = 0;
+  }
+}
+
+void LoopMonitor::schedule() {
+  m_timer.schedule(
+    LOOP_MONITOR_INTERVAL,
+    [this]() {
+      sample();
+      m_visiting = m_watchers.head();
+      while (auto w = m_visiting) {
+        m_visiting = m_visiting->next();
+        w->on_loop_sample();
+      }
+      if (m_is_running) schedule();
+    }
+  );
+}
+
+void LoopMonitor::sample() {
+  auto t = wall_time();
+  auto c = thread_cpu_time();
+  auto wall = t - m_last_time;
+  auto lag = std::max(0.0, wall - LOOP_MONITOR_INTERVAL);
+  auto busy = wall > 0 ? std::min(1.0, std::max(0.0, (c - m_last_cpu_time) / wall)) : 0;
+  auto k = LOOP_MONITOR_SMOOTHING;
+  m_lag = std::max(lag, m_lag * (1 - k) + lag * k); // Rise at once and decay slowly
+  m_lag_max = std::max(m_lag_max, lag);
+  m_busy = m_busy * (1 - k) + busy * k;
+  m_last_time = t;
+  m_last_cpu_time = c;
+}
+
 } // namespace pipy
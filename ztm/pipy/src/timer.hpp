@@ -129,6 +129,49 @@ private:
   void schedule();
 };
 
+//
+// LoopMonitor
+//
+
+class LoopMonitor {
+public:
+
+  //
+  // LoopMonitor::Watcher
+  //
+
+  class Watcher : public List<Watcher>::Item {
+    LoopMonitor* m_monitor = nullptr;
+    virtual void on_loop_sample() = 0;
+    friend class LoopMonitor;
+  };
+
+  static auto get() -> LoopMonitor*;
+
+  auto lag() const -> double { return m_lag; }
+  auto busy() const -> double { return m_busy; }
+  auto lag_max() -> double;
+
+  void watch(Watcher *w);
+  void unwatch(Watcher *w);
+
+private:
+  List<Watcher> m_watchers;
+  Timer m_timer;
+  Watcher* m_visiting = nullptr;
+  double m_lag = 0;
+  double m_lag_max = 0;
+  double m_busy = 0;
+  double m_last_time = 0;
+  double m_last_cpu_time = 0;
+  bool m_is_running = false;
+
+  void start();
+  void stop();
+  void schedule();
+  void sample();
+};
+
 } // namespace pipy
 
 #endif // TIMER_HPP
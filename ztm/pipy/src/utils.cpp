@@ -325,6 +325,7 @@ auto get_seconds(const std::string &str) -> double {
     char *str_end = nullptr;
     auto n = std::strtod(s, &str_end);
     if (!*str_end) return n;
+    if (std::tolower(str_end[0]) == 'm' && std::tolower(str_end[1]) == 's') return n / 1000;
     switch (std::tolower(*str_end)) {
       case 'd': n *= 24;
       case 'h': n *= 60;
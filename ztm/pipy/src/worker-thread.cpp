@@ -26,10 +26,14 @@
 #include "worker-thread.hpp"
 #include "worker.hpp"
 #include "codebase.hpp"
+#include "compressor.hpp"
+#include "file-io.hpp"
+#include "filter.hpp"
 #include "pipeline-lb.hpp"
 #include "timer.hpp"
 #include "api/configuration.hpp"
 #include "api/console.hpp"
+#include "api/crypto.hpp"
 #include "api/pipy.hpp"
 #include "net.hpp"
 #include "log.hpp"
@@ -132,6 +136,16 @@ void WorkerThread::stats(const std::function<void(stats::MetricData&)> &cb) {
   );
 }
 
+void WorkerThread::publish_metrics(const std::function<void()> &cb) {
+  m_net->post(
+    [=]() {
+      stats::Metric::local().collect();
+      m_metric_shard.publish(stats::Metric::local());
+      cb();
+    }
+  );
+}
+
 void WorkerThread::dump_objects(const std::string &class_name, std::map<std::string, size_t> &counts, const std::function<void()> &cb) {
   m_net->post(
     [&, cb]() {
@@ -154,6 +168,18 @@ void WorkerThread::dump_objects(const std::string &class_name, std::map<std::str
   );
 }
 
+void WorkerThread::clear_profiles() {
+  m_net->post(
+    []() {
+      PipelineLayout::for_each([](PipelineLayout *p) {
+        p->for_each_filter([](Filter *f) {
+          f->profile().clear();
+        });
+      });
+    }
+  );
+}
+
 void WorkerThread::recycle() {
   if (m_working && !m_recycling) {
     m_recycling = true;
@@ -304,6 +330,8 @@ bool WorkerThread::stop(bool force) {
 void WorkerThread::init_metrics() {
   pjs::Ref<pjs::Array> label_names = pjs::Array::make();
 
+  FileIO::init_metrics();
+
   //
   // Stats - size of allocated pool space
   //
@@ -412,6 +440,120 @@ void WorkerThread::init_metrics() {
     }
   );
 
+  //
+  // Stats - # of offloaded compression jobs
+  //
+
+  label_names->length(1);
+  label_names->set(0, "state");
+
+  stats::Gauge::make(
+    pjs::Str::make("pipy_compression_offload_count"),
+    label_names,
+    [](stats::Gauge *gauge) {
+      if (WorkerThread::current()->index() > 0) return;
+      thread_local static pjs::ConstStr s_queued("queued");
+      thread_local static pjs::ConstStr s_running("running");
+      pjs::Str *queued = s_queued;
+      pjs::Str *running = s_running;
+      auto n_queued = CompressorPool::queued();
+      auto n_running = CompressorPool::running();
+      gauge->with_labels(&queued, 1)->set(n_queued);
+      gauge->with_labels(&running, 1)->set(n_running);
+      gauge->set(n_queued + n_running);
+    }
+  );
+
+  //
+  // Stats - # of file I/O jobs
+  //
+
+  stats::Gauge::make(
+    pjs::Str::make("pipy_file_io_count"),
+    label_names,
+    [](stats::Gauge *gauge) {
+      if (WorkerThread::current()->index() > 0) return;
+      thread_local static pjs::ConstStr s_queued("queued");
+      thread_local static pjs::ConstStr s_running("running");
+      pjs::Str *queued = s_queued;
+      pjs::Str *running = s_running;
+      auto n_queued = FileIO::queued();
+      auto n_running = FileIO::running();
+      gauge->with_labels(&queued, 1)->set(n_queued);
+      gauge->with_labels(&running, 1)->set(n_running);
+      gauge->set(n_queued + n_running);
+    }
+  );
+
+  //
+  // Stats - # of offloaded crypto jobs
+  //
+
+  stats::Gauge::make(
+    pjs::Str::make("pipy_crypto_offload_count"),
+    label_names,
+    [](stats::Gauge *gauge) {
+      if (WorkerThread::current()->index() > 0) return;
+      thread_local static pjs::ConstStr s_queued("queued");
+      thread_local static pjs::ConstStr s_running("running");
+      pjs::Str *queued = s_queued;
+      pjs::Str *running = s_running;
+      auto n_queued = crypto::CryptoPool::queued();
+      auto n_running = crypto::CryptoPool::running();
+      gauge->with_labels(&queued, 1)->set(n_queued);
+      gauge->with_labels(&running, 1)->set(n_running);
+      gauge->set(n_queued + n_running);
+    }
+  );
+
+  //
+  // Stats - event loop lag and busy ratio
+  //
+
+  label_names->length(1);
+  label_names->set(0, "thread");
+
+  stats::Gauge::make(
+    pjs::Str::make("pipy_loop_lag"),
+    label_names,
+    [](stats::Gauge *gauge) {
+      pjs::Ref<pjs::Str> thread(pjs::Str::make(WorkerThread::current()->index()));
+      pjs::Str *name = thread.get();
+      auto lag = LoopMonitor::get()->lag_max() * 1000;
+      gauge->with_labels(&name, 1)->set(lag);
+      gauge->set(lag);
+    }
+  );
+
+  stats::Gauge::make(
+    pjs::Str::make("pipy_loop_busy"),
+    label_names,
+    [](stats::Gauge *gauge) {
+      pjs::Ref<pjs::Str> thread(pjs::Str::make(WorkerThread::current()->index()));
+      pjs::Str *name = thread.get();
+      auto busy = LoopMonitor::get()->busy();
+      gauge->with_labels(&name, 1)->set(busy);
+      gauge->set(busy);
+    }
+  );
+
+  //
+  // Stats - # of times a thread's metrics were reported stale
+  //
+
+  stats::Gauge::make(
+    pjs::Str::make("pipy_metric_stale_count"),
+    label_names,
+    [](stats::Gauge *gauge) {
+      auto wt = WorkerThread::current();
+      pjs::Ref<pjs::Str> thread(pjs::Str::make(wt->index()));
+      pjs::Str *name = thread.get();
+      auto n = double(wt->metric_shard().stale_count());
+      gauge->with_labels(&name, 1)->set(n);
+      gauge->set(n);
+    }
+  );
+
   //
   // Stats - # of pipelines
   //
@@ -667,33 +809,47 @@ bool WorkerManager::status(const std::function<void(Status&)> &cb) {
   return true;
 }
 
+//
+// Worker threads publish their metrics to their shards on request.
+// A busy thread that doesn't make it within the timeout is not waited
+// for, and the last shard it published is summed up instead.
+//
+
+static const double METRIC_PUBLISH_TIMEOUT = 0.1;
+
 auto WorkerManager::stats() -> stats::MetricDataSum& {
   if (!m_querying_stats && !m_reloading && !m_stopping) {
     m_querying_stats = true;
 
     if (auto n = m_worker_threads.size()) {
-      std::mutex m;
-      std::condition_variable cv;
-      pjs::vl_array<stats::MetricData, 256> metric_data(n);
+      struct Counter {
+        std::mutex m;
+        std::condition_variable cv;
+        size_t n;
+      };
+
+      auto counter = std::make_shared<Counter>();
+      counter->n = n;
 
+      save_metric_shard_versions();
       for (auto *wt : m_worker_threads) {
-        auto i = wt->index();
-        wt->stats(
-          metric_data[i],
-          [&]() {
-            std::lock_guard<std::mutex> lock(m);
-            n--;
-            cv.notify_one();
+        wt->publish_metrics(
+          [=]() {
+            std::lock_guard<std::mutex> lock(counter->m);
+            counter->n--;
+            counter->cv.notify_one();
           }
         );
       }
 
-      std::unique_lock<std::mutex> lock(m);
-      cv.wait(lock, [&]{ return n == 0; });
+      std::unique_lock<std::mutex> lock(counter->m);
+      counter->cv.wait_for(
+        lock, std::chrono::milliseconds((int)(METRIC_PUBLISH_TIMEOUT * 1000)),
+        [&]{ return counter->n == 0; }
+      );
+      lock.unlock();
 
-      for (auto i = 0; i < m_worker_threads.size(); i++) {
-        m_metric_data_sum.sum(metric_data[i], i == 0);
-      }
+      sum_metric_shards();
     }
 
     m_querying_stats = false;
@@ -710,19 +866,30 @@ bool WorkerManager::stats(const std::function<void(stats::MetricDataSum&)> &cb)
   m_querying_stats = true;
 
   auto &main = Net::current();
+  auto round = ++m_metric_data_sum_round;
   m_metric_data_sum_counter = 0;
 
+  auto done = [=]() {
+    if (round != m_metric_data_sum_round) return;
+    m_metric_data_sum_round++;
+    m_metric_data_sum_timer->cancel();
+    sum_metric_shards();
+    cb(m_metric_data_sum);
+    m_querying_stats = false;
+    check_reloading();
+  };
+
+  if (!m_metric_data_sum_timer) m_metric_data_sum_timer.reset(new Timer);
+  m_metric_data_sum_timer->schedule(METRIC_PUBLISH_TIMEOUT, done);
+
+  save_metric_shard_versions();
   for (auto *wt : m_worker_threads) {
-    wt->stats(
-      [&, cb](stats::MetricData &metric_data) {
+    wt->publish_metrics(
+      [=, &main]() {
         main.post(
-          [&, cb]() {
-            m_metric_data_sum.sum(metric_data, m_metric_data_sum_counter == 0);
-            if (++m_metric_data_sum_counter == m_worker_threads.size()) {
-              cb(m_metric_data_sum);
-              m_querying_stats = false;
-              check_reloading();
-            }
+          [=]() {
+            if (round != m_metric_data_sum_round) return;
+            if (++m_metric_data_sum_counter == m_worker_threads.size()) done();
           }
         );
       }
@@ -775,6 +942,15 @@ auto WorkerManager::dump_objects(const std::string &class_name) -> std::map<std:
   return all;
 }
 
+void WorkerManager::profile(bool enabled) {
+  if (enabled && !Filter::profiling()) {
+    for (auto *wt : m_worker_threads) {
+      wt->clear_profiles();
+    }
+  }
+  Filter::profiling(enabled);
+}
+
 void WorkerManager::recycle() {
   for (auto *wt : m_worker_threads) {
     wt->recycle();
@@ -798,6 +974,24 @@ bool WorkerManager::admin(pjs::Str *path, const Data &request, const std::functi
   return true;
 }
 
+void WorkerManager::save_metric_shard_versions() {
+  m_metric_shard_versions.clear();
+  for (auto *wt : m_worker_threads) {
+    m_metric_shard_versions.push_back(wt->metric_shard().version());
+  }
+}
+
+void WorkerManager::sum_metric_shards() {
+  std::vector<std::shared_ptr<const stats::MetricShard::Snapshot>> shards;
+  shards.reserve(m_worker_threads.size());
+  for (size_t i = 0; i < m_worker_threads.size(); i++) {
+    auto &shard = m_worker_threads[i]->metric_shard();
+    if (i < m_metric_shard_versions.size() && shard.version() == m_metric_shard_versions[i]) shard.stale();
+    shards.push_back(shard.snapshot());
+  }
+  m_metric_data_sum.sum(shards);
+}
+
 void WorkerManager::check_reloading() {
   if (m_reloading_requested) {
     m_reloading_requested = false;
@@ -31,6 +31,7 @@
 #include "status.hpp"
 #include "api/stats.hpp"
 #include "signal.hpp"
+#include "timer.hpp"
 
 #include <thread>
 #include <atomic>
@@ -71,7 +72,10 @@ public:
   void stats(stats::MetricData &metric_data, const std::function<void()> &cb);
   void stats(const std::function<void(stats::MetricData&)> &cb);
   void stats(const std::vector<std::string> &names, const std::function<void(stats::MetricData&)> &cb);
+  auto metric_shard() -> stats::MetricShard& { return m_metric_shard; }
+  void publish_metrics(const std::function<void()> &cb);
   void dump_objects(const std::string &class_name, std::map<std::string, size_t> &counts, const std::function<void()> &cb);
+  void clear_profiles();
   void recycle();
   void reload(const std::function<void(bool)> &cb);
   void reload_done(bool ok);
@@ -88,6 +92,7 @@ private:
   pjs::Ref<Worker> m_new_worker;
   Status m_status;
   stats::MetricData m_metric_data;
+  stats::MetricShard m_metric_shard;
   std::atomic<bool> m_working;
   std::atomic<bool> m_recycling;
   std::atomic<bool> m_shutdown;
@@ -133,6 +138,7 @@ public:
   bool stats(const std::function<void(stats::MetricDataSum&)> &cb);
   void stats(const std::function<void(stats::MetricDataSum&)> &cb, const std::vector<std::string> &names);
   auto dump_objects(const std::string &class_name) -> std::map<std::string, size_t>;
+  void profile(bool enabled);
   void recycle();
   void reload();
   bool admin(pjs::Str *path, const Data &request, const std::function<void(const Data *)> &respond);
@@ -188,6 +194,9 @@ private:
   int m_status_counter = -1;
   stats::MetricDataSum m_metric_data_sum;
   int m_metric_data_sum_counter = -1;
+  int m_metric_data_sum_round = 0;
+  std::unique_ptr<Timer> m_metric_data_sum_timer;
+  std::vector<uint64_t> m_metric_shard_versions;
   int m_concurrency = 0;
   bool m_graph_enabled = false;
   bool m_reloading_requested = false;
@@ -201,6 +210,8 @@ private:
   std::function<void()> m_on_done;
   std::function<void()> m_on_ended;
 
+  void save_metric_shard_versions();
+  void sum_metric_shards();
   void check_reloading();
   void start_reloading();
   void next_admin_request();
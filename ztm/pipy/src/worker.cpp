@@ -311,7 +311,7 @@ auto Worker::load_module(pjs::Module *referer, const std::string &path) -> pjs::
 
   std::string error;
   int error_line, error_column;
-  if (!mod->compile(error, error_line, error_column)) {
+  if (!ModuleCache::compile(mod, error, error_line, error_column)) {
     Log::pjs_location(source, name, error_line, error_column);
     Log::error(
       "[pjs] Syntax error: %s at line %d column %d in %s",
@@ -1,8 +1,24 @@
+//
+// To see the effect of flow-control window autotuning, add latency
+// to the loopback before running, e.g.:
+//
+//   tc qdisc add dev lo root netem delay 20ms
+//
+// and run with WINDOW_MAX=64m to let the windows grow up to 64MB.
+//
+
+var options = { version: 2 }
+
+if (os.env.WINDOW_MAX) {
+  options.maxConnectionWindowSize = os.env.WINDOW_MAX
+  options.maxStreamWindowSize = os.env.WINDOW_MAX
+}
+
 pipy()
 
 .listen(os.env.LISTEN || 8000)
 .demuxHTTP().to($=>$
-  .muxHTTP(() => 1, { version: 2 }).to($=>$
+  .muxHTTP(() => 1, options).to($=>$
     .connect('localhost:8080')
   )
 )
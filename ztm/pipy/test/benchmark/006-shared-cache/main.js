@@ -0,0 +1,57 @@
+//
+// Compares per-thread algo.Cache with algo.SharedCache.
+//
+// Environment variables:
+//   CACHE - 'local' for algo.Cache or 'shared' for algo.SharedCache (default: shared)
+//   KEYS  - Number of distinct keys requested at random (default: 100000)
+//   SIZE  - Maximum number of entries in the cache (default: 50000)
+//
+// Run with --threads=N to see how hit rates and memory usage
+// of the two kinds of caches change with the number of threads.
+// Each thread prints its cache statistics every 5 seconds.
+//
+
+var mode = os.env.CACHE || 'shared'
+var keyCount = (os.env.KEYS|0) || 100000
+var size = (os.env.SIZE|0) || 50000
+
+var hits = 0
+var misses = 0
+
+var allocate = key => (
+  misses++,
+  new crypto.Hash('sha256').update(key.toString()).digest('hex')
+)
+
+var cache = (
+  mode === 'local'
+    ? new algo.Cache(allocate, null, { size })
+    : new algo.SharedCache(allocate, { key: 'benchmark', size })
+)
+
+pipy.listen(os.env.LISTEN || 8000, $=>$
+  .serveHTTP(
+    () => {
+      var m = misses
+      var value = cache.get(Math.floor(Math.random() * keyCount))
+      if (m === misses) hits++
+      return new Message(value)
+    }
+  )
+)
+
+report()
+
+function report() {
+  new Timeout(5).wait().then(() => {
+    var total = hits + misses
+    var stats = mode === 'shared' ? cache.stats() : null
+    console.info(
+      `[${mode}] thread ${pipy.thread.id}:`,
+      `hit rate = ${total > 0 ? (hits / total * 100).toFixed(2) : 0}%`,
+      stats ? `entries in all threads = ${stats.size}` : `entries in this thread = ${Math.min(size, misses)}`,
+    )
+    hits = misses = 0
+    report()
+  })
+}
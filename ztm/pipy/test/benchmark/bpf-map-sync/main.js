@@ -0,0 +1,51 @@
+//
+// Measures the time it takes to sync a large BPF hash map
+// element by element versus in batches.
+//
+// Needs root privileges and a map created in advance with bpftool:
+//
+//   bpftool map create /sys/fs/bpf/pipy_bench \
+//     type hash key 4 value 8 entries 100000 name pipy_bench
+//
+// Environment variables:
+//   COUNT - Number of entries to sync (default: 100000)
+//   BATCH - Number of entries per batch (default: 1024)
+//
+
+var count = (os.env.COUNT|0) || 100000
+var batchSize = (os.env.BATCH|0) || 1024
+
+var info = bpf.Map.list().find(m => m.name === 'pipy_bench')
+if (!info) throw 'map pipy_bench not found'
+
+var map = bpf.Map.open(
+  info.id,
+  new CStruct({ key: 'uint32' }),
+  new CStruct({ value: 'uint64' }),
+)
+
+var entries = []
+var keys = []
+for (var i = 0; i < count; i++) {
+  keys[i] = { key: i }
+  entries[i] = [keys[i], { value: i * 2 }]
+}
+
+function measure(name, f) {
+  var t = Date.now()
+  var n = f()
+  console.log(name + ':', Date.now() - t, 'ms', n === undefined ? '' : '(' + n + ' entries)')
+}
+
+measure('update per element', () => entries.forEach(e => map.update(e[0], e[1])))
+measure('entries per element', () => map.entries(0).length)
+measure('keys per element', () => map.keys(0).length)
+measure('delete per element', () => keys.forEach(k => map.delete(k)))
+
+measure('update batched', () => map.updateBatch(entries, batchSize))
+measure('entries batched', () => map.entries(batchSize).length)
+measure('keys batched', () => map.keys(batchSize).length)
+measure('delete batched', () => map.deleteBatch(keys, batchSize))
+
+map.close()
+pipy.exit(0)
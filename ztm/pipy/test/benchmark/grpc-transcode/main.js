@@ -0,0 +1,93 @@
+//
+// Measures JSON/gRPC transcoding of a typical API response: decoding
+// a protobuf message into JSON with the schemaless protobuf.Message
+// API, with a compiled protobuf.Schema, and with a Schema decoding only
+// the fields a script looks at, plus encoding JSON into a gRPC frame.
+//
+// Run from this directory:
+//
+//   ../../../bin/pipy main.js
+//
+// Environment variables:
+//   ITEMS  - Number of items in each message (default: 1000)
+//   ROUNDS - Number of times each test is repeated (default: 100)
+//
+
+var itemCount = (os.env.ITEMS|0) || 1000
+var rounds = (os.env.ROUNDS|0) || 100
+
+var schema = new protobuf.Schema(`
+  syntax = "proto3";
+  package shop.v1;
+  message Item {
+    string sku = 1;
+    string title = 2;
+    int32 qty = 3;
+    double price = 4;
+    repeated int32 tags = 5;
+  }
+  message ListItemsResponse {
+    string next_page_token = 1;
+    int32 total = 2;
+    repeated Item items = 3;
+    map<string, string> labels = 4;
+  }
+`)
+
+var response = {
+  next_page_token: 'page-2',
+  total: itemCount,
+  items: new Array(itemCount).fill(0).map((_, i) => ({
+    sku: `SKU-${i}`,
+    title: 'Stainless steel water bottle, 750ml',
+    qty: i % 10,
+    price: 19.99 + i,
+    tags: [1, 2, 3, i],
+  })),
+  labels: { region: 'eu-west-1', cache: 'miss' },
+}
+
+var message = schema.encode('shop.v1.ListItemsResponse', response)
+
+var grpcFrame = body => new Data([0, body.size >>> 24, (body.size >> 16) & 255, (body.size >> 8) & 255, body.size & 255]).push(body)
+
+var tests = [
+  [
+    'protobuf.Message to JSON',
+    () => {
+      var msg = protobuf.decode(message)
+      return JSON.stringify({
+        next_page_token: msg.getString(1),
+        total: msg.getInt32(2),
+        items: msg.getMessageArray(3).map(item => ({
+          sku: item.getString(1),
+          title: item.getString(2),
+          qty: item.getInt32(3),
+          price: item.getDouble(4),
+          tags: item.getInt32Array(5),
+        })),
+      }).length
+    }
+  ],
+  [
+    'Schema to JSON',
+    () => JSON.stringify(schema.decode('shop.v1.ListItemsResponse', message)).length
+  ],
+  [
+    'Schema partial decode',
+    () => schema.decode('shop.v1.ListItemsResponse', message, ['total', 'items.price']).items.length
+  ],
+  [
+    'JSON to gRPC frame',
+    () => grpcFrame(schema.encode('shop.v1.ListItemsResponse', JSON.parse(JSON.stringify(response)))).size
+  ],
+]
+
+console.log(`Message size: ${message.size} bytes`)
+
+tests.forEach(([name, f]) => {
+  var t = Date.now()
+  new Array(rounds).fill(0).forEach(f)
+  var ms = (Date.now() - t) / rounds
+  console.log(`${name}: ${ms.toFixed(3)} ms`)
+})
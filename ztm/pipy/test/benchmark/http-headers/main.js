@@ -0,0 +1,60 @@
+//
+// Measures decoding and re-encoding of HTTP/1 requests carrying many
+// headers, either passed through untouched or read by a script.
+//
+// Run from this directory:
+//
+//   ../../../bin/pipy main.js
+//
+// Environment variables:
+//   REQUESTS - Number of requests in each round (default: 20000)
+//   HEADERS  - Number of extra headers in each request (default: 20)
+//   ROUNDS   - Number of rounds in each test (default: 5)
+//
+
+var requestCount = (os.env.REQUESTS|0) || 20000
+var headerCount = (os.env.HEADERS|0) || 20
+var rounds = (os.env.ROUNDS|0) || 5
+
+var request = [
+  'GET /index.html HTTP/1.1',
+  'Host: example.com',
+  'User-Agent: bench',
+  'Accept: */*',
+  ...new Array(headerCount).fill(0).map((_, i) => `X-Custom-Header-${i}: value-${i}`),
+  '', '',
+].join('\r\n')
+
+var input = new Data(new Array(requestCount).fill(request).join(''))
+
+var size = 0
+
+var passThrough = pipeline($=>$
+  .onStart(() => new Data(input))
+  .decodeHTTPRequest()
+  .encodeHTTPRequest()
+  .handleData(d => size += d.size)
+)
+
+var readHeaders = pipeline($=>$
+  .onStart(() => new Data(input))
+  .decodeHTTPRequest()
+  .handleMessageStart(msg => msg.head.headers['user-agent'])
+  .encodeHTTPRequest()
+  .handleData(d => size += d.size)
+)
+
+function run(name, p, n) {
+  if (n === rounds) return Promise.resolve()
+  var t = Date.now()
+  size = 0
+  return Promise.resolve(p.spawn()).then(() => {
+    var ms = Date.now() - t
+    console.log(`${name} ${n}: ${ms} ms for ${requestCount} requests, ${(requestCount / ms * 1000)|0} req/s, ${size} bytes out`)
+    return run(name, p, n + 1)
+  })
+}
+
+run('pass-through', passThrough, 0).then(
+  () => run('read headers', readHeaders, 0)
+)
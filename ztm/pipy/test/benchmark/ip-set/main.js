@@ -0,0 +1,76 @@
+//
+// Measures longest-prefix-match lookups in a large CIDR list,
+// with algo.IPSet versus a loop over IPMask objects.
+//
+// Run from this directory:
+//
+//   ../../../bin/pipy main.js
+//
+// Environment variables:
+//   PREFIXES - Number of prefixes in the set (default: 100000)
+//   MASKS    - Number of IPMask objects in the loop (default: 1000)
+//   LOOKUPS  - Number of addresses looked up in each test (default: 100000)
+//
+
+var prefixCount = (os.env.PREFIXES|0) || 100000
+var maskCount = (os.env.MASKS|0) || 1000
+var lookupCount = (os.env.LOOKUPS|0) || 100000
+
+var seed = 1
+function random() {
+  seed = (seed * 16807) % 2147483647
+  return seed
+}
+
+function ipv4(n) {
+  return `${(n>>>24)&255}.${(n>>>16)&255}.${(n>>>8)&255}.${n&255}`
+}
+
+function ipv6(n) {
+  return `2001:db8:${(n>>>16).toString(16)}:${(n&0xffff).toString(16)}::1`
+}
+
+var prefixes = {}
+new Array(prefixCount).fill(0).forEach(
+  (_, i) => {
+    if (i % 4 === 3) {
+      prefixes[`2001:db8:${(random()>>>15).toString(16)}::/${32 + random() % 17}`] = i
+    } else {
+      prefixes[`${ipv4(random() * 2)}/${12 + random() % 17}`] = i
+    }
+  }
+)
+
+var addresses = new Array(lookupCount).fill(0).map(
+  (_, i) => i % 4 === 3 ? ipv6(random() * 2) : ipv4(random() * 2)
+)
+
+var t = Date.now()
+var set = new algo.IPSet(prefixes)
+console.log(`build IPSet: ${Date.now() - t} ms for ${set.size} prefixes`)
+
+var masks = Object.keys(prefixes).slice(0, maskCount).map(cidr => [new IPMask(cidr), prefixes[cidr]])
+var ips = addresses.map(a => new IP(a))
+
+function run(name, count, f) {
+  var t = Date.now()
+  var hits = 0
+  new Array(count).fill(0).forEach((_, i) => { if (f(i) !== undefined) hits++ })
+  var ms = Date.now() - t
+  console.log(`${name}: ${(ms * 1000000 / count).toFixed(0)} ns per lookup (${hits} of ${count} hit)`)
+}
+
+run(`IPSet of ${set.size} by string`, lookupCount, i => set.find(addresses[i]))
+run(`IPSet of ${set.size} by IP`, lookupCount, i => ips[i] && set.find(ips[i]))
+run(`IPMask loop of ${masks.length} by string`, Math.min(lookupCount, 1000), i => {
+  var addr = addresses[i]
+  var best = -1
+  var value = undefined
+  masks.forEach(([mask, v]) => {
+    if (mask.bitmask > best && mask.contains(addr)) {
+      best = mask.bitmask
+      value = v
+    }
+  })
+  return value
+})
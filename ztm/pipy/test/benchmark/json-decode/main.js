@@ -0,0 +1,66 @@
+//
+// Measures decoding of API-gateway style JSON bodies: parsing whole
+// documents from strings and from chunked Data, and reading a few
+// fields through JSON.view() without decoding the rest.
+//
+// Run from this directory:
+//
+//   ../../../bin/pipy main.js
+//
+// Environment variables:
+//   ITEMS  - Number of items in the document (default: 10000)
+//   CHUNK  - Size of each Data chunk in bytes (default: 16384)
+//   ROUNDS - Number of times each test is repeated (default: 10)
+//
+
+var itemCount = (os.env.ITEMS|0) || 10000
+var chunkSize = (os.env.CHUNK|0) || 16384
+var rounds = (os.env.ROUNDS|0) || 10
+
+var text = JSON.stringify({
+  kind: 'OrderList',
+  total: itemCount,
+  items: new Array(itemCount).fill(0).map((_, i) => ({
+    id: i,
+    sku: `SKU-${i}-ABCDEFG`,
+    title: 'Stainless steel water bottle, 750ml, vacuum insulated éè',
+    price: 19.99 + i / 100,
+    tags: ['kitchen', 'outdoor', 'gift'],
+    available: i % 3 !== 0,
+    owner: null,
+  })),
+})
+
+var whole = new Data(text)
+var chunked = new Data
+var rest = new Data(text)
+new Array(Math.ceil(whole.size / chunkSize)).fill(0).forEach(
+  () => chunked.push(rest.shift(chunkSize))
+)
+
+var tests = [
+  [
+    'JSON.parse',
+    () => JSON.parse(text).items.length
+  ],
+  [
+    'JSON.decode',
+    () => JSON.decode(chunked).items.length
+  ],
+  [
+    'JSON.view',
+    () => {
+      var v = JSON.view(chunked)
+      return v.get('total') + v.get('items', itemCount >> 1, 'price')
+    }
+  ],
+]
+
+console.log(`Document size: ${whole.size} bytes in chunks of ${chunkSize}`)
+
+tests.forEach(([name, f]) => {
+  var t = Date.now()
+  new Array(rounds).fill(0).forEach(f)
+  var ms = (Date.now() - t) / rounds
+  console.log(`${name}: ${ms.toFixed(2)} ms, ${(whole.size / 1024 / 1024 / (ms / 1000)).toFixed(1)} MB/s`)
+})
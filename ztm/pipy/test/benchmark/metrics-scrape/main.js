@@ -0,0 +1,69 @@
+//
+// Measures Prometheus scrapes of a worker that carries many series,
+// either all of them standing still or a few families of them
+// changing all the time between scrapes.
+//
+// Run from this directory:
+//
+//   ../../../bin/pipy main.js --admin-port=6060
+//
+// Environment variables:
+//   FAMILIES - Number of metric families (default: 100)
+//   SERIES   - Number of series in each family (default: 100)
+//   CHANGING - Number of families that keep changing (default: 5)
+//   ROUNDS   - Number of scrapes in each test (default: 20)
+//
+
+var familyCount = (os.env.FAMILIES|0) || 100
+var seriesCount = (os.env.SERIES|0) || 100
+var changingCount = (os.env.CHANGING|0) || 5
+var rounds = (os.env.ROUNDS|0) || 20
+
+var families = new Array(familyCount).fill(0).map(
+  (_, i) => new stats.Counter(`bench_family_${i}`, ['series'])
+)
+
+var series = families.map(
+  f => new Array(seriesCount).fill(0).map((_, i) => f.withLabels(`s${i}`))
+)
+
+series.forEach(f => f.forEach(s => s.increase()))
+
+var changing = false
+function change() {
+  series.slice(0, changingCount).forEach(f => f.forEach(s => s.increase()))
+  if (changing) new Timeout(0.01).wait().then(change)
+}
+
+var agent = new http.Agent('localhost:6060')
+
+function scrape(n, total, max) {
+  if (n === 0) return Promise.resolve([total, max])
+  var t = Date.now()
+  return agent.request('GET', '/metrics').then(
+    res => {
+      var ms = Date.now() - t
+      if (res.head.status !== 200) throw `status ${res.head.status}`
+      return scrape(n - 1, total + ms, Math.max(max, ms))
+    }
+  )
+}
+
+function report(name) {
+  return ([total, max]) => console.log(
+    `${name}: ${(total / rounds).toFixed(2)} ms per scrape, ${max} ms max (${familyCount * seriesCount} series)`
+  )
+}
+
+// Wait for the admin service to come up
+new Timeout(1).wait().then(
+  () => scrape(rounds, 0, 0)
+).then(report('no changes')).then(
+  () => {
+    changing = true
+    change()
+    return scrape(rounds, 0, 0).then(report(`${changingCount} families changing`))
+  }
+).then(
+  () => changing = false
+)
@@ -0,0 +1,73 @@
+/*
+ *  Copyright (c) 2019 by flomesh.io
+ *
+ *  Unless prior written consent has been obtained from the copyright
+ *  owner, the following shall not be allowed.
+ *
+ *  1. The distribution of any source codes, header files, make files,
+ *     or libraries of the software.
+ *
+ *  2. Disclosure of any source codes pertaining to the software to any
+ *     additional parties.
+ *
+ *  3. Alteration or removal of any notices in or on the software or
+ *     within the documentation included within the software.
+ *
+ *  ALL SOURCE CODE AS WELL AS ALL DOCUMENTATION INCLUDED WITH THIS
+ *  SOFTWARE IS PROVIDED IN AN “AS IS” CONDITION, WITHOUT WARRANTY OF ANY
+ *  KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ *  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ *  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace pipy {
+namespace bench {
+
+//
+// Benchmark
+//
+// A benchmark runs its body for a given number of iterations.
+// Anything to be set up once goes outside of the loop in the body
+// and is amortized over the iterations.
+//
+
+class Benchmark {
+public:
+  Benchmark(const char *name, const std::function<void(size_t)> &body)
+    : m_name(name), m_body(body) { all().push_back(this); }
+
+  static auto all() -> std::vector<Benchmark*>& {
+    static std::vector<Benchmark*> s_all;
+    return s_all;
+  }
+
+  auto name() const -> const std::string& { return m_name; }
+  void run(size_t n) const { m_body(n); }
+
+private:
+  std::string m_name;
+  std::function<void(size_t)> m_body;
+};
+
+//
+// Keeps results from being optimized away
+//
+
+void keep(size_t n);
+void keep(const void *p);
+
+} // namespace bench
+} // namespace pipy
+
+#endif // BENCH_HPP
@@ -0,0 +1,261 @@
+/*
+ *  Copyright (c) 2019 by flomesh.io
+ *
+ *  Unless prior written consent has been obtained from the copyright
+ *  owner, the following shall not be allowed.
+ *
+ *  1. The distribution of any source codes, header files, make files,
+ *     or libraries of the software.
+ *
+ *  2. Disclosure of any source codes pertaining to the software to any
+ *     additional parties.
+ *
+ *  3. Alteration or removal of any notices in or on the software or
+ *     within the documentation included within the software.
+ *
+ *  ALL SOURCE CODE AS WELL AS ALL DOCUMENTATION INCLUDED WITH THIS
+ *  SOFTWARE IS PROVIDED IN AN “AS IS” CONDITION, WITHOUT WARRANTY OF ANY
+ *  KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ *  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ *  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "bench.hpp"
+#include "data.hpp"
+#include "deframer.hpp"
+#include "pjs/pjs.hpp"
+#include "api/algo.hpp"
+#include "api/http.hpp"
+
+namespace pipy {
+namespace bench {
+
+thread_local static Data::Producer s_dp("Benchmark");
+
+static auto make_keys(int count, const char *prefix) -> std::vector<std::string> {
+  std::vector<std::string> keys;
+  for (int i = 0; i < count; i++) {
+    keys.push_back(prefix + std::to_string(i));
+  }
+  return keys;
+}
+
+//
+// Data
+//
+
+static Benchmark s_data_push("data/push-64", [](size_t n) {
+  char buf[64] = { 0 };
+  Data data;
+  for (size_t i = 0; i < n; i++) {
+    data.push(buf, sizeof(buf), &s_dp);
+    if ((i & 255) == 255) data.clear();
+  }
+  keep(data.size());
+});
+
+static Benchmark s_data_shift("data/shift-100", [](size_t n) {
+  std::string chunk(DATA_CHUNK_SIZE, 'x');
+  Data data, out;
+  for (size_t i = 0; i < n; i++) {
+    if (data.size() < 100) {
+      for (int j = 0; j < 16; j++) data.push(chunk, &s_dp);
+    }
+    data.shift(100, out);
+    out.clear();
+  }
+  keep(data.size());
+});
+
+static Benchmark s_data_pack("data/pack-100", [](size_t n) {
+  Data piece(std::string(100, 'x'), &s_dp);
+  Data data;
+  for (size_t i = 0; i < n; i++) {
+    data.pack(piece, &s_dp);
+    if ((i & 255) == 255) data.clear();
+  }
+  keep(data.size());
+});
+
+//
+// Str
+//
+
+static Benchmark s_str_make("str/make-release", [](size_t n) {
+  auto keys = make_keys(1024, "key-");
+  for (size_t i = 0; i < n; i++) {
+    pjs::Ref<pjs::Str> s(pjs::Str::make(keys[i & 1023]));
+    keep(s.get());
+  }
+});
+
+static Benchmark s_str_make_interned("str/make-interned", [](size_t n) {
+  auto keys = make_keys(1024, "key-");
+  std::vector<pjs::Ref<pjs::Str>> alive;
+  for (const auto &k : keys) alive.push_back(pjs::Str::make(k));
+  for (size_t i = 0; i < n; i++) {
+    pjs::Ref<pjs::Str> s(pjs::Str::make(keys[i & 1023]));
+    keep(s.get());
+  }
+});
+
+//
+// pjs::Object
+//
+
+static Benchmark s_object_get("pjs/object-get", [](size_t n) {
+  auto keys = make_keys(16, "prop");
+  std::vector<pjs::Ref<pjs::Str>> names;
+  pjs::Ref<pjs::Object> obj = pjs::Object::make();
+  for (const auto &k : keys) {
+    names.push_back(pjs::Str::make(k));
+    obj->set(names.back(), int(names.size()));
+  }
+  pjs::Value v;
+  for (size_t i = 0; i < n; i++) {
+    obj->get(names[i & 15], v);
+  }
+  keep(size_t(v.to_int32()));
+});
+
+static Benchmark s_object_set("pjs/object-set", [](size_t n) {
+  auto keys = make_keys(16, "prop");
+  std::vector<pjs::Ref<pjs::Str>> names;
+  for (const auto &k : keys) names.push_back(pjs::Str::make(k));
+  pjs::Ref<pjs::Object> obj = pjs::Object::make();
+  for (size_t i = 0; i < n; i++) {
+    obj->set(names[i & 15], int(i));
+  }
+  keep(obj->ht_size());
+});
+
+static Benchmark s_object_field("pjs/class-field-get", [](size_t n) {
+  pjs::Ref<pjs::Str> name(pjs::Str::make("status"));
+  pjs::Ref<http::ResponseHead> head = http::ResponseHead::make();
+  pjs::Value v;
+  for (size_t i = 0; i < n; i++) {
+    head->get(name, v);
+  }
+  keep(size_t(v.to_int32()));
+});
+
+//
+// Pool
+//
+
+struct PooledItem : public pjs::Pooled<PooledItem> {
+  char data[64];
+};
+
+static Benchmark s_pool("pool/alloc-free", [](size_t n) {
+  PooledItem *items[16];
+  for (size_t i = 0; i < n; i += 16) {
+    for (int j = 0; j < 16; j++) items[j] = new PooledItem;
+    for (int j = 0; j < 16; j++) delete items[j];
+  }
+  keep(items[0]);
+});
+
+//
+// OrderedHash
+//
+
+static Benchmark s_ordered_hash_get("ordered-hash/get", [](size_t n) {
+  pjs::Ref<pjs::OrderedHash<pjs::Value, pjs::Value>> h = pjs::OrderedHash<pjs::Value, pjs::Value>::make();
+  for (int i = 0; i < 1024; i++) h->set(i, i);
+  pjs::Value v;
+  for (size_t i = 0; i < n; i++) {
+    h->get(int(i & 1023), v);
+  }
+  keep(size_t(v.to_int32()));
+});
+
+static Benchmark s_ordered_hash_set("ordered-hash/set-erase", [](size_t n) {
+  pjs::Ref<pjs::OrderedHash<pjs::Value, pjs::Value>> h = pjs::OrderedHash<pjs::Value, pjs::Value>::make();
+  for (size_t i = 0; i < n; i++) {
+    h->set(int(i & 1023), int(i));
+    if ((i & 1023) == 1023) h->clear();
+  }
+  keep(h->size());
+});
+
+//
+// Percentile
+//
+
+static Benchmark s_percentile_observe("percentile/observe", [](size_t n) {
+  pjs::Ref<pjs::Array> buckets = pjs::Array::make();
+  for (int i = 1; i <= 64; i++) buckets->push(i * i);
+  pjs::Ref<algo::Percentile> p = algo::Percentile::make(buckets.get());
+  for (size_t i = 0; i < n; i++) {
+    p->observe(double(i & 4095));
+  }
+  keep(p->get(0));
+});
+
+static Benchmark s_percentile_calculate("percentile/calculate", [](size_t n) {
+  pjs::Ref<pjs::Array> buckets = pjs::Array::make();
+  for (int i = 1; i <= 64; i++) buckets->push(i * i);
+  pjs::Ref<algo::Percentile> p = algo::Percentile::make(buckets.get());
+  for (int i = 0; i < 4096; i++) p->observe(i);
+  double sum = 0;
+  for (size_t i = 0; i < n; i++) {
+    sum += p->calculate(int(i % 100));
+  }
+  keep(size_t(sum));
+});
+
+//
+// Deframer
+//
+
+class LengthPrefixed : public Deframer {
+public:
+  size_t frames = 0;
+
+private:
+  int m_size = 0;
+  pjs::Ref<Data> m_payload;
+
+  virtual auto on_state(int state, int c) -> int override {
+    switch (state) {
+      case 0:
+        m_size = c << 8;
+        return 1;
+      case 1:
+        m_size |= c;
+        if (m_size == 0) {
+          frames++;
+          return 0;
+        }
+        m_payload = Data::make();
+        read(m_size, m_payload);
+        return 2;
+      case 2:
+        frames++;
+        return 0;
+    }
+    return -1;
+  }
+};
+
+static Benchmark s_deframer("deframer/frames-100", [](size_t n) {
+  Data frames;
+  for (int i = 0; i < 100; i++) {
+    uint8_t header[2] = { 0, 100 };
+    frames.push(header, sizeof(header), &s_dp);
+    frames.push(std::string(100, 'x'), &s_dp);
+  }
+  LengthPrefixed deframer;
+  for (size_t i = 0; i < n; i += 100) {
+    Data data(frames);
+    deframer.deframe(data);
+  }
+  keep(deframer.frames);
+});
+
+} // namespace bench
+} // namespace pipy
@@ -0,0 +1,149 @@
+/*
+ *  Copyright (c) 2019 by flomesh.io
+ *
+ *  Unless prior written consent has been obtained from the copyright
+ *  owner, the following shall not be allowed.
+ *
+ *  1. The distribution of any source codes, header files, make files,
+ *     or libraries of the software.
+ *
+ *  2. Disclosure of any source codes pertaining to the software to any
+ *     additional parties.
+ *
+ *  3. Alteration or removal of any notices in or on the software or
+ *     within the documentation included within the software.
+ *
+ *  ALL SOURCE CODE AS WELL AS ALL DOCUMENTATION INCLUDED WITH THIS
+ *  SOFTWARE IS PROVIDED IN AN “AS IS” CONDITION, WITHOUT WARRANTY OF ANY
+ *  KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ *  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ *  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "bench.hpp"
+#include "data.hpp"
+#include "event.hpp"
+#include "api/http.hpp"
+#include "filters/http.hpp"
+#include "filters/http2.hpp"
+
+namespace pipy {
+namespace bench {
+
+thread_local static Data::Producer s_dp("Benchmark HTTP");
+
+static const char s_request[] =
+  "GET /api/v1/products/12345?fields=name,price HTTP/1.1\r\n"
+  "Host: shop.example.com\r\n"
+  "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36\r\n"
+  "Accept: application/json, text/plain, */*\r\n"
+  "Accept-Encoding: gzip, deflate, br\r\n"
+  "Accept-Language: en-US,en;q=0.9\r\n"
+  "Cache-Control: no-cache\r\n"
+  "Cookie: session=0123456789abcdef; theme=dark\r\n"
+  "Referer: https://shop.example.com/products\r\n"
+  "X-Request-Id: 7f3c2a1e-5b4d-4c6e-8f9a-0b1c2d3e4f5a\r\n"
+  "Content-Length: 0\r\n"
+  "\r\n";
+
+static auto make_request_head() -> http::RequestHead* {
+  auto head = http::RequestHead::make();
+  head->method = pjs::Str::make("GET");
+  head->scheme = pjs::Str::make("https");
+  head->authority = pjs::Str::make("shop.example.com");
+  head->path = pjs::Str::make("/api/v1/products/12345?fields=name,price");
+  auto headers = pjs::Object::make();
+  headers->set("user-agent", pjs::Str::make("Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36"));
+  headers->set("accept", pjs::Str::make("application/json, text/plain, */*"));
+  headers->set("accept-encoding", pjs::Str::make("gzip, deflate, br"));
+  headers->set("accept-language", pjs::Str::make("en-US,en;q=0.9"));
+  headers->set("cache-control", pjs::Str::make("no-cache"));
+  headers->set("cookie", pjs::Str::make("session=0123456789abcdef; theme=dark"));
+  headers->set("referer", pjs::Str::make("https://shop.example.com/products"));
+  headers->set("x-request-id", pjs::Str::make("7f3c2a1e-5b4d-4c6e-8f9a-0b1c2d3e4f5a"));
+  head->headers = headers;
+  return head;
+}
+
+//
+// Counts whatever comes out of a codec
+//
+
+class Sink : public EventTarget {
+public:
+  size_t events = 0;
+  size_t bytes = 0;
+
+private:
+  virtual void on_event(Event *evt) override {
+    events++;
+    if (auto data = evt->as<Data>()) bytes += data->size();
+  }
+};
+
+//
+// HTTP/1
+//
+
+static Benchmark s_http_decode("http/decode-request", [](size_t n) {
+  Data request(s_request, sizeof(s_request) - 1, &s_dp);
+  Sink sink;
+  http::Decoder decoder(false);
+  decoder.chain(sink.input());
+  for (size_t i = 0; i < n; i++) {
+    decoder.input()->input(Data::make(request));
+  }
+  keep(sink.events);
+});
+
+static Benchmark s_http_encode("http/encode-request", [](size_t n) {
+  pjs::Ref<http::RequestHead> head = make_request_head();
+  Sink sink;
+  http::Encoder encoder(false);
+  encoder.chain(sink.input());
+  for (size_t i = 0; i < n; i++) {
+    encoder.input()->input(MessageStart::make(head));
+    encoder.input()->input(MessageEnd::make());
+  }
+  keep(sink.bytes);
+});
+
+//
+// HPACK
+//
+
+static Benchmark s_hpack_encode("hpack/encode-request", [](size_t n) {
+  pjs::Ref<http::RequestHead> head = make_request_head();
+  http2::HeaderEncoder encoder;
+  size_t size = 0;
+  for (size_t i = 0; i < n; i++) {
+    Data data;
+    encoder.encode(false, false, head, data);
+    size += data.size();
+  }
+  keep(size);
+});
+
+static Benchmark s_hpack_decode("hpack/decode-request", [](size_t n) {
+  pjs::Ref<http::RequestHead> head = make_request_head();
+  http2::HeaderEncoder encoder;
+  Data block;
+  encoder.encode(false, false, head, block);
+
+  http2::Settings settings;
+  http2::HeaderDecoder decoder(settings);
+  for (size_t i = 0; i < n; i++) {
+    Data data(block);
+    pjs::Ref<http::MessageHead> decoded;
+    decoder.start(false, false);
+    decoder.decode(data);
+    decoder.end(decoded);
+    keep(decoded.get());
+  }
+});
+
+} // namespace bench
+} // namespace pipy
@@ -0,0 +1,285 @@
+/*
+ *  Copyright (c) 2019 by flomesh.io
+ *
+ *  Unless prior written consent has been obtained from the copyright
+ *  owner, the following shall not be allowed.
+ *
+ *  1. The distribution of any source codes, header files, make files,
+ *     or libraries of the software.
+ *
+ *  2. Disclosure of any source codes pertaining to the software to any
+ *     additional parties.
+ *
+ *  3. Alteration or removal of any notices in or on the software or
+ *     within the documentation included within the software.
+ *
+ *  ALL SOURCE CODE AS WELL AS ALL DOCUMENTATION INCLUDED WITH THIS
+ *  SOFTWARE IS PROVIDED IN AN “AS IS” CONDITION, WITHOUT WARRANTY OF ANY
+ *  KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ *  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ *  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// pipy-bench runs microbenchmarks of the core primitives and prints
+// the results as JSON to stdout. Given the JSON from an earlier run
+// with --compare, it shows the changes and fails when any benchmark
+// is slower than the baseline by more than --threshold percent.
+//
+// Build with -DPIPY_BENCH=ON, then:
+//
+//   pipy-bench > base.json
+//   (make changes and rebuild)
+//   pipy-bench --compare=base.json
+//
+
+#include "bench.hpp"
+#include "api/json.hpp"
+#include "version.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+using namespace pipy;
+
+namespace pipy {
+namespace bench {
+
+static volatile size_t s_sink = 0;
+
+void keep(size_t n) { s_sink = s_sink + n; }
+void keep(const void *p) { s_sink = s_sink + (size_t)p; }
+
+} // namespace bench
+} // namespace pipy
+
+struct RunOptions {
+  std::string filter;
+  std::string compare;
+  int repeat = 5;
+  double min_time = 100;
+  double threshold = 10;
+  bool list = false;
+};
+
+struct Result {
+  std::string name;
+  size_t iterations;
+  double ns_per_op;
+  double min;
+  double max;
+};
+
+static void show_help() {
+  std::cout << "Usage: pipy-bench [options]" << std::endl;
+  std::cout << std::endl;
+  std::cout << "  --filter=<string>       Only run benchmarks with names containing the string" << std::endl;
+  std::cout << "  --repeat=<number>       Samples taken for each benchmark (default: 5)" << std::endl;
+  std::cout << "  --min-time=<ms>         Minimum time of each sample (default: 100)" << std::endl;
+  std::cout << "  --compare=<filename>    Compare with the JSON output from an earlier run" << std::endl;
+  std::cout << "  --threshold=<percent>   Slowdown counted as a regression (default: 10)" << std::endl;
+  std::cout << "  --list                  List all benchmarks" << std::endl;
+  std::cout << "  --help                  Show this help" << std::endl;
+}
+
+static bool parse_options(int argc, char *argv[], RunOptions &options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg(argv[i]), k, v;
+    auto p = arg.find('=');
+    if (p == std::string::npos) {
+      k = arg;
+    } else {
+      k = arg.substr(0, p);
+      v = arg.substr(p + 1);
+    }
+    if (k == "--filter") {
+      options.filter = v;
+    } else if (k == "--compare") {
+      options.compare = v;
+    } else if (k == "--repeat") {
+      options.repeat = std::max(1, std::atoi(v.c_str()));
+    } else if (k == "--min-time") {
+      options.min_time = std::max(1.0, std::atof(v.c_str()));
+    } else if (k == "--threshold") {
+      options.threshold = std::atof(v.c_str());
+    } else if (k == "--list") {
+      options.list = true;
+    } else if (k == "--help" || k == "-h") {
+      show_help();
+      return false;
+    } else {
+      std::cerr << "unknown option: " << arg << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+static const size_t s_max_iterations = 1000000000;
+
+static auto time_ns(const bench::Benchmark *b, size_t n) -> double {
+  auto t = std::chrono::steady_clock::now();
+  b->run(n);
+  auto d = std::chrono::steady_clock::now() - t;
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+}
+
+static auto measure(const bench::Benchmark *b, const RunOptions &options) -> Result {
+  auto min_time = options.min_time * 1e6;
+
+  // Grow the iteration count until a sample takes long enough,
+  // or stop at the cap for a body that takes next to no time
+  size_t n = 1;
+  for (;;) {
+    auto t = time_ns(b, n);
+    if (t >= min_time || n >= s_max_iterations) break;
+    if (t < min_time / 100) {
+      n *= 10;
+    } else {
+      n = size_t(n * min_time / t * 1.2) + 1;
+    }
+    n = std::min(n, s_max_iterations);
+  }
+
+  std::vector<double> samples;
+  for (int i = 0; i < options.repeat; i++) {
+    samples.push_back(time_ns(b, n) / n);
+  }
+
+  std::sort(samples.begin(), samples.end());
+
+  Result r;
+  r.name = b->name();
+  r.iterations = n;
+  r.ns_per_op = samples[samples.size() / 2];
+  r.min = samples.front();
+  r.max = samples.back();
+  return r;
+}
+
+static bool load_baseline(const std::string &filename, std::map<std::string, double> &baseline) {
+  std::ifstream fs(filename, std::ios::in);
+  if (!fs.is_open()) {
+    std::cerr << "cannot open " << filename << std::endl;
+    return false;
+  }
+
+  std::stringstream ss;
+  ss << fs.rdbuf();
+
+  pjs::Value json;
+  std::string err;
+  if (!JSON::parse(ss.str(), nullptr, json, err)) {
+    std::cerr << "cannot parse " << filename << ": " << err << std::endl;
+    return false;
+  }
+
+  pjs::Value benchmarks;
+  if (json.is_object() && json.o()) json.o()->get("benchmarks", benchmarks);
+  if (!benchmarks.is_array()) {
+    std::cerr << "no benchmarks found in " << filename << std::endl;
+    return false;
+  }
+
+  benchmarks.as<pjs::Array>()->iterate_all(
+    [&](pjs::Value &v, int) {
+      if (!v.is_object() || !v.o()) return;
+      pjs::Value name, ns;
+      v.o()->get("name", name);
+      v.o()->get("ns_per_op", ns);
+      if (name.is_string() && ns.is_number()) {
+        baseline[name.s()->str()] = ns.n();
+      }
+    }
+  );
+
+  return true;
+}
+
+static void print_result(const Result &r, const std::map<std::string, double> &baseline, const RunOptions &options) {
+  char line[200];
+  std::snprintf(line, sizeof(line), "%-36s %12.2f ns/op", r.name.c_str(), r.ns_per_op);
+  std::cerr << line;
+  auto i = baseline.find(r.name);
+  if (i != baseline.end() && i->second > 0) {
+    auto change = (r.ns_per_op - i->second) / i->second * 100;
+    std::snprintf(line, sizeof(line), " %12.2f ns/op %+8.2f%%", i->second, change);
+    std::cerr << line;
+    if (change > options.threshold) std::cerr << "  REGRESSION";
+  }
+  std::cerr << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  RunOptions options;
+  if (!parse_options(argc, argv, options)) return -1;
+
+  auto &all = bench::Benchmark::all();
+  std::sort(
+    all.begin(), all.end(),
+    [](bench::Benchmark *a, bench::Benchmark *b) {
+      return a->name() < b->name();
+    }
+  );
+
+  if (options.list) {
+    for (const auto *b : all) std::cout << b->name() << std::endl;
+    return 0;
+  }
+
+  std::map<std::string, double> baseline;
+  if (!options.compare.empty()) {
+    if (!load_baseline(options.compare, baseline)) return -1;
+  }
+
+  pjs::Ref<pjs::Array> results = pjs::Array::make();
+  int regressions = 0;
+
+  for (const auto *b : all) {
+    if (b->name().find(options.filter) == std::string::npos) continue;
+    auto r = measure(b, options);
+    print_result(r, baseline, options);
+
+    pjs::Ref<pjs::Object> obj = pjs::Object::make();
+    obj->set("name", pjs::Str::make(r.name));
+    obj->set("iterations", double(r.iterations));
+    obj->set("ns_per_op", r.ns_per_op);
+    obj->set("min", r.min);
+    obj->set("max", r.max);
+
+    auto i = baseline.find(r.name);
+    if (i != baseline.end() && i->second > 0) {
+      auto change = (r.ns_per_op - i->second) / i->second * 100;
+      obj->set("baseline", i->second);
+      obj->set("change", change);
+      if (change > options.threshold) regressions++;
+    }
+
+    results->push(obj.get());
+  }
+
+  pjs::Ref<pjs::Object> report = pjs::Object::make();
+  report->set("version", pjs::Str::make(PIPY_VERSION));
+  report->set("commit", pjs::Str::make(PIPY_COMMIT));
+  report->set("repeat", options.repeat);
+  report->set("min_time", options.min_time);
+  report->set("benchmarks", results.get());
+
+  std::cout << JSON::stringify(report.get(), nullptr, 2) << std::endl;
+
+  if (regressions > 0) {
+    std::cerr << regressions << " benchmark(s) slower than the baseline by more than " << options.threshold << "%" << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
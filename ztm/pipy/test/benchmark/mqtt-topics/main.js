@@ -0,0 +1,107 @@
+//
+// Measures routing of MQTT PUBLISH messages to subscribers with
+// algo.TopicTrie, against a script looping over the subscription list.
+// Subscriptions are modelled after a fleet of devices: one exact filter
+// per device, wildcard filters for alarms and dashboards, and a shared
+// group of workers taking all telemetry.
+//
+// Run from this directory:
+//
+//   ../../../bin/pipy main.js
+//
+// Environment variables:
+//   SUBSCRIPTIONS - Number of device subscriptions (default: 100000)
+//   PUBLISHES     - Number of PUBLISH messages routed (default: 100000)
+//   HOT           - Number of devices publishing most of the time (default: 100)
+//   SCAN          - Number of PUBLISH messages routed by the script loop (default: 10)
+//
+
+var subscriptionCount = (os.env.SUBSCRIPTIONS|0) || 100000
+var publishCount = (os.env.PUBLISHES|0) || 100000
+var hotCount = (os.env.HOT|0) || 100
+var scanCount = (os.env.SCAN|0) || 10
+
+var sites = 100
+
+var seed = 1
+var random = () => (seed = seed * 16807 % 2147483647)
+
+var filters = [
+  ...new Array(subscriptionCount).fill(0).map(
+    (_, i) => [`site/${i % sites}/device/${(i / sites)|0}/command`, `device-${i}`]
+  ),
+  ...new Array(sites).fill(0).map(
+    (_, i) => [`site/${i}/#`, `dashboard-${i}`]
+  ),
+  ['+/+/device/+/alarm', 'alarms'],
+  ...new Array(8).fill(0).map(
+    (_, i) => ['$share/workers/site/+/device/+/telemetry', `worker-${i}`]
+  ),
+]
+
+var trie = new algo.TopicTrie()
+var t = Date.now()
+filters.forEach(([f, s]) => trie.subscribe(f, s))
+console.log(`subscribe: ${Date.now() - t} ms for ${trie.size} subscriptions`)
+
+var topicOf = () => {
+  var i = random() % 10 < 9 ? random() % hotCount : random() % subscriptionCount
+  var kind = ['telemetry', 'telemetry', 'telemetry', 'command', 'alarm'][random() % 5]
+  return `site/${i % sites}/device/${(i / sites)|0}/${kind}`
+}
+
+var encode = pipeline($=>$
+  .onStart(() => new Array(publishCount).fill(0).map(
+    () => new Message({ type: 'PUBLISH', topicName: topicOf() }, 'x')
+  ))
+  .encodeMQTT()
+  .handleData(d => packets.push(d))
+)
+
+var packets = new Data
+
+var delivered = 0
+
+var route = pipeline($=>$
+  .onStart(() => new Data(packets))
+  .decodeMQTT()
+  .handleMessageStart(msg => delivered += trie.match(msg.head.topicName).length)
+)
+
+//
+// What scripts did before: test every filter on every PUBLISH
+//
+
+var scanFilters = filters.filter(
+  ([f, s]) => !f.startsWith('$share/') || s === 'worker-0'
+).map(
+  ([f, s]) => [f.startsWith('$share/') ? f.split('/').slice(2).join('/') : f, s]
+)
+
+function matches(filter, topic) {
+  var fl = filter.split('/')
+  var tl = topic.split('/')
+  var n = fl.indexOf('#')
+  if (n >= 0) return tl.length >= n && fl.slice(0, n).every((l, i) => l === '+' || l === tl[i])
+  return fl.length === tl.length && fl.every((l, i) => l === '+' || l === tl[i])
+}
+
+var scan = () => new Array(scanCount).fill(0).reduce(
+  (n, _) => {
+    var topic = topicOf()
+    return n + scanFilters.filter(([f]) => matches(f, topic)).length
+  }, 0
+)
+
+Promise.resolve(encode.spawn()).then(() => {
+  var t = Date.now()
+  return Promise.resolve(route.spawn()).then(() => {
+    var ms = Date.now() - t
+    console.log(`TopicTrie: ${ms} ms for ${publishCount} PUBLISH messages, ${(ms * 1000 / publishCount).toFixed(1)} us per message, ${delivered} deliveries`)
+  })
+}).then(() => {
+  var t = Date.now()
+  var n = scan()
+  var ms = Date.now() - t
+  console.log(`script scan: ${ms} ms for ${scanCount} PUBLISH messages, ${(ms / scanCount).toFixed(1)} ms per message, ${n} deliveries`)
+})
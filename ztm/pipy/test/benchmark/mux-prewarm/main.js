@@ -0,0 +1,70 @@
+//
+// Measures the latency of requests that arrive after the upstream
+// connections have been idle for longer than maxIdle, going through
+// muxHTTP with and without minIdle. The upstream takes some time to
+// accept each new connection to stand in for TCP and TLS handshakes.
+//
+// Run from this directory:
+//
+//   ../../../bin/pipy main.js
+//
+// Environment variables:
+//   MIN_IDLE  - Sessions kept warm in the second test (default: 2)
+//   HANDSHAKE - Milliseconds to set up an upstream connection (default: 50)
+//   ROUNDS    - Number of requests in each test (default: 5)
+//   IDLE      - Milliseconds between requests (default: 1500)
+//
+
+var minIdle = (os.env.MIN_IDLE|0) || 2
+var handshake = (os.env.HANDSHAKE|0) || 50
+var rounds = (os.env.ROUNDS|0) || 5
+var idle = (os.env.IDLE|0) || 1500
+
+pipy.listen(8081, $=>$
+  .wait(() => new Timeout(handshake / 1000).wait())
+  .demuxHTTP().to($=>$
+    .replaceMessage(new Message('ok'))
+  )
+)
+
+pipy.listen(8080, $=>$
+  .demuxHTTP().to($=>$
+    .muxHTTP({ version: 2, maxIdle: 0.5 }).to($=>$
+      .connect('localhost:8081')
+    )
+  )
+)
+
+pipy.listen(8082, $=>$
+  .demuxHTTP().to($=>$
+    .muxHTTP({ version: 2, maxIdle: 0.5, minIdle, pingInterval: 0.5 }).to($=>$
+      .connect('localhost:8081')
+    )
+  )
+)
+
+function measure(agent, n, total, max) {
+  if (n === 0) return Promise.resolve([total, max])
+  return new Timeout(idle / 1000).wait().then(() => {
+    var t = Date.now()
+    return agent.request('GET', '/').then(
+      res => {
+        var ms = Date.now() - t
+        if (res.head.status !== 200) throw `status ${res.head.status}`
+        return measure(agent, n - 1, total + ms, Math.max(max, ms))
+      }
+    )
+  })
+}
+
+function report(name) {
+  return ([total, max]) => console.log(
+    `${name}: ${(total / rounds).toFixed(2)} ms per request, ${max} ms max`
+  )
+}
+
+measure(new http.Agent('localhost:8080'), rounds, 0, 0).then(report('minIdle: 0')).then(
+  () => measure(new http.Agent('localhost:8082'), rounds, 0, 0).then(report(`minIdle: ${minIdle}`))
+).then(
+  () => pipy.exit()
+)
@@ -0,0 +1,62 @@
+//
+// Measures the throughput of native modules using the per-event
+// copying API versus batched events with zero-copy chunk access.
+//
+// Build the sample modules first, then run from this directory:
+//
+//   make -C ../../../samples/nmi/echo
+//   make -C ../../../samples/nmi/rot13
+//   ../../../bin/pipy main.js
+//
+// Environment variables:
+//   SIZE   - Size of each Data event in bytes (default: 16384)
+//   EVENTS - Number of Data events per measurement (default: 100000)
+//
+
+var size = (os.env.SIZE|0) || 16384
+var eventCount = (os.env.EVENTS|0) || 100000
+
+var chunk = new Data('The quick brown fox jumps over the lazy dog. '.repeat(Math.ceil(size / 45)).substring(0, size))
+var events = new Array(eventCount).fill(chunk).concat(new StreamEnd)
+
+var tests = [
+  ['echo', 'copy'],
+  ['echo', 'batch'],
+  ['rot13', 'copy'],
+  ['rot13', 'batch'],
+]
+
+var done = 0
+var startTime
+var received
+
+var config = pipy()
+
+tests.forEach(
+  ([module, mode]) => config
+    .pipeline(`${module}-${mode}`)
+    .use(`../../../bin/${module}.so`, mode)
+    .handleData(d => received += d.size)
+)
+
+tests.forEach(
+  ([module, mode]) => config
+    .task()
+    .onStart(() => (
+      startTime = Date.now(),
+      received = 0,
+      events
+    ))
+    .link(`${module}-${mode}`)
+    .handleStreamEnd(() => {
+      var ms = Date.now() - startTime
+      console.log(
+        `${module} (${mode}):`,
+        ms, 'ms,',
+        (received / 1024 / 1024 / (ms / 1000)).toFixed(2), 'MB/s'
+      )
+      if (++done === tests.length) pipy.exit(0)
+    })
+)
+
+config
@@ -0,0 +1,36 @@
+//
+// Measures bursts of short-lived sub-pipelines, each carrying a chain
+// of ten filters, created all at once by a fork() to many targets.
+//
+// Run from this directory:
+//
+//   ../../../bin/pipy main.js
+//
+// Environment variables:
+//   BRANCHES - Number of sub-pipelines in each burst (default: 20000)
+//   ROUNDS   - Number of bursts (default: 5)
+//
+
+var branchCount = (os.env.BRANCHES|0) || 20000
+var rounds = (os.env.ROUNDS|0) || 5
+
+var targets = new Array(branchCount).fill(0)
+
+var burst = pipeline($=>$
+  .onStart(() => new Message('x'))
+  .fork(targets).to($=>$
+    .replaceData(d => d).replaceMessage(m => m).handleStreamEnd(() => {}).handleData(() => {}).handleMessage(() => {})
+    .replaceData(d => d).replaceMessage(m => m).handleStreamEnd(() => {}).handleData(() => {}).handleMessage(() => {})
+  )
+)
+
+function run(n) {
+  if (n === rounds) return
+  var t = Date.now()
+  return Promise.resolve(burst.spawn()).then(() => {
+    console.log(`burst ${n}: ${Date.now() - t} ms for ${branchCount} sub-pipelines`)
+    return run(n + 1)
+  })
+}
+
+run(0)
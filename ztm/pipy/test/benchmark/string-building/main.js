@@ -0,0 +1,89 @@
+//
+// Measures the string building patterns found in access-log scripts:
+// formatting log lines, batching them up for a logging backend and
+// accumulating request bodies, using both + and template literals.
+//
+// Run from this directory:
+//
+//   ../../../bin/pipy main.js
+//
+// Environment variables:
+//   LINES  - Number of log lines per batch (default: 10000)
+//   ROUNDS - Number of times each test is repeated (default: 10)
+//
+
+var lineCount = (os.env.LINES|0) || 10000
+var rounds = (os.env.ROUNDS|0) || 10
+
+var lines = new Array(lineCount).fill(0)
+
+var record = {
+  time: '2023-06-01T12:34:56.789Z',
+  method: 'GET',
+  path: '/api/v1/users/12345/orders?page=2&size=50',
+  status: 200,
+  bytes: 1234,
+  agent: 'Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/114.0 Safari/537.36',
+  upstream: '10.0.1.23:8080',
+  latency: 12.3,
+}
+
+var chunk = 'x'.repeat(1000)
+
+var tests = [
+  [
+    'format lines with +',
+    () => lines.map(
+      (_, i) => record.time + ' ' + record.method + ' ' + record.path + ' ' + record.status + ' ' + (record.bytes + i) + ' "' + record.agent + '" ' + record.upstream + ' ' + record.latency
+    ).length
+  ],
+  [
+    'format lines with templates',
+    () => lines.map(
+      (_, i) => `${record.time} ${record.method} ${record.path} ${record.status} ${record.bytes + i} "${record.agent}" ${record.upstream} ${record.latency}`
+    ).length
+  ],
+  [
+    'batch lines with +=',
+    () => {
+      var batch = ''
+      lines.forEach((_, i) => { batch += record.time + ' ' + record.path + ' ' + i + '\n' })
+      return batch.length
+    }
+  ],
+  [
+    'batch lines with templates',
+    () => {
+      var batch = ''
+      lines.forEach((_, i) => { batch = `${batch}${record.time} ${record.path} ${i}\n` })
+      return batch.length
+    }
+  ],
+  [
+    'batch JSON with +',
+    () => {
+      var batch = '['
+      lines.forEach((_, i) => {
+        batch = batch + (i > 0 ? ',' : '') + '{"time":"' + record.time + '","path":"' + record.path + '","status":' + record.status + ',"n":' + i + '}'
+      })
+      batch = batch + ']'
+      return JSON.parse(batch).length
+    }
+  ],
+  [
+    'accumulate body',
+    () => {
+      var body = ''
+      lines.forEach(() => { body += chunk })
+      return body.substring(body.length - 10).length
+    }
+  ],
+]
+
+tests.forEach(([name, f]) => {
+  var t = Date.now()
+  var n = 0
+  new Array(rounds).fill(0).forEach(() => { n += f() })
+  var ms = Date.now() - t
+  console.log(`${name}: ${(ms / rounds).toFixed(2)} ms per batch of ${lineCount} (${n / rounds})`)
+})
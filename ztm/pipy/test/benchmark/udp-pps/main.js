@@ -0,0 +1,72 @@
+//
+// Measures UDP packets per second through a listener, with a number
+// of senders each blasting bursts of small datagrams at it, as the
+// UDP port-forwarding and DNS paths see them.
+//
+// Run from this directory:
+//
+//   ../../../bin/pipy main.js
+//
+// Environment variables:
+//   PORT     - Port to listen on (default: 9100)
+//   SIZE     - Size of each datagram in bytes (default: 64)
+//   BURST    - Number of datagrams sent by a sender at a time (default: 64)
+//   SENDERS  - Number of senders (default: 4)
+//   DURATION - Seconds to run (default: 5)
+//
+
+var port = (os.env.PORT|0) || 9100
+var size = (os.env.SIZE|0) || 64
+var burst = (os.env.BURST|0) || 64
+var senderCount = (os.env.SENDERS|0) || 4
+var duration = Number.parseFloat(os.env.DURATION) || 5
+
+var payload = 'x'.repeat(size)
+var sent = 0
+var received = 0
+var running = true
+
+pipy.listen(port, 'udp', $=>$
+  .handleData(() => { received++ })
+)
+
+var sender = pipeline($=>$
+  .connect(`localhost:${port}`, { protocol: 'udp' })
+)
+
+function blast() {
+  if (!running) return new Promise(() => {})
+  return new Timeout(0).wait().then(() => {
+    sent += burst
+    return new Array(burst).fill(0).map(() => new Data(payload))
+  })
+}
+
+var lastSent = 0
+var lastReceived = 0
+
+function report(t) {
+  console.log(
+    `sent ${((sent - lastSent) / t).toFixed(0)} pps, received ${((received - lastReceived) / t).toFixed(0)} pps`
+  )
+  lastSent = sent
+  lastReceived = received
+}
+
+function tick(n) {
+  if (n === 0) return
+  return new Timeout(1).wait().then(() => {
+    report(1)
+    return tick(n - 1)
+  })
+}
+
+new Array(senderCount).fill(0).forEach(() => sender.process(blast))
+
+tick(Math.ceil(duration)).then(() => {
+  running = false
+  return new Timeout(0.5).wait()
+}).then(() => {
+  console.log(`total: ${sent} sent, ${received} received (${(received * 100 / (sent || 1)).toFixed(1)}%)`)
+  pipy.exit()
+})
@@ -0,0 +1,35 @@
+var attempt = f => {
+  try {
+    return JSON.stringify(f())
+  } catch (e) {
+    return 'error'
+  }
+}
+
+var check = (text, i) => {
+  var view
+  try {
+    view = JSON.view(text)
+  } catch (e) {
+    return `${i}: view error\n`
+  }
+  var value = attempt(() => view.get())
+  var parsed = attempt(() => JSON.parse(text))
+  return [
+    `${i}: get ${value}`,
+    `${i}: keys ${attempt(() => view.keys())}`,
+    `${i}: size ${attempt(() => view.size())}`,
+    `${i}: same ${value === parsed}`,
+    ''
+  ].join('\n')
+}
+
+pipy.read('input', $=>$
+  .replaceStreamStart(evt => [new MessageStart, evt])
+  .replaceMessageBody(
+    data => new Data(
+      data.toString().split('\n').filter(l => l !== '').map(check).join('')
+    )
+  )
+  .tee('-')
+)
@@ -0,0 +1,72 @@
+var schema = new protobuf.Schema(pipy.load('schema.proto').toString())
+
+var nest = n => new Array(n).fill(0).reduce(child => ({ name: 'n', child }), { name: 'leaf' })
+var depth = obj => JSON.stringify(obj).split('"child"').length
+
+var varint = n => n < 128 ? [n] : [(n & 127) | 128, n >> 7]
+var concat = (a, b) => (a.push(b), a)
+var wrap = (data, n) => n > 0 ? wrap(concat(new Data([0x12].concat(varint(data.size))), data), n - 1) : data
+
+var encodeNodes = n => {
+  try {
+    return `encoded ${schema.encode('tutorial.Node', nest(n)).size} bytes`
+  } catch (e) {
+    return 'encode error'
+  }
+}
+
+var decodeNodes = data => (
+  (obj => obj ? `decoded ${depth(obj)} levels` : 'decode failed')(
+    schema.decode('tutorial.Node', data)
+  )
+)
+
+var large = {
+  people: [
+    {
+      name: 'Pipy'.repeat(40),
+      id: 12345678,
+      email: 'pipy@flomesh.io',
+      phones: [
+        { number: '86-21-88888888', type: 'WORK' },
+        { number: '86-21-'.repeat(30), type: 'HOME' },
+      ],
+      tags: { team: 'core', role: 'proxy'.repeat(30) },
+      scores: [1, 200, 30000, -1],
+    },
+    {
+      name: 'Pajama Coder',
+      id: 87654321,
+      phones: [],
+      tags: {},
+      scores: [],
+    },
+  ]
+}
+
+var check = data => {
+  var book = schema.decode('tutorial.AddressBook', data)
+  var encoded = schema.encode('tutorial.AddressBook', book)
+  var largeEncoded = schema.encode('tutorial.AddressBook', large)
+  var largeDecoded = schema.decode('tutorial.AddressBook', largeEncoded)
+  return [
+    JSON.stringify(book),
+    `round trip ${encoded.toString('hex') === data.toString('hex')}`,
+    largeEncoded.toString('hex'),
+    JSON.stringify(largeDecoded),
+    encodeNodes(99),
+    encodeNodes(100),
+    decodeNodes(schema.encode('tutorial.Node', nest(99))),
+    decodeNodes(wrap(schema.encode('tutorial.Node', nest(99)), 0)),
+    decodeNodes(wrap(schema.encode('tutorial.Node', nest(98)), 1)),
+    decodeNodes(wrap(schema.encode('tutorial.Node', nest(99)), 1)),
+    decodeNodes(wrap(schema.encode('tutorial.Node', nest(99)), 20)),
+    '',
+  ].join('\n')
+}
+
+pipy.read('input', $=>$
+  .replaceStreamStart(evt => [new MessageStart, evt])
+  .replaceMessageBody(data => new Data(check(data)))
+  .tee('-')
+)
@@ -0,0 +1,33 @@
+var trie = new algo.TopicTrie
+
+var run = line => {
+  var args = line.split(' ')
+  var cmd = args[0]
+  try {
+    if (cmd === 'trie') {
+      trie = new algo.TopicTrie({ cacheSize: args[1]|0 })
+      return `${line}\n`
+    } else if (cmd === 'sub') {
+      return `${line} -> ${trie.subscribe(args[1], args[2])}\n`
+    } else if (cmd === 'unsub') {
+      return `${line} -> ${trie.unsubscribe(args[1], args[2])}\n`
+    } else if (cmd === 'pub') {
+      return `${line} -> ${trie.match(args[1]).sort().join(' ')}\n`
+    } else if (cmd === 'size') {
+      return `${line} -> ${trie.size}\n`
+    }
+  } catch (e) {
+    return `${line} -> error\n`
+  }
+  return `${line} -> unknown command\n`
+}
+
+pipy.read('input', $=>$
+  .replaceStreamStart(evt => [new MessageStart, evt])
+  .replaceMessageBody(
+    data => new Data(
+      data.toString().split('\n').filter(l => l !== '').map(run).join('')
+    )
+  )
+  .tee('-')
+)
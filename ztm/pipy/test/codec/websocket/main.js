@@ -0,0 +1,9 @@
+os.readFileAsync('input').then(
+  data => pipeline($=>$
+    .onStart(new Message({ opcode: 2, masked: true }, data))
+    .encodeWebSocket()
+    .decodeWebSocket()
+    .replaceMessage(msg => msg.body)
+    .tee('-')
+  ).spawn()
+)
@@ -5,6 +5,13 @@ pipy()
   new Data('Hello!\n')
 )
 
+.listen(9091, { protocol: 'udp', idleTimeout: 3 })
+.replaceData(
+  () => new Array(2000).fill(new Data('.')).reduce(
+    (data, dot) => data.push(dot), new Data
+  )
+)
+
 .listen(8080)
 .demuxHTTP().to($=>$
   .replaceMessage(
@@ -15,3 +22,14 @@ pipy()
     data => new Message(data)
   )
 )
+
+.listen(8081)
+.demuxHTTP().to($=>$
+  .replaceMessage(
+    new Data('hi')
+  )
+  .connect('localhost:9091', { protocol: 'udp' })
+  .replaceData(
+    data => new Message(data.size + '\n')
+  )
+)
@@ -20,3 +20,6 @@ curl http://localhost:8080 ^
      http://localhost:8080 ^
      http://localhost:8080 ^
      http://localhost:8080
+
+echo Send a datagram of 2000 scattered bytes
+curl http://localhost:8081
@@ -0,0 +1,18 @@
+pipy()
+
+.listen(8080)
+.replaceData(
+  data => new Data(`HTTP/1.1 200 OK\r\ncontent-length: ${data.size}\r\n\r\n`).push(data)
+)
+
+.listen(8081)
+.serveHTTP(
+  msg => new Message(JSON.stringify(msg.head.headers) + '\n')
+)
+
+.listen(8000)
+.demuxHTTP().to($=>$
+  .muxHTTP().to($=>$
+    .connect('localhost:8080')
+  )
+)
@@ -0,0 +1,19 @@
+#!/bin/bash
+
+NO_DEFAULTS="-H User-Agent: -H Accept:"
+MANY="-H X-H01:1 -H X-H02:2 -H X-H03:3 -H X-H04:4 -H X-H05:5 -H X-H06:6
+      -H X-H07:7 -H X-H08:8 -H X-H09:9 -H X-H10:10 -H X-H11:11 -H X-H12:12
+      -H X-H13:13 -H X-H14:14 -H X-H15:15 -H X-H16:16 -H X-H17:17 -H X-H18:18"
+
+echo 'Duplicate cookies'
+curl -s $NO_DEFAULTS -H 'Cookie: a=1' -H 'Cookie: b=2' -H 'cookie: c=3' http://localhost:8081
+
+echo 'Mixed-case headers'
+curl -s $NO_DEFAULTS -H 'X-Foo: 1' -H 'x-FOO: 2' -H 'Content-TYPE: text/plain' http://localhost:8081
+
+echo 'Many headers'
+curl -s $NO_DEFAULTS $MANY -H 'x-h03: 33' -H 'Cookie: a=1' -H 'COOKIE: b=2' http://localhost:8081
+
+echo 'Headers passed on by proxy'
+curl -s $NO_DEFAULTS -H 'X-Foo: 1' -H 'x-FOO: 2' -H 'Cookie: a=1' -H 'Cookie: b=2' http://localhost:8000
+curl -s $NO_DEFAULTS $MANY -H 'x-h03: 33' -H 'Cookie: a=1' -H 'COOKIE: b=2' http://localhost:8000
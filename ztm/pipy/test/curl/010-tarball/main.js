@@ -0,0 +1,15 @@
+((
+  bundle = null
+) =>
+
+pipy()
+
+.listen(8080)
+.serveHTTP(
+  msg => (
+    bundle = bundle || new http.Directory('/bundle.tar', { tarball: true }),
+    bundle.serve(msg) || new Message({ status: 404 }, 'not found\n')
+  )
+)
+
+)()
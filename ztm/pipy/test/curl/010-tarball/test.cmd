@@ -0,0 +1,21 @@
+@echo off
+
+cd /d %~dp0
+
+for /f %%i in ('powershell -NoProfile -Command "(Start-Process -FilePath ..\..\..\bin\Release\pipy.exe -ArgumentList '--admin-port=6066','--init-repo=repo' -WindowStyle Hidden -PassThru).Id"') do set REPO=%%i
+sleep 2
+
+set URL=http://localhost:6066/repo/bundle/
+set TAR="accept: application/x-tar"
+for /f "tokens=2" %%i in ('curl -s -H %TAR% -o bundle.tar -D - %URL% ^| findstr /i /b "etag:"') do set GET_ETAG=%%i
+for /f "tokens=2" %%i in ('curl -s -I -H %TAR% %URL% ^| findstr /i /b "etag:"') do set HEAD_ETAG=%%i
+if defined GET_ETAG if "%GET_ETAG%"=="%HEAD_ETAG%" echo ETags match
+curl -s -I -H %TAR% %URL% | findstr /i /b "x-pipy-entry:"
+
+taskkill /f /pid %REPO% > NUL
+
+curl -s http://localhost:8080/hello.txt
+curl -s http://localhost:8080/a-directory-name-long-enough/to-push-the-whole-path/past-the-100-character-limit/of-ustar-headers/hello.txt
+curl -s http://localhost:8080/missing.txt
+
+del /q bundle.tar
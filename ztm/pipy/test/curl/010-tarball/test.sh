@@ -0,0 +1,22 @@
+#!/bin/bash
+
+cd "$(dirname "$0")"
+
+../../../bin/pipy --admin-port=6066 --init-repo=repo > /dev/null 2>&1 &
+REPO=$!
+sleep 2
+
+URL=http://localhost:6066/repo/bundle/
+TAR='accept: application/x-tar'
+GET_ETAG=$(curl -s -H "$TAR" -o bundle.tar -D - $URL | grep -i '^etag:' | tr -d '\r')
+HEAD_ETAG=$(curl -s -I -H "$TAR" $URL | grep -i '^etag:' | tr -d '\r')
+[ -n "$GET_ETAG" ] && [ "$GET_ETAG" == "$HEAD_ETAG" ] && echo 'ETags match'
+curl -s -I -H "$TAR" $URL | grep -i '^x-pipy-entry:' | tr -d '\r'
+
+kill $REPO
+
+curl -s http://localhost:8080/hello.txt
+curl -s http://localhost:8080/a-directory-name-long-enough/to-push-the-whole-path/past-the-100-character-limit/of-ustar-headers/hello.txt
+curl -s http://localhost:8080/missing.txt
+
+rm -f bundle.tar
@@ -0,0 +1,19 @@
+((
+  files = new http.Directory('www', {
+    fs: true,
+    cache: true,
+    cacheSize: 100,
+    compression: () => 'gzip',
+  })
+) =>
+
+pipy()
+
+.listen(8080)
+.serveHTTP(
+  msg => Promise.resolve(files.serve(msg)).then(
+    res => res || new Message({ status: 404 }, 'not found\n')
+  )
+)
+
+)()
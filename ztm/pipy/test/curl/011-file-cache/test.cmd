@@ -0,0 +1,12 @@
+@echo off
+
+curl -s http://localhost:8080/hello.txt
+curl -s http://localhost:8080/hello.txt
+curl -s http://localhost:8080/
+curl -s http://localhost:8080/large.txt
+curl -s -r 7-12 -w "\n" http://localhost:8080/hello.txt
+curl -s --compressed -D - http://localhost:8080/large.txt | findstr /i /b "content-encoding"
+curl -s --compressed http://localhost:8080/large.txt
+curl -s --compressed http://localhost:8080/hello.txt
+curl -s --compressed http://localhost:8080/hello.txt
+curl -s http://localhost:8080/missing.txt